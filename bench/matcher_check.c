@@ -0,0 +1,198 @@
+// 매처 차등 검사 (make check)
+//
+// 무작위 패턴 집합과 스트림을 만들어 Aho-Corasick 매처(matcher_process/matcher_scan)를
+// 무작위 청크 분할로 흘려 보내고, 스트림 전체를 한 번에 보는 단순 매처와 결과를 비교한다.
+// 치환 결과 바이트, 태그별 매칭 수, 검출 전용 스캔의 매칭 수가 모두 같아야 한다.
+//
+// 사용법: matcher_check [사례 수] [시드]
+
+#include "../include/matcher.h"
+#include "../include/rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK_CASES 20000
+#define CHECK_MAX_STREAM 4096
+#define CHECK_MAX_PATTERNS 12     // SIMD 사전 필터의 시작 쌍 한도(8)를 넘는 경우도 포함
+
+typedef struct {
+    uint8_t bytes[MATCHER_MAX_PATTERN_LEN];
+    uint8_t replacement[MATCHER_MAX_PATTERN_LEN];
+    int len;
+    MatchAction action;
+} CheckPattern;
+
+static int rand_range(Rng *rng, int lo, int hi) {
+    return lo + (int)(rng_next(rng) % (uint64_t)(hi - lo + 1));
+}
+
+// 작은 알파벳에서 고르면 매칭과 겹침이 자주 생김 (가끔 임의 바이트)
+static uint8_t rand_byte(Rng *rng, int alphabet) {
+    if (rng_next(rng) % 16 == 0) {
+        return (uint8_t)rng_next(rng);
+    }
+    return (uint8_t)('a' + rng_next(rng) % alphabet);
+}
+
+// 기준 매처: 각 끝 위치에서 원본 기준으로 끝나는 패턴을 긴 것부터 적용
+// (같은 바이트열이 여러 번 추가되면 먼저 추가된 것만, DFA의 출력 연결과 같은 순서)
+static void naive_process(const CheckPattern *patterns, int count, const uint8_t *in,
+                          uint8_t *out, int length, uint64_t *hits) {
+    memcpy(out, in, length);
+    for (int end = 1; end <= length; end++) {
+        for (int len = MATCHER_MAX_PATTERN_LEN; len >= 1; len--) {
+            if (len > end) continue;
+            for (int k = 0; k < count; k++) {
+                const CheckPattern *p = &patterns[k];
+                if (p->len != len || memcmp(in + end - len, p->bytes, len) != 0) {
+                    continue;
+                }
+                uint8_t *at = out + end - len;
+                if (p->action == MATCH_REPLACE) {
+                    memcpy(at, p->replacement, len);
+                } else if (p->action == MATCH_FLIP) {
+                    for (int i = 0; i < len; i++) at[i] ^= 0xFF;
+                } else if (p->action == MATCH_ZERO) {
+                    memset(at, 0, len);
+                }
+                hits[k]++;
+                break;  // 같은 바이트열의 뒤 패턴은 쓰이지 않음
+            }
+        }
+    }
+}
+
+// 매처로 스트림을 무작위 청크로 나눠 처리하고 마지막에 보류 바이트를 꺼냄
+static int stream_process(Matcher *matcher, Rng *rng, const uint8_t *in, int length,
+                          uint8_t *out, uint64_t *hits) {
+    uint8_t buffer[MATCHER_MAX_PATTERN_LEN + CHECK_MAX_STREAM];
+    int pos = 0, produced = 0;
+
+    while (pos < length) {
+        int chunk = rand_range(rng, 1, rng_next(rng) % 4 == 0 ? 8 : 512);
+        if (chunk > length - pos) chunk = length - pos;
+        memcpy(buffer + MATCHER_MAX_PATTERN_LEN, in + pos, chunk);
+
+        uint8_t *data = buffer + MATCHER_MAX_PATTERN_LEN;
+        int n = chunk;
+        matcher_process(matcher, &data, &n, hits);
+        memcpy(out + produced, data, n);
+        produced += n;
+        pos += chunk;
+    }
+    produced += matcher_flush(matcher, out + produced);
+    return produced;
+}
+
+static int stream_scan(Matcher *matcher, Rng *rng, const uint8_t *in, int length,
+                       uint64_t *hits) {
+    int pos = 0, found = 0;
+    while (pos < length) {
+        int chunk = rand_range(rng, 1, 512);
+        if (chunk > length - pos) chunk = length - pos;
+        found += matcher_scan(matcher, in + pos, chunk, hits);
+        pos += chunk;
+    }
+    return found;
+}
+
+static Matcher *build(const CheckPattern *patterns, int count, bool detect) {
+    Matcher *matcher = matcher_create();
+    for (int k = 0; k < count; k++) {
+        const CheckPattern *p = &patterns[k];
+        if (!matcher_add(matcher, p->bytes, p->len, detect ? MATCH_DETECT : p->action,
+                         p->replacement, k)) {
+            matcher_free(matcher);
+            return NULL;
+        }
+    }
+    if (!matcher_build(matcher)) {
+        matcher_free(matcher);
+        return NULL;
+    }
+    return matcher;
+}
+
+static void dump(const char *label, const uint8_t *data, int length) {
+    fprintf(stderr, "  %s (%d): ", label, length);
+    for (int i = 0; i < length && i < 96; i++) {
+        fprintf(stderr, (data[i] >= 0x20 && data[i] < 0x7F) ? "%c" : "\\x%02x", data[i]);
+    }
+    fprintf(stderr, "%s\n", length > 96 ? "..." : "");
+}
+
+// 사례 하나 검사 (실패하면 false와 함께 재현 정보 출력)
+static bool check_case(Rng *rng, int index) {
+    CheckPattern patterns[CHECK_MAX_PATTERNS];
+    int alphabet = rand_range(rng, 2, 6);
+    int count = rand_range(rng, 1, CHECK_MAX_PATTERNS);
+    int max_len = rng_next(rng) % 8 == 0 ? MATCHER_MAX_PATTERN_LEN : 6;
+
+    for (int k = 0; k < count; k++) {
+        CheckPattern *p = &patterns[k];
+        p->len = rand_range(rng, 1, max_len);
+        for (int i = 0; i < p->len; i++) {
+            p->bytes[i] = rand_byte(rng, alphabet);
+            p->replacement[i] = (uint8_t)('A' + rng_next(rng) % 26);
+        }
+        p->action = (MatchAction)(rng_next(rng) % 3);  // REPLACE, FLIP, ZERO
+    }
+
+    static uint8_t in[CHECK_MAX_STREAM], want[CHECK_MAX_STREAM], got[CHECK_MAX_STREAM];
+    int length = rand_range(rng, 0, CHECK_MAX_STREAM);
+    for (int i = 0; i < length; i++) {
+        in[i] = rand_byte(rng, alphabet);
+    }
+
+    uint64_t want_hits[CHECK_MAX_PATTERNS] = {0};
+    uint64_t got_hits[CHECK_MAX_PATTERNS] = {0};
+    uint64_t scan_hits[CHECK_MAX_PATTERNS] = {0};
+    naive_process(patterns, count, in, want, length, want_hits);
+
+    Matcher *matcher = build(patterns, count, false);
+    Matcher *detector = build(patterns, count, true);
+    if (matcher == NULL || detector == NULL) {
+        fprintf(stderr, "사례 %d: 매처 생성 실패\n", index);
+        matcher_free(matcher);
+        matcher_free(detector);
+        return false;
+    }
+    int produced = stream_process(matcher, rng, in, length, got, got_hits);
+    stream_scan(detector, rng, in, length, scan_hits);
+    matcher_free(matcher);
+    matcher_free(detector);
+
+    bool ok = produced == length && memcmp(want, got, length) == 0 &&
+              memcmp(want_hits, got_hits, sizeof(want_hits)) == 0 &&
+              memcmp(want_hits, scan_hits, sizeof(want_hits)) == 0;
+    if (!ok) {
+        fprintf(stderr, "사례 %d 불일치 (패턴 %d개)\n", index, count);
+        for (int k = 0; k < count; k++) {
+            fprintf(stderr, "  패턴 %d: 동작 %d, 매칭 기준 %llu / 치환 %llu / 검출 %llu\n",
+                    k, patterns[k].action, (unsigned long long)want_hits[k],
+                    (unsigned long long)got_hits[k], (unsigned long long)scan_hits[k]);
+            dump("    바이트", patterns[k].bytes, patterns[k].len);
+        }
+        dump("입력", in, length);
+        dump("기준", want, length);
+        dump("결과", got, produced);
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    int cases = argc > 1 ? atoi(argv[1]) : CHECK_CASES;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 0) : 1;
+
+    Rng rng;
+    rng_seed(&rng, seed);
+    for (int i = 0; i < cases; i++) {
+        if (!check_case(&rng, i)) {
+            fprintf(stderr, "matcher_check: 실패 (시드 %llu)\n", (unsigned long long)seed);
+            return 1;
+        }
+    }
+    printf("matcher_check: %d개 사례 통과 (시드 %llu)\n", cases, (unsigned long long)seed);
+    return 0;
+}
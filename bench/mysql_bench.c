@@ -0,0 +1,166 @@
+// MySQL 모드 패킷 해석 비용 측정 (make bench)
+//
+// 중계 루프가 청크마다 부르는 mysql_client_data/mysql_client_sent/mysql_server_data만 떼어
+// 쿼리당, 패킷당, 청크당 시간을 잰다 (소켓과 필터 제외, 한 코어). 비교용으로 같은 크기 청크의
+// memcpy 시간도 함께 출력한다 (중계 루프가 청크마다 이미 치르는 비용의 하한).
+//
+// 사용법: mysql_bench [반복 수]
+
+#include "../include/mysql.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_ITERATIONS 2000000
+#define BENCH_ROW_PAYLOAD 20      // 작은 행 패킷 payload (결과 집합이 큰 SELECT)
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 패킷 하나를 out에 씀 (헤더 + payload), 쓴 길이를 반환
+static int put_packet(uint8_t *out, uint8_t seq, const void *payload, uint32_t length) {
+    out[0] = (uint8_t)(length & 0xFF);
+    out[1] = (uint8_t)((length >> 8) & 0xFF);
+    out[2] = (uint8_t)((length >> 16) & 0xFF);
+    out[3] = seq;
+    memcpy(out + MYSQL_HEADER_LEN, payload, length);
+    return MYSQL_HEADER_LEN + (int)length;
+}
+
+static MysqlSession *session_after_login(void) {
+    MysqlSession *session = mysql_session_create();
+    session->login_seen = true;
+    return session;
+}
+
+// SELECT 1 한 번: 쿼리 패킷 하나와 결과 집합 패킷 다섯 개 (열 수, 열 정의, EOF, 행, EOF)
+static void bench_query(long iterations) {
+    uint8_t query[64], reply[128];
+    int query_len = put_packet(query, 0, "\x03" "SELECT 1", 9);
+
+    static const uint8_t column[] = "\x03" "def" "\x00\x00\x00" "\x01" "1" "\x00"
+                                    "\x0c\x3f\x00\x01\x00\x00\x00\x08\x81\x00\x00\x00\x00";
+    static const uint8_t eof[] = {0xFE, 0x00, 0x00, 0x02, 0x00};
+    int reply_len = 0;
+    reply_len += put_packet(reply + reply_len, 1, "\x01", 1);
+    reply_len += put_packet(reply + reply_len, 2, column, sizeof(column) - 1);
+    reply_len += put_packet(reply + reply_len, 3, eof, sizeof(eof));
+    reply_len += put_packet(reply + reply_len, 4, "\x01" "1", 2);
+    reply_len += put_packet(reply + reply_len, 5, eof, sizeof(eof));
+
+    MysqlSession *session = session_after_login();
+    const char *text;
+    int text_len;
+    double start = now_sec();
+    for (long n = 0; n < iterations; n++) {
+        mysql_client_data(session, (const char *)query, query_len, &text, &text_len);
+        mysql_client_sent(session, (uint64_t)n * 2);
+        mysql_server_data(session, (const char *)reply, reply_len, (uint64_t)n * 2 + 1);
+    }
+    double elapsed = now_sec() - start;
+
+    printf("  %7.1f ns/쿼리   SELECT 1 (요청 %d B 패킷 1개, 응답 %d B 패킷 5개)\n",
+           elapsed * 1e9 / iterations, query_len, reply_len);
+    if (session->stats.count != (uint64_t)iterations) {
+        fprintf(stderr, "응답 시간 기록 수가 맞지 않음: %llu\n",
+                (unsigned long long)session->stats.count);
+        exit(1);
+    }
+    mysql_session_free(session);
+}
+
+// 작은 행 패킷이 이어지는 응답을 BUFFER_SIZE 청크로 (청크 경계에 걸친 헤더 포함)
+static void bench_rows(long iterations) {
+    static uint8_t stream[BUFFER_SIZE * 2];
+    uint8_t payload[BENCH_ROW_PAYLOAD];
+    memset(payload, 'r', sizeof(payload));
+    int length = 0;
+    uint8_t seq = 0;
+    while (length + MYSQL_HEADER_LEN + BENCH_ROW_PAYLOAD <= (int)sizeof(stream)) {
+        length += put_packet(stream + length, seq++, payload, BENCH_ROW_PAYLOAD);
+    }
+
+    MysqlSession *session = session_after_login();
+    long chunks = iterations / 64;
+    int offset = 0;
+    double start = now_sec();
+    for (long n = 0; n < chunks; n++) {
+        // 두 청크 분량을 돌려 가며 패킷 중간에서 끊기는 청크도 섞음
+        int chunk = BUFFER_SIZE - (int)(n & 7);
+        if (offset + chunk > length) {
+            offset = 0;
+            memset(&session->server, 0, sizeof(session->server));
+        }
+        mysql_server_data(session, (const char *)stream + offset, chunk, 0);
+        offset += chunk;
+    }
+    double elapsed = now_sec() - start;
+
+    double packets = (double)chunks * BUFFER_SIZE / (MYSQL_HEADER_LEN + BENCH_ROW_PAYLOAD);
+    printf("  %7.1f ns/패킷   %5.0f ns/청크  %d B 행 패킷 (청크당 약 %.0f개)\n",
+           elapsed * 1e9 / packets, elapsed * 1e9 / chunks, BENCH_ROW_PAYLOAD,
+           packets / chunks);
+    mysql_session_free(session);
+}
+
+// 1 MiB INSERT 하나를 BUFFER_SIZE 청크로 (헤더 한 번, 나머지는 길이만큼 건너뜀)
+static void bench_large(long iterations) {
+    static uint8_t chunk[BUFFER_SIZE];
+    const uint32_t packet = (1u << 20) - 1;
+    memset(chunk, 'v', sizeof(chunk));
+
+    MysqlSession *session = session_after_login();
+    const char *text;
+    int text_len;
+    long chunks = iterations / 16;
+    uint32_t left = 0;
+    double start = now_sec();
+    for (long n = 0; n < chunks; n++) {
+        if (left == 0) {
+            chunk[0] = (uint8_t)(packet & 0xFF);
+            chunk[1] = (uint8_t)((packet >> 8) & 0xFF);
+            chunk[2] = (uint8_t)(packet >> 16);
+            chunk[3] = 0;
+            chunk[4] = MYSQL_COM_QUERY;
+            left = packet + MYSQL_HEADER_LEN;
+        } else {
+            chunk[0] = chunk[1] = chunk[2] = chunk[3] = chunk[4] = 'v';
+        }
+        int length = left < BUFFER_SIZE ? (int)left : BUFFER_SIZE;
+        mysql_client_data(session, (const char *)chunk, length, &text, &text_len);
+        left -= length;
+    }
+    double elapsed = now_sec() - start;
+
+    printf("  %7.1f ns/청크   1 MiB 쿼리 패킷의 %d B 청크\n", elapsed * 1e9 / chunks, BUFFER_SIZE);
+    mysql_session_free(session);
+}
+
+// 비교 기준: 같은 크기 청크의 memcpy
+static void bench_copy(long iterations) {
+    static char src[BUFFER_SIZE], dst[BUFFER_SIZE];
+    long chunks = iterations / 16;
+    double start = now_sec();
+    for (long n = 0; n < chunks; n++) {
+        src[n & (BUFFER_SIZE - 1)] = (char)n;
+        memcpy(dst, src, sizeof(dst));
+        __asm__ volatile("" : : "r"(dst) : "memory");
+    }
+    double elapsed = now_sec() - start;
+    printf("  %7.1f ns/청크   참고: %d B memcpy\n", elapsed * 1e9 / chunks, BUFFER_SIZE);
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+
+    printf("MySQL 패킷 해석: 반복 %ld회\n", iterations);
+    bench_query(iterations);
+    bench_rows(iterations);
+    bench_large(iterations);
+    bench_copy(iterations);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// 필터 트리거 청크당 비용 측정 (make bench)
+//
+// drop=0 필터 하나에 트리거를 붙여 filter_apply를 반복 호출하고 청크당 시간을 잰다
+// (캐시가 데워진 상태, 한 코어). 트리거가 동작하지 않는 경우의 평가 비용이 목적이므로
+// after=/offset=/elapsed=는 닿지 않는 값을 준다.
+//
+// 사용법: trigger_bench [반복 수]
+
+#include "../include/filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_ITERATIONS 2000000
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(const char *spec, int chunk_len, long iterations) {
+    Filter filter;
+    char err[256];
+    if (!filter_parse_spec(spec, &filter, err, sizeof(err))) {
+        fprintf(stderr, "필터 명세 오류: %s (%s)\n", spec, err);
+        exit(1);
+    }
+    FilterChain table;
+    filter_chain_init(&table);
+    filter.id = 1;
+    filter_chain_add(&table, &filter);
+
+    Connection conn;
+    memset(&conn, 0, sizeof(conn));
+    FilterPath path;
+    filter_path_init(&path, 1);
+    filter_path_compile(&table, &conn, FILTER_DIR_C2S, &path);
+
+    // 텍스트 청크 (match= 패턴은 들어 있지 않음)
+    static char buffer[FILTER_HEADROOM + BUFFER_SIZE];
+    for (int i = 0; i < chunk_len; i++) {
+        buffer[FILTER_HEADROOM + i] = (char)('a' + i % 26);
+    }
+
+    ConnectionStats stats;
+    memset(&stats, 0, sizeof(stats));
+    FilterPlan plan;
+    double start = now_sec();
+    for (long n = 0; n < iterations; n++) {
+        char *data = buffer + FILTER_HEADROOM;
+        int length = chunk_len;
+        filter_apply(&path, &data, &length, &stats, &plan);
+    }
+    double elapsed = now_sec() - start;
+
+    printf("  %7.1f ns/청크  %5d B  %s\n", elapsed * 1e9 / iterations, chunk_len, spec);
+    filter_path_free(&path);
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+
+    printf("filter_apply: 청크 %ld개\n", iterations);
+    run("drop=0", 64, iterations);
+    run("drop=0 after=1G", 64, iterations);
+    run("drop=0 offset=1G-2G", 64, iterations);
+    run("drop=0 elapsed=100000000", 64, iterations);
+    run("drop=0 match=COMMIT", 64, iterations);
+    run("drop=0 match=COMMIT", BUFFER_SIZE, iterations / 16);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 트래픽 캡처 (pcapng)
+//
+// 선택한 연결이 실제로 보낸 바이트를 양방향 모두 기록한다. 자식 프로세스는 fork 전에 만든 공유
+// 메모리 링에 레코드를 memcpy 하는 것이 전부이고 (자리는 원자적 CAS로 예약), 부모의 기록 스레드가
+// 링을 비우며 TCP/IP 헤더를 만들어 붙여 파일에 쓴다. 링이 가득 차면 기다리지 않고 버린 뒤 카운터만
+// 올리므로 디스크가 느려도 중계는 멈추지 않는다. 연결 시작/끝에는 SYN/FIN을 합성해 Wireshark의
+// "Follow TCP Stream"이 그대로 동작한다. 링크 타입은 LINKTYPE_RAW (IP 헤더부터).
+
+#define CAPTURE_RING_SIZE (16 * 1024 * 1024)  // 공유 링 크기 (바이트)
+#define CAPTURE_DRAIN_MS 10                   // 링이 비었을 때 기록 스레드 대기 간격
+#define CAPTURE_MAX_PAYLOAD 16384             // 레코드 하나의 최대 payload (넘으면 나눠 기록)
+#define CAPTURE_STALL_MS 1000                 // 예약만 하고 게시하지 않은 레코드를 건너뛰기까지 기다리는 시간
+                                              // (예약과 게시 사이에 SIGKILL/SIGSTOP된 자식)
+
+// 캡처 상태 (제어 응답용)
+typedef struct {
+    bool enabled;
+    char path[MAX_PATH_LEN];
+    char selector[MAX_FILTER_SPEC_LEN];  // 비어 있으면 모든 연결
+    uint64_t sessions;                // 캡처한 연결 수
+    uint64_t packets;                 // 링에 넣은 데이터 레코드
+    uint64_t bytes;                   // 링에 넣은 payload 바이트
+    uint64_t dropped;                 // 링이 가득 차 버린 레코드
+    uint64_t dropped_bytes;
+    uint64_t abandoned;               // 예약 후 게시되지 않아 건너뛴 레코드 (자식이 중간에 죽음/멈춤)
+    uint64_t written_packets;         // 파일에 쓴 패킷 (합성한 SYN/FIN 포함)
+    uint64_t file_bytes;              // 파일 크기
+    uint64_t write_errors;            // 파일 쓰기 실패
+    uint64_t ring_used;               // 지금 링에 남은 바이트
+    uint64_t ring_size;
+} CaptureStatus;
+
+struct CaptureFlow;
+
+// 캡처 시작 (부모가 fork 전에 호출: 공유 링 생성, 파일 헤더 기록, 기록 스레드 시작)
+// selector는 필터 선택자 문법 (예: "client=10.0.0.0/8 percent=10", NULL/빈 문자열 = 모든 연결)
+bool capture_start(const char *path, const char *selector);
+
+// 캡처 종료 (남은 레코드를 모두 쓰고 파일을 닫음)
+void capture_stop(void);
+
+// 연결 캡처 시작 (자식, 선택자에 맞지 않거나 캡처가 꺼져 있으면 NULL)
+struct CaptureFlow *capture_open(const Connection *conn);
+
+// 보낸 바이트 기록 (dir: FLIGHT_DIR_C2S/S2C)
+void capture_data(struct CaptureFlow *flow, uint8_t dir, const char *data, size_t length);
+
+// 연결 캡처 끝 (reset이면 RST, 아니면 양쪽 FIN 합성)
+void capture_close(struct CaptureFlow *flow, bool reset);
+
+// 캡처 상태 조회 (부모의 제어 스레드)
+void capture_get_status(CaptureStatus *status);
+
+#endif // CAPTURE_H
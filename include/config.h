@@ -7,8 +7,41 @@
 // 설정 초기화 (기본값)
 void config_init(ProxyConfig *config);
 
-// 설정 파일 로드
-bool config_load(ProxyConfig *config, const char *config_file);
+// 설정 파일 로드 (filter= 줄은 filter_chain에 추가)
+bool config_load(ProxyConfig *config, const char *config_file, FilterChain *filter_chain);
+
+// 프로토콜 모드 이름 파싱 ("raw", "mysql", "http") - 실패 시 -1
+int config_parse_protocol(const char *name);
+
+// 난수 마스터 시드 파싱 (10진수 또는 0x 16진수, 0이 아닌 64비트 정수) - 실패 시 false
+bool config_parse_seed(const char *text, uint64_t *seed);
+
+// 프로토콜 모드 이름
+const char *config_protocol_name(int protocol);
+
+// PROXY 프로토콜 방향 파싱 ("none", "in", "out", "both") - 실패 시 -1
+int config_parse_proxy_protocol(const char *name);
+
+// PROXY 프로토콜 방향 이름
+const char *config_proxy_protocol_name(int proxy_protocol);
+
+// "host:port" 파싱 (IPv6는 마지막 ':'에서 분리, "[::1]:port"의 대괄호는 벗김) - 실패 시 false
+bool config_parse_host_port(const char *text, char *host, size_t host_len, int *port);
+
+// 연결 대상 파싱: "host:port", "[v6]:port", "unix:/경로" (유닉스 소켓은 host에 그대로, port 0)
+bool config_parse_endpoint(const char *text, char *host, size_t host_len, int *port);
+
+// 리스닝 주소 파싱: 대상 형식에 더해 "port"만 쓰면 모든 주소
+bool config_parse_listen(const char *text, char *host, size_t host_len, int *port);
+
+// "unix:/경로"면 경로, 아니면 NULL
+const char *config_unix_path(const char *host);
+
+// 주소 표시용 문자열 ("host:port", "[v6]:port", "unix:/경로", 빈 호스트는 "*:port")
+void config_format_endpoint(const char *host, int port, char *out, size_t out_len);
+
+// 실제로 열 리스너 목록: [이름] 구역이 있으면 구역들, 없으면 기본 리스너 하나
+const ListenerConfig *config_active_listeners(const ProxyConfig *config, int *count);
 
 // 설정 출력
 void config_print(const ProxyConfig *config);
@@ -2,6 +2,10 @@
 #define CONTROL_H
 
 #include "types.h"
+#include "flight.h"
+#include "capture.h"
+#include "mirror.h"
+#include "udp.h"
 #include <stdbool.h>
 
 // 제어 명령 타입
@@ -10,7 +14,27 @@ typedef enum {
     CMD_KILL_CONNECTION,     // 특정 연결 종료
     CMD_SEND_SIGNAL,         // 특정 프로세스에 시그널 전송
     CMD_GET_STATS,           // 통계 정보 조회
-    CMD_SHUTDOWN             // 프록시 서버 종료
+    CMD_SHUTDOWN,            // 프록시 서버 종료
+    CMD_DUMP_FLIGHT,         // 연결 플라이트 레코더 조회
+    CMD_GET_HISTORY,         // 초/분 단위 처리량 이력 조회
+    CMD_TOP_CONNECTIONS,     // 현재 처리량 상위 N개 연결
+    CMD_FILTER_LIST,         // 런타임 필터 테이블 조회
+    CMD_FILTER_ADD,          // 필터 추가 (filter_spec)
+    CMD_FILTER_REMOVE,       // 필터 제거 (filter_index)
+    CMD_FILTER_ENABLE,       // 필터 활성화 (filter_index)
+    CMD_FILTER_DISABLE,      // 필터 비활성화 (filter_index)
+    CMD_FILTER_CLEAR,        // 모든 필터 제거
+    CMD_SCENARIO_START,      // 시나리오 시작 (path, 진행 중이면 교체)
+    CMD_SCENARIO_STOP,       // 시나리오 중단 (필터 테이블은 그대로)
+    CMD_SCENARIO_STATUS,     // 시나리오 진행 상황
+    CMD_KILL_MATCHING,       // 선택자에 맞는 모든 연결 종료 (selector, abortive)
+    CMD_SIGNAL_MATCHING,     // 선택자에 맞는 모든 연결에 시그널 전송 (selector, signal_num)
+    CMD_QUERY_STATS,         // 프로토콜 모드 쿼리 지연 히스토그램 조회
+    CMD_QUERY_RESET,         // 쿼리 지연 히스토그램 초기화
+    CMD_CAPTURE_STATUS,      // 트래픽 캡처 상태
+    CMD_MIRROR_STATUS,       // 섀도 미러링 상태
+    CMD_UDP_STATUS,          // UDP 모드 세션/데이터그램 상태
+    CMD_LISTENERS            // 리스너별 주소와 누적 통계
 } ControlCommand;
 
 // 제어 요청 구조체
@@ -18,27 +42,121 @@ typedef struct {
     ControlCommand cmd;
     pid_t target_pid;        // 대상 프로세스 ID
     int signal_num;          // 전송할 시그널 번호
+    uint64_t conn_id;        // 대상 연결 ID (0이면 target_pid 사용)
+    int interval_sec;        // 이력 해상도 (1: 초, 60: 분) / top 기준 창 (1, 10, 60초)
+    int count;               // 조회할 항목 수
+    int filter_index;        // 대상 필터 인덱스
+    char filter_spec[MAX_FILTER_SPEC_LEN]; // 필터 명세 (예: "delay=100")
+    char path[MAX_PATH_LEN]; // 시나리오 파일 경로 (부모 기준이므로 절대 경로)
+    char selector[MAX_FILTER_SPEC_LEN]; // 일괄 명령 선택자 (예: "idle=300 client=10.0.0.0/8")
+    bool abortive;           // 일괄 종료를 FIN 대신 RST로
+    bool dry_run;            // 일괄 명령 대상만 조회하고 시그널은 보내지 않음
 } ControlRequest;
 
+// 처리량 이력 보관 크기
+#define HISTORY_SECONDS 120      // 초 단위 구간 수 (2분)
+#define HISTORY_MINUTES 60       // 분 단위 구간 수 (1시간)
+
+// 처리량 이력 구간 (부모 제어 스레드가 1초마다 기록)
+typedef struct {
+    time_t end_time;                  // 구간 끝 시각
+    int duration_sec;                 // 구간 길이 (초)
+    uint64_t client_to_server_bytes;
+    uint64_t server_to_client_bytes;
+    uint32_t connections_opened;
+    uint32_t connections_closed;
+    uint32_t packets_dropped;
+    uint32_t connect_errors;
+} HistoryBucket;
+
+// 이력 조회 결과 (오래된 구간 -> 최근 구간 순)
+typedef struct {
+    int interval_sec;
+    int count;
+    HistoryBucket buckets[HISTORY_SECONDS];
+} HistoryDump;
+
+// 시나리오 진행 상황
+typedef struct {
+    bool loaded;                      // 시나리오를 시작한 적 있음
+    bool running;                     // 남은 단계가 있음
+    char path[MAX_PATH_LEN];
+    int step_count;
+    int steps_done;                   // 적용한 단계 수
+    uint64_t elapsed_ms;              // 시작 후 경과 (끝났으면 마지막 단계 시각)
+    uint64_t next_at_ms;              // 다음 단계 시각
+    char last_step[160];              // 마지막으로 적용한 단계
+    char next_step[160];              // 다음 단계
+} ScenarioStatus;
+
+#define MAX_CONNECTIONS 8192    // 공유 메모리에 등록 가능한 연결 수 (넘는 연결은 목록 밖으로 셈)
+
 // 연결 정보 요약 (관리용)
 typedef struct {
     pid_t pid;
+    uint64_t conn_id;
+    int listener_index;           // 연결을 받은 리스너 (ListenerStats 순서)
+    char listener[MAX_LISTENER_NAME];
     char client_addr[MAX_ADDR_LEN];
     int client_port;
-    char target_addr[MAX_ADDR_LEN];
+    char target_addr[MAX_HOST_LEN];   // 설정/SNI 규칙의 대상 호스트 ("unix:/경로" 포함)
     int target_port;
+    char sni[MAX_SNI_LEN];        // SNI 라우팅으로 고른 이름 (없으면 빈 문자열)
     uint64_t client_to_server_bytes;
     uint64_t server_to_client_bytes;
+    uint32_t packets_dropped;
     time_t start_time;
     time_t last_activity;
+    TcpInfoSample client_tcp;
+    TcpInfoSample server_tcp;
+    ConnectionRates rates;
+    bool abort_requested;         // 종료 요청 시 RST로 끊음 (일괄 종료가 시그널 전에 설정)
 } ConnectionInfo;
 
+// 리스너별 누적 통계 (시작 시 게시한 순서, 연결 수/바이트는 모든 연결 합계)
+typedef struct {
+    char name[MAX_LISTENER_NAME];
+    char listen[128];                 // 표시용 리스닝 주소
+    char target[128];                 // 표시용 대상 서버 주소
+    int protocol;
+    int sni_route_count;
+    uint64_t client_to_server_bytes;
+    uint64_t server_to_client_bytes;
+    uint64_t connections_opened;
+    uint64_t connections_closed;
+    uint64_t packets_dropped;
+    uint64_t connect_errors;
+} ListenerStats;
+
+// 일괄 명령 결과 (대상 연결은 응답 뒤에 이어 보냄)
+typedef struct {
+    int matched;                      // 선택자에 맞은 연결 수
+    int signaled;                     // 시그널 전송 성공
+    int failed;                       // 전송 실패 (그 사이 종료된 연결 등)
+} BulkResult;
+
 // 제어 응답 구조체
+// 연결 목록(list, stats, top, 일괄 명령)은 고정 크기 응답 뒤에 ConnectionInfo를
+// connection_count개 이어 보낸다 (다른 명령은 0개).
 typedef struct {
     bool success;
-    int connection_count;
-    ConnectionInfo connections[100];  // 최대 100개 연결
+    int connection_count;             // 응답 뒤에 이어지는 연결 수
+    int unregistered;                 // 연결 표가 가득 차 목록에 없는 활성 연결 수
+    uint64_t unregistered_total;      // 시작 후 목록에 등록하지 못한 연결 누적
     char message[256];
+    FlightDump flight;                // CMD_DUMP_FLIGHT 결과
+    HistoryDump history;              // CMD_GET_HISTORY 결과
+    FilterChain filters;              // CMD_FILTER_* 이후 필터 테이블
+    uint32_t filter_generation;       // 필터 테이블 세대
+    FilterCounters filter_counters[MAX_FILTERS][FILTER_DIR_COUNT]; // 필터별 방향별 효과
+    ScenarioStatus scenario;          // CMD_SCENARIO_* 결과
+    BulkResult bulk;                  // CMD_*_MATCHING 결과
+    QueryStats queries;               // CMD_QUERY_* 결과 (모든 연결 합계)
+    CaptureStatus capture;            // CMD_CAPTURE_STATUS 결과
+    MirrorStatus mirror;              // CMD_MIRROR_STATUS 결과
+    UdpStatus udp;                    // CMD_UDP_STATUS 결과
+    int listener_count;               // CMD_LISTENERS 결과
+    ListenerStats listeners[MAX_LISTENERS];
 } ControlResponse;
 
 // 제어 서버 시작
@@ -47,14 +165,42 @@ int control_server_start(const char *socket_path);
 // 제어 서버 종료
 void control_server_stop(void);
 
-// 연결 정보 등록 (자식 프로세스가 호출)
-void control_register_connection(const Connection *conn);
+// 연결 정보 등록 (자식 프로세스가 호출, 표가 가득 차면 목록 밖 연결로 셈)
+void control_register_connection(Connection *conn);
 
 // 연결 정보 제거 (자식 프로세스가 종료될 때 호출)
-void control_unregister_connection(pid_t pid);
+void control_unregister_connection(Connection *conn);
+
+// 종료 요청이 RST로 끊는 요청인지 (자식이 SIGTERM을 받은 뒤 호출)
+bool control_abort_requested(pid_t pid);
+
+// 연결 통계 업데이트 (직전 호출 이후 증가분을 누적값에 더하므로 목록에 없는 연결도 이력에 반영)
+void control_update_stats(Connection *conn);
+
+// 리스너 목록 게시 (부모가 시작 시 호출, 이후 연결/바이트를 리스너별로도 누적)
+void control_listeners_publish(const ListenerConfig *listeners, int count);
+
+// 런타임 필터 테이블 게시 (부모가 시작 시 호출)
+void control_filter_publish(const FilterChain *chain);
+
+// 시나리오 시작 (부모가 필터 테이블 게시 후 호출, 이후 제어 스레드가 시각에 맞춰 적용)
+bool control_scenario_start(const char *path);
+
+// 공유 필터 테이블이 바뀌었으면 로컬 체인 갱신 (자식이 청크마다 호출, 세대 비교 한 번)
+bool control_filter_sync(FilterChain *chain, uint32_t *generation);
+
+// 연결별 필터 효과 카운터를 공유 테이블의 필터별/방향별 합계에 반영하고 비움
+void control_filter_account(const FilterChain *chain, int direction, FilterCounters *pending);
+
+// 연결별 쿼리 지연 통계를 공유 합계에 반영하고 비움 (자식이 필터 카운터와 같은 주기로 호출)
+void control_query_account(QueryStats *pending);
+
+// 연결 목록에 등록하지 않는 트래픽(UDP 세션)을 이력 누적값과 첫 리스너에 반영 (UDP 이벤트 루프가 1초마다 호출)
+void control_account_traffic(uint64_t c2s_bytes, uint64_t s2c_bytes, uint32_t opened,
+                             uint32_t closed, uint32_t dropped);
 
-// 연결 통계 업데이트
-void control_update_stats(pid_t pid, const ConnectionStats *stats);
+// 대상 서버 연결 실패 기록 (부모 프로세스 또는 SNI 라우팅 자식이 리스너 번호와 함께 호출)
+void control_record_connect_error(int listener);
 
 // 제어 요청 처리
 void control_handle_request(int client_fd);
@@ -0,0 +1,21 @@
+#ifndef DIST_H
+#define DIST_H
+
+#include "types.h"
+
+// 지연 분포 표 (역누적분포함수를 미리 계산해 두고 균등 난수로 O(1) 조회)
+#define DIST_TABLE_BITS 12
+#define DIST_TABLE_SIZE (1 << DIST_TABLE_BITS)
+
+// 표 생성 (fork 전에 부모가 한 번 호출, 이후 자식은 복사본을 읽기만 함)
+void dist_init(void);
+
+// 분포 이름 파싱 ("uniform", "normal", "pareto", "lognormal") - 실패 시 -1
+int dist_parse(const char *name);
+const char *dist_name(int dist);
+
+// 균등 난수 u ∈ [0, 1)을 분포의 표준화된 값으로 변환
+// (uniform은 [-1, 1), 나머지는 평균 0, 표준편차 1)
+float dist_sample(int dist, double u);
+
+#endif // DIST_H
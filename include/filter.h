@@ -3,17 +3,105 @@
 
 #include "types.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 수정 필터가 보류 바이트를 붙일 수 있도록 청크 앞에 비워 둘 공간
+#define FILTER_HEADROOM MODIFY_MAX_PATTERN_LEN
+
+#define FILTER_HOLD_FOREVER UINT64_MAX   // 연결이 끝날 때까지 보류 (stall=0)
+
+// 청크에 대한 필터 판정
+typedef enum {
+    VERDICT_PASS = 0,             // 전송 (보류/분할/복제는 FilterPlan에 따라)
+    VERDICT_DROP,                 // 버림
+    VERDICT_RESET,                // 양쪽 연결을 RST로 끊음
+    VERDICT_HALF_CLOSE,           // 이 방향 출력을 FIN으로 닫고 이후 입력은 버림
+    VERDICT_ERROR                 // 쿼리를 보내지 않고 클라이언트에 오류 응답 (프로토콜 모드)
+} FilterVerdict;
+
+// 통과한 청크의 전송 방법 (잠들지 않고 중계 루프가 마감 시각에 전송)
+typedef struct {
+    uint64_t hold_us;             // 전송 전 보류 시간 (지연/쓰로틀/정지 합계, FILTER_HOLD_FOREVER 가능)
+    int fragment;                 // 0이 아니면 이 크기씩 나눠 TCP_NODELAY로 전송
+    int copies;                   // 전송 횟수 (복제 시 2 이상)
+    bool reorder;                 // 다음 청크 뒤로 보냄
+    int hold_ms;                  // VERDICT_HALF_CLOSE: 반쪽 닫은 뒤 연결을 유지할 시간 (0 = 무제한)
+    int error_code;               // VERDICT_ERROR: 응답할 오류 번호
+    uint64_t throttle_us;         // 데이터그램: 쓰로틀 전송 시간 (호출자가 세션 방향별로 이어 붙임)
+} FilterPlan;
+
+// 데이터그램 필터 적용 기준 (UDP 세션의 방향별 상태)
+typedef struct {
+    uint32_t mask;                // 이 세션에 적용할 체인 필터 (비트 i = 체인의 i번째, 선택자 평가 결과)
+    uint64_t offset;              // 이 방향에서 앞서 들어온 바이트 (트리거 offset=)
+    uint64_t session_bytes;       // 세션 양방향 누적 바이트 (트리거 after=)
+    uint64_t start_ms;            // 세션 시작 시각 (CLOCK_MONOTONIC_COARSE, 트리거 elapsed=)
+    Rng *rng;                     // 세션 방향별 난수 (드롭/지터/복제, 다른 세션의 트래픽과 무관한 수열)
+} DatagramContext;
 
 // 필터 체인 초기화
 void filter_chain_init(FilterChain *chain);
 
-// 필터 추가
-bool filter_chain_add_delay(FilterChain *chain, int delay_ms);
-bool filter_chain_add_drop(FilterChain *chain, float drop_rate);
-bool filter_chain_add_throttle(FilterChain *chain, int bytes_per_sec);
+// 필터 추가 (directions: FILTER_DIR_C2S, FILTER_DIR_S2C, FILTER_DIR_BOTH)
+bool filter_chain_add_delay(FilterChain *chain, int delay_ms, int directions);
+bool filter_chain_add_drop(FilterChain *chain, float drop_rate, int directions);
+bool filter_chain_add_throttle(FilterChain *chain, int bytes_per_sec, int directions);
+
+// 필터 추가/제거/활성화 (런타임 변경용)
+bool filter_chain_add(FilterChain *chain, const Filter *filter);
+bool filter_chain_remove(FilterChain *chain, int index);
+bool filter_chain_set_enabled(FilterChain *chain, int index, bool enabled);
+
+// 필터 명세 파싱 (예: "delay=100", "drop=0.1 client=10.0.0.0/8", "modify=GET/PUT dir=c2s")
+bool filter_parse_spec(const char *spec, Filter *filter, char *err, size_t err_len);
+
+// 선택자 옵션 하나 파싱 (client=, ports=, conn=, pid=, percent=, listener=) - 선택자 키가 아니면 *handled = false
+bool filter_parse_selector_option(const char *key, const char *value, FilterSelector *sel,
+                                  bool *handled, char *err, size_t err_len);
+
+// 선택자 문자열 파싱 (예: "client=10.0.0.0/8 percent=10", NULL/빈 문자열/"all" = 모든 연결)
+bool filter_parse_selector(const char *text, FilterSelector *sel, char *err, size_t err_len);
+
+// 선택자 평가 (연결 필드 기준, 제어 서버의 일괄 종료/시그널도 사용)
+bool filter_selector_match(const FilterSelector *sel, uint64_t conn_id, pid_t pid,
+                           const char *client_addr, int client_port, const char *listener);
+
+// 바이트 수 파싱 (K/M/G 접미사는 1024 단위)
+bool filter_parse_byte_count(const char *value, uint64_t *out);
+
+// 방향 이름 파싱 ("c2s", "s2c", "both") - 실패 시 0
+int filter_parse_direction(const char *name);
+
+// 연결과 방향에 해당하는 필터만 골라 체인 생성 (청크당 비용이 규칙 수와 무관하도록)
+void filter_chain_compile(const FilterChain *table, const Connection *conn, int direction,
+                          FilterChain *out);
+
+// 방향별 필터 경로 초기화/해제 (seed는 이 방향 난수 생성기의 시드)
+void filter_path_init(FilterPath *path, uint64_t seed);
+void filter_path_free(FilterPath *path);
+
+// 체인을 다시 컴파일하고 수정 규칙 매처를 생성 (보류 바이트는 먼저 filter_path_flush로 비울 것)
+void filter_path_compile(const FilterChain *table, const Connection *conn, int direction,
+                         FilterPath *path);
+
+// 수정 필터가 보류 중인 바이트 수 / 보류 바이트를 그대로 꺼냄 (out은 FILTER_HEADROOM 이상)
+int filter_path_pending(const FilterPath *path);
+int filter_path_flush(FilterPath *path, char *out);
+
+// 필터 적용 (*data 앞에 FILTER_HEADROOM 바이트 여유 필요)
+// 수정 필터가 있으면 *data와 *length가 지금 내보낼 구간으로 바뀌며 0이 될 수 있다.
+// 통과한 청크를 언제 어떻게 보낼지는 plan에 채운다 (지연도 여기서 잠들지 않음).
+FilterVerdict filter_apply(FilterPath *path, char **data, int *length, ConnectionStats *stats,
+                           FilterPlan *plan);
 
-// 필터 적용
-bool filter_apply(FilterChain *chain, const char *data, int length, ConnectionStats *stats);
+// 데이터그램 하나에 필터 적용 (UDP 모드)
+// path는 여러 세션이 함께 쓰는 방향별 경로이고 ctx->mask에 켜진 필터만 이 세션에 적용한다.
+// 난수는 path가 아니라 ctx->rng에서 뽑는다 (상관 지연의 직전 값은 경로에 있어 세션끼리 이어짐).
+// 드롭/지연/쓰로틀/복제만 동작하고 스트림 고장(수정/리셋/정지/분할/반쪽 닫기/순서 바꾸기/오류 응답)은
+// 건너뛴다. 지연은 plan->hold_us, 쓰로틀 전송 시간은 plan->throttle_us로 따로 돌려준다.
+FilterVerdict filter_apply_datagram(FilterPath *path, const DatagramContext *ctx,
+                                    const char *data, int length, FilterPlan *plan);
 
 // 필터 정보 출력
 void filter_chain_print(const FilterChain *chain);
@@ -0,0 +1,109 @@
+#ifndef FLIGHT_H
+#define FLIGHT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/types.h>
+
+// 플라이트 레코더 설정
+#define FLIGHT_RING_SIZE 64      // 연결당 보관 이벤트 수 (2의 거듭제곱)
+#define FLIGHT_SLOTS 128         // 링 슬롯 수 (종료된 연결 보관분 포함)
+#define FLIGHT_GRACE_SEC 300     // 종료 후 링 보관 시간 (초)
+
+// 이벤트 타입
+typedef enum {
+    FLIGHT_OPEN = 1,             // 연결 시작
+    FLIGHT_RECV,                 // 수신 (value = 바이트)
+    FLIGHT_SEND,                 // 전송 완료 (value = 바이트)
+    FLIGHT_FILTER_PASS,          // 필터 통과 (value = 필터 소요 tick)
+    FLIGHT_FILTER_DROP,          // 필터 드롭 (value = 필터 소요 tick)
+    FLIGHT_EAGAIN,               // 전송 재시도 (value = errno)
+    FLIGHT_TIMEOUT,              // 유휴 타임아웃
+    FLIGHT_CLOSE,                // 연결 종료
+    FLIGHT_RESET,                // 리셋 필터로 RST 전송
+    FLIGHT_HALF_CLOSE,           // 반쪽 닫기 필터로 FIN 전송 (value = 유지 시간 ms)
+    FLIGHT_QUERY,                // 쿼리 응답 시작 (value = 서버 응답 시간 us)
+    FLIGHT_QUERY_ERROR           // 쿼리 대신 오류 응답 주입 (value = 오류 번호)
+} FlightEventType;
+
+// 이벤트 방향
+#define FLIGHT_DIR_NONE 0
+#define FLIGHT_DIR_C2S  1        // 클라이언트 -> 서버
+#define FLIGHT_DIR_S2C  2        // 서버 -> 클라이언트
+
+// 이벤트 (16 bytes)
+typedef struct {
+    uint64_t ticks;              // 타임스탬프 (flight_now() 단위)
+    uint32_t value;              // 이벤트별 값
+    uint8_t type;                // FlightEventType
+    uint8_t dir;                 // FLIGHT_DIR_*
+    uint16_t reserved;
+} FlightEvent;
+
+// 연결별 링 (공유 메모리, 쓰기는 해당 자식 프로세스만)
+typedef struct FlightRing {
+    uint32_t state;              // 슬롯 상태 (flight.c 참고)
+    pid_t pid;
+    uint64_t conn_id;
+    time_t closed_at;            // 종료 시각 (활성 중이면 0)
+    uint32_t head;               // 지금까지 기록된 이벤트 수
+    FlightEvent events[FLIGHT_RING_SIZE];
+} FlightRing;
+
+// 제어 응답용 링 스냅샷 (오래된 이벤트 -> 최근 이벤트 순)
+typedef struct {
+    bool found;
+    pid_t pid;
+    uint64_t conn_id;
+    time_t closed_at;            // 0이면 활성 연결
+    uint32_t total_events;       // 링에 기록된 전체 이벤트 수
+    int event_count;             // events[]에 담긴 수
+    double ticks_per_us;         // 타임스탬프 변환 비율
+    FlightEvent events[FLIGHT_RING_SIZE];
+} FlightDump;
+
+// 타임스탬프: x86에서는 TSC(수 ns), 그 외에는 단조 시계(ns)
+static inline uint64_t flight_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+// 이벤트 기록 (락 없음, 단일 작성자)
+static inline void flight_record(FlightRing *ring, uint8_t type, uint8_t dir, uint32_t value) {
+    if (ring == NULL) return;
+
+    uint32_t head = ring->head;
+    FlightEvent *ev = &ring->events[head & (FLIGHT_RING_SIZE - 1)];
+    ev->ticks = flight_now();
+    ev->value = value;
+    ev->type = type;
+    ev->dir = dir;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// 레코더 공유 메모리 생성 (fork 전에 부모가 호출)
+bool flight_init(void);
+
+// 레코더 정리
+void flight_cleanup(void);
+
+// 연결용 링 할당 (없으면 NULL, 기록은 무시됨)
+FlightRing *flight_open(pid_t pid, uint64_t conn_id);
+
+// 연결 종료 표시 (FLIGHT_GRACE_SEC 동안 보관)
+void flight_close(FlightRing *ring);
+
+// 회수한 자식의 링이 아직 활성이면 종료로 표시 (SIGKILL 등으로 flight_close 없이 끝난 연결)
+// 부모의 SIGCHLD 핸들러에서 호출 (시그널 안전)
+void flight_reap(pid_t pid);
+
+// PID 또는 연결 ID로 링 스냅샷 (conn_id가 0이면 PID로 검색)
+bool flight_snapshot(pid_t pid, uint64_t conn_id, FlightDump *dump);
+
+#endif // FLIGHT_H
@@ -0,0 +1,103 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// HTTP/1.1 인식 모드
+//
+// 시작 줄과 헤더는 줄 단위로 그 자리에서 읽고 (청크 경계에 걸친 줄만 HTTP_LINE_MAX까지 모음),
+// 본문은 Content-Length나 chunked 크기만큼 건너뛰므로 본문 바이트는 복사하지 않는다.
+// keep-alive 파이프라이닝은 요청마다 응답을 기다리는 FIFO로 맞춘다. 요청의 마지막 바이트를
+// 서버로 보낸 시각부터 그 응답 첫 바이트까지가 요청의 서버 응답 시간이다.
+// 첫 요청 줄이 HTTP가 아니거나, 업그레이드(101)/CONNECT 이후에는 해석하지 않고 그대로 중계한다.
+
+#define HTTP_LINE_MAX 128          // 청크 경계에 걸친 줄을 모으는 최대 길이 (넘는 부분은 버림)
+#define HTTP_PIPELINE_MAX 32       // 응답을 기다리는 요청 최대 수 (넘으면 해석 중단)
+#define HTTP_ERROR_RESPONSE_MAX 160 // 주입하는 오류 응답 하나의 최대 크기
+
+typedef enum {
+    HTTP_START_LINE = 0,          // 요청 줄/상태 줄
+    HTTP_HEADERS,
+    HTTP_BODY,                    // Content-Length 본문
+    HTTP_CHUNK_SIZE,              // chunked 크기 줄
+    HTTP_CHUNK_DATA,
+    HTTP_CHUNK_END,               // 조각 뒤 CRLF
+    HTTP_TRAILERS,
+    HTTP_UNTIL_CLOSE              // 연결이 끝날 때까지 본문 (길이 없는 응답)
+} HttpState;
+
+// 한 방향의 메시지 경계 추적
+typedef struct {
+    HttpState state;
+    char line[HTTP_LINE_MAX];     // 청크 경계에 걸친 줄
+    int line_len;
+    bool in_message;              // 메시지 첫 바이트를 받음
+    uint64_t remaining;           // 본문/조각의 남은 바이트
+    int64_t content_length;       // -1 = 없음
+    bool chunked;
+    int status;                   // 응답: 상태 코드
+    bool head;                    // 응답: HEAD 요청에 대한 응답 (본문 없음)
+    bool discard;                 // 드롭/오류 주입한 메시지의 나머지를 버리는 중
+} HttpStream;
+
+// 응답을 기다리는 요청
+typedef struct {
+    uint64_t sent_us;             // 마지막 바이트를 서버로 보낸 시각 (0 = 아직 보내지 않음)
+    bool head;
+} HttpPending;
+
+// 연결별 세션 (자식 프로세스 전용)
+typedef struct HttpSession {
+    HttpStream client;            // 클라이언트 → 서버
+    HttpStream server;            // 서버 → 클라이언트
+    bool passthrough;             // HTTP가 아니거나 업그레이드 이후 해석 중단
+    bool request_seen;            // 첫 요청 줄을 확인함
+    bool request_head;            // 진행 중인 요청이 HEAD
+    bool request_connect;         // 진행 중인 요청이 CONNECT
+    HttpPending pending[HTTP_PIPELINE_MAX];
+    int pending_head;             // FIFO 시작 위치
+    int pending_count;
+    int unsent;                   // FIFO 끝에서 아직 서버로 보내지 않은 요청 수
+    int chunk_requests;           // 마지막 클라이언트 청크에서 시작한 요청 수
+    uint64_t response_start_us;   // 진행 중인 응답의 첫 바이트 수신 시각
+    QueryStats stats;             // 공유 통계에 아직 반영하지 않은 값
+} HttpSession;
+
+// 청크 해석 결과
+typedef struct {
+    int start;                    // 이 청크에서 처음 시작한 메시지 위치 (-1 = 없음)
+    const char *line;             // 그 메시지의 시작 줄 (청크 안에 있는 부분만, 요청만)
+    int line_len;
+    bool can_reply;               // 청크가 요청 경계에서 시작하고 기다리는 응답이 없음 (오류 주입 가능)
+} HttpScan;
+
+// 세션 생성/해제
+HttpSession *http_session_create(void);
+void http_session_free(HttpSession *session);
+
+// 이 방향에서 한 번에 읽을 최대 바이트 (본문 끝에서 청크를 끊어 다음 메시지가 새 청크에서
+// 시작하도록, 제한이 없으면 0)
+int http_recv_limit(const HttpSession *session, uint8_t dir);
+
+// 클라이언트 청크 해석 (필터 적용 전, 수신한 그대로). 앞에서 버릴 바이트 수를 반환
+// (드롭/오류 주입한 요청의 나머지).
+int http_client_data(HttpSession *session, const char *data, int length, HttpScan *scan);
+
+// 클라이언트 청크를 서버로 보낸 뒤 호출 (끝난 요청이 있으면 응답 시간 측정 시작)
+void http_client_sent(HttpSession *session, uint64_t now_us);
+
+// 서버 청크 해석. 앞에서 버릴 바이트 수를 반환하고, 응답이 시작되면 *latency_us에 마지막
+// 응답의 서버 응답 시간을 넣는다 (없으면 -1).
+int http_server_data(HttpSession *session, const char *data, int length, uint64_t now_us,
+                     HttpScan *scan, int64_t *latency_us);
+
+// 방금 해석한 청크를 드롭함: 이 청크에서 끝나지 않은 메시지의 나머지도 버린다
+void http_drop_message(HttpSession *session, uint8_t dir);
+
+// 방금 해석한 청크의 요청들 대신 클라이언트에 보낼 오류 응답 생성
+// (요청마다 하나씩, out은 HTTP_ERROR_RESPONSE_MAX * HTTP_PIPELINE_MAX 이상). 길이를 반환.
+int http_inject_error(HttpSession *session, int status, char *out);
+
+#endif // HTTP_H
@@ -0,0 +1,64 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "types.h"
+
+// 지연 히스토그램 구간 (0과 1us는 0번 구간, 이후 log2)
+static inline int latency_bucket(uint64_t us) {
+    if (us < 2) {
+        return 0;
+    }
+    int bucket = 63 - __builtin_clzll(us);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// 응답 하나 기록
+static inline void latency_record(QueryStats *stats, uint64_t us, bool error) {
+    stats->count++;
+    stats->sum_us += us;
+    if (us > stats->max_us) {
+        stats->max_us = us;
+    }
+    if (error) {
+        stats->errors++;
+    }
+    stats->buckets[latency_bucket(us)]++;
+}
+
+// 누적 (dst += src)
+static inline void latency_merge(QueryStats *dst, const QueryStats *src) {
+    dst->count += src->count;
+    dst->errors += src->errors;
+    dst->injected += src->injected;
+    dst->sum_us += src->sum_us;
+    if (src->max_us > dst->max_us) {
+        dst->max_us = src->max_us;
+    }
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        dst->buckets[i] += src->buckets[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        dst->status[i] += src->status[i];
+    }
+}
+
+// 백분위 (해당 구간의 상한, 구간 폭 안에서만 정확)
+static inline uint64_t latency_percentile(const QueryStats *stats, double percent) {
+    if (stats->count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(stats->count * percent / 100.0 + 0.5);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += stats->buckets[i];
+        if (seen >= rank) {
+            uint64_t upper = (2ULL << i) - 1;
+            return upper < stats->max_us ? upper : stats->max_us;
+        }
+    }
+    return stats->max_us;
+}
+
+#endif // LATENCY_H
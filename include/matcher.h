@@ -0,0 +1,52 @@
+#ifndef MATCHER_H
+#define MATCHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 다중 패턴 매칭 및 치환 (Aho-Corasick DFA + 첫 바이트 SIMD 사전 필터)
+//
+// 스트림 단위로 동작: 청크 끝에서 패턴 접두사가 진행 중이면 그 바이트를 보류했다가
+// 다음 청크 앞에 붙여 이어서 검사하므로 recv 경계에 걸친 패턴도 치환된다.
+
+// 매칭 시 동작
+typedef enum {
+    MATCH_REPLACE = 0,           // 같은 길이의 바이트로 치환
+    MATCH_FLIP,                  // 모든 비트 반전
+    MATCH_ZERO,                  // 0으로 채움
+    MATCH_DETECT                 // 검출만 (matcher_scan용)
+} MatchAction;
+
+#define MATCHER_MAX_PATTERN_LEN 32   // 패턴 최대 길이 (= 최대 보류 바이트)
+#define MATCHER_MAX_PATTERNS 128
+
+typedef struct Matcher Matcher;
+
+// 매처 생성/해제
+Matcher *matcher_create(void);
+void matcher_free(Matcher *matcher);
+
+// 패턴 추가 (tag는 매칭 횟수를 집계할 슬롯, replacement는 MATCH_REPLACE일 때만 사용)
+bool matcher_add(Matcher *matcher, const uint8_t *pattern, int len,
+                 MatchAction action, const uint8_t *replacement, int tag);
+
+// 패턴 추가가 끝난 뒤 DFA 생성
+bool matcher_build(Matcher *matcher);
+
+// 청크 처리 (제자리 치환)
+// *data 앞에 MATCHER_MAX_PATTERN_LEN 바이트의 여유 공간이 있어야 한다 (보류 바이트를 붙임).
+// 처리 후 *data와 *length는 지금 내보낼 구간을 가리키며, 끝의 미완성 접두사는 보류된다.
+// hits[tag]에 매칭 횟수를 더한다 (NULL 가능). 치환한 패턴 수를 반환.
+int matcher_process(Matcher *matcher, uint8_t **data, int *length, uint64_t *hits);
+
+// 검출 전용 청크 처리 (데이터를 바꾸거나 보류하지 않고 DFA 상태만 이어감)
+// 청크 경계에 걸친 패턴은 끝나는 청크에서 집계된다. 찾은 패턴 수를 반환.
+int matcher_scan(Matcher *matcher, const uint8_t *data, int length, uint64_t *hits);
+
+// 보류 중인 바이트 수
+int matcher_pending(const Matcher *matcher);
+
+// 보류 바이트를 그대로 내보내고 상태 초기화 (out은 MATCHER_MAX_PATTERN_LEN 이상)
+int matcher_flush(Matcher *matcher, uint8_t *out);
+
+#endif // MATCHER_H
@@ -0,0 +1,61 @@
+#ifndef MIRROR_H
+#define MIRROR_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 섀도 미러링
+//
+// 선택한 연결에서 서버로 보낸 바이트(필터 적용 후)를 섀도 백엔드에도 보내고, 섀도의 응답은 읽어서
+// 버린다. 섀도 소켓은 논블로킹이고 연결별 큐는 크기가 정해져 있어 주 경로는 섀도를 기다리지 않는다.
+// 큐가 넘치면 섀도 쪽 스트림은 이미 어긋났으므로 그 연결의 미러링을 끊고 이후 바이트는 버린 것으로
+// 센다. 카운터는 fork 전에 만든 공유 메모리에 있어 proxyctl mirror로 조회한다.
+
+#define MIRROR_QUEUE_SIZE (256 * 1024)  // 연결별 미러 큐 크기 (바이트)
+#define MIRROR_DRAIN_MS 200             // 연결이 끝난 뒤 남은 큐를 섀도로 보낼 최대 시간
+
+// 미러링 상태 (제어 응답용)
+typedef struct {
+    bool enabled;
+    char host[MAX_HOST_LEN];
+    int port;
+    char selector[MAX_FILTER_SPEC_LEN];  // 비어 있으면 모든 연결
+    uint64_t sessions;                // 미러링을 시작한 연결 수
+    uint64_t connect_failed;          // 섀도 연결 실패
+    uint64_t overflowed;              // 큐가 넘쳐 미러링을 끊은 연결
+    uint64_t bytes;                   // 섀도로 보낸 바이트
+    uint64_t dropped_bytes;           // 보내지 못하고 버린 바이트 (연결 실패/큐 넘침 이후 포함)
+    uint64_t discarded_bytes;         // 읽고 버린 섀도 응답 바이트
+} MirrorStatus;
+
+struct MirrorFlow;
+
+// 미러링 시작 (부모가 fork 전에 호출: 섀도 주소 해석, 공유 카운터 생성)
+// selector는 필터 선택자 문법 (예: "percent=10", NULL/빈 문자열 = 모든 연결)
+bool mirror_start(const char *host, int port, const char *selector);
+
+// 미러링 종료 (부모)
+void mirror_stop(void);
+
+// 연결 미러링 시작 (자식, 논블로킹 연결. 선택자에 맞지 않거나 꺼져 있으면 NULL)
+struct MirrorFlow *mirror_open(const Connection *conn);
+
+// 서버로 보낸 바이트를 섀도에도 보냄 (보낼 수 없는 만큼 큐에 쌓고, 넘치면 미러링 중단)
+void mirror_data(struct MirrorFlow *flow, const char *data, size_t length);
+
+// 중계 루프가 기다릴 섀도 소켓 (-1 = 없음)과 쓰기 대기 여부
+int mirror_fd(const struct MirrorFlow *flow);
+bool mirror_wants_write(const struct MirrorFlow *flow);
+
+// 섀도 소켓 이벤트 처리 (연결 완료 확인, 큐 전송, 응답 읽고 버리기)
+void mirror_poll(struct MirrorFlow *flow, bool readable, bool writable);
+
+// 연결 미러링 끝 (남은 큐를 MIRROR_DRAIN_MS까지 보내고 닫음)
+void mirror_close(struct MirrorFlow *flow);
+
+// 미러링 상태 조회 (부모의 제어 스레드)
+void mirror_get_status(MirrorStatus *status);
+
+#endif // MIRROR_H
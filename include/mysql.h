@@ -0,0 +1,68 @@
+#ifndef MYSQL_H
+#define MYSQL_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// MySQL 프로토콜 인식 모드
+//
+// 패킷 헤더(3바이트 길이 + 1바이트 sequence id)만 읽고 payload는 길이만큼 건너뛰므로
+// 복사 없이 청크당 패킷 수에 비례하는 비용으로 명령 경계를 찾는다. 명령 단계에서 클라이언트가
+// 보내는 sequence 0 패킷이 명령이고, 그에 대한 서버의 첫 패킷까지가 쿼리의 서버 응답 시간이다.
+// TLS(CLIENT_SSL)나 압축(CLIENT_COMPRESS)을 협상하면 이후는 해석하지 않고 그대로 중계한다.
+
+#define MYSQL_HEADER_LEN 4
+#define MYSQL_COM_QUERY 0x03
+#define MYSQL_COM_STMT_EXECUTE 0x17
+#define MYSQL_ERR_PACKET 0xFF
+#define MYSQL_CLIENT_COMPRESS 0x00000020
+#define MYSQL_CLIENT_SSL 0x00000800
+#define MYSQL_ERROR_PACKET_MAX 128   // 주입하는 ERR 패킷 최대 크기
+
+// 한 방향의 패킷 경계 추적
+typedef struct {
+    uint8_t header[MYSQL_HEADER_LEN];
+    int header_len;               // 모은 헤더 바이트 (청크 경계에 걸친 경우)
+    uint32_t remaining;           // 현재 패킷의 남은 payload
+    bool at_payload;              // 다음 바이트가 payload 첫 바이트
+    uint8_t seq;                  // 현재 패킷 sequence id
+    uint32_t length;              // 현재 패킷 payload 길이
+} MysqlStream;
+
+// 연결별 세션 (자식 프로세스 전용)
+typedef struct MysqlSession {
+    MysqlStream client;           // 클라이언트 → 서버
+    MysqlStream server;           // 서버 → 클라이언트
+    bool passthrough;             // TLS/압축 협상으로 해석 중단
+    bool login_seen;              // 로그인 패킷의 capability 확인함
+    bool query_open;              // 쿼리 패킷이 아직 끝나지 않음
+    bool query_received;          // 쿼리 패킷을 다 받음 (서버로 보낸 시각 기록 대기)
+    bool awaiting_response;       // 쿼리를 보냈고 응답 첫 패킷 대기
+    uint64_t sent_us;             // 쿼리 마지막 청크를 서버로 보낸 시각
+    uint32_t discard;             // 오류를 주입한 명령의 남은 payload (서버로 보내지 않음)
+    QueryStats stats;             // 공유 통계에 아직 반영하지 않은 값
+} MysqlSession;
+
+// 세션 생성/해제
+MysqlSession *mysql_session_create(void);
+void mysql_session_free(MysqlSession *session);
+
+// 클라이언트 청크 해석 (필터 적용 전, 수신한 그대로)
+// 청크에서 쿼리(COM_QUERY/COM_STMT_EXECUTE)가 시작하면 *query/*query_len에 본문을 가리킨다
+// (청크 안에 있는 부분만, COM_STMT_EXECUTE는 길이 0). 앞에서 버릴 바이트 수를 반환
+// (오류를 주입한 명령의 나머지).
+int mysql_client_data(MysqlSession *session, const char *data, int length,
+                      const char **query, int *query_len);
+
+// 클라이언트 청크를 서버로 보낸 뒤 호출 (끝난 쿼리가 있으면 응답 시간 측정 시작)
+void mysql_client_sent(MysqlSession *session, uint64_t now_us);
+
+// 서버 청크 해석, 쿼리 응답이 시작되면 서버 응답 시간(마이크로초)을 반환 (없으면 -1)
+int64_t mysql_server_data(MysqlSession *session, const char *data, int length, uint64_t now_us);
+
+// 진행 중인 쿼리 대신 클라이언트에 보낼 ERR 패킷 생성 (out은 MYSQL_ERROR_PACKET_MAX 이상)
+// 쿼리의 나머지 바이트는 이후 mysql_client_data가 버리도록 표시한다. 패킷 길이를 반환.
+int mysql_inject_error(MysqlSession *session, int code, uint8_t *out);
+
+#endif // MYSQL_H
@@ -0,0 +1,32 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+// USDT 정적 트레이스포인트 (provider: tcp_proxy)
+//
+// <sys/sdt.h>(systemtap-sdt-dev)가 있으면 각 프로브는 nop 명령 하나와
+// ELF 노트로 컴파일되고, bpftrace/perf가 연결할 때만 활성화됩니다.
+// 헤더가 없거나 NO_USDT로 빌드하면 아무 코드도 생성하지 않습니다.
+// 프로브 목록과 인자는 scripts/bpftrace/README.md 참고.
+
+#if !defined(NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PROXY_USDT_ENABLED 1
+#endif
+#endif
+
+#ifdef PROXY_USDT_ENABLED
+#define PROBE0(name)                   DTRACE_PROBE(tcp_proxy, name)
+#define PROBE1(name, a)                DTRACE_PROBE1(tcp_proxy, name, a)
+#define PROBE2(name, a, b)             DTRACE_PROBE2(tcp_proxy, name, a, b)
+#define PROBE3(name, a, b, c)          DTRACE_PROBE3(tcp_proxy, name, a, b, c)
+#define PROBE4(name, a, b, c, d)       DTRACE_PROBE4(tcp_proxy, name, a, b, c, d)
+#else
+#define PROBE0(name)                   do { } while (0)
+#define PROBE1(name, a)                do { (void)(a); } while (0)
+#define PROBE2(name, a, b)             do { (void)(a); (void)(b); } while (0)
+#define PROBE3(name, a, b, c)          do { (void)(a); (void)(b); (void)(c); } while (0)
+#define PROBE4(name, a, b, c, d)       do { (void)(a); (void)(b); (void)(c); (void)(d); } while (0)
+#endif
+
+#endif // PROBES_H
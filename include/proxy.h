@@ -7,6 +7,9 @@
 // 프록시 서버 시작
 int proxy_start(const ProxyConfig *config, FilterChain *filter_chain);
 
+// 리스닝 유닉스 소켓 파일 정리 (부모 종료 시, 시그널 핸들러에서 불러도 안전)
+void proxy_stop(void);
+
 // 클라이언트 연결 처리
 void proxy_handle_connection(Connection *conn);
 
@@ -0,0 +1,45 @@
+#ifndef PROXYPROTO_H
+#define PROXYPROTO_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// PROXY 프로토콜 (HAProxy v1 텍스트 / v2 바이너리)
+//
+// 받는 쪽: L4 로드밸런서가 연결 앞에 붙인 헤더를 MSG_PEEK로 엿보아 해석한 뒤 헤더 길이만큼만
+// 읽어 버리므로 뒤따르는 클라이언트 데이터는 소켓에 그대로 남는다. 보내는 쪽: 대상 서버에 연결한
+// 직후 실제 클라이언트 주소를 담은 v2 헤더를 먼저 쓴다. 둘 다 스택 버퍼만 쓴다 (힙 할당 없음).
+
+#define PROXY_V1_MAX 107             // v1 헤더 최대 길이 (CRLF 포함)
+#define PROXY_V2_HEADER_LEN 16       // v2 고정 헤더 (서명 12 + 버전/명령 + 주소 종류 + 길이 2)
+#define PROXY_V2_ADDR_MAX 216        // v2 주소 블록 최대 (AF_UNIX 두 경로)
+#define PROXY_V2_MAX (PROXY_V2_HEADER_LEN + 36)  // 보내는 v2 헤더 최대 (IPv6)
+#define PROXY_HEADER_TIMEOUT_MS 5000 // 헤더를 기다리는 최대 시간
+
+// 해석한 헤더
+typedef struct {
+    int version;                  // 1 또는 2
+    int family;                   // AF_INET, AF_INET6, AF_UNSPEC (LOCAL/UNKNOWN: 소켓 주소 사용)
+    char src_addr[MAX_ADDR_LEN];  // 실제 클라이언트
+    int src_port;
+    char dst_addr[MAX_ADDR_LEN];  // 로드밸런서가 받은 대상 주소
+    int dst_port;
+} ProxyHeader;
+
+// 버퍼 앞의 헤더 해석: 헤더 전체 길이 (> 0), 0 = 데이터가 더 필요함, -1 = PROXY 헤더가 아님
+int proxyproto_parse(const uint8_t *data, int length, ProxyHeader *header);
+
+// 소켓에서 헤더를 읽음 (헤더 바이트만 소비). 헤더가 없거나 잘못되었거나 시간이 지나면 false
+bool proxyproto_read(int fd, int timeout_ms, ProxyHeader *header);
+
+// v2 PROXY 헤더 생성 (주소를 해석할 수 없으면 LOCAL 명령). 길이를 반환 (out은 PROXY_V2_MAX 이상)
+int proxyproto_build_v2(const char *src_addr, int src_port, const char *dst_addr, int dst_port,
+                        uint8_t *out);
+
+// 대상 서버 소켓에 v2 헤더 전송. 원래 대상 주소는 header에 있으면 그것을, 없으면 클라이언트
+// 소켓의 로컬 주소를 쓴다.
+bool proxyproto_send_v2(int server_fd, int client_fd, const ProxyHeader *header,
+                        const char *client_addr, int client_port);
+
+#endif // PROXYPROTO_H
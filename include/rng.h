@@ -0,0 +1,58 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// 연결별 고속 의사난수 생성기 (xoshiro256**)
+// 전역 rand()와 달리 상태를 연결/방향마다 따로 가지므로 락이 필요 없고,
+// 같은 시드에서 항상 같은 수열을 만든다.
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+// splitmix64 (시드 확장용)
+static inline uint64_t rng_splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// 마스터 시드와 스트림 번호(연결 ID 등)로 독립적인 하위 시드 생성
+static inline uint64_t rng_derive_seed(uint64_t master, uint64_t stream) {
+    uint64_t x = master ^ (stream * 0xD1B54A32D192ED03ULL);
+    rng_splitmix64(&x);
+    return rng_splitmix64(&x);
+}
+
+static inline void rng_seed(Rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = rng_splitmix64(&seed);
+    }
+}
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+
+    return result;
+}
+
+// [0, 1) 균등 분포 (53비트)
+static inline double rng_uniform(Rng *rng) {
+    return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+#endif // RNG_H
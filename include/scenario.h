@@ -0,0 +1,42 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "types.h"
+#include "control.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// 고장 시나리오 (시각별 필터 테이블 변경 목록)
+//
+// 파일 형식 (한 줄에 한 단계, # 주석, 시각은 시나리오 시작 기준이며 줄어들 수 없음):
+//   0s    nothing
+//   30s   add delay=200 percent=20
+//   60s   add drop=0.05
+//   90s   clear
+// 시각 단위: ms, s(기본), m. 앞에 "t="를 붙여도 된다.
+// 동작: add <명세>, remove|enable|disable <인덱스>, clear, nothing
+
+#define MAX_SCENARIO_STEPS 64
+
+// 시나리오 단계 (같은 시각의 단계들은 제어 스레드가 한 번에 게시)
+typedef struct {
+    uint64_t at_ms;               // 시나리오 시작 기준 시각
+    ControlCommand cmd;           // CMD_FILTER_ADD/REMOVE/ENABLE/DISABLE/CLEAR (CMD_FILTER_LIST = 없음)
+    int index;                    // remove/enable/disable 대상
+    char spec[MAX_FILTER_SPEC_LEN]; // add 명세
+    int line;                     // 파일 줄 번호
+} ScenarioStep;
+
+typedef struct {
+    char path[MAX_PATH_LEN];
+    ScenarioStep steps[MAX_SCENARIO_STEPS];
+    int count;
+} Scenario;
+
+// 시나리오 파일 읽기 (add 명세는 여기서 미리 검증)
+bool scenario_load(const char *path, Scenario *scenario, char *err, size_t err_len);
+
+// 단계 설명 (예: "30s add delay=200 percent=20")
+void scenario_step_describe(const ScenarioStep *step, char *buf, size_t size);
+
+#endif // SCENARIO_H
@@ -0,0 +1,10 @@
+#ifndef TCPINFO_H
+#define TCPINFO_H
+
+#include "types.h"
+#include <stdbool.h>
+
+// 소켓의 커널 TCP 상태(TCP_INFO)를 샘플링
+bool tcpinfo_sample(int sockfd, TcpInfoSample *sample);
+
+#endif // TCPINFO_H
@@ -0,0 +1,33 @@
+#ifndef TLS_H
+#define TLS_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// TLS SNI 라우팅 (TLS를 종료하지 않음)
+//
+// 클라이언트의 첫 바이트를 MSG_PEEK로 엿보아 ClientHello의 server_name 확장만 읽는다.
+// 엿본 바이트는 커널 수신 버퍼에 그대로 남으므로 대상 서버에 연결한 뒤 일반 중계가 ClientHello를
+// 포함한 스트림을 손대지 않고 전달한다. ClientHello가 여러 레코드에 나뉘어 오거나 한 번에 다
+// 도착하지 않으면 SO_RCVLOWAT로 더 올 때까지 기다렸다가 처음부터 다시 엿본다.
+
+#define TLS_PEEK_MAX 16384           // 엿볼 최대 바이트 (ClientHello가 이보다 크면 SNI 없음으로 처리)
+#define TLS_PEEK_TIMEOUT_MS 5000     // ClientHello를 기다리는 최대 시간
+
+// 버퍼의 ClientHello에서 SNI 추출 (소문자로 sni에 복사)
+// 1 = 찾음, 0 = TLS가 아니거나 SNI 없음, -1 = 데이터가 더 필요함
+int tls_parse_client_hello(const uint8_t *data, int length, char *sni, size_t size);
+
+// 소켓의 첫 ClientHello를 엿보아 SNI 추출 (소켓에서 바이트를 소비하지 않음)
+// 1 = 찾음, 0 = SNI 없음/시간 초과, -1 = 클라이언트가 아무것도 보내지 않고 닫음/오류
+int tls_peek_sni(int fd, int timeout_ms, char *sni, size_t size);
+
+// 라우팅 규칙 파싱 ("<패턴>=<host:port>", 예: "*.example.com=10.0.0.5:443")
+bool tls_parse_route(const char *spec, SniRoute *route, char *err, size_t err_len);
+
+// SNI에 맞는 첫 규칙 (sni가 비었거나 맞는 규칙이 없으면 NULL)
+const SniRoute *tls_route_match(const SniRoute *routes, int count, const char *sni);
+
+#endif // TLS_H
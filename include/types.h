@@ -5,24 +5,78 @@
 #include <stdbool.h>
 #include <time.h>
 #include <sys/types.h>
+#include "rng.h"
 
 // 상수 정의
 #define MAX_HOST_LEN 256
 #define MAX_PATH_LEN 256
 #define MAX_ADDR_LEN 64
+#define MAX_SNI_LEN 128           // TLS SNI 호스트 이름 최대 길이 (NUL 포함)
+#define MAX_SNI_ROUTES 32         // SNI 라우팅 규칙 최대 수
+#define MAX_LISTENERS 32          // 한 프로세스의 리스너 최대 수 (설정 파일 [이름] 구역)
+#define MAX_LISTENER_NAME 32      // 리스너 이름 최대 길이 (NUL 포함)
+#define MAX_FILTER_SPEC_LEN 128   // 필터 명세 문자열 최대 길이
 #define BUFFER_SIZE 8192
+#define SPLICE_PIPE_SIZE (256 * 1024) // 제로 카피 중계(splice) 파이프 크기 (적용할 필터가 없는 방향)
 #define SELECT_TIMEOUT_SEC 60
 #define MAX_LISTEN_BACKLOG 10
+#define UNIX_PREFIX "unix:"       // 유닉스 도메인 소켓 주소 표기 ("unix:/run/mysqld/mysqld.sock")
+#define TCP_INFO_SAMPLE_SEC 1     // TCP_INFO 샘플링 주기 (초)
+#define RATE_UPDATE_MS 250        // 처리량 EWMA 갱신 최소 간격 (밀리초)
+#define MODIFY_FLUSH_MS 20        // 입력이 멈추면 수정 필터 보류 바이트를 내보내는 시간 (밀리초)
+#define REORDER_WAIT_MS 100       // 순서 바꾸기로 미룬 청크가 다음 청크를 기다리는 최대 시간 (밀리초)
+#define RELAY_DRAIN_MAX_MS 5000   // 연결을 닫을 때 보류 청크의 마감을 기다리는 최대 시간 (밀리초)
 
-// 프록시 설정
+// 프로토콜 인식 모드 (청크 대신 프로토콜 단위로 필터 트리거와 지연 측정)
+typedef enum {
+    PROTOCOL_RAW = 0,             // 바이트 스트림 그대로
+    PROTOCOL_MYSQL,               // MySQL 패킷/명령 경계 인식
+    PROTOCOL_HTTP                 // HTTP/1.1 요청/응답 경계 인식
+} ProtocolMode;
+
+// SNI 라우팅 규칙 (패턴: 정확한 이름, "*.example.com", "*")
+typedef struct {
+    char pattern[MAX_SNI_LEN];
+    char host[MAX_HOST_LEN];
+    int port;
+} SniRoute;
+
+// PROXY 프로토콜 (ListenerConfig.proxy_protocol 비트)
+#define PROXY_PROTOCOL_IN  0x01   // 클라이언트 앞의 v1/v2 헤더를 해석해 실제 클라이언트 주소로 사용
+#define PROXY_PROTOCOL_OUT 0x02   // 대상 서버에 연결 직후 v2 헤더 전송
+
+// 리스너 설정 (리스닝 주소 하나와 그 대상/라우팅/프로토콜)
 typedef struct {
+    char name[MAX_LISTENER_NAME]; // 선택자(listener=)와 proxyctl에 쓰는 이름
+    char listen_host[MAX_HOST_LEN];  // 리스닝 주소 (비어 있으면 모든 주소 IPv6/IPv4 겸용, "unix:/경로"면 유닉스 소켓)
     int listen_port;              // 프록시 리스닝 포트
-    char target_host[MAX_HOST_LEN];  // 대상 서버 주소
-    int target_port;              // 대상 서버 포트
+    char target_host[MAX_HOST_LEN];  // 대상 서버 주소 ("unix:/경로"면 유닉스 소켓)
+    int target_port;              // 대상 서버 포트 (유닉스 소켓이면 0)
+    int protocol;                 // ProtocolMode
+    SniRoute sni_routes[MAX_SNI_ROUTES]; // SNI별 대상 (맞는 규칙이 없으면 target_host:target_port)
+    int sni_route_count;          // 0이면 SNI를 보지 않고 accept 직후 바로 연결
+    int proxy_protocol;           // PROXY_PROTOCOL_IN | PROXY_PROTOCOL_OUT
+} ListenerConfig;
+
+// 프록시 설정
+typedef struct {
+    ListenerConfig listener;      // 구역 밖 설정과 명령행 (구역이 없으면 유일한 리스너, 있으면 각 구역의 기본값)
+    ListenerConfig listeners[MAX_LISTENERS]; // 설정 파일 [이름] 구역
+    int listener_count;
     bool enable_logging;          // 로깅 활성화
     char log_file[MAX_PATH_LEN];  // 로그 파일 경로
     bool enable_filters;          // 필터 활성화
     char control_socket[MAX_PATH_LEN]; // 제어 소켓 경로
+    uint64_t seed;                // 난수 마스터 시드 (0이면 시작 시 생성해 로그에 남김)
+    char scenario_file[MAX_PATH_LEN]; // 시작 시 실행할 고장 시나리오 (비어 있으면 없음)
+    char capture_file[MAX_PATH_LEN]; // pcapng 캡처 파일 (비어 있으면 캡처 안 함)
+    char capture_select[MAX_FILTER_SPEC_LEN]; // 캡처할 연결 선택자 (비어 있으면 모든 연결)
+    char mirror_host[MAX_HOST_LEN];  // 섀도 백엔드 (비어 있으면 미러링 안 함)
+    int mirror_port;
+    char mirror_select[MAX_FILTER_SPEC_LEN]; // 미러링할 연결 선택자 (비어 있으면 모든 연결)
+    bool udp;                     // UDP 모드 (연결별 fork 대신 이벤트 루프 하나로 데이터그램 중계)
+    int udp_idle_sec;             // UDP 세션 유휴 만료 (초)
+    bool udp_gso;                 // UDP GSO/GRO 사용 (커널과 장치가 지원할 때)
 } ProxyConfig;
 
 // 필터 타입
@@ -31,16 +85,99 @@ typedef enum {
     FILTER_DELAY,                 // 지연 추가
     FILTER_DROP,                  // 패킷 드롭
     FILTER_THROTTLE,              // 대역폭 제한
-    FILTER_MODIFY                 // 데이터 수정
+    FILTER_MODIFY,                // 데이터 수정
+    FILTER_RESET,                 // RST로 연결 끊기 (SO_LINGER 0)
+    FILTER_STALL,                 // 연결은 열어 둔 채 이 방향 전달을 멈춤
+    FILTER_FRAGMENT,              // 작은 조각으로 나눠 쓰기 (TCP_NODELAY)
+    FILTER_HALF_CLOSE,            // 이 방향 출력만 FIN으로 닫고 연결 유지
+    FILTER_DUPLICATE,             // 청크를 두 번 전송
+    FILTER_REORDER,               // 청크를 다음 청크 뒤로 보냄
+    FILTER_MYSQL_ERROR,           // 쿼리를 서버로 보내지 않고 ERR 패킷으로 응답 (MySQL 모드)
+    FILTER_HTTP_ERROR             // 요청을 서버로 보내지 않고 오류 응답 (HTTP 모드)
 } FilterType;
 
+// 필터 선택자 조건 (flags 비트)
+#define SELECT_CLIENT_CIDR  0x01      // 클라이언트 주소 대역
+#define SELECT_CLIENT_PORT  0x02      // 클라이언트 포트 범위
+#define SELECT_CONN_ID      0x04      // 특정 연결 ID
+#define SELECT_PID          0x08      // 특정 자식 프로세스
+#define SELECT_PERCENT      0x10      // 연결 중 일정 비율
+#define SELECT_LISTENER     0x20      // 특정 리스너로 들어온 연결
+
+// 지연 분포 (jitter가 0이면 항상 고정 지연)
+typedef enum {
+    DIST_CONSTANT = 0,
+    DIST_UNIFORM,                 // delay ± jitter 균등
+    DIST_NORMAL,                  // 표준편차 jitter
+    DIST_PARETO,                  // 표준편차 jitter, 긴 오른쪽 꼬리
+    DIST_LOGNORMAL                // 표준편차 jitter, 오른쪽 치우침
+} DelayDistribution;
+
+// 필터 적용 방향 (비트 플래그)
+#define FILTER_DIR_C2S   0x01     // 클라이언트 → 서버
+#define FILTER_DIR_S2C   0x02     // 서버 → 클라이언트
+#define FILTER_DIR_BOTH  (FILTER_DIR_C2S | FILTER_DIR_S2C)
+#define FILTER_DIR_COUNT 2        // 방향별 배열 크기 (인덱스 = 방향 플래그 - 1)
+
+// 필터 적용 대상 선택자 (조건이 없으면 모든 연결, 여러 조건은 AND)
+typedef struct {
+    uint32_t flags;
+    int family;                   // AF_INET 또는 AF_INET6
+    uint8_t addr[16];             // 대역 주소 (네트워크 바이트 순서)
+    int prefix_len;               // 프리픽스 길이
+    int port_min;                 // 클라이언트 포트 범위
+    int port_max;
+    uint64_t conn_id;
+    pid_t pid;
+    float percent;                // 선택할 연결 비율 (0 ~ 100)
+    char listener[MAX_LISTENER_NAME];
+} FilterSelector;
+
+// 데이터 수정 규칙 (패턴과 같은 길이로 치환하거나 손상)
+#define MODIFY_MAX_RULES 4
+#define MODIFY_MAX_PATTERN_LEN 32
+typedef struct {
+    uint8_t len;                  // 패턴 길이
+    uint8_t action;               // MatchAction (matcher.h)
+    uint8_t pattern[MODIFY_MAX_PATTERN_LEN];
+    uint8_t replacement[MODIFY_MAX_PATTERN_LEN];
+} ModifyRule;
+
+// 트리거 조건 (flags 비트, 여러 조건은 AND)
+#define TRIGGER_MATCH    0x01     // 청크에서 패턴이 완성됨 (recv 경계에 걸친 경우 포함)
+#define TRIGGER_AFTER    0x02     // 연결 전체 전송량이 N바이트 이상
+#define TRIGGER_OFFSET   0x04     // 청크가 이 방향 스트림의 [min, max) 구간과 겹침
+#define TRIGGER_ELAPSED  0x08     // 연결 경과 시간이 [min, max) 밀리초 (max 0 = 무제한)
+#define TRIGGER_QUERY    0x10     // 청크에서 쿼리가 시작됨 (프로토콜 모드, 본문 또는 HTTP 요청 줄 접두사 비교 가능)
+
+// 필터 트리거 (조건이 없으면 모든 청크에 동작, 청크마다 평가)
+typedef struct {
+    uint32_t flags;
+    uint8_t pattern_len;
+    uint8_t pattern[MODIFY_MAX_PATTERN_LEN];
+    uint64_t after_bytes;
+    uint64_t offset_min;
+    uint64_t offset_max;
+    uint64_t elapsed_min_ms;
+    uint64_t elapsed_max_ms;
+    uint8_t query_prefix_len;     // 0 = 모든 쿼리
+    char query_prefix[MODIFY_MAX_PATTERN_LEN]; // 쿼리 본문 접두사 (대소문자 무시)
+} FilterTrigger;
+
 // 필터 규칙
 typedef struct {
     FilterType type;
     bool enabled;
+    uint32_t id;                  // 공유 테이블이 부여하는 식별자 (효과 카운터 매칭용)
+    int directions;               // 적용 방향 (FILTER_DIR_*)
+    FilterSelector selector;      // 적용 대상 (연결 시작/테이블 변경 시 한 번 평가)
+    FilterTrigger trigger;        // 동작 조건 (청크마다 평가)
     union {
         struct {
-            int delay_ms;         // 지연 시간 (밀리초)
+            int delay_ms;         // 지연 시간 (밀리초, 분포의 평균/중심)
+            int jitter_ms;        // 변동폭 (0이면 고정 지연)
+            int distribution;     // DelayDistribution
+            float correlation;    // 직전 값과의 상관 (0.0 ~ 1.0, netem과 같은 방식)
         } delay;
         struct {
             float drop_rate;      // 드롭 확률 (0.0 ~ 1.0)
@@ -48,16 +185,90 @@ typedef struct {
         struct {
             int bytes_per_sec;    // 초당 바이트 수
         } throttle;
+        struct {
+            int rule_count;
+            ModifyRule rules[MODIFY_MAX_RULES];
+        } modify;
+        struct {
+            int after_ms;         // 발동 후 RST까지 (0 = 즉시)
+        } reset;
+        struct {
+            int duration_ms;      // 전달을 멈출 시간 (0 = 연결이 끝날 때까지)
+        } stall;
+        struct {
+            int size;             // 조각 크기 (바이트)
+        } fragment;
+        struct {
+            int hold_ms;          // 반쪽 닫은 뒤 연결을 유지할 시간 (0 = 상대가 끝낼 때까지)
+        } half_close;
+        struct {
+            float rate;           // 복제/순서 바꾸기 확률 (0.0 ~ 1.0)
+        } chance;                 // FILTER_DUPLICATE, FILTER_REORDER
+        struct {
+            int code;             // MySQL 오류 번호 (예: 1213 deadlock)
+        } mysql_error;
+        struct {
+            int status;           // HTTP 응답 코드 (예: 503)
+        } http_error;
     } params;
 } Filter;
 
 // 필터 체인
-#define MAX_FILTERS 10
+#define MAX_FILTERS 32
 typedef struct {
     Filter filters[MAX_FILTERS];
     int count;
 } FilterChain;
 
+// 필터 효과 카운터 (필터별, 방향별)
+typedef struct {
+    uint64_t chunks;              // 동작한 청크 수 (트리거 조건을 만족한 청크)
+    uint64_t bytes;               // 평가한 바이트 수
+    uint64_t dropped;             // 드롭한 청크 수
+    uint64_t delay_us;            // 추가한 지연 합계 (마이크로초)
+    uint64_t modified;            // 치환/손상한 패턴 수 (복제/순서 바꾸기/분할은 해당 청크 수)
+} FilterCounters;
+
+struct Matcher;
+
+// 방향별 필터 경로 (연결별로 컴파일된 체인과 실행 상태)
+typedef struct {
+    FilterChain chain;
+    FilterCounters counters[MAX_FILTERS];   // 아직 공유 테이블에 반영하지 않은 효과
+    struct Matcher *matcher;      // 체인의 FILTER_MODIFY 규칙을 합친 매처 (없으면 NULL)
+    struct Matcher *trigger_matcher; // 체인의 match= 트리거 패턴 검출용 (없으면 NULL)
+    uint64_t offset;              // 이 방향에서 지금까지 들어온 바이트 (트리거 offset 기준)
+    uint64_t start_ms;            // 경로 생성 시각 (단조 시계, 트리거 elapsed 기준)
+    Rng rng;                      // 이 방향 전용 난수 생성기
+    double delay_last[MAX_FILTERS]; // 상관 지연용 직전 균등 난수
+    bool fired[MAX_FILTERS];      // 한 번만 동작하는 고장(리셋/정지/반쪽 닫기)의 발동 여부
+    uint64_t reset_due_ms[MAX_FILTERS]; // 리셋 필터별 예약 시각 (다시 컴파일해도 필터 ID로 이어감)
+    uint64_t reset_at_ms;         // 예약된 RST 시각 중 가장 이른 것 (단조 시계, 0 = 없음)
+    const char *query;            // 이 청크에서 시작하는 쿼리 본문 (프로토콜 모드가 설정, NULL = 없음)
+    int query_len;
+    bool per_message;             // 지연/드롭을 메시지가 시작하는 청크에만 적용 (HTTP 모드)
+    bool message_start;           // 이 청크에서 메시지(요청/응답)가 시작됨
+    int reply_type;               // 이 청크 대신 보낼 수 있는 오류 응답 필터 (0 = 없음)
+} FilterPath;
+
+// TCP_INFO 샘플 (커널이 보는 소켓 상태)
+typedef struct {
+    bool valid;                   // 샘플 유효 여부
+    uint32_t rtt_us;              // 평활 RTT (마이크로초)
+    uint32_t rttvar_us;           // RTT 편차 (마이크로초)
+    uint32_t retransmits;         // 누적 재전송 세그먼트 수
+    uint32_t snd_cwnd;            // 혼잡 윈도우 (세그먼트)
+    uint32_t unacked;             // 확인되지 않은 세그먼트 수
+    uint64_t delivery_rate;       // 전달률 (bytes/s)
+} TcpInfoSample;
+
+// 지수 가중 이동 평균 처리량 (bytes/s)
+#define RATE_WINDOWS 3            // 1초, 10초, 60초
+typedef struct {
+    float client_to_server[RATE_WINDOWS];
+    float server_to_client[RATE_WINDOWS];
+} ConnectionRates;
+
 // 연결 통계 (방향별로 구분)
 typedef struct {
     // 클라이언트 -> 서버 방향
@@ -73,19 +284,62 @@ typedef struct {
     // 시간 정보
     time_t start_time;            // 연결 시작 시간
     time_t last_activity;         // 마지막 활동 시간
+
+    // 커널 TCP 상태 (주기적으로 샘플링)
+    TcpInfoSample client_tcp;     // 클라이언트 소켓
+    TcpInfoSample server_tcp;     // 서버 소켓
+    time_t last_tcp_sample;       // 마지막 샘플링 시간
+
+    // 현재 처리량 (EWMA)
+    ConnectionRates rates;
+    uint64_t rate_last_ms;        // 마지막 EWMA 갱신 시각 (단조 시계)
+    uint64_t rate_base_c2s;       // 마지막 갱신 시점의 누적 바이트
+    uint64_t rate_base_s2c;
 } ConnectionStats;
 
+// 쿼리 지연 통계 (서버 응답 시간 히스토그램, 구간 i = [2^i, 2^(i+1)) 마이크로초)
+#define LATENCY_BUCKETS 32
+typedef struct {
+    uint64_t count;               // 응답을 받은 쿼리 수
+    uint64_t errors;              // 서버가 오류로 응답한 쿼리
+    uint64_t injected;            // 프록시가 오류를 주입한 쿼리 (서버로 보내지 않음)
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t buckets[LATENCY_BUCKETS];
+    uint64_t status[6];           // HTTP 응답 코드 종류 (0 = 기타, 1~5 = 1xx~5xx)
+} QueryStats;
+
+struct CaptureFlow;
+struct FlightRing;
+struct MirrorFlow;
+struct HttpSession;
+struct MysqlSession;
+
 // 연결 정보
 typedef struct {
     pid_t pid;                    // 프로세스 ID
+    uint64_t conn_id;             // 연결 ID (부모가 순서대로 부여)
+    int listener;                 // 연결을 받은 리스너 (번호, 통계 구분용)
+    char listener_name[MAX_LISTENER_NAME];
     int client_fd;                // 클라이언트 소켓
     int server_fd;                // 서버 소켓
     char client_addr[MAX_ADDR_LEN]; // 클라이언트 주소
     int client_port;              // 클라이언트 포트
-    char target_addr[MAX_ADDR_LEN]; // 대상 서버 주소
+    char target_addr[MAX_HOST_LEN]; // 대상 서버 주소 (호스트 이름, 유닉스 소켓 경로 포함)
     int target_port;              // 대상 서버 포트
+    char sni[MAX_SNI_LEN];        // TLS ClientHello의 SNI (SNI 라우팅 시, 없으면 빈 문자열)
     ConnectionStats stats;        // 통계
-    FilterChain filter_chain;     // 필터 체인
+    FilterPath filters[FILTER_DIR_COUNT]; // 방향별 필터 경로
+    uint32_t filter_generation;   // 적용 중인 공유 필터 테이블 세대
+    int control_slot;             // 공유 연결 목록에서의 위치 (힌트, -1 = 표가 가득 차 등록 못 함)
+    uint64_t published_c2s;       // 공유 누적값에 이미 더한 바이트/드롭 수 (갱신 때는 차이만 더함)
+    uint64_t published_s2c;
+    uint32_t published_dropped;
+    struct FlightRing *flight;    // 플라이트 레코더 링
+    struct CaptureFlow *capture;  // 트래픽 캡처 (NULL = 캡처하지 않는 연결)
+    struct MirrorFlow *mirror;    // 섀도 미러링 (NULL = 미러링하지 않는 연결)
+    struct MysqlSession *mysql;   // MySQL 모드 파서 상태 (NULL = 바이트 스트림)
+    struct HttpSession *http;     // HTTP 모드 파서 상태 (NULL = 바이트 스트림)
 } Connection;
 
 #endif // TYPES_H
@@ -0,0 +1,48 @@
+#ifndef UDP_H
+#define UDP_H
+
+#include "types.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// UDP 프록시 모드
+//
+// 자식 프로세스를 만들지 않고 부모의 이벤트 루프 하나가 모든 데이터그램을 중계한다. 클라이언트 주소마다
+// 세션을 만들어 대상 서버에 연결한 전용 소켓을 두고, 서버 응답은 그 소켓으로 받아 리스닝 소켓에서
+// 클라이언트에게 보낸다. 수신은 recvmmsg, 송신은 sendmmsg로 묶어 데이터그램마다 시스템 호출을 하지
+// 않는다. 드롭/지연/쓰로틀/복제 필터는 데이터그램 단위로 적용하며 드롭은 실제로 패킷을 버린다.
+// 지연/쓰로틀된 데이터그램은 복사해 시각 순 힙에 두고 루프가 마감 시각에 보낸다.
+
+#define UDP_BATCH 64                  // recvmmsg/sendmmsg 한 번에 처리할 데이터그램 수
+#define UDP_MAX_DATAGRAM 65536        // 수신 버퍼 크기 (GRO로 합쳐진 버퍼 포함)
+#define UDP_MAX_SESSIONS 65536        // 세션 최대 수 (세션마다 소켓 하나, 파일 수 제한에 맞춰 줄어듦)
+#define UDP_DEFAULT_IDLE_SEC 30       // 세션 유휴 만료 기본값 (초)
+#define UDP_DELAY_QUEUE 65536         // 지연/쓰로틀로 보류할 수 있는 데이터그램 수 (넘치면 드롭)
+
+// UDP 모드 상태 (제어 응답용, 이벤트 루프가 1초마다 갱신)
+typedef struct {
+    bool enabled;
+    bool gso;                         // GSO/GRO 사용 중 (커널이 거부하면 꺼짐)
+    int idle_sec;
+    int max_sessions;
+    uint64_t sessions_active;
+    uint64_t sessions_created;
+    uint64_t sessions_expired;
+    uint64_t sessions_rejected;       // 세션 표가 가득 차거나 소켓을 만들 수 없어 버린 새 클라이언트
+    uint64_t datagrams[FILTER_DIR_COUNT];   // 방향별 받은 데이터그램
+    uint64_t bytes[FILTER_DIR_COUNT];       // 방향별 받은 바이트
+    uint64_t sent[FILTER_DIR_COUNT];        // 방향별 보낸 데이터그램 (복제 포함)
+    uint64_t dropped[FILTER_DIR_COUNT];     // 필터/보류 큐 넘침으로 버린 데이터그램
+    uint64_t send_errors[FILTER_DIR_COUNT]; // 송신 실패 (소켓 버퍼 가득 참, ICMP 거부 등)
+    uint64_t delayed;                 // 지금 보류 중인 데이터그램
+    uint64_t recv_calls;              // recvmmsg 호출 수 (묶음 효율 확인용)
+    uint64_t send_calls;              // sendmmsg 호출 수
+} UdpStatus;
+
+// UDP 프록시 시작 (종료 시그널까지 반환하지 않음, 실패 시 -1)
+int udp_proxy_start(const ProxyConfig *config, FilterChain *filter_chain);
+
+// UDP 모드 상태 조회 (제어 스레드)
+void udp_get_status(UdpStatus *status);
+
+#endif // UDP_H
@@ -0,0 +1,621 @@
+#include "../include/capture.h"
+#include "../include/filter.h"
+#include "../include/flight.h"
+#include "../include/logger.h"
+#include "../include/rng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+// 레코드 상태 (기록 스레드는 비운 자리 전체를 0으로 지우므로 어느 위치든 다시 EMPTY)
+#define REC_EMPTY 0
+#define REC_READY 1
+#define REC_PAD   2              // 링 끝의 남은 자리 (다음 레코드는 링 처음부터)
+
+// 레코드 종류
+#define KIND_DATA  0
+#define KIND_OPEN  1             // SYN, SYN-ACK, ACK 합성
+#define KIND_CLOSE 2             // 양쪽 FIN 합성
+#define KIND_RESET 3             // 양쪽 RST 합성
+
+#define TCP_FIN 0x01
+#define TCP_SYN 0x02
+#define TCP_RST 0x04
+#define TCP_PSH 0x08
+#define TCP_ACK 0x10
+
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER 0x1A2B3C4D
+#define LINKTYPE_RAW 101
+
+#define CAPTURE_OUTBUF_SIZE (256 * 1024)
+
+// 링 레코드 (payload가 바로 뒤에 붙음, 전체 크기는 8바이트 정렬)
+typedef struct {
+    uint32_t state;               // REC_* (생산자가 예약 직후 EMPTY, 복사를 마친 뒤 release로 READY)
+    uint32_t size;                // 레코드 전체 크기 (예약 직후 기록, 게시되지 않은 레코드를 건너뛸 때 사용)
+    uint64_t ts_us;               // CLOCK_REALTIME
+    uint32_t seq[2];              // 방향별 다음 순서 번호 ([0] 클라이언트, [1] 서버)
+    uint16_t length;              // payload 길이
+    uint8_t dir;                  // FLIGHT_DIR_C2S/S2C (데이터 레코드)
+    uint8_t kind;                 // KIND_*
+    uint8_t ipv6;                 // 주소 종류 (IPv4가 섞이면 ::ffff: 매핑)
+    uint8_t reserved;
+    uint16_t client_port;
+    uint16_t server_port;
+    uint8_t client_ip[16];
+    uint8_t server_ip[16];
+} CaptureRecord;
+
+// 공유 메모리 (fork 전에 생성, 자식들이 생산자, 부모 기록 스레드가 소비자)
+typedef struct {
+    uint64_t head __attribute__((aligned(64)));  // 예약한 바이트 (CAS)
+    uint64_t tail __attribute__((aligned(64)));  // 비운 바이트
+    uint64_t sessions __attribute__((aligned(64)));
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t dropped;
+    uint64_t dropped_bytes;
+    uint64_t abandoned;
+    uint8_t data[CAPTURE_RING_SIZE] __attribute__((aligned(64)));
+} CaptureShared;
+
+// 연결별 상태 (자식 프로세스 전용)
+typedef struct CaptureFlow {
+    CaptureRecord base;           // 주소/포트를 채운 레코드 틀
+    uint32_t seq[2];
+} CaptureFlow;
+
+static CaptureShared *g_capture = NULL;
+static FilterSelector g_selector;        // 자식은 fork로 물려받음
+static char g_path[MAX_PATH_LEN];
+static char g_selector_text[MAX_FILTER_SPEC_LEN];
+
+// 기록 스레드 상태 (부모 전용)
+static pthread_t g_writer;
+static volatile int g_writer_stop = 0;
+static int g_fd = -1;                    // FILE*를 쓰지 않음: 자식의 exit()가 버퍼를 다시 쓰지 않도록
+static uint8_t g_outbuf[CAPTURE_OUTBUF_SIZE];
+static size_t g_outlen = 0;
+static uint64_t g_written_packets = 0;
+static uint64_t g_stall_tail = UINT64_MAX;  // 게시를 기다리며 멈춘 tail 위치 (없으면 UINT64_MAX)
+static uint64_t g_stall_since_ms = 0;
+static uint64_t g_stall_head = 0;           // 멈추기 시작했을 때의 head (그때까지의 예약은 모두 끝났어야 함)
+static uint64_t g_file_bytes = 0;
+static uint64_t g_write_errors = 0;
+static uint16_t g_ip_id = 0;
+
+static uint32_t align8(uint32_t n) {
+    return (n + 7) & ~7u;
+}
+
+// ---- 생산자 (자식 프로세스) ----
+
+// 링에 size 바이트 예약 (가득 차면 NULL). 끝에 남는 자리는 PAD 레코드로 채움.
+// *pos는 레코드의 링 위치 (게시 직전에 기록 스레드가 이미 건너뛰었는지 확인용)
+static CaptureRecord *ring_reserve(uint32_t size, uint64_t *pos) {
+    uint64_t head = __atomic_load_n(&g_capture->head, __ATOMIC_RELAXED);
+
+    while (1) {
+        uint64_t offset = head % CAPTURE_RING_SIZE;
+        uint32_t pad = offset + size > CAPTURE_RING_SIZE ? (uint32_t)(CAPTURE_RING_SIZE - offset) : 0;
+        uint64_t tail = __atomic_load_n(&g_capture->tail, __ATOMIC_ACQUIRE);
+
+        if (head + pad + size - tail > CAPTURE_RING_SIZE) {
+            return NULL;
+        }
+        if (__atomic_compare_exchange_n(&g_capture->head, &head, head + pad + size,
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            if (pad > 0) {
+                CaptureRecord *filler = (CaptureRecord *)(g_capture->data + offset);
+                filler->size = pad;
+                __atomic_store_n(&filler->state, REC_PAD, __ATOMIC_RELEASE);
+                offset = 0;
+            }
+            // 무엇보다 먼저 머리에 EMPTY와 크기를 씀: 기록 스레드가 지운 자리지만, 여기서 죽어도
+            // 기록 스레드가 크기만큼 건너뛸 수 있도록
+            CaptureRecord *rec = (CaptureRecord *)(g_capture->data + offset);
+            __atomic_store_n(&rec->size, size, __ATOMIC_RELAXED);
+            __atomic_store_n(&rec->state, REC_EMPTY, __ATOMIC_RELEASE);
+            *pos = head + pad;
+            return rec;
+        }
+    }
+}
+
+static uint64_t realtime_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool push_record(CaptureFlow *flow, uint8_t kind, uint8_t dir, const char *data, uint16_t length) {
+    uint32_t size = align8(sizeof(CaptureRecord) + length);
+    uint64_t pos;
+    CaptureRecord *rec = ring_reserve(size, &pos);
+    if (rec == NULL) {
+        __atomic_fetch_add(&g_capture->dropped, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&g_capture->dropped_bytes, length, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    memcpy(rec, &flow->base, sizeof(CaptureRecord));
+    rec->size = size;
+    rec->ts_us = realtime_us();
+    rec->seq[0] = flow->seq[0];
+    rec->seq[1] = flow->seq[1];
+    rec->length = length;
+    rec->dir = dir;
+    rec->kind = kind;
+    if (length > 0) {
+        memcpy(rec + 1, data, length);
+    }
+
+    // 멈춰 있던 사이 기록 스레드가 이 자리를 건너뛰었으면 게시하지 않음 (이미 다른 레코드의 자리)
+    if (__atomic_load_n(&g_capture->tail, __ATOMIC_ACQUIRE) > pos) {
+        return false;
+    }
+    __atomic_store_n(&rec->state, REC_READY, __ATOMIC_RELEASE);
+    return true;
+}
+
+// 주소 문자열을 16바이트로 (IPv4는 ::ffff: 매핑). IPv4면 true.
+static bool addr_to_bytes(const char *text, uint8_t *out) {
+    struct in_addr v4;
+    memset(out, 0, 16);
+    if (inet_pton(AF_INET, text, &v4) == 1) {
+        out[10] = 0xff;
+        out[11] = 0xff;
+        memcpy(out + 12, &v4, 4);
+        return true;
+    }
+    if (inet_pton(AF_INET6, text, out) == 1) {
+        return false;
+    }
+    return true;  // 해석할 수 없는 주소는 0.0.0.0
+}
+
+CaptureFlow *capture_open(const Connection *conn) {
+    if (g_capture == NULL ||
+        !filter_selector_match(&g_selector, conn->conn_id, conn->pid,
+                               conn->client_addr, conn->client_port, conn->listener_name)) {
+        return NULL;
+    }
+
+    CaptureFlow *flow = calloc(1, sizeof(CaptureFlow));
+    if (flow == NULL) {
+        return NULL;
+    }
+
+    bool client_v4 = addr_to_bytes(conn->client_addr, flow->base.client_ip);
+    flow->base.client_port = (uint16_t)conn->client_port;
+
+    // 대상 주소는 이름이 아니라 실제로 연결한 소켓 주소
+    bool server_v4 = true;
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    flow->base.server_ip[10] = 0xff;
+    flow->base.server_ip[11] = 0xff;
+    flow->base.server_port = (uint16_t)conn->target_port;
+    if (getpeername(conn->server_fd, (struct sockaddr *)&peer, &peer_len) == 0) {
+        if (peer.ss_family == AF_INET) {
+            struct sockaddr_in *sin = (struct sockaddr_in *)&peer;
+            memcpy(flow->base.server_ip + 12, &sin->sin_addr, 4);
+            flow->base.server_port = ntohs(sin->sin_port);
+        } else if (peer.ss_family == AF_INET6) {
+            struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&peer;
+            memcpy(flow->base.server_ip, &sin6->sin6_addr, 16);
+            flow->base.server_port = ntohs(sin6->sin6_port);
+            server_v4 = IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr);
+        }
+    }
+    flow->base.ipv6 = !(client_v4 && server_v4);
+
+    // 연결 ID로 정한 초기 순서 번호 (같은 연결은 같은 값)
+    uint64_t x = conn->conn_id;
+    flow->seq[0] = (uint32_t)rng_splitmix64(&x) + 1;
+    flow->seq[1] = (uint32_t)rng_splitmix64(&x) + 1;
+
+    __atomic_fetch_add(&g_capture->sessions, 1, __ATOMIC_RELAXED);
+    push_record(flow, KIND_OPEN, FLIGHT_DIR_NONE, NULL, 0);
+    return flow;
+}
+
+void capture_data(CaptureFlow *flow, uint8_t dir, const char *data, size_t length) {
+    if (flow == NULL) return;
+
+    int side = dir == FLIGHT_DIR_C2S ? 0 : 1;
+    size_t offset = 0;
+
+    while (offset < length) {
+        uint16_t n = (uint16_t)(length - offset < CAPTURE_MAX_PAYLOAD ?
+                                length - offset : CAPTURE_MAX_PAYLOAD);
+        if (push_record(flow, KIND_DATA, dir, data + offset, n)) {
+            __atomic_fetch_add(&g_capture->packets, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&g_capture->bytes, n, __ATOMIC_RELAXED);
+        }
+        // 버린 레코드도 순서 번호는 진행 (Wireshark에 빠진 구간으로 보임)
+        flow->seq[side] += n;
+        offset += n;
+    }
+}
+
+void capture_close(CaptureFlow *flow, bool reset) {
+    if (flow == NULL) return;
+    push_record(flow, reset ? KIND_RESET : KIND_CLOSE, FLIGHT_DIR_NONE, NULL, 0);
+    free(flow);
+}
+
+// ---- 소비자 (부모 기록 스레드) ----
+
+static void out_flush(void) {
+    size_t done = 0;
+    while (done < g_outlen) {
+        ssize_t n = write(g_fd, g_outbuf + done, g_outlen - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            __atomic_fetch_add(&g_write_errors, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        done += n;
+    }
+    __atomic_fetch_add(&g_file_bytes, done, __ATOMIC_RELAXED);
+    g_outlen = 0;
+}
+
+static void out_write(const void *data, size_t length) {
+    if (g_outlen + length > sizeof(g_outbuf)) {
+        out_flush();
+    }
+    memcpy(g_outbuf + g_outlen, data, length);
+    g_outlen += length;
+}
+
+static void out_u32(uint32_t value) {
+    out_write(&value, 4);
+}
+
+static uint32_t checksum_add(uint32_t sum, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        sum += (uint32_t)((data[i] << 8) | data[i + 1]);
+    }
+    if (length & 1) {
+        sum += (uint32_t)(data[length - 1] << 8);
+    }
+    return sum;
+}
+
+static uint16_t checksum_fold(uint32_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// IP/TCP 헤더를 합성해 EPB 하나 기록
+static void write_segment(const CaptureRecord *rec, bool from_client, uint8_t flags,
+                          uint32_t seq, uint32_t ack, const uint8_t *payload, uint16_t length) {
+    uint8_t header[60];
+    const uint8_t *src = from_client ? rec->client_ip : rec->server_ip;
+    const uint8_t *dst = from_client ? rec->server_ip : rec->client_ip;
+    int ip_len = rec->ipv6 ? 40 : 20;
+    uint8_t *tcp = header + ip_len;
+    uint32_t sum = 0;
+
+    memset(header, 0, sizeof(header));
+    if (rec->ipv6) {
+        header[0] = 0x60;
+        put_u16(header + 4, (uint16_t)(20 + length));
+        header[6] = IPPROTO_TCP;
+        header[7] = 64;
+        memcpy(header + 8, src, 16);
+        memcpy(header + 24, dst, 16);
+        sum = checksum_add(sum, src, 16);
+        sum = checksum_add(sum, dst, 16);
+    } else {
+        header[0] = 0x45;
+        put_u16(header + 2, (uint16_t)(20 + 20 + length));
+        put_u16(header + 4, g_ip_id++);
+        put_u16(header + 6, 0x4000);  // DF
+        header[8] = 64;
+        header[9] = IPPROTO_TCP;
+        memcpy(header + 12, src + 12, 4);
+        memcpy(header + 16, dst + 12, 4);
+        put_u16(header + 10, checksum_fold(checksum_add(0, header, 20)));
+        sum = checksum_add(sum, src + 12, 4);
+        sum = checksum_add(sum, dst + 12, 4);
+    }
+
+    put_u16(tcp, from_client ? rec->client_port : rec->server_port);
+    put_u16(tcp + 2, from_client ? rec->server_port : rec->client_port);
+    put_u32(tcp + 4, seq);
+    put_u32(tcp + 8, (flags & TCP_ACK) ? ack : 0);
+    tcp[12] = 5 << 4;
+    tcp[13] = flags;
+    put_u16(tcp + 14, 65535);
+
+    // TCP 체크섬: 의사 헤더 (주소, 프로토콜, 길이) + 헤더 + payload
+    sum += IPPROTO_TCP + 20 + length;
+    sum = checksum_add(sum, tcp, 20);
+    sum = checksum_add(sum, payload, length);
+    put_u16(tcp + 16, checksum_fold(sum));
+
+    uint32_t packet_len = ip_len + 20 + length;
+    uint32_t padded = (packet_len + 3) & ~3u;
+    uint32_t block_len = 28 + padded + 4;
+    static const uint8_t zeros[4] = {0};
+
+    out_u32(PCAPNG_EPB);
+    out_u32(block_len);
+    out_u32(0);                                 // 인터페이스 ID
+    out_u32((uint32_t)(rec->ts_us >> 32));
+    out_u32((uint32_t)rec->ts_us);
+    out_u32(packet_len);
+    out_u32(packet_len);
+    out_write(header, ip_len + 20);
+    if (length > 0) {
+        out_write(payload, length);
+    }
+    out_write(zeros, padded - packet_len);
+    out_u32(block_len);
+
+    __atomic_fetch_add(&g_written_packets, 1, __ATOMIC_RELAXED);
+}
+
+static void write_record(const CaptureRecord *rec) {
+    uint32_t c = rec->seq[0];
+    uint32_t s = rec->seq[1];
+
+    switch (rec->kind) {
+        case KIND_OPEN:
+            write_segment(rec, true, TCP_SYN, c - 1, 0, NULL, 0);
+            write_segment(rec, false, TCP_SYN | TCP_ACK, s - 1, c, NULL, 0);
+            write_segment(rec, true, TCP_ACK, c, s, NULL, 0);
+            break;
+        case KIND_CLOSE:
+            write_segment(rec, true, TCP_FIN | TCP_ACK, c, s, NULL, 0);
+            write_segment(rec, false, TCP_FIN | TCP_ACK, s, c + 1, NULL, 0);
+            write_segment(rec, true, TCP_ACK, c + 1, s + 1, NULL, 0);
+            break;
+        case KIND_RESET:
+            write_segment(rec, true, TCP_RST | TCP_ACK, c, s, NULL, 0);
+            write_segment(rec, false, TCP_RST | TCP_ACK, s, c, NULL, 0);
+            break;
+        default:
+            if (rec->dir == FLIGHT_DIR_C2S) {
+                write_segment(rec, true, TCP_PSH | TCP_ACK, c, s,
+                              (const uint8_t *)(rec + 1), rec->length);
+            } else {
+                write_segment(rec, false, TCP_PSH | TCP_ACK, s, c,
+                              (const uint8_t *)(rec + 1), rec->length);
+            }
+            break;
+    }
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// tail의 레코드가 CAPTURE_STALL_MS 넘게 게시되지 않으면 건너뛸 크기 (아직 기다릴 때는 0)
+// 예약 직후 쓴 크기가 맞지 않으면 (크기를 쓰기 전에 죽음) 멈추기 시작할 때의 head까지 건너뜀:
+// 그때까지의 다른 예약은 그 사이 모두 게시됐거나 같은 이유로 버려진 것
+static uint64_t ring_stall_skip(uint64_t tail, uint64_t head, const CaptureRecord *rec) {
+    uint64_t now = monotonic_ms();
+    if (g_stall_tail != tail) {
+        g_stall_tail = tail;
+        g_stall_since_ms = now;
+        g_stall_head = head;
+        return 0;
+    }
+    if (now - g_stall_since_ms < CAPTURE_STALL_MS) {
+        return 0;
+    }
+
+    uint32_t size = __atomic_load_n(&rec->size, __ATOMIC_RELAXED);
+    uint64_t offset = tail % CAPTURE_RING_SIZE;
+    if (size < sizeof(CaptureRecord) || (size & 7) != 0 || size > g_stall_head - tail ||
+        offset + size > CAPTURE_RING_SIZE) {
+        size = (uint32_t)(g_stall_head - tail);
+    }
+    __atomic_fetch_add(&g_capture->abandoned, 1, __ATOMIC_RELAXED);
+    LOG_WARN("캡처: %lu ms 넘게 게시되지 않은 레코드를 건너뜀 (%u바이트, 자식이 중간에 종료/정지)",
+             now - g_stall_since_ms, size);
+    g_stall_tail = UINT64_MAX;
+    return size;
+}
+
+// 비운 구간 [tail, tail + size)를 0으로 지움 (링 끝을 넘으면 앞부분까지)
+// 다음 바퀴의 레코드 머리가 예전 payload 한가운데에 오더라도 예약 직후부터 EMPTY로 보이도록
+static void ring_clear(uint64_t tail, uint64_t size) {
+    uint64_t offset = tail % CAPTURE_RING_SIZE;
+    uint64_t first = size < CAPTURE_RING_SIZE - offset ? size : CAPTURE_RING_SIZE - offset;
+    memset(g_capture->data + offset, 0, first);
+    if (size > first) {
+        memset(g_capture->data, 0, size - first);
+    }
+}
+
+// 준비된 레코드를 모두 기록 (기록한 레코드 수 반환)
+static int ring_drain(void) {
+    uint64_t tail = __atomic_load_n(&g_capture->tail, __ATOMIC_RELAXED);
+    uint64_t head = __atomic_load_n(&g_capture->head, __ATOMIC_ACQUIRE);
+    int count = 0;
+
+    while (tail < head) {
+        CaptureRecord *rec = (CaptureRecord *)(g_capture->data + tail % CAPTURE_RING_SIZE);
+        uint32_t state = __atomic_load_n(&rec->state, __ATOMIC_ACQUIRE);
+        uint64_t size;
+        if (state == REC_EMPTY) {
+            // 예약한 자식이 아직 복사 중 (순서를 지키려고 여기서 멈춤, 오래 멈추면 건너뜀)
+            size = ring_stall_skip(tail, head, rec);
+            if (size == 0) {
+                break;
+            }
+        } else {
+            size = rec->size;
+            if (state == REC_READY) {
+                write_record(rec);
+                count++;
+            }
+        }
+
+        // 자리를 지운 뒤에 tail을 옮겨야 생산자가 예전 바이트를 상태로 읽지 않음
+        ring_clear(tail, size);
+        tail += size;
+        __atomic_store_n(&g_capture->tail, tail, __ATOMIC_RELEASE);
+    }
+
+    return count;
+}
+
+static void *capture_writer_thread(void *arg) {
+    (void)arg;
+
+    // 파이프(FIFO)로 내보낼 때 읽는 쪽이 닫아도 프록시가 죽지 않도록 (write가 EPIPE로 실패),
+    // 종료 시그널은 메인 스레드가 받아 capture_stop()으로 이 스레드를 기다림
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGPIPE);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    while (!g_writer_stop) {
+        if (ring_drain() == 0) {
+            if (g_outlen > 0) {
+                out_flush();  // 한가할 때만 파일로 (실시간으로 열어 볼 수 있게)
+            }
+            usleep(CAPTURE_DRAIN_MS * 1000);
+        }
+    }
+
+    ring_drain();
+    out_flush();
+    return NULL;
+}
+
+static void write_file_header(void) {
+    // Section Header Block (옵션 없음)
+    out_u32(PCAPNG_SHB);
+    out_u32(28);
+    out_u32(PCAPNG_BYTE_ORDER);
+    uint16_t version[2] = {1, 0};
+    out_write(version, sizeof(version));
+    uint64_t section_len = UINT64_MAX;  // 길이 미상
+    out_write(&section_len, sizeof(section_len));
+    out_u32(28);
+
+    // Interface Description Block (IP 헤더부터, 타임스탬프는 기본 마이크로초)
+    out_u32(PCAPNG_IDB);
+    out_u32(20);
+    uint16_t link[2] = {LINKTYPE_RAW, 0};
+    out_write(link, sizeof(link));
+    out_u32(0);   // snaplen 제한 없음
+    out_u32(20);
+    out_flush();
+}
+
+bool capture_start(const char *path, const char *selector) {
+    char err[160];
+    if (!filter_parse_selector(selector, &g_selector, err, sizeof(err))) {
+        LOG_ERROR("잘못된 캡처 선택자: %s", err);
+        return false;
+    }
+
+    g_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (g_fd < 0) {
+        LOG_ERROR("캡처 파일을 열 수 없습니다: %s (%s)", path, strerror(errno));
+        return false;
+    }
+
+    g_capture = mmap(NULL, sizeof(CaptureShared), PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (g_capture == MAP_FAILED) {
+        LOG_ERROR("캡처 링 공유 메모리 생성 실패: %s", strerror(errno));
+        g_capture = NULL;
+        close(g_fd);
+        g_fd = -1;
+        return false;
+    }
+
+    strncpy(g_path, path, sizeof(g_path) - 1);
+    strncpy(g_selector_text, selector ? selector : "", sizeof(g_selector_text) - 1);
+    write_file_header();
+
+    g_writer_stop = 0;
+    if (pthread_create(&g_writer, NULL, capture_writer_thread, NULL) != 0) {
+        LOG_ERROR("캡처 기록 스레드 생성 실패");
+        munmap(g_capture, sizeof(CaptureShared));
+        g_capture = NULL;
+        close(g_fd);
+        g_fd = -1;
+        return false;
+    }
+
+    LOG_INFO("트래픽 캡처: %s (선택자: %s, 링 %d MB)", path,
+             g_selector_text[0] ? g_selector_text : "모든 연결", CAPTURE_RING_SIZE / (1024 * 1024));
+    return true;
+}
+
+void capture_stop(void) {
+    if (g_capture == NULL) return;
+
+    g_writer_stop = 1;
+    pthread_join(g_writer, NULL);
+    close(g_fd);
+    g_fd = -1;
+
+    LOG_INFO("트래픽 캡처 종료: %s (패킷 %lu개, 링이 가득 차 버린 레코드 %lu개)", g_path,
+             g_written_packets, g_capture->dropped);
+
+    munmap(g_capture, sizeof(CaptureShared));
+    g_capture = NULL;
+}
+
+void capture_get_status(CaptureStatus *status) {
+    memset(status, 0, sizeof(CaptureStatus));
+    if (g_capture == NULL) return;
+
+    status->enabled = true;
+    memcpy(status->path, g_path, sizeof(status->path));
+    memcpy(status->selector, g_selector_text, sizeof(status->selector));
+    status->sessions = __atomic_load_n(&g_capture->sessions, __ATOMIC_RELAXED);
+    status->packets = __atomic_load_n(&g_capture->packets, __ATOMIC_RELAXED);
+    status->bytes = __atomic_load_n(&g_capture->bytes, __ATOMIC_RELAXED);
+    status->dropped = __atomic_load_n(&g_capture->dropped, __ATOMIC_RELAXED);
+    status->dropped_bytes = __atomic_load_n(&g_capture->dropped_bytes, __ATOMIC_RELAXED);
+    status->abandoned = __atomic_load_n(&g_capture->abandoned, __ATOMIC_RELAXED);
+    status->written_packets = __atomic_load_n(&g_written_packets, __ATOMIC_RELAXED);
+    status->file_bytes = __atomic_load_n(&g_file_bytes, __ATOMIC_RELAXED);
+    status->write_errors = __atomic_load_n(&g_write_errors, __ATOMIC_RELAXED);
+    status->ring_used = __atomic_load_n(&g_capture->head, __ATOMIC_RELAXED) -
+                        __atomic_load_n(&g_capture->tail, __ATOMIC_RELAXED);
+    status->ring_size = CAPTURE_RING_SIZE;
+}
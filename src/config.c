@@ -1,26 +1,259 @@
 #include "../include/config.h"
 #include "../include/logger.h"
+#include "../include/filter.h"
+#include "../include/tls.h"
+#include "../include/udp.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/un.h>
 
 void config_init(ProxyConfig *config) {
     memset(config, 0, sizeof(ProxyConfig));
 
-    // 기본값 설정
-    config->listen_port = 9999;
-    strncpy(config->target_host, "127.0.0.1", MAX_HOST_LEN - 1);
-    config->target_host[MAX_HOST_LEN - 1] = '\0';
-    config->target_port = 8080;
+    // 기본값 설정 (구역이 없으면 이 리스너 하나로 동작)
+    strcpy(config->listener.name, "default");
+    config->listener.listen_port = 9999;
+    strncpy(config->listener.target_host, "127.0.0.1", MAX_HOST_LEN - 1);
+    config->listener.target_host[MAX_HOST_LEN - 1] = '\0';
+    config->listener.target_port = 8080;
     config->enable_logging = true;
     strncpy(config->log_file, "logs/proxy.log", MAX_PATH_LEN - 1);
     config->log_file[MAX_PATH_LEN - 1] = '\0';
     strncpy(config->control_socket, "/tmp/tcp_proxy_control.sock", MAX_PATH_LEN - 1);
     config->control_socket[MAX_PATH_LEN - 1] = '\0';
     config->enable_filters = false;
+    config->udp_idle_sec = UDP_DEFAULT_IDLE_SEC;
 }
 
-bool config_load(ProxyConfig *config, const char *config_file) {
+int config_parse_protocol(const char *name) {
+    if (strcmp(name, "raw") == 0 || strcmp(name, "tcp") == 0) return PROTOCOL_RAW;
+    if (strcmp(name, "mysql") == 0) return PROTOCOL_MYSQL;
+    if (strcmp(name, "http") == 0) return PROTOCOL_HTTP;
+    return -1;
+}
+
+bool config_parse_seed(const char *text, uint64_t *seed) {
+    // strtoull은 앞 공백과 음수 부호를 받아들이므로 숫자로 시작하는지 먼저 확인
+    if (text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    char *endptr;
+    errno = 0;
+    unsigned long long value = strtoull(text, &endptr, 0);
+    if (*endptr != '\0' || errno == ERANGE || value == 0) {
+        return false;
+    }
+    *seed = value;
+    return true;
+}
+
+const char *config_protocol_name(int protocol) {
+    switch (protocol) {
+        case PROTOCOL_MYSQL: return "mysql";
+        case PROTOCOL_HTTP:  return "http";
+        default:             return "raw";
+    }
+}
+
+int config_parse_proxy_protocol(const char *name) {
+    if (strcmp(name, "none") == 0 || strcmp(name, "off") == 0) return 0;
+    if (strcmp(name, "in") == 0) return PROXY_PROTOCOL_IN;
+    if (strcmp(name, "out") == 0) return PROXY_PROTOCOL_OUT;
+    if (strcmp(name, "both") == 0) return PROXY_PROTOCOL_IN | PROXY_PROTOCOL_OUT;
+    return -1;
+}
+
+const char *config_proxy_protocol_name(int proxy_protocol) {
+    switch (proxy_protocol) {
+        case PROXY_PROTOCOL_IN:  return "in";
+        case PROXY_PROTOCOL_OUT: return "out";
+        case PROXY_PROTOCOL_IN | PROXY_PROTOCOL_OUT: return "both";
+        default: return "none";
+    }
+}
+
+bool config_parse_host_port(const char *text, char *host, size_t host_len, int *port) {
+    const char *colon = strrchr(text, ':');
+    if (colon == NULL || colon == text || (size_t)(colon - text) >= host_len) {
+        return false;
+    }
+
+    char *endptr;
+    long value = strtol(colon + 1, &endptr, 10);
+    if (*endptr != '\0' || value <= 0 || value > 65535) {
+        return false;
+    }
+
+    // "[::1]:port" 형식이면 대괄호를 벗김
+    const char *start = text;
+    const char *end = colon;
+    if (*start == '[') {
+        if (end[-1] != ']' || end - start < 3) {
+            return false;
+        }
+        start++;
+        end--;
+    }
+
+    memcpy(host, start, end - start);
+    host[end - start] = '\0';
+    *port = (int)value;
+    return true;
+}
+
+const char *config_unix_path(const char *host) {
+    size_t prefix_len = strlen(UNIX_PREFIX);
+    return strncmp(host, UNIX_PREFIX, prefix_len) == 0 ? host + prefix_len : NULL;
+}
+
+bool config_parse_endpoint(const char *text, char *host, size_t host_len, int *port) {
+    const char *path = config_unix_path(text);
+    if (path != NULL) {
+        // sun_path 크기를 넘는 경로는 bind/connect할 수 없음
+        struct sockaddr_un sun;
+        if (path[0] == '\0' || strlen(path) >= sizeof(sun.sun_path) || strlen(text) >= host_len) {
+            return false;
+        }
+        strcpy(host, text);
+        *port = 0;
+        return true;
+    }
+    return config_parse_host_port(text, host, host_len, port);
+}
+
+bool config_parse_listen(const char *text, char *host, size_t host_len, int *port) {
+    char *endptr;
+    long value = strtol(text, &endptr, 10);
+    if (*text != '\0' && *endptr == '\0') {
+        if (value <= 0 || value > 65535) {
+            return false;
+        }
+        host[0] = '\0';
+        *port = (int)value;
+        return true;
+    }
+    return config_parse_endpoint(text, host, host_len, port);
+}
+
+void config_format_endpoint(const char *host, int port, char *out, size_t out_len) {
+    if (config_unix_path(host) != NULL) {
+        snprintf(out, out_len, "%s", host);
+    } else if (host[0] == '\0') {
+        snprintf(out, out_len, "*:%d", port);
+    } else if (strchr(host, ':') != NULL) {
+        snprintf(out, out_len, "[%s]:%d", host, port);
+    } else {
+        snprintf(out, out_len, "%s:%d", host, port);
+    }
+}
+
+// 리스너별 설정 키 (구역 밖이면 기본 리스너, [이름] 구역 안이면 그 리스너) - 리스너 키가 아니면 false
+static bool listener_option(ListenerConfig *listener, const char *key, const char *value, int line_num) {
+    if (strcmp(key, "listen") == 0) {
+        // 포트, host:port, [v6]:port, unix:/경로
+        if (!config_parse_listen(value, listener->listen_host, sizeof(listener->listen_host),
+                                 &listener->listen_port)) {
+            LOG_ERROR("설정 파일 %d번째 줄: 잘못된 리스닝 주소: %s (port, host:port, [v6]:port, unix:/경로)",
+                      line_num, value);
+        }
+    } else if (strcmp(key, "target") == 0) {
+        if (!config_parse_endpoint(value, listener->target_host, sizeof(listener->target_host),
+                                   &listener->target_port)) {
+            LOG_ERROR("설정 파일 %d번째 줄: 잘못된 대상 서버: %s (host:port, [v6]:port, unix:/경로)",
+                      line_num, value);
+        }
+    } else if (strcmp(key, "listen_port") == 0) {
+        listener->listen_port = atoi(value);
+    } else if (strcmp(key, "target_host") == 0) {
+        strncpy(listener->target_host, value, sizeof(listener->target_host) - 1);
+    } else if (strcmp(key, "target_port") == 0) {
+        listener->target_port = atoi(value);
+    } else if (strcmp(key, "protocol") == 0) {
+        int protocol = config_parse_protocol(value);
+        if (protocol < 0) {
+            LOG_ERROR("설정 파일 %d번째 줄: 알 수 없는 프로토콜: %s (raw, mysql, http)", line_num, value);
+        } else {
+            listener->protocol = protocol;
+        }
+    } else if (strcmp(key, "proxy_protocol") == 0) {
+        int proxy_protocol = config_parse_proxy_protocol(value);
+        if (proxy_protocol < 0) {
+            LOG_ERROR("설정 파일 %d번째 줄: 잘못된 PROXY 프로토콜 방향: %s (none, in, out, both)",
+                      line_num, value);
+        } else {
+            listener->proxy_protocol = proxy_protocol;
+        }
+    } else if (strcmp(key, "route") == 0) {
+        // SNI 라우팅 규칙 (예: route=api.example.com=10.0.0.5:443)
+        SniRoute route;
+        char err[128];
+        if (listener->sni_route_count >= MAX_SNI_ROUTES) {
+            LOG_ERROR("설정 파일 %d번째 줄: SNI 라우팅 규칙이 너무 많습니다 (최대 %d개)",
+                      line_num, MAX_SNI_ROUTES);
+        } else if (!tls_parse_route(value, &route, err, sizeof(err))) {
+            LOG_ERROR("설정 파일 %d번째 줄: 잘못된 SNI 라우팅 규칙 (%s)", line_num, err);
+        } else {
+            listener->sni_routes[listener->sni_route_count++] = route;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 리스너 이름: 영문자, 숫자, '-', '_', '.' (선택자 토큰과 proxyctl 인자로 쓰므로 공백 없음)
+static bool valid_listener_name(const char *name) {
+    size_t len = strlen(name);
+    if (len == 0 || len >= MAX_LISTENER_NAME) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '-' || c == '_' || c == '.')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// [이름] 구역 시작: 구역 밖 설정(대상, 프로토콜, PROXY 프로토콜)을 기본값으로 새 리스너
+static ListenerConfig *begin_listener(ProxyConfig *config, char *header, int line_num) {
+    char *end = strchr(header, ']');
+    if (end == NULL || end[1] != '\0') {
+        LOG_ERROR("설정 파일 %d번째 줄: 잘못된 구역 머리: [%s", line_num, header);
+        return NULL;
+    }
+    *end = '\0';
+
+    if (!valid_listener_name(header)) {
+        LOG_ERROR("설정 파일 %d번째 줄: 잘못된 리스너 이름: %s (영문자, 숫자, -, _, ., 최대 %d자)",
+                  line_num, header, MAX_LISTENER_NAME - 1);
+        return NULL;
+    }
+    for (int i = 0; i < config->listener_count; i++) {
+        if (strcmp(config->listeners[i].name, header) == 0) {
+            LOG_ERROR("설정 파일 %d번째 줄: 리스너 이름이 겹칩니다: %s", line_num, header);
+            return NULL;
+        }
+    }
+    if (config->listener_count >= MAX_LISTENERS) {
+        LOG_ERROR("설정 파일 %d번째 줄: 리스너가 너무 많습니다 (최대 %d개)", line_num, MAX_LISTENERS);
+        return NULL;
+    }
+
+    ListenerConfig *listener = &config->listeners[config->listener_count++];
+    *listener = config->listener;
+    strcpy(listener->name, header);
+    listener->listen_host[0] = '\0';
+    listener->listen_port = 0;
+    listener->sni_route_count = 0;
+    return listener;
+}
+
+bool config_load(ProxyConfig *config, const char *config_file, FilterChain *filter_chain) {
     FILE *fp = fopen(config_file, "r");
     if (fp == NULL) {
         LOG_WARN("설정 파일을 열 수 없습니다: %s (기본값 사용)", config_file);
@@ -29,6 +262,8 @@ bool config_load(ProxyConfig *config, const char *config_file) {
     
     char line[256];
     int line_num = 0;
+    ListenerConfig *section = NULL;   // 지금 읽는 [이름] 구역 (NULL = 구역 밖)
+    bool in_section = false;          // 잘못된 구역 머리 뒤의 줄도 전역 설정으로 읽지 않도록
     
     while (fgets(line, sizeof(line), fp)) {
         line_num++;
@@ -40,47 +275,185 @@ bool config_load(ProxyConfig *config, const char *config_file) {
         
         // 개행 제거
         line[strcspn(line, "\n")] = 0;
+
+        // 리스너 구역 ([이름]부터 다음 구역까지)
+        if (line[0] == '[') {
+            section = begin_listener(config, line + 1, line_num);
+            in_section = true;
+            continue;
+        }
         
-        // Key=Value 파싱
-        char *key = strtok(line, "=");
-        char *value = strtok(NULL, "=");
+        // Key=Value 파싱 (값에 '='가 들어갈 수 있으므로 첫 '='에서만 분리)
+        char *key = line;
+        char *value = strchr(line, '=');
         
-        if (key == NULL || value == NULL) {
+        if (value == NULL) {
             continue;
         }
+        *value++ = '\0';
         
         // 공백 제거
         while (*key == ' ') key++;
         while (*value == ' ') value++;
+
+        if (in_section) {
+            if (section == NULL) {
+                continue;  // 잘못된 구역의 줄 (머리에서 이미 오류 기록)
+            }
+            if (strcmp(key, "filter") == 0) {
+                // 구역의 필터는 listener=를 따로 주지 않으면 그 리스너의 연결에만 (다른 선택자와 AND)
+                Filter filter;
+                char err[128];
+                if (!filter_parse_spec(value, &filter, err, sizeof(err))) {
+                    LOG_ERROR("설정 파일 %d번째 줄: 잘못된 필터 명세 (%s)", line_num, err);
+                    continue;
+                }
+                if (!(filter.selector.flags & SELECT_LISTENER)) {
+                    strcpy(filter.selector.listener, section->name);
+                    filter.selector.flags |= SELECT_LISTENER;
+                }
+                if (filter_chain_add(filter_chain, &filter)) {
+                    config->enable_filters = true;
+                }
+            } else if (!listener_option(section, key, value, line_num)) {
+                LOG_ERROR("설정 파일 %d번째 줄: 리스너 구역에서 쓸 수 없는 설정: %s "
+                          "(전역 설정은 첫 구역 앞에)", line_num, key);
+            }
+            continue;
+        }
         
         // 설정 적용
-        if (strcmp(key, "listen_port") == 0) {
-            config->listen_port = atoi(value);
-        } else if (strcmp(key, "target_host") == 0) {
-            strncpy(config->target_host, value, sizeof(config->target_host) - 1);
-        } else if (strcmp(key, "target_port") == 0) {
-            config->target_port = atoi(value);
+        if (listener_option(&config->listener, key, value, line_num)) {
+            continue;
         } else if (strcmp(key, "enable_logging") == 0) {
             config->enable_logging = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         } else if (strcmp(key, "log_file") == 0) {
             strncpy(config->log_file, value, sizeof(config->log_file) - 1);
         } else if (strcmp(key, "enable_filters") == 0) {
             config->enable_filters = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+        } else if (strcmp(key, "seed") == 0) {
+            // 10진수 또는 0x 16진수 (같은 시드로 같은 고장 순서를 재현)
+            if (!config_parse_seed(value, &config->seed)) {
+                LOG_ERROR("설정 파일 %d번째 줄: 잘못된 시드: %s (0이 아닌 정수)", line_num, value);
+            }
+        } else if (strcmp(key, "scenario") == 0) {
+            strncpy(config->scenario_file, value, sizeof(config->scenario_file) - 1);
+        } else if (strcmp(key, "capture") == 0) {
+            strncpy(config->capture_file, value, sizeof(config->capture_file) - 1);
+        } else if (strcmp(key, "capture_select") == 0) {
+            strncpy(config->capture_select, value, sizeof(config->capture_select) - 1);
+        } else if (strcmp(key, "mirror") == 0) {
+            if (!config_parse_host_port(value, config->mirror_host, sizeof(config->mirror_host),
+                                        &config->mirror_port)) {
+                LOG_ERROR("설정 파일 %d번째 줄: 잘못된 섀도 백엔드: %s (host:port)", line_num, value);
+            }
+        } else if (strcmp(key, "mirror_select") == 0) {
+            strncpy(config->mirror_select, value, sizeof(config->mirror_select) - 1);
+        } else if (strcmp(key, "transport") == 0) {
+            if (strcmp(value, "udp") == 0) {
+                config->udp = true;
+            } else if (strcmp(value, "tcp") == 0) {
+                config->udp = false;
+            } else {
+                LOG_ERROR("설정 파일 %d번째 줄: 알 수 없는 전송 계층: %s (tcp, udp)", line_num, value);
+            }
+        } else if (strcmp(key, "udp_idle") == 0) {
+            int idle = atoi(value);
+            if (idle <= 0) {
+                LOG_ERROR("설정 파일 %d번째 줄: 잘못된 UDP 유휴 시간: %s (초, 양수)", line_num, value);
+            } else {
+                config->udp_idle_sec = idle;
+            }
+        } else if (strcmp(key, "udp_gso") == 0) {
+            config->udp_gso = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
+        } else if (strcmp(key, "filter") == 0) {
+            // 필터 명세 (예: filter=delay=100 dir=s2c)
+            Filter filter;
+            char err[128];
+            if (!filter_parse_spec(value, &filter, err, sizeof(err))) {
+                LOG_ERROR("설정 파일 %d번째 줄: 잘못된 필터 명세 (%s)", line_num, err);
+            } else if (filter_chain_add(filter_chain, &filter)) {
+                config->enable_filters = true;
+            }
         }
     }
     
     fclose(fp);
+
+    // 리스닝 주소가 없는 구역은 시작할 수 없으므로 뺌
+    int kept = 0;
+    for (int i = 0; i < config->listener_count; i++) {
+        ListenerConfig *listener = &config->listeners[i];
+        if (listener->listen_port <= 0 && config_unix_path(listener->listen_host) == NULL) {
+            LOG_ERROR("설정 파일: 리스너 [%s]에 listen=이 없어 제외합니다", listener->name);
+            continue;
+        }
+        if (kept != i) {
+            config->listeners[kept] = *listener;
+        }
+        kept++;
+    }
+    config->listener_count = kept;
+
     LOG_INFO("설정 파일 로드 완료: %s", config_file);
     return true;
 }
 
+const ListenerConfig *config_active_listeners(const ProxyConfig *config, int *count) {
+    if (config->listener_count > 0) {
+        *count = config->listener_count;
+        return config->listeners;
+    }
+    *count = 1;
+    return &config->listener;
+}
+
 void config_print(const ProxyConfig *config) {
     LOG_INFO("=== 프록시 설정 ===");
-    LOG_INFO("  리스닝 포트: %d", config->listen_port);
-    LOG_INFO("  대상 서버: %s:%d", config->target_host, config->target_port);
+    int count;
+    const ListenerConfig *listeners = config_active_listeners(config, &count);
+    for (int i = 0; i < count; i++) {
+        const ListenerConfig *listener = &listeners[i];
+        char listen[MAX_HOST_LEN + 16];
+        char target[MAX_HOST_LEN + 16];
+        config_format_endpoint(listener->listen_host, listener->listen_port, listen, sizeof(listen));
+        config_format_endpoint(listener->target_host, listener->target_port, target, sizeof(target));
+        if (config->listener_count > 0) {
+            LOG_INFO("  리스너 [%s]: %s -> %s", listener->name, listen, target);
+        } else {
+            LOG_INFO("  리스닝: %s", listen);
+            LOG_INFO("  대상 서버: %s", target);
+        }
+        if (listener->protocol != PROTOCOL_RAW) {
+            LOG_INFO("    프로토콜: %s", config_protocol_name(listener->protocol));
+        }
+        if (listener->proxy_protocol != 0) {
+            LOG_INFO("    PROXY 프로토콜: %s", config_proxy_protocol_name(listener->proxy_protocol));
+        }
+        if (listener->sni_route_count > 0) {
+            LOG_INFO("    SNI 라우팅: 규칙 %d개 (맞는 규칙이 없으면 대상 서버로)", listener->sni_route_count);
+        }
+    }
+    if (config->udp) {
+        LOG_INFO("  전송 계층: UDP (유휴 %d초 후 세션 만료, GSO/GRO %s)", config->udp_idle_sec,
+                 config->udp_gso ? "사용" : "사용 안 함");
+    }
     LOG_INFO("  로깅: %s", config->enable_logging ? "활성화" : "비활성화");
     if (config->enable_logging) {
         LOG_INFO("  로그 파일: %s", config->log_file);
     }
     LOG_INFO("  필터: %s", config->enable_filters ? "활성화" : "비활성화");
+    if (config->capture_file[0] != '\0') {
+        LOG_INFO("  캡처: %s (%s)", config->capture_file,
+                 config->capture_select[0] ? config->capture_select : "모든 연결");
+    }
+    if (config->mirror_host[0] != '\0') {
+        LOG_INFO("  섀도 미러링: %s:%d (%s)", config->mirror_host, config->mirror_port,
+                 config->mirror_select[0] ? config->mirror_select : "모든 연결");
+    }
+    if (config->scenario_file[0] != '\0') {
+        LOG_INFO("  시나리오: %s", config->scenario_file);
+    }
+    LOG_INFO("  난수 시드: %lu (재현하려면 -s %lu 또는 seed=%lu)",
+             config->seed, config->seed, config->seed);
 }
@@ -1,5 +1,10 @@
 #include "../include/control.h"
 #include "../include/logger.h"
+#include "../include/probes.h"
+#include "../include/filter.h"
+#include "../include/scenario.h"
+#include "../include/latency.h"
+#include "../include/config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,13 +14,49 @@
 #include <sys/mman.h>
 #include <pthread.h>
 #include <signal.h>
+#include <poll.h>
 #include <errno.h>
 
+// 누적 트래픽 카운터 (이력 구간은 이 값의 차이로 계산)
+typedef struct {
+    uint64_t client_to_server_bytes;
+    uint64_t server_to_client_bytes;
+    uint64_t connections_opened;
+    uint64_t connections_closed;
+    uint64_t packets_dropped;
+    uint64_t connect_errors;
+} TrafficTotals;
+
 // 공유 메모리 구조체
 typedef struct {
-    ConnectionInfo connections[100];
+    ConnectionInfo connections[MAX_CONNECTIONS];   // 앞쪽 connection_count개만 사용 (순서 없음)
     int connection_count;
+    int unregistered;                     // 표가 가득 차 등록하지 못한 활성 연결 수
+    uint64_t unregistered_total;
     pthread_mutex_t mutex;
+
+    // 처리량 이력
+    TrafficTotals totals;
+    TrafficTotals last_totals;            // 직전 tick 시점의 누적값
+    time_t last_tick;
+    HistoryBucket seconds[HISTORY_SECONDS];
+    HistoryBucket minutes[HISTORY_MINUTES];
+    HistoryBucket current_minute;         // 집계 중인 분 구간
+    uint64_t seconds_written;
+    uint64_t minutes_written;
+
+    // 런타임 필터 테이블 (seqlock: 세대가 홀수면 갱신 중)
+    uint32_t filter_generation;
+    FilterChain filter_chain;
+    uint32_t next_filter_id;
+    FilterCounters filter_counters[MAX_FILTERS][FILTER_DIR_COUNT]; // 테이블 순서와 동일
+
+    // 프로토콜 모드 쿼리 지연 (모든 연결 합계)
+    QueryStats query_stats;
+
+    // 리스너별 누적 (totals와 같은 시점에 같은 양을 더함)
+    ListenerStats listeners[MAX_LISTENERS];
+    int listener_count;
 } SharedConnectionData;
 
 // 공유 메모리로 관리되는 연결 정보
@@ -24,6 +65,16 @@ static int g_control_sock = -1;
 static pthread_t g_control_thread;
 static volatile bool g_control_running = false;
 
+// 시나리오 실행 상태 (부모 프로세스 전용, g_shared_data->mutex로 보호)
+static Scenario g_scenario;
+static bool g_scenario_loaded = false;
+static bool g_scenario_running = false;
+static int g_scenario_next = 0;              // 다음에 적용할 단계
+static uint64_t g_scenario_start_ms = 0;
+static char g_scenario_last[160];
+
+static int scenario_tick(void);
+
 // 공유 메모리 초기화
 static int init_shared_memory(void) {
     // 익명 공유 메모리 생성
@@ -36,9 +87,9 @@ static int init_shared_memory(void) {
         return -1;
     }
 
-    // 초기화
-    memset(g_shared_data, 0, sizeof(SharedConnectionData));
+    // 익명 매핑은 0으로 채워져 있음 (연결 표 전체를 memset으로 건드리지 않음)
     g_shared_data->connection_count = 0;
+    g_shared_data->last_tick = time(NULL);
 
     // 프로세스 간 공유 가능한 mutex 초기화
     pthread_mutexattr_t attr;
@@ -59,11 +110,160 @@ static void cleanup_shared_memory(void) {
     }
 }
 
-// 제어 서버 스레드
+static void bucket_add(HistoryBucket *dst, const HistoryBucket *src) {
+    dst->end_time = src->end_time;
+    dst->duration_sec += src->duration_sec;
+    dst->client_to_server_bytes += src->client_to_server_bytes;
+    dst->server_to_client_bytes += src->server_to_client_bytes;
+    dst->connections_opened += src->connections_opened;
+    dst->connections_closed += src->connections_closed;
+    dst->packets_dropped += src->packets_dropped;
+    dst->connect_errors += src->connect_errors;
+}
+
+static ListenerStats *listener_stats_locked(int listener);
+
+// 해제하지 못하고 끝난 자식(SIGKILL, 비정상 종료)의 항목 제거 (뮤텍스 보유 상태, 1초마다)
+// 부모가 SIGCHLD에서 바로 회수하므로 없는 PID는 끝난 연결이고, 종료 수도 여기서 셈
+static void prune_dead_connections_locked(void) {
+    for (int i = 0; i < g_shared_data->connection_count; ) {
+        ConnectionInfo *info = &g_shared_data->connections[i];
+        if (kill(info->pid, 0) == 0 || errno != ESRCH) {
+            i++;
+            continue;
+        }
+        LOG_WARN("해제 없이 끝난 연결 정리: PID=%d (연결 #%lu)", info->pid, info->conn_id);
+        g_shared_data->totals.connections_closed++;
+        ListenerStats *listener = listener_stats_locked(info->listener_index);
+        if (listener) {
+            listener->connections_closed++;
+        }
+        *info = g_shared_data->connections[--g_shared_data->connection_count];
+    }
+}
+
+// 직전 tick 이후 증가분을 초 구간으로 기록하고 분 구간에 누적
+static void history_tick(time_t now) {
+    pthread_mutex_lock(&g_shared_data->mutex);
+
+    TrafficTotals *cur = &g_shared_data->totals;
+    TrafficTotals *prev = &g_shared_data->last_totals;
+
+    if (now <= g_shared_data->last_tick) {
+        pthread_mutex_unlock(&g_shared_data->mutex);
+        return;
+    }
+    prune_dead_connections_locked();
+
+    HistoryBucket bucket = {
+        .end_time = now,
+        .duration_sec = (int)(now - g_shared_data->last_tick),
+        .client_to_server_bytes = cur->client_to_server_bytes - prev->client_to_server_bytes,
+        .server_to_client_bytes = cur->server_to_client_bytes - prev->server_to_client_bytes,
+        .connections_opened = (uint32_t)(cur->connections_opened - prev->connections_opened),
+        .connections_closed = (uint32_t)(cur->connections_closed - prev->connections_closed),
+        .packets_dropped = (uint32_t)(cur->packets_dropped - prev->packets_dropped),
+        .connect_errors = (uint32_t)(cur->connect_errors - prev->connect_errors),
+    };
+
+    g_shared_data->seconds[g_shared_data->seconds_written++ % HISTORY_SECONDS] = bucket;
+
+    // 분 경계를 넘으면 집계 중인 분 구간 확정
+    HistoryBucket *minute = &g_shared_data->current_minute;
+    if (minute->duration_sec > 0 &&
+        (minute->end_time - 1) / 60 != (bucket.end_time - 1) / 60) {
+        g_shared_data->minutes[g_shared_data->minutes_written++ % HISTORY_MINUTES] = *minute;
+        memset(minute, 0, sizeof(HistoryBucket));
+    }
+    bucket_add(minute, &bucket);
+
+    *prev = *cur;
+    g_shared_data->last_tick = now;
+
+    pthread_mutex_unlock(&g_shared_data->mutex);
+}
+
+// 이력 복사 (뮤텍스 보유 상태에서 호출)
+static void history_dump(int interval_sec, int count, HistoryDump *dump) {
+    const HistoryBucket *ring;
+    uint64_t written;
+    int capacity;
+
+    if (interval_sec >= 60) {
+        ring = g_shared_data->minutes;
+        written = g_shared_data->minutes_written;
+        capacity = HISTORY_MINUTES;
+        dump->interval_sec = 60;
+    } else {
+        ring = g_shared_data->seconds;
+        written = g_shared_data->seconds_written;
+        capacity = HISTORY_SECONDS;
+        dump->interval_sec = 1;
+    }
+
+    // 분 단위는 집계 중인 구간을 마지막에 포함
+    bool with_partial = dump->interval_sec == 60 && g_shared_data->current_minute.duration_sec > 0;
+    int limit = with_partial ? capacity - 1 : capacity;
+
+    if (count <= 0 || count > limit) count = limit;
+    if ((uint64_t)count > written) count = (int)written;
+
+    for (int i = 0; i < count; i++) {
+        dump->buckets[i] = ring[(written - count + i) % capacity];
+    }
+    if (with_partial) {
+        dump->buckets[count++] = g_shared_data->current_minute;
+    }
+    dump->count = count;
+}
+
+// 다음 초 경계까지 남은 시간 (ms)
+static int ms_until_next_second(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return 1000 - (int)(ts.tv_nsec / 1000000);
+}
+
+// 현재 시각 (초)
+// time()은 coarse 시계라 경계 직후 이전 초를 돌려줄 수 있으므로 poll 대기와 같은 시계 사용
+static time_t current_second(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec;
+}
+
+// 제어 서버 스레드 (요청 처리 + 1초마다 이력 기록 + 시나리오 단계 적용)
 static void* control_server_thread(void *arg) {
-    const char *socket_path = (const char*)arg;
+    (void)arg;
 
     while (g_control_running) {
+        // 1초 경계(이력 기록) 또는 다음 시나리오 단계 중 먼저 오는 시각까지 대기
+        int timeout_ms = ms_until_next_second();
+        int scenario_ms = scenario_tick();
+        if (scenario_ms >= 0 && scenario_ms < timeout_ms) {
+            timeout_ms = scenario_ms;
+        }
+
+        struct pollfd pfd = { .fd = g_control_sock, .events = POLLIN };
+        int ready = poll(&pfd, 1, timeout_ms);
+
+        if (!g_control_running) {
+            break;
+        }
+
+        history_tick(current_second());
+
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("제어 소켓 poll 실패: %s", strerror(errno));
+            break;
+        }
+        if (ready == 0 || !(pfd.revents & POLLIN)) {
+            continue;
+        }
+
         struct sockaddr_un client_addr;
         socklen_t client_len = sizeof(client_addr);
 
@@ -148,29 +348,75 @@ void control_server_stop(void) {
     cleanup_shared_memory();
 }
 
-void control_register_connection(const Connection *conn) {
+// 리스너 번호의 누적 통계 (뮤텍스 보유 상태, 게시 전이거나 범위를 벗어나면 NULL)
+static ListenerStats *listener_stats_locked(int listener) {
+    if (listener < 0 || listener >= g_shared_data->listener_count) {
+        return NULL;
+    }
+    return &g_shared_data->listeners[listener];
+}
+
+void control_listeners_publish(const ListenerConfig *listeners, int count) {
+    if (g_shared_data == NULL) return;
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+    memset(g_shared_data->listeners, 0, sizeof(g_shared_data->listeners));
+    for (int i = 0; i < count && i < MAX_LISTENERS; i++) {
+        ListenerStats *stats = &g_shared_data->listeners[i];
+        memcpy(stats->name, listeners[i].name, sizeof(stats->name));
+        config_format_endpoint(listeners[i].listen_host, listeners[i].listen_port,
+                               stats->listen, sizeof(stats->listen));
+        config_format_endpoint(listeners[i].target_host, listeners[i].target_port,
+                               stats->target, sizeof(stats->target));
+        stats->protocol = listeners[i].protocol;
+        stats->sni_route_count = listeners[i].sni_route_count;
+    }
+    g_shared_data->listener_count = count < MAX_LISTENERS ? count : MAX_LISTENERS;
+    pthread_mutex_unlock(&g_shared_data->mutex);
+}
+
+void control_register_connection(Connection *conn) {
     if (g_shared_data == NULL) return;
 
     pthread_mutex_lock(&g_shared_data->mutex);
 
-    if (g_shared_data->connection_count >= 100) {
-        LOG_WARN("최대 연결 수 초과, 등록 실패");
+    g_shared_data->totals.connections_opened++;
+    ListenerStats *listener = listener_stats_locked(conn->listener);
+    if (listener) {
+        listener->connections_opened++;
+    }
+
+    // 표가 가득 차도 연결은 계속 중계 (트래픽은 누적값에 반영되고 개수만 따로 셈)
+    if (g_shared_data->connection_count >= MAX_CONNECTIONS) {
+        conn->control_slot = -1;
+        g_shared_data->unregistered++;
+        g_shared_data->unregistered_total++;
         pthread_mutex_unlock(&g_shared_data->mutex);
+        LOG_WARN("연결 표가 가득 참 (%d개), PID=%d는 목록/top/일괄 명령에서 빠짐",
+                 MAX_CONNECTIONS, conn->pid);
         return;
     }
 
+    conn->control_slot = g_shared_data->connection_count;
     ConnectionInfo *info = &g_shared_data->connections[g_shared_data->connection_count++];
     info->pid = conn->pid;
-    strncpy(info->client_addr, conn->client_addr, MAX_ADDR_LEN - 1);
-    info->client_addr[MAX_ADDR_LEN - 1] = '\0';
+    info->conn_id = conn->conn_id;
+    info->listener_index = conn->listener;
+    memcpy(info->listener, conn->listener_name, sizeof(info->listener));
+    snprintf(info->client_addr, sizeof(info->client_addr), "%s", conn->client_addr);
     info->client_port = conn->client_port;
-    strncpy(info->target_addr, conn->target_addr, MAX_ADDR_LEN - 1);
-    info->target_addr[MAX_ADDR_LEN - 1] = '\0';
+    snprintf(info->target_addr, sizeof(info->target_addr), "%s", conn->target_addr);
     info->target_port = conn->target_port;
+    snprintf(info->sni, sizeof(info->sni), "%s", conn->sni);
     info->client_to_server_bytes = 0;
     info->server_to_client_bytes = 0;
+    info->packets_dropped = 0;
     info->start_time = conn->stats.start_time;
     info->last_activity = conn->stats.last_activity;
+    info->client_tcp = conn->stats.client_tcp;
+    info->server_tcp = conn->stats.server_tcp;
+    info->rates = conn->stats.rates;
+    info->abort_requested = false;
 
     pthread_mutex_unlock(&g_shared_data->mutex);
 
@@ -179,40 +425,770 @@ void control_register_connection(const Connection *conn) {
               conn->target_addr, conn->target_port);
 }
 
-void control_unregister_connection(pid_t pid) {
+// 자식의 목록 항목 (뮤텍스 보유 상태, 힌트 위치가 다른 연결로 바뀌었으면 다시 찾음, 없으면 NULL)
+static ConnectionInfo *connection_slot_locked(Connection *conn) {
+    int slot = conn->control_slot;
+    if (slot < 0) {
+        return NULL;
+    }
+    if (slot >= g_shared_data->connection_count ||
+        g_shared_data->connections[slot].pid != conn->pid) {
+        // 다른 연결이 해제되며 이 항목이 그 빈자리로 옮겨진 경우
+        for (slot = 0; slot < g_shared_data->connection_count; slot++) {
+            if (g_shared_data->connections[slot].pid == conn->pid) {
+                break;
+            }
+        }
+        if (slot == g_shared_data->connection_count) {
+            return NULL;
+        }
+        conn->control_slot = slot;
+    }
+    return &g_shared_data->connections[slot];
+}
+
+void control_unregister_connection(Connection *conn) {
     if (g_shared_data == NULL) return;
 
     pthread_mutex_lock(&g_shared_data->mutex);
 
+    g_shared_data->totals.connections_closed++;
+    ListenerStats *listener = listener_stats_locked(conn->listener);
+    if (listener) {
+        listener->connections_closed++;
+    }
+
+    if (conn->control_slot < 0) {
+        g_shared_data->unregistered--;
+    } else {
+        ConnectionInfo *info = connection_slot_locked(conn);
+        if (info) {
+            // 마지막 항목을 빈자리로 옮김 (표가 커도 해제 비용은 항목 하나)
+            ConnectionInfo *last = &g_shared_data->connections[--g_shared_data->connection_count];
+            if (info != last) {
+                *info = *last;
+            }
+            LOG_DEBUG("연결 해제: PID=%d", conn->pid);
+        }
+    }
+
+    pthread_mutex_unlock(&g_shared_data->mutex);
+}
+
+bool control_abort_requested(pid_t pid) {
+    if (g_shared_data == NULL) return false;
+
+    bool abort = false;
+    pthread_mutex_lock(&g_shared_data->mutex);
     for (int i = 0; i < g_shared_data->connection_count; i++) {
         if (g_shared_data->connections[i].pid == pid) {
-            // 배열에서 제거 (뒤의 요소들을 앞으로 이동)
-            memmove(&g_shared_data->connections[i], &g_shared_data->connections[i + 1],
-                    (g_shared_data->connection_count - i - 1) * sizeof(ConnectionInfo));
-            g_shared_data->connection_count--;
-            LOG_DEBUG("연결 해제: PID=%d", pid);
+            abort = g_shared_data->connections[i].abort_requested;
             break;
         }
     }
+    pthread_mutex_unlock(&g_shared_data->mutex);
+    return abort;
+}
+
+void control_update_stats(Connection *conn) {
+    if (g_shared_data == NULL) return;
+
+    const ConnectionStats *stats = &conn->stats;
+    uint32_t dropped = stats->client_to_server_dropped + stats->server_to_client_dropped;
+    uint64_t c2s = stats->client_to_server_bytes - conn->published_c2s;
+    uint64_t s2c = stats->server_to_client_bytes - conn->published_s2c;
+    uint32_t new_drops = dropped - conn->published_dropped;
+    conn->published_c2s = stats->client_to_server_bytes;
+    conn->published_s2c = stats->server_to_client_bytes;
+    conn->published_dropped = dropped;
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+
+    // 증가분은 목록 등록 여부와 관계없이 전체 누적 카운터와 리스너 누적에 반영
+    g_shared_data->totals.client_to_server_bytes += c2s;
+    g_shared_data->totals.server_to_client_bytes += s2c;
+    g_shared_data->totals.packets_dropped += new_drops;
+    ListenerStats *listener = listener_stats_locked(conn->listener);
+    if (listener) {
+        listener->client_to_server_bytes += c2s;
+        listener->server_to_client_bytes += s2c;
+        listener->packets_dropped += new_drops;
+    }
+
+    ConnectionInfo *info = connection_slot_locked(conn);
+    if (info) {
+        info->client_to_server_bytes = stats->client_to_server_bytes;
+        info->server_to_client_bytes = stats->server_to_client_bytes;
+        info->packets_dropped = dropped;
+        info->last_activity = stats->last_activity;
+        info->client_tcp = stats->client_tcp;
+        info->server_tcp = stats->server_tcp;
+        info->rates = stats->rates;
+    }
 
     pthread_mutex_unlock(&g_shared_data->mutex);
 }
 
-void control_update_stats(pid_t pid, const ConnectionStats *stats) {
+// EWMA 창 인덱스 (1, 10, 60초)
+static int rate_window_index(int window_sec) {
+    if (window_sec >= 60) return 2;
+    if (window_sec >= 10) return 1;
+    return 0;
+}
+
+static float connection_rate(const ConnectionInfo *info, int window) {
+    return info->rates.client_to_server[window] + info->rates.server_to_client[window];
+}
+
+// top 정렬 키 (연결 표 항목 대신 처리량과 표 위치만 옮김)
+typedef struct {
+    float rate;
+    int index;
+} RateKey;
+
+static int compare_rate_desc(const void *a, const void *b) {
+    float x = ((const RateKey *)a)->rate;
+    float y = ((const RateKey *)b)->rate;
+    return x > y ? -1 : x < y;
+}
+
+// 처리량 내림차순으로 상위 k개를 앞쪽에 모으고 그 k개만 정렬 (quickselect + 부분 정렬)
+static void partial_sort_by_rate(RateKey *keys, int n, int k) {
+    int left = 0, right = n - 1;
+
+    while (left < right) {
+        float pivot = keys[(left + right) / 2].rate;
+        int i = left, j = right;
+
+        while (i <= j) {
+            while (keys[i].rate > pivot) i++;
+            while (keys[j].rate < pivot) j--;
+            if (i <= j) {
+                RateKey tmp = keys[i];
+                keys[i] = keys[j];
+                keys[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+
+        // k번째 경계가 속한 쪽만 계속 분할
+        if (k - 1 <= j) {
+            right = j;
+        } else if (k - 1 >= i) {
+            left = i;
+        } else {
+            break;
+        }
+    }
+
+    // 상위 k개만 정렬 (top 0이면 표 전체)
+    qsort(keys, k, sizeof(RateKey), compare_rate_desc);
+}
+
+// 필터 테이블 교체 (뮤텍스 보유 상태에서 호출, 읽는 쪽은 락 없이 세대로 검증)
+static void filter_table_store(const FilterChain *chain) {
+    uint32_t generation = g_shared_data->filter_generation;
+
+    __atomic_store_n(&g_shared_data->filter_generation, generation + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(&g_shared_data->filter_chain, chain, sizeof(FilterChain));
+
+    __atomic_store_n(&g_shared_data->filter_generation, generation + 2, __ATOMIC_RELEASE);
+}
+
+void control_filter_publish(const FilterChain *chain) {
     if (g_shared_data == NULL) return;
 
+    FilterChain table;
+    if (chain == NULL) {
+        filter_chain_init(&table);
+    } else {
+        table = *chain;
+    }
+
     pthread_mutex_lock(&g_shared_data->mutex);
+    for (int i = 0; i < table.count; i++) {
+        table.filters[i].id = ++g_shared_data->next_filter_id;
+    }
+    memset(g_shared_data->filter_counters, 0, sizeof(g_shared_data->filter_counters));
+    filter_table_store(&table);
+    pthread_mutex_unlock(&g_shared_data->mutex);
+}
 
-    for (int i = 0; i < g_shared_data->connection_count; i++) {
-        if (g_shared_data->connections[i].pid == pid) {
-            g_shared_data->connections[i].client_to_server_bytes = stats->client_to_server_bytes;
-            g_shared_data->connections[i].server_to_client_bytes = stats->server_to_client_bytes;
-            g_shared_data->connections[i].last_activity = stats->last_activity;
+bool control_filter_sync(FilterChain *chain, uint32_t *generation) {
+    if (g_shared_data == NULL) return false;
+
+    uint32_t current = __atomic_load_n(&g_shared_data->filter_generation, __ATOMIC_ACQUIRE);
+    if (current == *generation) {
+        return false;  // 변경 없음 (빠른 경로)
+    }
+
+    FilterChain copy;
+    for (;;) {
+        uint32_t before = __atomic_load_n(&g_shared_data->filter_generation, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue;  // 갱신 중
+        }
+
+        memcpy(&copy, &g_shared_data->filter_chain, sizeof(FilterChain));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&g_shared_data->filter_generation, __ATOMIC_RELAXED) == before) {
+            current = before;
             break;
         }
     }
 
+    memcpy(chain, &copy, sizeof(FilterChain));
+    *generation = current;
+    return true;
+}
+
+void control_filter_account(const FilterChain *chain, int direction, FilterCounters *pending) {
+    if (g_shared_data == NULL || chain->count == 0) return;
+
+    int dir = direction - 1;
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+
+    // 테이블 위치는 제거 시 바뀌므로 id로 찾음 (이미 제거된 필터의 효과는 버림)
+    const FilterChain *table = &g_shared_data->filter_chain;
+    for (int i = 0; i < chain->count; i++) {
+        if (pending[i].chunks == 0) continue;
+
+        for (int j = 0; j < table->count; j++) {
+            if (table->filters[j].id == chain->filters[i].id) {
+                FilterCounters *total = &g_shared_data->filter_counters[j][dir];
+                total->chunks += pending[i].chunks;
+                total->bytes += pending[i].bytes;
+                total->dropped += pending[i].dropped;
+                total->delay_us += pending[i].delay_us;
+                total->modified += pending[i].modified;
+                break;
+            }
+        }
+    }
+
     pthread_mutex_unlock(&g_shared_data->mutex);
+
+    memset(pending, 0, chain->count * sizeof(FilterCounters));
+}
+
+// 이름이 게시된 리스너인지 (뮤텍스 보유 상태, 오타로 어느 연결에도 맞지 않는 필터를 막음)
+static bool listener_known_locked(const char *name) {
+    for (int i = 0; i < g_shared_data->listener_count; i++) {
+        if (strcmp(g_shared_data->listeners[i].name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 필터 테이블 편집 (뮤텍스 보유 상태에서 호출, 효과 카운터도 테이블 순서에 맞춰 옮김)
+// 게시는 호출한 쪽이 filter_table_store로 하므로 여러 편집을 한 세대로 묶을 수 있다.
+static bool filter_table_edit(FilterChain *chain, ControlCommand cmd, int index, const char *spec,
+                              char *message, size_t message_len) {
+    char err[128] = {0};
+    bool changed = false;
+
+    switch (cmd) {
+        case CMD_FILTER_ADD: {
+            Filter filter;
+            if (!filter_parse_spec(spec, &filter, err, sizeof(err))) {
+                snprintf(message, message_len, "필터 명세 오류: %s", err);
+            } else if ((filter.selector.flags & SELECT_LISTENER) &&
+                       !listener_known_locked(filter.selector.listener)) {
+                snprintf(message, message_len, "알 수 없는 리스너: %s (proxyctl listeners로 확인)",
+                         filter.selector.listener);
+            } else if (!filter_chain_add(chain, &filter)) {
+                snprintf(message, message_len,
+                         "필터 체인이 가득 찼습니다 (최대 %d개)", MAX_FILTERS);
+            } else {
+                chain->filters[chain->count - 1].id = ++g_shared_data->next_filter_id;
+                memset(g_shared_data->filter_counters[chain->count - 1], 0,
+                       sizeof(g_shared_data->filter_counters[0]));
+                changed = true;
+                snprintf(message, message_len, "필터 [%d] 추가: %s", chain->count - 1, spec);
+            }
+            break;
+        }
+
+        case CMD_FILTER_REMOVE:
+            changed = filter_chain_remove(chain, index);
+            if (changed) {
+                // 효과 카운터도 테이블 순서에 맞춰 당김
+                memmove(g_shared_data->filter_counters[index],
+                        g_shared_data->filter_counters[index + 1],
+                        (chain->count - index) * sizeof(g_shared_data->filter_counters[0]));
+            }
+            snprintf(message, message_len,
+                     changed ? "필터 [%d] 제거" : "필터 [%d]를 찾을 수 없음", index);
+            break;
+
+        case CMD_FILTER_ENABLE:
+        case CMD_FILTER_DISABLE: {
+            bool enable = cmd == CMD_FILTER_ENABLE;
+            changed = filter_chain_set_enabled(chain, index, enable);
+            if (changed) {
+                snprintf(message, message_len, "필터 [%d] %s", index, enable ? "활성화" : "비활성화");
+            } else {
+                snprintf(message, message_len, "필터 [%d]를 찾을 수 없음", index);
+            }
+            break;
+        }
+
+        case CMD_FILTER_CLEAR:
+            filter_chain_init(chain);
+            memset(g_shared_data->filter_counters, 0, sizeof(g_shared_data->filter_counters));
+            changed = true;
+            snprintf(message, message_len, "모든 필터 제거");
+            break;
+
+        default:
+            break;
+    }
+
+    return changed;
+}
+
+// CMD_FILTER_* 처리 (뮤텍스 보유 상태에서 호출)
+static void handle_filter_command(const ControlRequest *req, ControlResponse *resp) {
+    FilterChain chain = g_shared_data->filter_chain;
+    bool changed = false;
+
+    if (req->cmd == CMD_FILTER_LIST) {
+        resp->success = true;
+        snprintf(resp->message, sizeof(resp->message), "필터 %d개", chain.count);
+    } else {
+        changed = filter_table_edit(&chain, req->cmd, req->filter_index, req->filter_spec,
+                                    resp->message, sizeof(resp->message));
+    }
+
+    if (changed) {
+        filter_table_store(&chain);
+        resp->success = true;
+        LOG_INFO("필터 테이블 변경 (세대 %u): %s", g_shared_data->filter_generation, resp->message);
+    }
+
+    resp->filters = g_shared_data->filter_chain;
+    resp->filter_generation = g_shared_data->filter_generation;
+    memcpy(resp->filter_counters, g_shared_data->filter_counters, sizeof(resp->filter_counters));
+}
+
+static uint64_t scenario_clock_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 시각이 된 단계를 모두 적용해 한 세대로 게시 (뮤텍스 보유 상태에서 호출)
+// 연결들은 다음 청크에서 중간 상태 없이 새 테이블을 본다. 다음 단계까지 남은 ms, 없으면 -1
+static int scenario_tick_locked(uint64_t now_ms) {
+    if (!g_scenario_running) {
+        return -1;
+    }
+
+    uint64_t elapsed = now_ms - g_scenario_start_ms;
+    FilterChain chain = g_shared_data->filter_chain;
+    bool changed = false;
+
+    while (g_scenario_next < g_scenario.count &&
+           g_scenario.steps[g_scenario_next].at_ms <= elapsed) {
+        const ScenarioStep *step = &g_scenario.steps[g_scenario_next++];
+        char message[256];
+
+        scenario_step_describe(step, g_scenario_last, sizeof(g_scenario_last));
+        if (step->cmd != CMD_FILTER_LIST) {
+            if (filter_table_edit(&chain, step->cmd, step->index, step->spec,
+                                  message, sizeof(message))) {
+                changed = true;
+            } else {
+                LOG_WARN("시나리오 %d행 적용 실패: %s", step->line, message);
+            }
+        }
+        LOG_INFO("시나리오 [%d/%d] %s", g_scenario_next, g_scenario.count, g_scenario_last);
+    }
+
+    if (changed) {
+        filter_table_store(&chain);
+        LOG_INFO("시나리오로 필터 테이블 변경 (세대 %u, 필터 %d개)",
+                 g_shared_data->filter_generation, chain.count);
+    }
+
+    if (g_scenario_next >= g_scenario.count) {
+        g_scenario_running = false;
+        LOG_INFO("시나리오 완료: %s", g_scenario.path);
+        return -1;
+    }
+    return (int)(g_scenario.steps[g_scenario_next].at_ms - elapsed);
+}
+
+static int scenario_tick(void) {
+    if (g_shared_data == NULL) return -1;
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+    int wait_ms = scenario_tick_locked(scenario_clock_ms());
+    pthread_mutex_unlock(&g_shared_data->mutex);
+    return wait_ms;
+}
+
+// 새 시나리오로 교체하고 t=0 단계를 바로 적용 (뮤텍스 보유 상태에서 호출)
+static void scenario_install_locked(const Scenario *scenario) {
+    g_scenario = *scenario;
+    g_scenario_loaded = true;
+    g_scenario_running = true;
+    g_scenario_next = 0;
+    g_scenario_start_ms = scenario_clock_ms();
+    g_scenario_last[0] = '\0';
+
+    LOG_INFO("시나리오 시작: %s (%d단계, %.1f초)", scenario->path, scenario->count,
+             scenario->steps[scenario->count - 1].at_ms / 1000.0);
+    scenario_tick_locked(g_scenario_start_ms);
+}
+
+static void scenario_status_locked(ScenarioStatus *status) {
+    memset(status, 0, sizeof(ScenarioStatus));
+    if (!g_scenario_loaded) {
+        return;
+    }
+
+    status->loaded = true;
+    status->running = g_scenario_running;
+    snprintf(status->path, sizeof(status->path), "%s", g_scenario.path);
+    status->step_count = g_scenario.count;
+    status->steps_done = g_scenario_next;
+    status->elapsed_ms = scenario_clock_ms() - g_scenario_start_ms;
+    snprintf(status->last_step, sizeof(status->last_step), "%s", g_scenario_last);
+    if (g_scenario_running) {
+        const ScenarioStep *next = &g_scenario.steps[g_scenario_next];
+        status->next_at_ms = next->at_ms;
+        scenario_step_describe(next, status->next_step, sizeof(status->next_step));
+    }
+}
+
+bool control_scenario_start(const char *path) {
+    if (g_shared_data == NULL) {
+        LOG_ERROR("제어 서버가 없어 시나리오를 실행할 수 없습니다");
+        return false;
+    }
+
+    Scenario scenario;
+    char err[256];
+    if (!scenario_load(path, &scenario, err, sizeof(err))) {
+        LOG_ERROR("시나리오 로드 실패: %s", err);
+        return false;
+    }
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+    scenario_install_locked(&scenario);
+    pthread_mutex_unlock(&g_shared_data->mutex);
+    return true;
+}
+
+// CMD_SCENARIO_* 처리 (뮤텍스 보유 상태에서 호출, 파일은 호출 전에 읽어 둠)
+static void handle_scenario_command(const ControlRequest *req, const Scenario *loaded,
+                                    const char *load_err, ControlResponse *resp) {
+    switch (req->cmd) {
+        case CMD_SCENARIO_START:
+            if (loaded == NULL) {
+                snprintf(resp->message, sizeof(resp->message), "시나리오 로드 실패: %s", load_err);
+                break;
+            }
+            scenario_install_locked(loaded);
+            resp->success = true;
+            snprintf(resp->message, sizeof(resp->message), "시나리오 시작: %.200s (%d단계)",
+                     loaded->path, loaded->count);
+            break;
+
+        case CMD_SCENARIO_STOP:
+            if (!g_scenario_running) {
+                snprintf(resp->message, sizeof(resp->message), "진행 중인 시나리오가 없음");
+                break;
+            }
+            g_scenario_running = false;
+            resp->success = true;
+            snprintf(resp->message, sizeof(resp->message), "시나리오 중단 (%d/%d단계 적용, 필터 테이블 유지)",
+                     g_scenario_next, g_scenario.count);
+            LOG_INFO("%s", resp->message);
+            break;
+
+        default:
+            resp->success = true;
+            snprintf(resp->message, sizeof(resp->message), "시나리오 상태");
+            break;
+    }
+
+    scenario_status_locked(&resp->scenario);
+    resp->filters = g_shared_data->filter_chain;
+    resp->filter_generation = g_shared_data->filter_generation;
+}
+
+void control_query_account(QueryStats *pending) {
+    if (g_shared_data == NULL || (pending->count == 0 && pending->injected == 0)) return;
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+    latency_merge(&g_shared_data->query_stats, pending);
+    pthread_mutex_unlock(&g_shared_data->mutex);
+
+    memset(pending, 0, sizeof(QueryStats));
+}
+
+// 일괄 명령 선택자 (필터 선택자 + 유휴 시간/전송량/대상 조건, 여러 조건은 AND)
+#define BULK_IDLE       0x01
+#define BULK_BYTES_MIN  0x02
+#define BULK_BYTES_MAX  0x04
+#define BULK_TARGET     0x08
+
+typedef struct {
+    FilterSelector base;              // client=, ports=, conn=, pid=, percent=, listener=
+    uint32_t flags;
+    time_t idle_sec;                  // 마지막 활동 후 이 시간 이상
+    uint64_t bytes_min;               // 전체 전송량(양방향)이 이보다 큼
+    uint64_t bytes_max;               // 전체 전송량이 이보다 작음
+    char target_host[MAX_HOST_LEN];   // 빈 문자열 = 호스트 무관
+    int target_port;                  // 0 = 포트 무관
+} BulkSelector;
+
+// 유휴 시간 파싱 ("300", "300s", "5m", "1h") - 초 단위
+static bool parse_idle_sec(const char *value, time_t *out) {
+    char *endptr;
+    long n = strtol(value, &endptr, 10);
+    if (endptr == value || n < 0) {
+        return false;
+    }
+
+    if (strcmp(endptr, "m") == 0) {
+        n *= 60;
+    } else if (strcmp(endptr, "h") == 0) {
+        n *= 3600;
+    } else if (*endptr != '\0' && strcmp(endptr, "s") != 0) {
+        return false;
+    }
+
+    *out = (time_t)n;
+    return true;
+}
+
+// "db.local:3306", "db.local", ":3306"
+static bool parse_bulk_target(const char *value, BulkSelector *sel) {
+    const char *colon = strrchr(value, ':');
+    size_t host_len = colon ? (size_t)(colon - value) : strlen(value);
+
+    if (host_len >= sizeof(sel->target_host) || (host_len == 0 && colon == NULL)) {
+        return false;
+    }
+    memcpy(sel->target_host, value, host_len);
+    sel->target_host[host_len] = '\0';
+
+    sel->target_port = 0;
+    if (colon) {
+        char *endptr;
+        long port = strtol(colon + 1, &endptr, 10);
+        if (*endptr != '\0' || port < 1 || port > 65535) {
+            return false;
+        }
+        sel->target_port = (int)port;
+    }
+    return true;
+}
+
+// 선택자 파싱 ("idle=300 bytes<1M client=10.0.0.0/8 target=db:3306", 모든 연결은 "all")
+static bool parse_bulk_selector(const char *text, BulkSelector *sel, char *err, size_t err_len) {
+    char buf[MAX_FILTER_SPEC_LEN];
+    char *saveptr = NULL;
+    bool has_condition = false;
+
+    memset(sel, 0, sizeof(BulkSelector));
+    strncpy(buf, text, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (char *token = strtok_r(buf, " \t", &saveptr); token != NULL;
+         token = strtok_r(NULL, " \t", &saveptr)) {
+        if (strcmp(token, "all") == 0) {
+            has_condition = true;
+            continue;
+        }
+
+        // bytes>N, bytes<N (비교 연산자가 구분자)
+        if (strncmp(token, "bytes", 5) == 0 && (token[5] == '>' || token[5] == '<')) {
+            uint64_t *bound = token[5] == '>' ? &sel->bytes_min : &sel->bytes_max;
+            if (!filter_parse_byte_count(token + 6, bound)) {
+                snprintf(err, err_len, "잘못된 바이트 수: %s (예: bytes>10M)", token);
+                return false;
+            }
+            sel->flags |= token[5] == '>' ? BULK_BYTES_MIN : BULK_BYTES_MAX;
+            has_condition = true;
+            continue;
+        }
+
+        char *eq = strchr(token, '=');
+        if (eq == NULL || eq[1] == '\0') {
+            snprintf(err, err_len, "key=value 형식이 아닙니다: %s", token);
+            return false;
+        }
+        *eq = '\0';
+        const char *key = token;
+        const char *value = eq + 1;
+        has_condition = true;
+
+        if (strcmp(key, "idle") == 0) {
+            if (!parse_idle_sec(value, &sel->idle_sec)) {
+                snprintf(err, err_len, "잘못된 유휴 시간: %s (예: 300, 5m)", value);
+                return false;
+            }
+            sel->flags |= BULK_IDLE;
+        } else if (strcmp(key, "target") == 0) {
+            if (!parse_bulk_target(value, sel)) {
+                snprintf(err, err_len, "잘못된 대상: %s (host[:port] 또는 :port)", value);
+                return false;
+            }
+            sel->flags |= BULK_TARGET;
+        } else {
+            bool handled;
+            if (!filter_parse_selector_option(key, value, &sel->base, &handled, err, err_len)) {
+                return false;
+            }
+            if (!handled) {
+                snprintf(err, err_len, "알 수 없는 선택자: %s", key);
+                return false;
+            }
+        }
+    }
+
+    // 실수로 전체 연결을 끊지 않도록 조건이 없으면 거부
+    if (!has_condition) {
+        snprintf(err, err_len, "선택자가 비었습니다 (모든 연결은 all)");
+        return false;
+    }
+    return true;
+}
+
+// 싼 조건(정수 비교)부터 평가하고 주소 비교는 마지막에
+static bool bulk_selector_match(const BulkSelector *sel, const ConnectionInfo *info, time_t now) {
+    uint64_t bytes = info->client_to_server_bytes + info->server_to_client_bytes;
+
+    if ((sel->flags & BULK_IDLE) && now - info->last_activity < sel->idle_sec) {
+        return false;
+    }
+    if ((sel->flags & BULK_BYTES_MIN) && bytes <= sel->bytes_min) {
+        return false;
+    }
+    if ((sel->flags & BULK_BYTES_MAX) && bytes >= sel->bytes_max) {
+        return false;
+    }
+    if ((sel->flags & BULK_TARGET) &&
+        ((sel->target_port != 0 && info->target_port != sel->target_port) ||
+         (sel->target_host[0] != '\0' && strcmp(info->target_addr, sel->target_host) != 0))) {
+        return false;
+    }
+    return filter_selector_match(&sel->base, info->conn_id, info->pid,
+                                 info->client_addr, info->client_port, info->listener);
+}
+
+// 한 번의 순회로 대상을 rows에 모음 (시그널은 뮤텍스를 놓은 뒤 bulk_signal이 전송)
+static int bulk_select_locked(const ControlRequest *req, const BulkSelector *sel,
+                              ControlResponse *resp, ConnectionInfo *rows) {
+    time_t now = time(NULL);
+    int count = 0;
+
+    for (int i = 0; i < g_shared_data->connection_count; i++) {
+        ConnectionInfo *info = &g_shared_data->connections[i];
+        if (!bulk_selector_match(sel, info, now)) {
+            continue;
+        }
+        // 자식은 SIGTERM을 받은 뒤 이 표시로 FIN/RST를 고름
+        if (req->cmd == CMD_KILL_MATCHING && !req->dry_run) {
+            info->abort_requested = req->abortive;
+        }
+        rows[count++] = *info;
+    }
+
+    resp->connection_count = count;
+    resp->bulk.matched = count;
+    return count;
+}
+
+static void bulk_signal(const ControlRequest *req, const ConnectionInfo *rows, int count,
+                        ControlResponse *resp) {
+    int sig = req->cmd == CMD_KILL_MATCHING ? SIGTERM : req->signal_num;
+
+    if (!req->dry_run) {
+        for (int i = 0; i < count; i++) {
+            if (kill(rows[i].pid, sig) == 0) {
+                resp->bulk.signaled++;
+            } else {
+                resp->bulk.failed++;  // 그 사이 종료된 연결 (ESRCH)
+            }
+        }
+    }
+
+    const char *action = req->cmd == CMD_SIGNAL_MATCHING ? "시그널" :
+                         req->abortive ? "RST 종료" : "FIN 종료";
+    resp->success = true;
+    if (req->dry_run) {
+        snprintf(resp->message, sizeof(resp->message), "%d개 연결 일치 (dry-run, %s 요청 안 함)",
+                 count, action);
+    } else {
+        snprintf(resp->message, sizeof(resp->message), "%d개 연결 일치, %d개 %s 요청, %d개 실패",
+                 count, resp->bulk.signaled, action, resp->bulk.failed);
+        LOG_INFO("일괄 %s: 선택자 \"%s\", %d개 일치, %d개 전송, %d개 실패",
+                 action, req->selector, count, resp->bulk.signaled, resp->bulk.failed);
+    }
+    if (resp->unregistered > 0) {
+        LOG_WARN("일괄 %s: 연결 표가 가득 차 목록에 없는 연결 %d개는 대상이 아님",
+                 action, resp->unregistered);
+    }
+}
+
+void control_account_traffic(uint64_t c2s_bytes, uint64_t s2c_bytes, uint32_t opened,
+                             uint32_t closed, uint32_t dropped) {
+    if (g_shared_data == NULL) return;
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+    g_shared_data->totals.client_to_server_bytes += c2s_bytes;
+    g_shared_data->totals.server_to_client_bytes += s2c_bytes;
+    g_shared_data->totals.connections_opened += opened;
+    g_shared_data->totals.connections_closed += closed;
+    g_shared_data->totals.packets_dropped += dropped;
+    ListenerStats *listener = listener_stats_locked(0);  // UDP 모드는 리스너 하나
+    if (listener) {
+        listener->client_to_server_bytes += c2s_bytes;
+        listener->server_to_client_bytes += s2c_bytes;
+        listener->connections_opened += opened;
+        listener->connections_closed += closed;
+        listener->packets_dropped += dropped;
+    }
+    pthread_mutex_unlock(&g_shared_data->mutex);
+}
+
+void control_record_connect_error(int listener) {
+    if (g_shared_data == NULL) return;
+
+    pthread_mutex_lock(&g_shared_data->mutex);
+    g_shared_data->totals.connect_errors++;
+    ListenerStats *stats = listener_stats_locked(listener);
+    if (stats) {
+        stats->connect_errors++;
+    }
+    pthread_mutex_unlock(&g_shared_data->mutex);
+}
+
+// 응답이 소켓 버퍼보다 클 수 있으므로 다 보낼 때까지 (클라이언트가 끊으면 false)
+static bool send_all(int fd, const void *data, size_t length) {
+    const char *p = data;
+    while (length > 0) {
+        ssize_t n = send(fd, p, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_DEBUG("제어 응답 전송 실패: %s", strerror(errno));
+            return false;
+        }
+        p += n;
+        length -= n;
+    }
+    return true;
 }
 
 void control_handle_request(int client_fd) {
@@ -231,6 +1207,8 @@ void control_handle_request(int client_fd) {
         return;
     }
 
+    PROBE2(control_request, req.cmd, req.target_pid);
+
     if (g_shared_data == NULL) {
         resp.success = false;
         snprintf(resp.message, sizeof(resp.message), "공유 메모리 미초기화");
@@ -238,13 +1216,48 @@ void control_handle_request(int client_fd) {
         return;
     }
 
+    // 시나리오 파일은 뮤텍스 밖에서 읽음 (자식들의 통계 갱신을 막지 않도록)
+    static Scenario loaded;
+    char load_err[192] = "";
+    bool scenario_ok = false;
+    if (req.cmd == CMD_SCENARIO_START) {
+        req.path[sizeof(req.path) - 1] = '\0';
+        scenario_ok = scenario_load(req.path, &loaded, load_err, sizeof(load_err));
+    }
+
+    // 일괄 명령 선택자도 뮤텍스 밖에서 파싱
+    BulkSelector bulk_sel;
+    int bulk_count = -1;
+    bool bulk_ok = false;
+    if (req.cmd == CMD_KILL_MATCHING || req.cmd == CMD_SIGNAL_MATCHING) {
+        req.selector[sizeof(req.selector) - 1] = '\0';
+        bulk_ok = parse_bulk_selector(req.selector, &bulk_sel, load_err, sizeof(load_err));
+    }
+
     pthread_mutex_lock(&g_shared_data->mutex);
 
+    // 연결 목록을 돌려주는 명령은 응답 뒤에 이어 보낼 사본을 만듦 (뮤텍스는 복사하는 동안만)
+    ConnectionInfo *rows = NULL;
+    resp.unregistered = g_shared_data->unregistered;
+    resp.unregistered_total = g_shared_data->unregistered_total;
+    if (req.cmd == CMD_LIST_CONNECTIONS || req.cmd == CMD_GET_STATS ||
+        req.cmd == CMD_TOP_CONNECTIONS ||
+        (bulk_ok && (req.cmd == CMD_KILL_MATCHING || req.cmd == CMD_SIGNAL_MATCHING))) {
+        rows = malloc((g_shared_data->connection_count + 1) * sizeof(ConnectionInfo));
+        if (rows == NULL) {
+            pthread_mutex_unlock(&g_shared_data->mutex);
+            resp.success = false;
+            snprintf(resp.message, sizeof(resp.message), "메모리 부족");
+            send(client_fd, &resp, sizeof(resp), 0);
+            return;
+        }
+    }
+
     switch (req.cmd) {
         case CMD_LIST_CONNECTIONS:
             resp.success = true;
             resp.connection_count = g_shared_data->connection_count;
-            memcpy(resp.connections, g_shared_data->connections,
+            memcpy(rows, g_shared_data->connections,
                    g_shared_data->connection_count * sizeof(ConnectionInfo));
             snprintf(resp.message, sizeof(resp.message),
                      "총 %d개 연결", g_shared_data->connection_count);
@@ -296,12 +1309,133 @@ void control_handle_request(int client_fd) {
         case CMD_GET_STATS:
             resp.success = true;
             resp.connection_count = g_shared_data->connection_count;
-            memcpy(resp.connections, g_shared_data->connections,
+            memcpy(rows, g_shared_data->connections,
                    g_shared_data->connection_count * sizeof(ConnectionInfo));
             snprintf(resp.message, sizeof(resp.message),
                      "통계 조회 성공");
             break;
 
+        case CMD_DUMP_FLIGHT:
+            // 링은 별도 공유 메모리 (종료된 연결도 보관 기간 동안 조회 가능)
+            resp.success = flight_snapshot(req.target_pid, req.conn_id, &resp.flight);
+            if (resp.success) {
+                snprintf(resp.message, sizeof(resp.message),
+                         "연결 #%lu (PID %d) 이벤트 %d개",
+                         resp.flight.conn_id, resp.flight.pid, resp.flight.event_count);
+            } else if (req.conn_id != 0) {
+                snprintf(resp.message, sizeof(resp.message),
+                         "연결 #%lu의 기록을 찾을 수 없음", req.conn_id);
+            } else {
+                snprintf(resp.message, sizeof(resp.message),
+                         "PID %d의 기록을 찾을 수 없음", req.target_pid);
+            }
+            break;
+
+        case CMD_GET_HISTORY:
+            resp.success = true;
+            history_dump(req.interval_sec, req.count, &resp.history);
+            snprintf(resp.message, sizeof(resp.message),
+                     "%s 단위 이력 %d개", resp.history.interval_sec == 60 ? "분" : "초",
+                     resp.history.count);
+            break;
+
+        case CMD_TOP_CONNECTIONS: {
+            int n = g_shared_data->connection_count;
+            int k = (req.count <= 0 || req.count > n) ? n : req.count;
+            int window = rate_window_index(req.interval_sec);
+
+            // 표 전체를 8바이트 키로 순위를 매기고 상위 k개 항목만 복사
+            RateKey *keys = malloc((n + 1) * sizeof(RateKey));
+            if (keys == NULL) {
+                resp.success = false;
+                snprintf(resp.message, sizeof(resp.message), "메모리 부족");
+                break;
+            }
+            for (int i = 0; i < n; i++) {
+                keys[i].rate = connection_rate(&g_shared_data->connections[i], window);
+                keys[i].index = i;
+            }
+            partial_sort_by_rate(keys, n, k);
+            for (int i = 0; i < k; i++) {
+                rows[i] = g_shared_data->connections[keys[i].index];
+            }
+            free(keys);
+
+            resp.success = true;
+            resp.connection_count = k;
+            snprintf(resp.message, sizeof(resp.message),
+                     "전체 %d개 중 상위 %d개", n, k);
+            break;
+        }
+
+        case CMD_FILTER_LIST:
+        case CMD_FILTER_ADD:
+        case CMD_FILTER_REMOVE:
+        case CMD_FILTER_ENABLE:
+        case CMD_FILTER_DISABLE:
+        case CMD_FILTER_CLEAR:
+            handle_filter_command(&req, &resp);
+            break;
+
+        case CMD_SCENARIO_START:
+        case CMD_SCENARIO_STOP:
+        case CMD_SCENARIO_STATUS:
+            handle_scenario_command(&req, scenario_ok ? &loaded : NULL, load_err, &resp);
+            break;
+
+        case CMD_QUERY_STATS:
+        case CMD_QUERY_RESET:
+            resp.success = true;
+            resp.queries = g_shared_data->query_stats;
+            if (req.cmd == CMD_QUERY_RESET) {
+                memset(&g_shared_data->query_stats, 0, sizeof(QueryStats));
+                snprintf(resp.message, sizeof(resp.message), "쿼리 통계 초기화 (이전 %lu개)",
+                         resp.queries.count);
+            } else {
+                snprintf(resp.message, sizeof(resp.message), "쿼리 %lu개", resp.queries.count);
+            }
+            break;
+
+        case CMD_CAPTURE_STATUS:
+            // 카운터는 캡처 링 공유 메모리와 이 프로세스의 기록 스레드에 있음
+            capture_get_status(&resp.capture);
+            resp.success = resp.capture.enabled;
+            snprintf(resp.message, sizeof(resp.message), "%s",
+                     resp.capture.enabled ? "캡처 중" : "캡처가 꺼져 있습니다 (-w <file> 또는 capture=)");
+            break;
+
+        case CMD_MIRROR_STATUS:
+            mirror_get_status(&resp.mirror);
+            resp.success = resp.mirror.enabled;
+            snprintf(resp.message, sizeof(resp.message), "%s",
+                     resp.mirror.enabled ? "미러링 중" : "미러링이 꺼져 있습니다 (-M <host:port> 또는 mirror=)");
+            break;
+
+        case CMD_UDP_STATUS:
+            // UDP 이벤트 루프는 이 프로세스의 주 스레드 (1초마다 게시한 사본)
+            udp_get_status(&resp.udp);
+            resp.success = resp.udp.enabled;
+            snprintf(resp.message, sizeof(resp.message), "%s",
+                     resp.udp.enabled ? "UDP 모드" : "UDP 모드가 아닙니다 (-u 또는 transport=udp)");
+            break;
+
+        case CMD_LISTENERS:
+            resp.success = true;
+            resp.listener_count = g_shared_data->listener_count;
+            memcpy(resp.listeners, g_shared_data->listeners, sizeof(resp.listeners));
+            snprintf(resp.message, sizeof(resp.message), "리스너 %d개", resp.listener_count);
+            break;
+
+        case CMD_KILL_MATCHING:
+        case CMD_SIGNAL_MATCHING:
+            if (bulk_ok) {
+                bulk_count = bulk_select_locked(&req, &bulk_sel, &resp, rows);
+            } else {
+                resp.success = false;
+                snprintf(resp.message, sizeof(resp.message), "%s", load_err);
+            }
+            break;
+
         case CMD_SHUTDOWN:
             resp.success = true;
             snprintf(resp.message, sizeof(resp.message),
@@ -319,8 +1453,17 @@ void control_handle_request(int client_fd) {
 
     pthread_mutex_unlock(&g_shared_data->mutex);
 
-    // 응답 전송
-    send(client_fd, &resp, sizeof(resp), 0);
+    // 시그널은 뮤텍스를 놓은 뒤 (대상이 많아도 자식들의 통계 갱신을 막지 않도록)
+    if (bulk_count >= 0) {
+        bulk_signal(&req, rows, bulk_count, &resp);
+    }
+
+    // 응답 전송 (연결 목록은 뒤에 이어서)
+    if (send_all(client_fd, &resp, sizeof(resp)) && resp.connection_count > 0) {
+        send_all(client_fd, rows, resp.connection_count * sizeof(ConnectionInfo));
+    }
+    free(rows);
+    PROBE2(control_response, req.cmd, resp.success);
 
     LOG_DEBUG("제어 요청 처리: cmd=%d, success=%d, msg=%s",
               req.cmd, resp.success, resp.message);
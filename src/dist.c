@@ -0,0 +1,96 @@
+#include "../include/dist.h"
+#include <string.h>
+#include <math.h>
+
+#define PARETO_ALPHA 3.0          // 분산이 유한한 가장 무거운 꼬리 (정수 형상)
+#define LOGNORMAL_SIGMA 0.5
+
+static float g_tables[DIST_LOGNORMAL + 1][DIST_TABLE_SIZE];
+static int g_tables_ready = 0;
+
+// 표준 정규분포 역누적분포함수 (Acklam 근사, 상대 오차 1.15e-9)
+static double normal_quantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                               -2.759285104469687e+02, 1.383577518672690e+02,
+                               -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                               -1.556989798598866e+02, 6.680131188771972e+01,
+                               -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                               -2.400758277161838e+00, -2.549732539343734e+00,
+                               4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+                               2.445134137142996e+00, 3.754408661907416e+00};
+    const double p_low = 0.02425;
+
+    if (p < p_low) {
+        double q = sqrt(-2 * log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if (p > 1 - p_low) {
+        double q = sqrt(-2 * log(1 - p));
+        return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+void dist_init(void) {
+    if (g_tables_ready) return;
+
+    // 파레토(xm=1)와 로그정규의 이론 평균/표준편차로 표준화
+    double pareto_mean = PARETO_ALPHA / (PARETO_ALPHA - 1);
+    double pareto_sd = sqrt(PARETO_ALPHA / ((PARETO_ALPHA - 1) * (PARETO_ALPHA - 1) * (PARETO_ALPHA - 2)));
+    double s2 = LOGNORMAL_SIGMA * LOGNORMAL_SIGMA;
+    double lognormal_mean = exp(s2 / 2);
+    double lognormal_sd = sqrt((exp(s2) - 1) * exp(s2));
+
+    for (int i = 0; i < DIST_TABLE_SIZE; i++) {
+        double p = (i + 0.5) / DIST_TABLE_SIZE;   // 구간 중앙 (양 끝의 무한대 회피)
+        double z = normal_quantile(p);
+
+        g_tables[DIST_NORMAL][i] = (float)z;
+        g_tables[DIST_PARETO][i] =
+            (float)((pow(1 - p, -1 / PARETO_ALPHA) - pareto_mean) / pareto_sd);
+        g_tables[DIST_LOGNORMAL][i] =
+            (float)((exp(LOGNORMAL_SIGMA * z) - lognormal_mean) / lognormal_sd);
+    }
+
+    g_tables_ready = 1;
+}
+
+int dist_parse(const char *name) {
+    if (strcmp(name, "uniform") == 0) return DIST_UNIFORM;
+    if (strcmp(name, "normal") == 0) return DIST_NORMAL;
+    if (strcmp(name, "pareto") == 0) return DIST_PARETO;
+    if (strcmp(name, "lognormal") == 0) return DIST_LOGNORMAL;
+    return -1;
+}
+
+const char *dist_name(int dist) {
+    switch (dist) {
+        case DIST_UNIFORM:   return "uniform";
+        case DIST_NORMAL:    return "normal";
+        case DIST_PARETO:    return "pareto";
+        case DIST_LOGNORMAL: return "lognormal";
+        default:             return "constant";
+    }
+}
+
+float dist_sample(int dist, double u) {
+    if (dist == DIST_UNIFORM) {
+        return (float)(2 * u - 1);
+    }
+    if (dist < DIST_NORMAL || dist > DIST_LOGNORMAL) {
+        return 0.0f;
+    }
+    if (!g_tables_ready) {
+        dist_init();  // 부모가 호출하지 않은 경우 (자식에서 한 번)
+    }
+    return g_tables[dist][(int)(u * DIST_TABLE_SIZE)];
+}
@@ -1,16 +1,24 @@
 #include "../include/filter.h"
 #include "../include/logger.h"
+#include "../include/probes.h"
+#include "../include/matcher.h"
+#include "../include/dist.h"
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
 #include <time.h>
+#include <ctype.h>
+#include <errno.h>
+#include <arpa/inet.h>
+
+_Static_assert(FILTER_HEADROOM <= MATCHER_MAX_PATTERN_LEN, "보류 공간이 매처 최대 패턴보다 작음");
+_Static_assert(MAX_FILTERS * MODIFY_MAX_RULES <= MATCHER_MAX_PATTERNS, "매처 패턴 수 부족");
 
 void filter_chain_init(FilterChain *chain) {
     memset(chain, 0, sizeof(FilterChain));
     chain->count = 0;
 }
 
-bool filter_chain_add_delay(FilterChain *chain, int delay_ms) {
+bool filter_chain_add_delay(FilterChain *chain, int delay_ms, int directions) {
     if (chain->count >= MAX_FILTERS) {
         LOG_ERROR("필터 체인이 가득 찼습니다");
         return false;
@@ -19,13 +27,14 @@ bool filter_chain_add_delay(FilterChain *chain, int delay_ms) {
     Filter *filter = &chain->filters[chain->count++];
     filter->type = FILTER_DELAY;
     filter->enabled = true;
+    filter->directions = directions;
     filter->params.delay.delay_ms = delay_ms;
     
     LOG_INFO("지연 필터 추가: %d ms", delay_ms);
     return true;
 }
 
-bool filter_chain_add_drop(FilterChain *chain, float drop_rate) {
+bool filter_chain_add_drop(FilterChain *chain, float drop_rate, int directions) {
     if (chain->count >= MAX_FILTERS) {
         LOG_ERROR("필터 체인이 가득 찼습니다");
         return false;
@@ -39,13 +48,14 @@ bool filter_chain_add_drop(FilterChain *chain, float drop_rate) {
     Filter *filter = &chain->filters[chain->count++];
     filter->type = FILTER_DROP;
     filter->enabled = true;
+    filter->directions = directions;
     filter->params.drop.drop_rate = drop_rate;
     
     LOG_INFO("드롭 필터 추가: %.2f%%", drop_rate * 100);
     return true;
 }
 
-bool filter_chain_add_throttle(FilterChain *chain, int bytes_per_sec) {
+bool filter_chain_add_throttle(FilterChain *chain, int bytes_per_sec, int directions) {
     if (chain->count >= MAX_FILTERS) {
         LOG_ERROR("필터 체인이 가득 찼습니다");
         return false;
@@ -54,62 +64,1267 @@ bool filter_chain_add_throttle(FilterChain *chain, int bytes_per_sec) {
     Filter *filter = &chain->filters[chain->count++];
     filter->type = FILTER_THROTTLE;
     filter->enabled = true;
+    filter->directions = directions;
     filter->params.throttle.bytes_per_sec = bytes_per_sec;
     
     LOG_INFO("쓰로틀 필터 추가: %d bytes/sec", bytes_per_sec);
     return true;
 }
 
-bool filter_apply(FilterChain *chain, const char *data, int length, ConnectionStats *stats) {
-    (void)data;   // 미사용 매개변수 경고 방지
-    (void)stats;  // 미사용 매개변수 경고 방지
+bool filter_chain_add(FilterChain *chain, const Filter *filter) {
+    if (chain->count >= MAX_FILTERS) {
+        LOG_ERROR("필터 체인이 가득 찼습니다");
+        return false;
+    }
+
+    chain->filters[chain->count++] = *filter;
+    return true;
+}
+
+bool filter_chain_remove(FilterChain *chain, int index) {
+    if (index < 0 || index >= chain->count) {
+        return false;
+    }
+
+    memmove(&chain->filters[index], &chain->filters[index + 1],
+            (chain->count - index - 1) * sizeof(Filter));
+    chain->count--;
+    memset(&chain->filters[chain->count], 0, sizeof(Filter));
+    return true;
+}
+
+bool filter_chain_set_enabled(FilterChain *chain, int index, bool enabled) {
+    if (index < 0 || index >= chain->count) {
+        return false;
+    }
+
+    chain->filters[index].enabled = enabled;
+    return true;
+}
+
+// 패턴 파싱 (수정 규칙, match= 트리거): "0x" 접두사면 16진수, 아니면 리터럴
+static int parse_pattern_bytes(const char *text, uint8_t *out) {
+    if (strncmp(text, "0x", 2) == 0) {
+        const char *hex = text + 2;
+        size_t digits = strlen(hex);
+        if (digits == 0 || digits % 2 != 0 || digits / 2 > MODIFY_MAX_PATTERN_LEN) {
+            return -1;
+        }
+        for (size_t i = 0; i < digits / 2; i++) {
+            char byte[3] = {hex[i * 2], hex[i * 2 + 1], '\0'};
+            if (!isxdigit((unsigned char)byte[0]) || !isxdigit((unsigned char)byte[1])) {
+                return -1;
+            }
+            out[i] = (uint8_t)strtoul(byte, NULL, 16);
+        }
+        return (int)(digits / 2);
+    }
+
+    size_t len = strlen(text);
+    if (len == 0 || len > MODIFY_MAX_PATTERN_LEN) {
+        return -1;
+    }
+    memcpy(out, text, len);
+    return (int)len;
+}
+
+// "GET/PUT,0xdeadbeef/!flip" (규칙은 쉼표로 구분, 치환은 패턴과 같은 길이)
+static bool parse_modify_rules(const char *value, Filter *filter, char *err, size_t err_len) {
+    char buf[MAX_FILTER_SPEC_LEN];
+    char *saveptr = NULL;
+
+    strncpy(buf, value, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    filter->params.modify.rule_count = 0;
+    for (char *rule = strtok_r(buf, ",", &saveptr); rule != NULL;
+         rule = strtok_r(NULL, ",", &saveptr)) {
+        if (filter->params.modify.rule_count >= MODIFY_MAX_RULES) {
+            snprintf(err, err_len, "수정 규칙이 너무 많습니다 (최대 %d개)", MODIFY_MAX_RULES);
+            return false;
+        }
+
+        char *slash = strchr(rule, '/');
+        if (slash == NULL) {
+            snprintf(err, err_len, "수정 규칙은 패턴/치환 형식이어야 합니다: %s", rule);
+            return false;
+        }
+        *slash = '\0';
+        const char *replacement = slash + 1;
+
+        ModifyRule *r = &filter->params.modify.rules[filter->params.modify.rule_count];
+        int len = parse_pattern_bytes(rule, r->pattern);
+        if (len < 0) {
+            snprintf(err, err_len, "잘못된 패턴: %s (1-%d바이트, 16진수는 0x...)",
+                     rule, MODIFY_MAX_PATTERN_LEN);
+            return false;
+        }
+        r->len = (uint8_t)len;
+
+        if (strcmp(replacement, "!flip") == 0) {
+            r->action = MATCH_FLIP;
+        } else if (strcmp(replacement, "!zero") == 0) {
+            r->action = MATCH_ZERO;
+        } else {
+            r->action = MATCH_REPLACE;
+            if (parse_pattern_bytes(replacement, r->replacement) != len) {
+                snprintf(err, err_len, "치환은 패턴과 같은 길이(%d바이트)여야 합니다: %s",
+                         len, replacement);
+                return false;
+            }
+        }
+        filter->params.modify.rule_count++;
+    }
+
+    if (filter->params.modify.rule_count == 0) {
+        snprintf(err, err_len, "수정 규칙이 없습니다");
+        return false;
+    }
+    return true;
+}
+
+#define FAULT_MAX_MS 3600000   // reset/stall/halfclose 시간 상한 (1시간)
+
+// 필터 종류와 값 파싱 (예: "delay=100")
+static bool parse_filter_action(const char *key, const char *value, Filter *filter,
+                                char *err, size_t err_len) {
+    char *endptr;
+
+    if (strcmp(key, "delay") == 0) {
+        long delay = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || delay < 0 || delay > 10000) {
+            snprintf(err, err_len, "잘못된 지연 시간: %s (0-10000ms)", value);
+            return false;
+        }
+        filter->type = FILTER_DELAY;
+        filter->params.delay.delay_ms = (int)delay;
+    } else if (strcmp(key, "drop") == 0) {
+        double rate = strtod(value, &endptr);
+        if (*endptr != '\0' || rate < 0.0 || rate > 1.0) {
+            snprintf(err, err_len, "잘못된 드롭 확률: %s (0.0-1.0)", value);
+            return false;
+        }
+        filter->type = FILTER_DROP;
+        filter->params.drop.drop_rate = (float)rate;
+    } else if (strcmp(key, "throttle") == 0) {
+        long bps = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || bps <= 0) {
+            snprintf(err, err_len, "잘못된 대역폭: %s (양수여야 함)", value);
+            return false;
+        }
+        filter->type = FILTER_THROTTLE;
+        filter->params.throttle.bytes_per_sec = (int)bps;
+    } else if (strcmp(key, "modify") == 0) {
+        filter->type = FILTER_MODIFY;
+        return parse_modify_rules(value, filter, err, err_len);
+    } else if (strcmp(key, "reset") == 0 || strcmp(key, "stall") == 0 ||
+               strcmp(key, "halfclose") == 0) {
+        long ms = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || ms < 0 || ms > FAULT_MAX_MS) {
+            snprintf(err, err_len, "잘못된 시간: %s (0-%dms)", value, FAULT_MAX_MS);
+            return false;
+        }
+        if (key[0] == 'r') {
+            filter->type = FILTER_RESET;
+            filter->params.reset.after_ms = (int)ms;
+        } else if (key[0] == 's') {
+            filter->type = FILTER_STALL;
+            filter->params.stall.duration_ms = (int)ms;
+        } else {
+            filter->type = FILTER_HALF_CLOSE;
+            filter->params.half_close.hold_ms = (int)ms;
+        }
+    } else if (strcmp(key, "fragment") == 0) {
+        long size = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || size <= 0 || size > BUFFER_SIZE) {
+            snprintf(err, err_len, "잘못된 조각 크기: %s (1-%d bytes)", value, BUFFER_SIZE);
+            return false;
+        }
+        filter->type = FILTER_FRAGMENT;
+        filter->params.fragment.size = (int)size;
+    } else if (strcmp(key, "duplicate") == 0 || strcmp(key, "reorder") == 0) {
+        double rate = strtod(value, &endptr);
+        if (*endptr != '\0' || rate < 0.0 || rate > 1.0) {
+            snprintf(err, err_len, "잘못된 확률: %s (0.0-1.0)", value);
+            return false;
+        }
+        filter->type = key[0] == 'd' ? FILTER_DUPLICATE : FILTER_REORDER;
+        filter->params.chance.rate = (float)rate;
+    } else if (strcmp(key, "myerror") == 0) {
+        long code = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || code < 1000 || code > 65535) {
+            snprintf(err, err_len, "잘못된 MySQL 오류 번호: %s (1000-65535, 예: 1213)", value);
+            return false;
+        }
+        filter->type = FILTER_MYSQL_ERROR;
+        filter->params.mysql_error.code = (int)code;
+    } else if (strcmp(key, "httperror") == 0) {
+        long status = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || status < 400 || status > 599) {
+            snprintf(err, err_len, "잘못된 HTTP 응답 코드: %s (400-599, 예: 503)", value);
+            return false;
+        }
+        filter->type = FILTER_HTTP_ERROR;
+        filter->params.http_error.status = (int)status;
+    } else {
+        snprintf(err, err_len, "알 수 없는 필터: %s", key);
+        return false;
+    }
+
+    return true;
+}
+
+// "10.0.0.0/8", "2001:db8::/32", "192.168.1.10" (프리픽스 생략 시 단일 주소)
+static bool parse_cidr(const char *value, FilterSelector *sel, char *err, size_t err_len) {
+    char addr[INET6_ADDRSTRLEN];
+    const char *slash = strchr(value, '/');
+    size_t addr_len = slash ? (size_t)(slash - value) : strlen(value);
+
+    if (addr_len == 0 || addr_len >= sizeof(addr)) {
+        snprintf(err, err_len, "잘못된 주소 대역: %s", value);
+        return false;
+    }
+    memcpy(addr, value, addr_len);
+    addr[addr_len] = '\0';
+
+    memset(sel->addr, 0, sizeof(sel->addr));
+    if (inet_pton(AF_INET, addr, sel->addr) == 1) {
+        sel->family = AF_INET;
+    } else if (inet_pton(AF_INET6, addr, sel->addr) == 1) {
+        sel->family = AF_INET6;
+    } else {
+        snprintf(err, err_len, "잘못된 주소: %s", addr);
+        return false;
+    }
+
+    int max_prefix = sel->family == AF_INET ? 32 : 128;
+    sel->prefix_len = max_prefix;
+    if (slash) {
+        char *endptr;
+        long prefix = strtol(slash + 1, &endptr, 10);
+        if (*endptr != '\0' || prefix < 0 || prefix > max_prefix) {
+            snprintf(err, err_len, "잘못된 프리픽스 길이: %s", slash + 1);
+            return false;
+        }
+        sel->prefix_len = (int)prefix;
+    }
+
+    sel->flags |= SELECT_CLIENT_CIDR;
+    return true;
+}
+
+bool filter_parse_selector_option(const char *key, const char *value, FilterSelector *sel,
+                                  bool *handled, char *err, size_t err_len) {
+    char *endptr;
+    *handled = true;
+
+    if (strcmp(key, "client") == 0) {
+        return parse_cidr(value, sel, err, err_len);
+    } else if (strcmp(key, "ports") == 0 || strcmp(key, "port") == 0) {
+        long port_min = strtol(value, &endptr, 10);
+        long port_max = port_min;
+        if (*endptr == '-') {
+            port_max = strtol(endptr + 1, &endptr, 10);
+        }
+        if (*endptr != '\0' || port_min < 1 || port_max > 65535 || port_min > port_max) {
+            snprintf(err, err_len, "잘못된 포트 범위: %s", value);
+            return false;
+        }
+        sel->port_min = (int)port_min;
+        sel->port_max = (int)port_max;
+        sel->flags |= SELECT_CLIENT_PORT;
+    } else if (strcmp(key, "conn") == 0) {
+        unsigned long long id = strtoull(value, &endptr, 10);
+        if (*endptr != '\0' || id == 0) {
+            snprintf(err, err_len, "잘못된 연결 ID: %s", value);
+            return false;
+        }
+        sel->conn_id = id;
+        sel->flags |= SELECT_CONN_ID;
+    } else if (strcmp(key, "pid") == 0) {
+        long pid = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || pid <= 0) {
+            snprintf(err, err_len, "잘못된 PID: %s", value);
+            return false;
+        }
+        sel->pid = (pid_t)pid;
+        sel->flags |= SELECT_PID;
+    } else if (strcmp(key, "percent") == 0) {
+        double percent = strtod(value, &endptr);
+        if (*endptr == '%') endptr++;
+        if (*endptr != '\0' || percent < 0.0 || percent > 100.0) {
+            snprintf(err, err_len, "잘못된 비율: %s (0-100)", value);
+            return false;
+        }
+        sel->percent = (float)percent;
+        sel->flags |= SELECT_PERCENT;
+    } else if (strcmp(key, "listener") == 0) {
+        if (strlen(value) >= sizeof(sel->listener)) {
+            snprintf(err, err_len, "리스너 이름이 너무 깁니다: %s (최대 %d자)", value,
+                     MAX_LISTENER_NAME - 1);
+            return false;
+        }
+        strcpy(sel->listener, value);
+        sel->flags |= SELECT_LISTENER;
+    } else {
+        *handled = false;
+    }
+
+    return true;
+}
+
+bool filter_parse_selector(const char *text, FilterSelector *sel, char *err, size_t err_len) {
+    char buf[MAX_FILTER_SPEC_LEN];
+    char *saveptr = NULL;
+
+    memset(sel, 0, sizeof(FilterSelector));
+    if (text == NULL) {
+        return true;
+    }
+    strncpy(buf, text, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (char *token = strtok_r(buf, " \t", &saveptr); token != NULL;
+         token = strtok_r(NULL, " \t", &saveptr)) {
+        if (strcmp(token, "all") == 0) {
+            continue;
+        }
+        char *eq = strchr(token, '=');
+        if (eq == NULL || eq[1] == '\0') {
+            snprintf(err, err_len, "key=value 형식이 아닙니다: %s", token);
+            return false;
+        }
+        *eq = '\0';
+
+        bool handled = false;
+        if (!filter_parse_selector_option(token, eq + 1, sel, &handled, err, err_len)) {
+            return false;
+        }
+        if (!handled) {
+            snprintf(err, err_len, "선택자가 아닙니다: %s (client=, ports=, conn=, pid=, percent=, listener=)", token);
+            return false;
+        }
+    }
+    return true;
+}
+
+int filter_parse_direction(const char *name) {
+    if (strcmp(name, "c2s") == 0) return FILTER_DIR_C2S;
+    if (strcmp(name, "s2c") == 0) return FILTER_DIR_S2C;
+    if (strcmp(name, "both") == 0) return FILTER_DIR_BOTH;
+    return 0;
+}
+
+// 지연 분포 옵션 파싱 (jitter=, dist=, corr=) - 지연 필터에만 허용
+static bool parse_delay_option(const char *key, const char *value, Filter *filter,
+                               bool *handled, char *err, size_t err_len) {
+    char *endptr;
+    *handled = true;
 
+    if (strcmp(key, "jitter") != 0 && strcmp(key, "dist") != 0 && strcmp(key, "corr") != 0) {
+        *handled = false;
+        return true;
+    }
+    if (filter->type != FILTER_DELAY) {
+        snprintf(err, err_len, "%s 옵션은 지연 필터에만 사용할 수 있습니다", key);
+        return false;
+    }
+
+    if (strcmp(key, "jitter") == 0) {
+        long jitter = strtol(value, &endptr, 10);
+        if (*endptr != '\0' || jitter < 0 || jitter > 10000) {
+            snprintf(err, err_len, "잘못된 지터: %s (0-10000ms)", value);
+            return false;
+        }
+        filter->params.delay.jitter_ms = (int)jitter;
+        if (filter->params.delay.distribution == DIST_CONSTANT) {
+            filter->params.delay.distribution = DIST_UNIFORM;
+        }
+    } else if (strcmp(key, "dist") == 0) {
+        int dist = dist_parse(value);
+        if (dist < 0) {
+            snprintf(err, err_len, "알 수 없는 분포: %s (uniform, normal, pareto, lognormal)", value);
+            return false;
+        }
+        filter->params.delay.distribution = dist;
+    } else {
+        double corr = strtod(value, &endptr);
+        if (*endptr == '%') endptr++;
+        if (*endptr != '\0' || corr < 0.0 || corr > 100.0) {
+            snprintf(err, err_len, "잘못된 상관 계수: %s (0-100%%)", value);
+            return false;
+        }
+        filter->params.delay.correlation = (float)(corr / 100.0);
+    }
+
+    return true;
+}
+
+bool filter_parse_byte_count(const char *value, uint64_t *out) {
+    // strtoull은 앞 공백과 음수 부호를 받아들이므로 숫자로 시작하는지 먼저 확인 ("-1"이 최댓값이 됨)
+    if (value[0] < '0' || value[0] > '9') {
+        return false;
+    }
+    char *endptr;
+    errno = 0;
+    unsigned long long n = strtoull(value, &endptr, 10);
+    if (errno == ERANGE) {
+        return false;
+    }
+
+    int shift = 0;
+    switch (*endptr) {
+        case 'K': case 'k': shift = 10; endptr++; break;
+        case 'M': case 'm': shift = 20; endptr++; break;
+        case 'G': case 'g': shift = 30; endptr++; break;
+        default: break;
+    }
+    // 접미사를 곱한 값이 넘치면 거부 (잘린 값이 조용히 작은 수가 되지 않도록)
+    if (*endptr != '\0' || n > (UINT64_MAX >> shift)) {
+        return false;
+    }
+    n <<= shift;
+
+    *out = n;
+    return true;
+}
+
+// "a-b" 또는 "a" (b 생략 시 0 = 무제한)
+static bool parse_range(const char *value, uint64_t *min, uint64_t *max) {
+    char buf[64];
+    strncpy(buf, value, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    char *dash = strchr(buf, '-');
+    if (dash) *dash = '\0';
+
+    if (!filter_parse_byte_count(buf, min)) {
+        return false;
+    }
+    *max = 0;
+    if (dash && (!filter_parse_byte_count(dash + 1, max) || *max <= *min)) {
+        return false;
+    }
+    return true;
+}
+
+// 트리거 옵션 파싱 (match=, after=, offset=, elapsed=, query=)
+static bool parse_trigger_option(const char *key, const char *value, FilterTrigger *trigger,
+                                 bool *handled, char *err, size_t err_len) {
+    *handled = true;
+
+    if (strcmp(key, "match") == 0) {
+        int len = parse_pattern_bytes(value, trigger->pattern);
+        if (len < 0) {
+            snprintf(err, err_len, "잘못된 패턴: %s (1-%d바이트, 16진수는 0x...)",
+                     value, MODIFY_MAX_PATTERN_LEN);
+            return false;
+        }
+        trigger->pattern_len = (uint8_t)len;
+        trigger->flags |= TRIGGER_MATCH;
+    } else if (strcmp(key, "after") == 0) {
+        if (!filter_parse_byte_count(value, &trigger->after_bytes)) {
+            snprintf(err, err_len, "잘못된 바이트 수: %s (예: 10M)", value);
+            return false;
+        }
+        trigger->flags |= TRIGGER_AFTER;
+    } else if (strcmp(key, "offset") == 0) {
+        if (!parse_range(value, &trigger->offset_min, &trigger->offset_max)) {
+            snprintf(err, err_len, "잘못된 오프셋 구간: %s (예: 1K-2K)", value);
+            return false;
+        }
+        trigger->flags |= TRIGGER_OFFSET;
+    } else if (strcmp(key, "elapsed") == 0) {
+        if (!parse_range(value, &trigger->elapsed_min_ms, &trigger->elapsed_max_ms)) {
+            snprintf(err, err_len, "잘못된 경과 시간: %s (밀리초, 예: 5000-10000)", value);
+            return false;
+        }
+        trigger->flags |= TRIGGER_ELAPSED;
+    } else if (strcmp(key, "query") == 0) {
+        // 명세는 공백으로 나뉘므로 접두사 안의 공백은 %20 ("POST%20/orders")
+        size_t len = 0;
+        bool all = strcmp(value, "*") == 0;
+        for (const char *c = value; !all && *c != '\0'; c++) {
+            if (len >= sizeof(trigger->query_prefix)) {
+                snprintf(err, err_len, "쿼리 접두사가 너무 깁니다: %s (최대 %zu자)",
+                         value, sizeof(trigger->query_prefix));
+                return false;
+            }
+            if (c[0] == '%' && isxdigit((unsigned char)c[1]) && isxdigit((unsigned char)c[2])) {
+                char byte[3] = {c[1], c[2], '\0'};
+                trigger->query_prefix[len++] = (char)strtoul(byte, NULL, 16);
+                c += 2;
+            } else {
+                trigger->query_prefix[len++] = *c;
+            }
+        }
+        trigger->query_prefix_len = (uint8_t)len;
+        trigger->flags |= TRIGGER_QUERY;
+    } else {
+        *handled = false;
+    }
+
+    return true;
+}
+
+bool filter_parse_spec(const char *spec, Filter *filter, char *err, size_t err_len) {
+    char buf[MAX_FILTER_SPEC_LEN];
+    char *saveptr = NULL;
+    bool has_action = false;
+
+    memset(filter, 0, sizeof(Filter));
+    filter->enabled = true;
+    filter->directions = FILTER_DIR_BOTH;
+
+    strncpy(buf, spec, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    // 공백으로 구분된 key=value 토큰 (첫 토큰은 필터 종류)
+    for (char *token = strtok_r(buf, " \t", &saveptr); token != NULL;
+         token = strtok_r(NULL, " \t", &saveptr)) {
+        char *eq = strchr(token, '=');
+        if (eq == NULL || eq[1] == '\0') {
+            snprintf(err, err_len, "key=value 형식이 아닙니다: %s", token);
+            return false;
+        }
+        *eq = '\0';
+        const char *key = token;
+        const char *value = eq + 1;
+
+        if (!has_action) {
+            if (!parse_filter_action(key, value, filter, err, err_len)) {
+                return false;
+            }
+            has_action = true;
+            continue;
+        }
+
+        if (strcmp(key, "dir") == 0) {
+            filter->directions = filter_parse_direction(value);
+            if (filter->directions == 0) {
+                snprintf(err, err_len, "잘못된 방향: %s (c2s, s2c, both)", value);
+                return false;
+            }
+            continue;
+        }
+
+        bool handled;
+        if (!filter_parse_selector_option(key, value, &filter->selector, &handled, err, err_len)) {
+            return false;
+        }
+        if (!handled && !parse_trigger_option(key, value, &filter->trigger, &handled, err, err_len)) {
+            return false;
+        }
+        if (!handled && !parse_delay_option(key, value, filter, &handled, err, err_len)) {
+            return false;
+        }
+        if (!handled) {
+            snprintf(err, err_len, "알 수 없는 옵션: %s", key);
+            return false;
+        }
+    }
+
+    if (!has_action) {
+        snprintf(err, err_len, "빈 필터 명세");
+        return false;
+    }
+
+    // 오류 응답은 클라이언트가 보낸 쿼리를 대신하므로 C→S 방향에만
+    if (filter->type == FILTER_MYSQL_ERROR || filter->type == FILTER_HTTP_ERROR) {
+        filter->directions &= FILTER_DIR_C2S;
+        if (filter->directions == 0) {
+            snprintf(err, err_len, "%s는 c2s 방향에만 사용할 수 있습니다",
+                     filter->type == FILTER_MYSQL_ERROR ? "myerror" : "httperror");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// 주소의 앞 prefix_len 비트 비교
+static bool prefix_match(const uint8_t *a, const uint8_t *b, int prefix_len) {
+    int bytes = prefix_len / 8;
+    int bits = prefix_len % 8;
+
+    if (memcmp(a, b, bytes) != 0) {
+        return false;
+    }
+    if (bits == 0) {
+        return true;
+    }
+
+    uint8_t mask = (uint8_t)(0xFF << (8 - bits));
+    return (a[bytes] & mask) == (b[bytes] & mask);
+}
+
+static bool selector_match_cidr(const FilterSelector *sel, const char *client_addr) {
+    uint8_t addr[16];
+
+    if (sel->family == AF_INET) {
+        if (inet_pton(AF_INET, client_addr, addr) == 1) {
+            return prefix_match(addr, sel->addr, sel->prefix_len);
+        }
+        // 듀얼 스택 리스너의 IPv4 매핑 주소 (::ffff:a.b.c.d)
+        static const uint8_t v4_mapped[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+        if (inet_pton(AF_INET6, client_addr, addr) == 1 && memcmp(addr, v4_mapped, 12) == 0) {
+            return prefix_match(addr + 12, sel->addr, sel->prefix_len);
+        }
+        return false;
+    }
+
+    return inet_pton(AF_INET6, client_addr, addr) == 1 &&
+           prefix_match(addr, sel->addr, sel->prefix_len);
+}
+
+// 연결 ID 기반 결정적 해시 (같은 연결은 항상 같은 비율 구간)
+static uint64_t selector_hash(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+bool filter_selector_match(const FilterSelector *sel, uint64_t conn_id, pid_t pid,
+                           const char *client_addr, int client_port, const char *listener) {
+    if (sel->flags == 0) {
+        return true;
+    }
+    if ((sel->flags & SELECT_LISTENER) && strcmp(sel->listener, listener) != 0) {
+        return false;
+    }
+    if ((sel->flags & SELECT_CONN_ID) && sel->conn_id != conn_id) {
+        return false;
+    }
+    if ((sel->flags & SELECT_PID) && sel->pid != pid) {
+        return false;
+    }
+    if ((sel->flags & SELECT_CLIENT_PORT) &&
+        (client_port < sel->port_min || client_port > sel->port_max)) {
+        return false;
+    }
+    if ((sel->flags & SELECT_CLIENT_CIDR) && !selector_match_cidr(sel, client_addr)) {
+        return false;
+    }
+    if (sel->flags & SELECT_PERCENT) {
+        double bucket = (selector_hash(conn_id) % 10000) / 100.0;
+        if (bucket >= sel->percent) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void filter_chain_compile(const FilterChain *table, const Connection *conn, int direction,
+                          FilterChain *out) {
+    FilterChain compiled;
+    filter_chain_init(&compiled);
+
+    for (int i = 0; i < table->count; i++) {
+        const Filter *filter = &table->filters[i];
+        if (filter->enabled && (filter->directions & direction) &&
+            filter_selector_match(&filter->selector, conn->conn_id, conn->pid,
+                                  conn->client_addr, conn->client_port, conn->listener_name)) {
+            compiled.filters[compiled.count++] = *filter;
+        }
+    }
+
+    *out = compiled;
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void filter_path_init(FilterPath *path, uint64_t seed) {
+    memset(path, 0, sizeof(FilterPath));
+    path->start_ms = monotonic_ms();
+    rng_seed(&path->rng, seed);
+}
+
+void filter_path_free(FilterPath *path) {
+    matcher_free(path->matcher);
+    matcher_free(path->trigger_matcher);
+    path->matcher = NULL;
+    path->trigger_matcher = NULL;
+}
+
+// 체인의 match= 트리거 패턴을 검출 전용 매처로 합침 (태그 = 체인 내 필터 위치)
+static Matcher *build_trigger_matcher(const FilterChain *chain) {
+    Matcher *matcher = NULL;
+
+    for (int i = 0; i < chain->count; i++) {
+        const FilterTrigger *trigger = &chain->filters[i].trigger;
+        if (!(trigger->flags & TRIGGER_MATCH)) continue;
+
+        if (matcher == NULL && (matcher = matcher_create()) == NULL) {
+            LOG_ERROR("트리거 매처 생성 실패 (match= 트리거는 동작하지 않음)");
+            return NULL;
+        }
+        matcher_add(matcher, trigger->pattern, trigger->pattern_len, MATCH_DETECT, NULL, i);
+    }
+
+    if (matcher != NULL && !matcher_build(matcher)) {
+        LOG_ERROR("트리거 매처 DFA 생성 실패 (match= 트리거는 동작하지 않음)");
+        matcher_free(matcher);
+        return NULL;
+    }
+    return matcher;
+}
+
+// 이전 체인에서 같은 ID의 필터 위치 (ID 0은 테이블에 게시되지 않은 필터라 이어가지 않음, 없으면 -1)
+static int find_filter_id(const FilterChain *chain, uint32_t id) {
+    if (id == 0) {
+        return -1;
+    }
+    for (int i = 0; i < chain->count; i++) {
+        if (chain->filters[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void filter_path_compile(const FilterChain *table, const Connection *conn, int direction,
+                         FilterPath *path) {
+    // 테이블이 바뀌어도 남아 있는 필터의 실행 상태(한 번만 동작하는 고장의 발동 여부, 리셋 예약,
+    // 상관 지연의 직전 값)는 필터 ID로 이어감: 그렇지 않으면 게시할 때마다 고장이 다시 일어나고
+    // 트리거 없는 리셋은 매번 처음부터 시간을 잼
+    FilterChain old_chain = path->chain;
+    bool old_fired[MAX_FILTERS];
+    uint64_t old_due[MAX_FILTERS];
+    double old_delay_last[MAX_FILTERS];
+    memcpy(old_fired, path->fired, sizeof(old_fired));
+    memcpy(old_due, path->reset_due_ms, sizeof(old_due));
+    memcpy(old_delay_last, path->delay_last, sizeof(old_delay_last));
+
+    filter_path_free(path);
+    filter_chain_compile(table, conn, direction, &path->chain);
+    memset(path->counters, 0, sizeof(path->counters));
+    memset(path->fired, 0, sizeof(path->fired));
+    memset(path->reset_due_ms, 0, sizeof(path->reset_due_ms));
+    memset(path->delay_last, 0, sizeof(path->delay_last));
+    path->reset_at_ms = 0;
+
+    uint64_t now = monotonic_ms();
+    for (int i = 0; i < path->chain.count; i++) {
+        const Filter *filter = &path->chain.filters[i];
+        int prev = find_filter_id(&old_chain, filter->id);
+        if (prev >= 0) {
+            path->fired[i] = old_fired[prev];
+            path->reset_due_ms[i] = old_due[prev];
+            path->delay_last[i] = old_delay_last[prev];
+        } else if (filter->type == FILTER_RESET && filter->enabled && filter->trigger.flags == 0) {
+            // 새로 들어온 트리거 없는 리셋은 체인에 들어온 시점부터 시간을 잼
+            path->fired[i] = true;
+            path->counters[i].chunks++;
+            path->reset_due_ms[i] = now + filter->params.reset.after_ms;
+        }
+        if (path->reset_due_ms[i] != 0 &&
+            (path->reset_at_ms == 0 || path->reset_due_ms[i] < path->reset_at_ms)) {
+            path->reset_at_ms = path->reset_due_ms[i];
+        }
+    }
+
+    // 체인의 모든 수정 규칙을 하나의 매처로 합침 (태그 = 체인 내 필터 위치)
+    Matcher *matcher = NULL;
+    for (int i = 0; i < path->chain.count; i++) {
+        const Filter *filter = &path->chain.filters[i];
+        if (filter->type != FILTER_MODIFY) continue;
+
+        if (matcher == NULL && (matcher = matcher_create()) == NULL) {
+            LOG_ERROR("매처 생성 실패 (수정 필터 비활성)");
+            return;
+        }
+        for (int r = 0; r < filter->params.modify.rule_count; r++) {
+            const ModifyRule *rule = &filter->params.modify.rules[r];
+            matcher_add(matcher, rule->pattern, rule->len, (MatchAction)rule->action,
+                        rule->replacement, i);
+        }
+    }
+
+    if (matcher != NULL && !matcher_build(matcher)) {
+        LOG_ERROR("매처 DFA 생성 실패 (수정 필터 비활성)");
+        matcher_free(matcher);
+        matcher = NULL;
+    }
+    path->matcher = matcher;
+    path->trigger_matcher = build_trigger_matcher(&path->chain);
+}
+
+int filter_path_pending(const FilterPath *path) {
+    return path->matcher ? matcher_pending(path->matcher) : 0;
+}
+
+int filter_path_flush(FilterPath *path, char *out) {
+    return path->matcher ? matcher_flush(path->matcher, (uint8_t *)out) : 0;
+}
+
+// 이번 청크의 지연 (마이크로초): 분포 표에서 O(1) 조회, 상관은 직전 균등 난수와 섞음
+static int delay_sample_us(FilterPath *path, Rng *rng, int index, const Filter *filter) {
+    int delay_us = filter->params.delay.delay_ms * 1000;
+    int jitter_us = filter->params.delay.jitter_ms * 1000;
+    if (jitter_us == 0) {
+        return delay_us;
+    }
+
+    double u = rng_uniform(rng);
+    float rho = filter->params.delay.correlation;
+    if (rho > 0.0f) {
+        u = (1.0 - rho) * u + rho * path->delay_last[index];
+        path->delay_last[index] = u;
+    }
+
+    int sample = delay_us + (int)(dist_sample(filter->params.delay.distribution, u) * jitter_us);
+    return sample > 0 ? sample : 0;
+}
+
+// 쿼리 본문이 접두사로 시작하는지 (앞 공백 무시, 대소문자 무시)
+static bool query_has_prefix(const char *query, int query_len, const FilterTrigger *trigger) {
+    int i = 0;
+    while (i < query_len && isspace((unsigned char)query[i])) {
+        i++;
+    }
+    if (query_len - i < trigger->query_prefix_len) {
+        return false;
+    }
+    for (int k = 0; k < trigger->query_prefix_len; k++) {
+        if (tolower((unsigned char)query[i + k]) != tolower((unsigned char)trigger->query_prefix[k])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 트리거 조건 평가 (chunk_offset/chunk_len은 수정 전 수신 청크 기준)
+// start_ms는 elapsed 기준 시각 (스트림은 경로 생성 시각, 데이터그램은 세션 시작 시각)
+static bool trigger_fires(const FilterTrigger *trigger, const FilterPath *path, uint64_t start_ms,
+                          const ConnectionStats *stats, uint64_t chunk_offset, int chunk_len,
+                          uint64_t match_hits) {
+    if ((trigger->flags & TRIGGER_MATCH) && match_hits == 0) {
+        return false;
+    }
+    if ((trigger->flags & TRIGGER_AFTER) &&
+        stats->client_to_server_bytes + stats->server_to_client_bytes < trigger->after_bytes) {
+        return false;
+    }
+    if (trigger->flags & TRIGGER_OFFSET) {
+        uint64_t chunk_end = chunk_offset + chunk_len;
+        if (chunk_end <= trigger->offset_min ||
+            (trigger->offset_max != 0 && chunk_offset >= trigger->offset_max)) {
+            return false;
+        }
+    }
+    if (trigger->flags & TRIGGER_ELAPSED) {
+        uint64_t elapsed = monotonic_ms() - start_ms;
+        if (elapsed < trigger->elapsed_min_ms ||
+            (trigger->elapsed_max_ms != 0 && elapsed >= trigger->elapsed_max_ms)) {
+            return false;
+        }
+    }
+    if ((trigger->flags & TRIGGER_QUERY) &&
+        (path->query == NULL || !query_has_prefix(path->query, path->query_len, trigger))) {
+        return false;
+    }
+    return true;
+}
+
+// 한 번만 동작하는 고장 (발동 후에는 체인을 다시 컴파일할 때까지 건너뜀)
+static bool filter_is_one_shot(const Filter *filter) {
+    return filter->type == FILTER_RESET || filter->type == FILTER_STALL ||
+           filter->type == FILTER_HALF_CLOSE;
+}
+
+// 보류 시간 누적 (무제한 정지가 먼저 걸렸으면 그대로)
+static void plan_hold(FilterPlan *plan, uint64_t us) {
+    if (plan->hold_us != FILTER_HOLD_FOREVER) {
+        plan->hold_us += us;
+    }
+}
+
+FilterVerdict filter_apply(FilterPath *path, char **data, int *length, ConnectionStats *stats,
+                           FilterPlan *plan) {
+    memset(plan, 0, sizeof(FilterPlan));
+    plan->copies = 1;
+
+    FilterChain *chain = &path->chain;
     if (chain->count == 0) {
-        return true;  // 필터 없음, 통과
+        return VERDICT_PASS;  // 필터 없음, 통과
     }
 
+    // 트리거 기준은 수신한 그대로의 청크 (앞선 수정 필터의 치환/보류 이전)
+    uint64_t chunk_offset = path->offset;
+    int chunk_len = *length;
+    path->offset += chunk_len;
+
+    uint64_t match_hits[MAX_FILTERS];
+    if (path->trigger_matcher) {
+        memset(match_hits, 0, sizeof(match_hits));
+        matcher_scan(path->trigger_matcher, (const uint8_t *)*data, chunk_len, match_hits);
+    }
+
+    bool modified = false;
+
     for (int i = 0; i < chain->count; i++) {
         Filter *filter = &chain->filters[i];
 
-        if (!filter->enabled) {
+        if (!filter->enabled || path->fired[i]) {
+            continue;
+        }
+
+        if (filter->trigger.flags != 0 &&
+            !trigger_fires(&filter->trigger, path, path->start_ms, stats, chunk_offset, chunk_len,
+                           path->trigger_matcher ? match_hits[i] : 0)) {
             continue;
         }
 
+        // 오류 주입은 프로토콜 모드가 대신 응답할 수 있다고 표시한 청크에서만
+        if ((filter->type == FILTER_MYSQL_ERROR || filter->type == FILTER_HTTP_ERROR) &&
+            path->reply_type != (int)filter->type) {
+            continue;
+        }
+
+        // 메시지 단위 모드: 지연/드롭은 요청(응답)이 시작하는 청크에서 메시지 전체에 한 번
+        if (path->per_message && !path->message_start &&
+            (filter->type == FILTER_DELAY || filter->type == FILTER_DROP)) {
+            continue;
+        }
+
+        FilterCounters *effect = &path->counters[i];
+        effect->chunks++;
+        effect->bytes += *length;
+        if (filter_is_one_shot(filter)) {
+            path->fired[i] = true;
+        }
+
         switch (filter->type) {
             case FILTER_DELAY: {
-                int delay_ms = filter->params.delay.delay_ms;
-                LOG_DEBUG("지연 적용: %d ms", delay_ms);
-                usleep(delay_ms * 1000);  // ms to microseconds
+                int delay_us = delay_sample_us(path, &path->rng, i, filter);
+                LOG_DEBUG("지연 적용: %d us", delay_us);
+                PROBE4(filter_decision, i, filter->type, 1, *length);
+                plan_hold(plan, delay_us);
+                effect->delay_us += delay_us;
                 break;
             }
 
             case FILTER_DROP: {
                 float drop_rate = filter->params.drop.drop_rate;
-                float random = (float)rand() / RAND_MAX;
+                float random = (float)rng_uniform(&path->rng);
 
                 if (random < drop_rate) {
+                    PROBE4(filter_decision, i, filter->type, 0, *length);
                     LOG_WARN("패킷 드롭 (확률: %.2f%%, 랜덤: %.2f)",
                              drop_rate * 100, random * 100);
                     // 드롭 카운팅은 proxy.c에서 수행
-                    return false;  // 패킷 드롭
+                    effect->dropped++;
+                    return VERDICT_DROP;  // 패킷 드롭
                 }
+                PROBE4(filter_decision, i, filter->type, 1, *length);
                 break;
             }
 
             case FILTER_THROTTLE: {
                 int bytes_per_sec = filter->params.throttle.bytes_per_sec;
-                int delay_us = (length * 1000000) / bytes_per_sec;
-                LOG_DEBUG("쓰로틀링: %d bytes -> %d us 지연", length, delay_us);
-                usleep(delay_us);
+                int delay_us = (int)((int64_t)*length * 1000000 / bytes_per_sec);
+                LOG_DEBUG("쓰로틀링: %d bytes -> %d us 지연", *length, delay_us);
+                PROBE4(filter_decision, i, filter->type, 1, *length);
+                plan_hold(plan, delay_us);
+                effect->delay_us += delay_us;
+                break;
+            }
+
+            case FILTER_MODIFY: {
+                // 체인의 모든 수정 규칙은 첫 FILTER_MODIFY 위치에서 한 번에 처리
+                if (path->matcher == NULL || modified) break;
+                modified = true;
+
+                uint64_t hits[MAX_FILTERS] = {0};
+                uint8_t *buf = (uint8_t *)*data;
+                int replaced = matcher_process(path->matcher, &buf, length, hits);
+                *data = (char *)buf;
+
+                if (replaced > 0) {
+                    for (int k = 0; k < chain->count; k++) {
+                        path->counters[k].modified += hits[k];
+                    }
+                    LOG_DEBUG("데이터 수정: 패턴 %d개 치환", replaced);
+                }
+                PROBE4(filter_decision, i, filter->type, 1, *length);
+
+                // 전부 보류되었으면 이번에 내보낼 데이터 없음
+                if (*length == 0) {
+                    return VERDICT_PASS;
+                }
+                break;
+            }
+
+            case FILTER_RESET: {
+                int after_ms = filter->params.reset.after_ms;
+                PROBE4(filter_decision, i, filter->type, after_ms > 0, *length);
+                if (after_ms == 0) {
+                    LOG_WARN("리셋 주입 (청크 %d bytes 대신 RST)", *length);
+                    effect->dropped++;
+                    return VERDICT_RESET;
+                }
+                LOG_WARN("리셋 예약: %d ms 후", after_ms);
+                uint64_t at = monotonic_ms() + after_ms;
+                path->reset_due_ms[i] = at;
+                if (path->reset_at_ms == 0 || at < path->reset_at_ms) {
+                    path->reset_at_ms = at;
+                }
+                break;
+            }
+
+            case FILTER_STALL: {
+                int duration_ms = filter->params.stall.duration_ms;
+                LOG_WARN("전달 정지: %d ms%s", duration_ms, duration_ms ? "" : " (연결 종료까지)");
+                PROBE4(filter_decision, i, filter->type, 1, *length);
+                if (duration_ms == 0) {
+                    plan->hold_us = FILTER_HOLD_FOREVER;
+                } else {
+                    plan_hold(plan, (uint64_t)duration_ms * 1000);
+                    effect->delay_us += (uint64_t)duration_ms * 1000;
+                }
+                break;
+            }
+
+            case FILTER_FRAGMENT: {
+                int size = filter->params.fragment.size;
+                PROBE4(filter_decision, i, filter->type, 1, *length);
+                if (*length > size) {
+                    effect->modified++;
+                }
+                if (plan->fragment == 0 || size < plan->fragment) {
+                    plan->fragment = size;
+                }
                 break;
             }
 
+            case FILTER_HALF_CLOSE:
+                LOG_WARN("반쪽 닫기 주입 (청크 %d bytes 대신 FIN)", *length);
+                PROBE4(filter_decision, i, filter->type, 0, *length);
+                effect->dropped++;
+                plan->hold_ms = filter->params.half_close.hold_ms;
+                return VERDICT_HALF_CLOSE;
+
+            case FILTER_DUPLICATE:
+            case FILTER_REORDER: {
+                bool hit = rng_uniform(&path->rng) < filter->params.chance.rate;
+                PROBE4(filter_decision, i, filter->type, 1, *length);
+                if (!hit) break;
+
+                effect->modified++;
+                if (filter->type == FILTER_DUPLICATE) {
+                    plan->copies++;
+                } else {
+                    plan->reorder = true;
+                }
+                break;
+            }
+
+            case FILTER_MYSQL_ERROR:
+                LOG_WARN("MySQL 오류 주입: %d (쿼리 %d bytes를 서버로 보내지 않음)",
+                         filter->params.mysql_error.code, *length);
+                PROBE4(filter_decision, i, filter->type, 0, *length);
+                effect->dropped++;
+                plan->error_code = filter->params.mysql_error.code;
+                return VERDICT_ERROR;
+
+            case FILTER_HTTP_ERROR:
+                LOG_WARN("HTTP 오류 주입: %d (요청 %d bytes를 서버로 보내지 않음)",
+                         filter->params.http_error.status, *length);
+                PROBE4(filter_decision, i, filter->type, 0, *length);
+                effect->dropped++;
+                plan->error_code = filter->params.http_error.status;
+                return VERDICT_ERROR;
+
             default:
                 break;
         }
     }
 
-    return true;  // 통과
+    return VERDICT_PASS;  // 통과
+}
+
+FilterVerdict filter_apply_datagram(FilterPath *path, const DatagramContext *ctx,
+                                    const char *data, int length, FilterPlan *plan) {
+    memset(plan, 0, sizeof(FilterPlan));
+    plan->copies = 1;
+
+    FilterChain *chain = &path->chain;
+    uint64_t match_hits[MAX_FILTERS];
+    bool scanned = false;
+
+    for (int i = 0; i < chain->count; i++) {
+        Filter *filter = &chain->filters[i];
+        if (!(ctx->mask & (1u << i)) || !filter->enabled) {
+            continue;
+        }
+
+        if (filter->trigger.flags != 0) {
+            // 데이터그램은 서로 이어지지 않으므로 패턴은 매번 처음 상태에서 검출
+            if ((filter->trigger.flags & TRIGGER_MATCH) && !scanned && path->trigger_matcher) {
+                uint8_t unused[MATCHER_MAX_PATTERN_LEN];
+                matcher_flush(path->trigger_matcher, unused);
+                memset(match_hits, 0, sizeof(match_hits));
+                matcher_scan(path->trigger_matcher, (const uint8_t *)data, length, match_hits);
+                scanned = true;
+            }
+            ConnectionStats stats = { .client_to_server_bytes = ctx->session_bytes };
+            if (!trigger_fires(&filter->trigger, path, ctx->start_ms, &stats, ctx->offset, length,
+                               scanned ? match_hits[i] : 0)) {
+                continue;
+            }
+        }
+
+        FilterCounters *effect = &path->counters[i];
+
+        switch (filter->type) {
+            case FILTER_DELAY: {
+                int delay_us = delay_sample_us(path, ctx->rng, i, filter);
+                plan_hold(plan, delay_us);
+                effect->chunks++;
+                effect->bytes += length;
+                effect->delay_us += delay_us;
+                break;
+            }
+
+            case FILTER_DROP:
+                effect->chunks++;
+                effect->bytes += length;
+                if (rng_uniform(ctx->rng) < filter->params.drop.drop_rate) {
+                    // 초당 수십만 개가 버려질 수 있어 드롭마다 경고하지 않음
+                    LOG_DEBUG("데이터그램 드롭 (%d bytes)", length);
+                    effect->dropped++;
+                    return VERDICT_DROP;
+                }
+                break;
+
+            case FILTER_THROTTLE: {
+                uint64_t us = (uint64_t)length * 1000000 / filter->params.throttle.bytes_per_sec;
+                plan->throttle_us += us;
+                effect->chunks++;
+                effect->bytes += length;
+                effect->delay_us += us;
+                break;
+            }
+
+            case FILTER_DUPLICATE:
+                effect->chunks++;
+                effect->bytes += length;
+                if (rng_uniform(ctx->rng) < filter->params.chance.rate) {
+                    effect->modified++;
+                    plan->copies++;
+                }
+                break;
+
+            default:
+                break;  // 스트림 고장은 데이터그램에 적용하지 않음
+        }
+    }
+
+    return VERDICT_PASS;
+}
+
+// 수정 패턴 표시 (출력 가능한 문자만 있으면 리터럴, 아니면 0x 16진수)
+static void modify_bytes_describe(const uint8_t *bytes, int len, char *buf, size_t size) {
+    bool literal = !(len >= 2 && bytes[0] == '0' && bytes[1] == 'x');
+    for (int i = 0; i < len && literal; i++) {
+        literal = isgraph(bytes[i]) && !strchr("/,!", bytes[i]);
+    }
+
+    if (literal) {
+        snprintf(buf, size, "%.*s", len, (const char *)bytes);
+        return;
+    }
+
+    size_t pos = snprintf(buf, size, "0x");
+    for (int i = 0; i < len && pos + 2 < size; i++) {
+        pos += snprintf(buf + pos, size - pos, "%02x", bytes[i]);
+    }
+}
+
+static void modify_rules_describe(const Filter *filter, char *buf, size_t size) {
+    size_t len = 0;
+    buf[0] = '\0';
+
+    for (int i = 0; i < filter->params.modify.rule_count && len < size; i++) {
+        const ModifyRule *rule = &filter->params.modify.rules[i];
+        char pattern[MODIFY_MAX_PATTERN_LEN * 2 + 3];
+        char replacement[MODIFY_MAX_PATTERN_LEN * 2 + 3];
+
+        modify_bytes_describe(rule->pattern, rule->len, pattern, sizeof(pattern));
+        if (rule->action == MATCH_FLIP) {
+            snprintf(replacement, sizeof(replacement), "!flip");
+        } else if (rule->action == MATCH_ZERO) {
+            snprintf(replacement, sizeof(replacement), "!zero");
+        } else {
+            modify_bytes_describe(rule->replacement, rule->len, replacement, sizeof(replacement));
+        }
+        len += snprintf(buf + len, size - len, "%s%s/%s", i ? "," : "", pattern, replacement);
+    }
+}
+
+// 선택자 설명 (없으면 빈 문자열)
+static void selector_describe(const Filter *filter, char *buf, size_t size) {
+    const FilterSelector *sel = &filter->selector;
+    size_t len = 0;
+    buf[0] = '\0';
+
+    if (filter->directions == FILTER_DIR_C2S) {
+        len += snprintf(buf + len, size - len, " dir=c2s");
+    } else if (filter->directions == FILTER_DIR_S2C) {
+        len += snprintf(buf + len, size - len, " dir=s2c");
+    }
+    if ((sel->flags & SELECT_CLIENT_CIDR) && len < size) {
+        char addr[INET6_ADDRSTRLEN];
+        inet_ntop(sel->family, sel->addr, addr, sizeof(addr));
+        len += snprintf(buf + len, size - len, " client=%s/%d", addr, sel->prefix_len);
+    }
+    if ((sel->flags & SELECT_CLIENT_PORT) && len < size) {
+        len += snprintf(buf + len, size - len, " ports=%d-%d", sel->port_min, sel->port_max);
+    }
+    if ((sel->flags & SELECT_CONN_ID) && len < size) {
+        len += snprintf(buf + len, size - len, " conn=%lu", sel->conn_id);
+    }
+    if ((sel->flags & SELECT_PID) && len < size) {
+        len += snprintf(buf + len, size - len, " pid=%d", sel->pid);
+    }
+    if ((sel->flags & SELECT_PERCENT) && len < size) {
+        len += snprintf(buf + len, size - len, " percent=%.1f", sel->percent);
+    }
+    if ((sel->flags & SELECT_LISTENER) && len < size) {
+        len += snprintf(buf + len, size - len, " listener=%s", sel->listener);
+    }
+
+    // 트리거 조건
+    const FilterTrigger *trigger = &filter->trigger;
+    if ((trigger->flags & TRIGGER_MATCH) && len < size) {
+        char pattern[MODIFY_MAX_PATTERN_LEN * 2 + 3];
+        modify_bytes_describe(trigger->pattern, trigger->pattern_len, pattern, sizeof(pattern));
+        len += snprintf(buf + len, size - len, " match=%s", pattern);
+    }
+    if ((trigger->flags & TRIGGER_AFTER) && len < size) {
+        len += snprintf(buf + len, size - len, " after=%lu", trigger->after_bytes);
+    }
+    if ((trigger->flags & TRIGGER_OFFSET) && len < size) {
+        len += snprintf(buf + len, size - len, trigger->offset_max ? " offset=%lu-%lu" : " offset=%lu",
+                        trigger->offset_min, trigger->offset_max);
+    }
+    if ((trigger->flags & TRIGGER_ELAPSED) && len < size) {
+        len += snprintf(buf + len, size - len,
+                        trigger->elapsed_max_ms ? " elapsed=%lu-%lu" : " elapsed=%lu",
+                        trigger->elapsed_min_ms, trigger->elapsed_max_ms);
+    }
+    if ((trigger->flags & TRIGGER_QUERY) && len < size) {
+        len += snprintf(buf + len, size - len, " query=%s", trigger->query_prefix_len ? "" : "*");
+        for (int i = 0; i < trigger->query_prefix_len && len < size; i++) {
+            char c = trigger->query_prefix[i];
+            len += snprintf(buf + len, size - len, c == ' ' ? "%%20" : "%c", c);
+        }
+    }
 }
 
 void filter_chain_print(const FilterChain *chain) {
@@ -121,16 +1336,59 @@ void filter_chain_print(const FilterChain *chain) {
     LOG_INFO("=== 필터 체인 (%d개) ===", chain->count);
     for (int i = 0; i < chain->count; i++) {
         const Filter *filter = &chain->filters[i];
-        
+        char sel[256];
+        selector_describe(filter, sel, sizeof(sel));
+
         switch (filter->type) {
             case FILTER_DELAY:
-                LOG_INFO("  [%d] 지연: %d ms", i, filter->params.delay.delay_ms);
+                if (filter->params.delay.jitter_ms > 0) {
+                    LOG_INFO("  [%d] 지연: %d ms ±%d ms (%s, 상관 %.0f%%)%s", i,
+                             filter->params.delay.delay_ms, filter->params.delay.jitter_ms,
+                             dist_name(filter->params.delay.distribution),
+                             filter->params.delay.correlation * 100, sel);
+                } else {
+                    LOG_INFO("  [%d] 지연: %d ms%s", i, filter->params.delay.delay_ms, sel);
+                }
                 break;
             case FILTER_DROP:
-                LOG_INFO("  [%d] 드롭: %.2f%%", i, filter->params.drop.drop_rate * 100);
+                LOG_INFO("  [%d] 드롭: %.2f%%%s", i, filter->params.drop.drop_rate * 100, sel);
                 break;
             case FILTER_THROTTLE:
-                LOG_INFO("  [%d] 쓰로틀: %d bytes/sec", i, filter->params.throttle.bytes_per_sec);
+                LOG_INFO("  [%d] 쓰로틀: %d bytes/sec%s", i, filter->params.throttle.bytes_per_sec, sel);
+                break;
+            case FILTER_MODIFY: {
+                char rules[320];
+                modify_rules_describe(filter, rules, sizeof(rules));
+                LOG_INFO("  [%d] 수정: %s%s", i, rules, sel);
+                break;
+            }
+            case FILTER_RESET:
+                LOG_INFO("  [%d] 리셋: %d ms 후%s", i, filter->params.reset.after_ms, sel);
+                break;
+            case FILTER_STALL:
+                if (filter->params.stall.duration_ms > 0) {
+                    LOG_INFO("  [%d] 정지: %d ms%s", i, filter->params.stall.duration_ms, sel);
+                } else {
+                    LOG_INFO("  [%d] 정지: 연결 종료까지%s", i, sel);
+                }
+                break;
+            case FILTER_FRAGMENT:
+                LOG_INFO("  [%d] 분할: %d bytes씩%s", i, filter->params.fragment.size, sel);
+                break;
+            case FILTER_HALF_CLOSE:
+                LOG_INFO("  [%d] 반쪽 닫기: %d ms 유지%s", i, filter->params.half_close.hold_ms, sel);
+                break;
+            case FILTER_DUPLICATE:
+                LOG_INFO("  [%d] 복제: %.2f%%%s", i, filter->params.chance.rate * 100, sel);
+                break;
+            case FILTER_REORDER:
+                LOG_INFO("  [%d] 순서 바꾸기: %.2f%%%s", i, filter->params.chance.rate * 100, sel);
+                break;
+            case FILTER_MYSQL_ERROR:
+                LOG_INFO("  [%d] MySQL 오류 주입: %d%s", i, filter->params.mysql_error.code, sel);
+                break;
+            case FILTER_HTTP_ERROR:
+                LOG_INFO("  [%d] HTTP 오류 주입: %d%s", i, filter->params.http_error.status, sel);
                 break;
             default:
                 break;
@@ -0,0 +1,184 @@
+#include "../include/flight.h"
+#include "../include/logger.h"
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+// 슬롯 상태
+#define FLIGHT_SLOT_FREE     0
+#define FLIGHT_SLOT_ACTIVE   1
+#define FLIGHT_SLOT_CLOSED   2
+#define FLIGHT_SLOT_CLAIMING 3
+
+// 공유 메모리 레이아웃
+typedef struct {
+    uint64_t base_ticks;              // 초기화 시점 타임스탬프 (보정용)
+    struct timespec base_time;        // 초기화 시점 단조 시계
+    FlightRing rings[FLIGHT_SLOTS];
+} FlightShared;
+
+static FlightShared *g_flight = NULL;
+
+bool flight_init(void) {
+    g_flight = mmap(NULL, sizeof(FlightShared),
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (g_flight == MAP_FAILED) {
+        LOG_ERROR("플라이트 레코더 공유 메모리 생성 실패: %s", strerror(errno));
+        g_flight = NULL;
+        return false;
+    }
+
+    memset(g_flight, 0, sizeof(FlightShared));
+    g_flight->base_ticks = flight_now();
+    clock_gettime(CLOCK_MONOTONIC, &g_flight->base_time);
+    return true;
+}
+
+void flight_cleanup(void) {
+    if (g_flight != NULL) {
+        munmap(g_flight, sizeof(FlightShared));
+        g_flight = NULL;
+    }
+}
+
+static bool try_claim(FlightRing *ring, uint32_t expected) {
+    return __atomic_compare_exchange_n(&ring->state, &expected, FLIGHT_SLOT_CLAIMING,
+                                       false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+FlightRing *flight_open(pid_t pid, uint64_t conn_id) {
+    if (g_flight == NULL) return NULL;
+
+    time_t now = time(NULL);
+    FlightRing *claimed = NULL;
+
+    // 1차: 빈 슬롯 또는 보관 기간이 지난 슬롯
+    for (int i = 0; i < FLIGHT_SLOTS && claimed == NULL; i++) {
+        FlightRing *ring = &g_flight->rings[i];
+        uint32_t state = __atomic_load_n(&ring->state, __ATOMIC_ACQUIRE);
+
+        if (state == FLIGHT_SLOT_FREE ||
+            (state == FLIGHT_SLOT_CLOSED && now - ring->closed_at >= FLIGHT_GRACE_SEC)) {
+            if (try_claim(ring, state)) {
+                claimed = ring;
+            }
+        }
+    }
+
+    // 2차: 가장 오래전에 종료된 슬롯 재사용
+    while (claimed == NULL) {
+        FlightRing *oldest = NULL;
+        for (int i = 0; i < FLIGHT_SLOTS; i++) {
+            FlightRing *ring = &g_flight->rings[i];
+            if (__atomic_load_n(&ring->state, __ATOMIC_ACQUIRE) == FLIGHT_SLOT_CLOSED &&
+                (oldest == NULL || ring->closed_at < oldest->closed_at)) {
+                oldest = ring;
+            }
+        }
+
+        if (oldest == NULL) {
+            LOG_WARN("플라이트 레코더 슬롯 부족 (PID=%d)", pid);
+            return NULL;
+        }
+        if (try_claim(oldest, FLIGHT_SLOT_CLOSED)) {
+            claimed = oldest;
+        }
+    }
+
+    claimed->pid = pid;
+    claimed->conn_id = conn_id;
+    claimed->closed_at = 0;
+    claimed->head = 0;
+    __atomic_store_n(&claimed->state, FLIGHT_SLOT_ACTIVE, __ATOMIC_RELEASE);
+    return claimed;
+}
+
+void flight_close(FlightRing *ring) {
+    if (ring == NULL) return;
+
+    ring->closed_at = time(NULL);
+    __atomic_store_n(&ring->state, FLIGHT_SLOT_CLOSED, __ATOMIC_RELEASE);
+}
+
+void flight_reap(pid_t pid) {
+    if (g_flight == NULL) return;
+
+    for (int i = 0; i < FLIGHT_SLOTS; i++) {
+        FlightRing *ring = &g_flight->rings[i];
+        // 작성자가 끝났으므로 그대로 닫으면 마지막 이벤트까지 보관 기간 동안 조회 가능
+        if (ring->pid == pid && try_claim(ring, FLIGHT_SLOT_ACTIVE)) {
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);  // time()은 시그널 안전 함수가 아님
+            ring->closed_at = now.tv_sec;
+            __atomic_store_n(&ring->state, FLIGHT_SLOT_CLOSED, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+// 초기화 이후 경과 시간으로 타임스탬프 단위 보정
+static double ticks_per_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t ticks = flight_now() - g_flight->base_ticks;
+    double elapsed_us = (now.tv_sec - g_flight->base_time.tv_sec) * 1e6 +
+                        (now.tv_nsec - g_flight->base_time.tv_nsec) / 1e3;
+
+    if (elapsed_us <= 0 || ticks == 0) {
+        return 1000.0;  // 보정 불가 (ns 단위로 간주)
+    }
+    return ticks / elapsed_us;
+}
+
+bool flight_snapshot(pid_t pid, uint64_t conn_id, FlightDump *dump) {
+    memset(dump, 0, sizeof(FlightDump));
+    if (g_flight == NULL) return false;
+
+    // 활성 링 우선, 없으면 가장 최근에 종료된 링
+    FlightRing *match = NULL;
+    for (int i = 0; i < FLIGHT_SLOTS; i++) {
+        FlightRing *ring = &g_flight->rings[i];
+        uint32_t state = __atomic_load_n(&ring->state, __ATOMIC_ACQUIRE);
+
+        if (state != FLIGHT_SLOT_ACTIVE && state != FLIGHT_SLOT_CLOSED) continue;
+        if (conn_id != 0 ? ring->conn_id != conn_id : ring->pid != pid) continue;
+
+        if (state == FLIGHT_SLOT_ACTIVE) {
+            match = ring;
+            break;
+        }
+        if (match == NULL || ring->closed_at > match->closed_at) {
+            match = ring;
+        }
+    }
+
+    if (match == NULL) return false;
+
+    uint32_t head = __atomic_load_n(&match->head, __ATOMIC_ACQUIRE);
+    uint32_t count = head < FLIGHT_RING_SIZE ? head : FLIGHT_RING_SIZE;
+    uint32_t first = head - count;
+
+    for (uint32_t i = 0; i < count; i++) {
+        dump->events[i] = match->events[(first + i) & (FLIGHT_RING_SIZE - 1)];
+    }
+
+    // 복사 중 덮어쓰인 앞부분 제거
+    uint32_t head_after = __atomic_load_n(&match->head, __ATOMIC_ACQUIRE);
+    uint32_t overwritten = head_after - head;
+    if (overwritten > count) overwritten = count;
+    if (overwritten > 0) {
+        memmove(dump->events, dump->events + overwritten,
+                (count - overwritten) * sizeof(FlightEvent));
+        count -= overwritten;
+    }
+
+    dump->found = true;
+    dump->pid = match->pid;
+    dump->conn_id = match->conn_id;
+    dump->closed_at = match->closed_at;
+    dump->total_events = head_after;
+    dump->event_count = (int)count;
+    dump->ticks_per_us = ticks_per_us();
+    return true;
+}
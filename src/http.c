@@ -0,0 +1,478 @@
+#include "../include/http.h"
+#include "../include/flight.h"
+#include "../include/latency.h"
+#include "../include/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// 한 번의 청크 해석 상태
+typedef struct {
+    HttpSession *session;
+    HttpStream *st;
+    bool response;
+    uint64_t now_us;
+    HttpScan *scan;
+    int64_t latency_us;           // 이 청크에서 시작한 마지막 응답의 서버 응답 시간 (-1 = 없음)
+    int skip;                     // 앞에서 버릴 바이트 (버리던 메시지가 끝난 위치)
+} HttpParse;
+
+// 주입 가능한 응답 코드의 사유 구절
+typedef struct {
+    int status;
+    const char *reason;
+} HttpReason;
+
+static const HttpReason http_reasons[] = {
+    {400, "Bad Request"},
+    {403, "Forbidden"},
+    {404, "Not Found"},
+    {408, "Request Timeout"},
+    {429, "Too Many Requests"},
+    {500, "Internal Server Error"},
+    {502, "Bad Gateway"},
+    {503, "Service Unavailable"},
+    {504, "Gateway Timeout"},
+};
+
+HttpSession *http_session_create(void) {
+    HttpSession *session = calloc(1, sizeof(HttpSession));
+    if (session != NULL) {
+        session->client.content_length = -1;
+        session->server.content_length = -1;
+    }
+    return session;
+}
+
+void http_session_free(HttpSession *session) {
+    free(session);
+}
+
+static void stop_parsing(HttpSession *session, const char *reason) {
+    LOG_INFO("HTTP: %s, 이후 해석 없이 중계", reason);
+    session->passthrough = true;
+}
+
+// 대소문자 무시 접두사 비교
+static bool has_prefix(const char *line, int len, const char *prefix) {
+    int n = (int)strlen(prefix);
+    return len >= n && strncasecmp(line, prefix, n) == 0;
+}
+
+// 요청 줄 검사 ("METHOD SP target SP HTTP/1.x", 메서드는 대문자 토큰)
+static bool parse_request_line(HttpSession *session, const char *line, int len, bool truncated) {
+    int method_len = 0;
+    while (method_len < len && method_len < 20 &&
+           ((line[method_len] >= 'A' && line[method_len] <= 'Z') || line[method_len] == '-')) {
+        method_len++;
+    }
+    if (method_len == 0 || method_len >= len || line[method_len] != ' ') {
+        return false;
+    }
+    if (!truncated && (len < method_len + 10 || strncmp(line + len - 8, "HTTP/1.", 7) != 0)) {
+        return false;
+    }
+
+    session->request_head = method_len == 4 && strncmp(line, "HEAD", 4) == 0;
+    session->request_connect = method_len == 7 && strncmp(line, "CONNECT", 7) == 0;
+    return true;
+}
+
+// 응답을 기다리던 요청을 꺼내 서버 응답 시간 기록
+static void response_started(HttpParse *p, int status) {
+    HttpSession *session = p->session;
+    p->st->head = false;
+    if (session->pending_count == 0) {
+        return;  // 요청이 끝나기 전에 온 응답 (측정하지 않음)
+    }
+
+    HttpPending *req = &session->pending[session->pending_head];
+    session->pending_head = (session->pending_head + 1) % HTTP_PIPELINE_MAX;
+    session->pending_count--;
+    if (session->unsent > session->pending_count) {
+        session->unsent = session->pending_count;
+    }
+    p->st->head = req->head;
+    if (req->sent_us == 0) {
+        return;
+    }
+
+    uint64_t latency = session->response_start_us > req->sent_us ?
+                       session->response_start_us - req->sent_us : 0;
+    latency_record(&session->stats, latency, status >= 500);
+    session->stats.status[status >= 100 && status < 600 ? status / 100 : 0]++;
+    p->latency_us = (int64_t)latency;
+}
+
+// 메시지 끝 (요청이면 응답 대기 FIFO에 넣음)
+static void message_end(HttpParse *p, int offset) {
+    HttpStream *st = p->st;
+    HttpSession *session = p->session;
+
+    st->in_message = false;
+    st->state = HTTP_START_LINE;
+    if (st->discard) {
+        st->discard = false;
+        p->skip = offset;
+        return;
+    }
+
+    if (!p->response) {
+        if (session->pending_count >= HTTP_PIPELINE_MAX) {
+            stop_parsing(session, "응답을 기다리는 요청이 너무 많음");
+            return;
+        }
+        int tail = (session->pending_head + session->pending_count) % HTTP_PIPELINE_MAX;
+        session->pending[tail].sent_us = 0;
+        session->pending[tail].head = session->request_head;
+        session->pending_count++;
+        session->unsent++;
+    }
+}
+
+// 헤더 끝: 본문 형식 결정
+static void headers_done(HttpParse *p, int offset) {
+    HttpStream *st = p->st;
+    HttpSession *session = p->session;
+
+    if (p->response) {
+        if (st->status >= 100 && st->status < 200) {
+            // 중간 응답 (100 Continue 등): 최종 응답을 계속 기다림
+            st->in_message = false;
+            st->state = HTTP_START_LINE;
+            return;
+        }
+        if (st->head || st->status == 204 || st->status == 304) {
+            message_end(p, offset);
+            return;
+        }
+    } else if (session->request_connect) {
+        message_end(p, offset);
+        stop_parsing(session, "CONNECT 터널");
+        return;
+    }
+
+    if (st->chunked) {
+        st->state = HTTP_CHUNK_SIZE;
+    } else if (st->content_length > 0) {
+        st->state = HTTP_BODY;
+        st->remaining = (uint64_t)st->content_length;
+    } else if (st->content_length < 0 && p->response) {
+        st->state = HTTP_UNTIL_CLOSE;  // 길이 없는 응답은 연결 종료가 끝
+    } else {
+        message_end(p, offset);
+    }
+}
+
+// 줄 하나 처리 (CRLF 제외, offset은 줄 다음 위치)
+static void handle_line(HttpParse *p, const char *line, int len, bool truncated, int offset) {
+    HttpStream *st = p->st;
+    HttpSession *session = p->session;
+
+    switch (st->state) {
+        case HTTP_START_LINE:
+            st->content_length = -1;
+            st->chunked = false;
+            if (p->response) {
+                if (!has_prefix(line, len, "HTTP/1.") || len < 12 ||
+                    line[9] < '1' || line[9] > '5' || line[10] < '0' || line[10] > '9' ||
+                    line[11] < '0' || line[11] > '9') {
+                    stop_parsing(session, "HTTP 응답이 아님");
+                    return;
+                }
+                st->status = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+                if (st->status == 101) {
+                    stop_parsing(session, "프로토콜 업그레이드");
+                    return;
+                }
+                if (st->status >= 200) {
+                    response_started(p, st->status);
+                }
+            } else {
+                if (!parse_request_line(session, line, len, truncated)) {
+                    stop_parsing(session, session->request_seen ? "잘못된 요청 줄" : "HTTP 요청이 아님");
+                    return;
+                }
+                session->request_seen = true;
+            }
+            st->state = HTTP_HEADERS;
+            break;
+
+        case HTTP_HEADERS:
+            if (len == 0) {
+                headers_done(p, offset);
+            } else if (has_prefix(line, len, "content-length:")) {
+                char *endptr;
+                char value[24];
+                int n = len - 15 < (int)sizeof(value) - 1 ? len - 15 : (int)sizeof(value) - 1;
+                memcpy(value, line + 15, n);
+                value[n] = '\0';
+                long long length = strtoll(value, &endptr, 10);
+                while (*endptr == ' ' || *endptr == '\t') endptr++;
+                if (length < 0 || *endptr != '\0') {
+                    stop_parsing(session, "잘못된 Content-Length");
+                    return;
+                }
+                st->content_length = length;
+            } else if (has_prefix(line, len, "transfer-encoding:")) {
+                for (int i = 18; i + 7 <= len; i++) {
+                    if (strncasecmp(line + i, "chunked", 7) == 0) {
+                        st->chunked = true;
+                        break;
+                    }
+                }
+            }
+            break;
+
+        case HTTP_CHUNK_SIZE: {
+            uint64_t size = 0;
+            int i = 0;
+            while (i < len && line[i] == ' ') i++;
+            int digits = 0;
+            for (; i < len && digits < 16; i++, digits++) {
+                char c = line[i];
+                int v = (c >= '0' && c <= '9') ? c - '0' :
+                        (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                        (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                if (v < 0) break;
+                size = size * 16 + v;
+            }
+            if (digits == 0) {
+                stop_parsing(session, "잘못된 chunked 크기");
+                return;
+            }
+            if (size == 0) {
+                st->state = HTTP_TRAILERS;
+            } else {
+                st->state = HTTP_CHUNK_DATA;
+                st->remaining = size;
+            }
+            break;
+        }
+
+        case HTTP_CHUNK_END:
+            st->state = HTTP_CHUNK_SIZE;
+            break;
+
+        case HTTP_TRAILERS:
+            if (len == 0) {
+                message_end(p, offset);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// 아직 끝나지 않은 시작 줄이 HTTP일 수 있는지 (줄바꿈 없는 다른 프로토콜을 일찍 걸러냄)
+static bool start_line_plausible(bool response, const char *line, int len) {
+    if (response) {
+        const char *version = "HTTP/1.";
+        return strncmp(line, version, len < 7 ? len : 7) == 0;
+    }
+    for (int i = 0; i < len && i <= 20; i++) {
+        if (line[i] == ' ') return i > 0;
+        if (!((line[i] >= 'A' && line[i] <= 'Z') || line[i] == '-')) return false;
+    }
+    return len <= 20;
+}
+
+// 메시지 첫 바이트
+static void message_start(HttpParse *p, const uint8_t *data, int i, int length) {
+    HttpSession *session = p->session;
+    HttpScan *scan = p->scan;
+
+    p->st->in_message = true;
+    if (p->response) {
+        session->response_start_us = p->now_us;
+    } else {
+        session->chunk_requests++;
+    }
+
+    if (scan->start < 0) {
+        scan->start = i;
+        if (!p->response) {
+            const uint8_t *eol = memchr(data + i, '\n', length - i);
+            int n = eol ? (int)(eol - (data + i)) : length - i;
+            if (n > 0 && data[i + n - 1] == '\r') n--;
+            scan->line = (const char *)data + i;
+            scan->line_len = n;
+        }
+    }
+}
+
+// 청크 해석 (본문은 길이만큼 건너뛰고, 줄은 청크 안에 온전히 있으면 그 자리에서 읽음)
+static void stream_scan(HttpParse *p, const uint8_t *data, int length) {
+    HttpStream *st = p->st;
+    int i = 0;
+
+    while (i < length && !p->session->passthrough) {
+        if (st->state == HTTP_BODY || st->state == HTTP_CHUNK_DATA) {
+            uint64_t n = st->remaining;
+            if (n > (uint64_t)(length - i)) n = (uint64_t)(length - i);
+            st->remaining -= n;
+            i += (int)n;
+            if (st->remaining == 0) {
+                if (st->state == HTTP_BODY) {
+                    message_end(p, i);
+                } else {
+                    st->state = HTTP_CHUNK_END;
+                }
+            }
+            continue;
+        }
+        if (st->state == HTTP_UNTIL_CLOSE) {
+            break;
+        }
+
+        if (st->state == HTTP_START_LINE && !st->in_message && st->line_len == 0) {
+            // 메시지 사이의 빈 줄은 무시
+            if (data[i] == '\r' || data[i] == '\n') {
+                i++;
+                continue;
+            }
+            message_start(p, data, i, length);
+        }
+
+        const uint8_t *eol = memchr(data + i, '\n', length - i);
+        int n = eol ? (int)(eol - (data + i)) + 1 : length - i;
+        const char *line;
+        int line_len;
+        bool truncated = false;
+
+        if (eol && st->line_len == 0) {
+            line = (const char *)data + i;
+            line_len = n - 1;
+        } else {
+            int room = HTTP_LINE_MAX - st->line_len;
+            int copy = n < room ? n : room;
+            memcpy(st->line + st->line_len, data + i, copy);
+            st->line_len += copy;
+            truncated = copy < n;
+            line = st->line;
+            line_len = st->line_len;
+            if (!truncated && eol) line_len--;
+        }
+        i += n;
+        if (!eol) {
+            if (st->state == HTTP_START_LINE && !start_line_plausible(p->response, line, line_len)) {
+                stop_parsing(p->session, p->response ? "HTTP 응답이 아님" : "HTTP 요청이 아님");
+            }
+            break;  // 줄이 다음 청크로 이어짐
+        }
+
+        st->line_len = 0;
+        if (line_len > 0 && line[line_len - 1] == '\r') {
+            line_len--;
+        }
+        handle_line(p, line, line_len, truncated, i);
+    }
+
+    if (st->discard) {
+        p->skip = length;
+    }
+}
+
+int http_recv_limit(const HttpSession *session, uint8_t dir) {
+    const HttpStream *st = (dir == FLIGHT_DIR_C2S) ? &session->client : &session->server;
+    if (session->passthrough || st->state != HTTP_BODY || st->remaining >= BUFFER_SIZE) {
+        return 0;
+    }
+    return (int)st->remaining;
+}
+
+static void parse_init(HttpParse *p, HttpSession *session, bool response, uint64_t now_us,
+                       HttpScan *scan) {
+    p->session = session;
+    p->st = response ? &session->server : &session->client;
+    p->response = response;
+    p->now_us = now_us;
+    p->scan = scan;
+    p->latency_us = -1;
+    p->skip = 0;
+    scan->start = -1;
+    scan->line = NULL;
+    scan->line_len = 0;
+    scan->can_reply = false;
+}
+
+int http_client_data(HttpSession *session, const char *data, int length, HttpScan *scan) {
+    HttpParse p;
+    parse_init(&p, session, false, 0, scan);
+    if (session->passthrough) {
+        return 0;
+    }
+
+    // 이전 요청이 모두 응답을 받았고 요청 경계에서 시작하는 청크만 오류로 대신 응답할 수 있음
+    bool idle = session->pending_count == 0 && !session->client.in_message &&
+                !session->client.discard;
+    session->chunk_requests = 0;
+
+    stream_scan(&p, (const uint8_t *)data, length);
+    scan->can_reply = idle && scan->start == 0 && !session->passthrough;
+    return p.skip;
+}
+
+void http_client_sent(HttpSession *session, uint64_t now_us) {
+    for (int k = session->pending_count - session->unsent; k < session->pending_count; k++) {
+        session->pending[(session->pending_head + k) % HTTP_PIPELINE_MAX].sent_us = now_us;
+    }
+    session->unsent = 0;
+}
+
+int http_server_data(HttpSession *session, const char *data, int length, uint64_t now_us,
+                     HttpScan *scan, int64_t *latency_us) {
+    HttpParse p;
+    parse_init(&p, session, true, now_us, scan);
+    *latency_us = -1;
+    if (session->passthrough) {
+        return 0;
+    }
+
+    stream_scan(&p, (const uint8_t *)data, length);
+    *latency_us = p.latency_us;
+    return p.skip;
+}
+
+void http_drop_message(HttpSession *session, uint8_t dir) {
+    HttpStream *st = (dir == FLIGHT_DIR_C2S) ? &session->client : &session->server;
+    if (st->in_message) {
+        st->discard = true;  // 길이 없는 응답이면 연결이 끝날 때까지 버림
+    }
+
+    // 서버로 가지 않은 요청은 응답을 기다리지 않음
+    if (dir == FLIGHT_DIR_C2S) {
+        session->pending_count -= session->unsent;
+        session->unsent = 0;
+    }
+}
+
+int http_inject_error(HttpSession *session, int status, char *out) {
+    const char *reason = "Error";
+    for (size_t i = 0; i < sizeof(http_reasons) / sizeof(http_reasons[0]); i++) {
+        if (http_reasons[i].status == status) {
+            reason = http_reasons[i].reason;
+            break;
+        }
+    }
+
+    int len = snprintf(out, HTTP_ERROR_RESPONSE_MAX,
+                       "HTTP/1.1 %d %s\r\nContent-Type: text/plain\r\nContent-Length: %d\r\n\r\n%s\n",
+                       status, reason, (int)strlen(reason) + 1, reason);
+    if (len >= HTTP_ERROR_RESPONSE_MAX) {
+        len = HTTP_ERROR_RESPONSE_MAX - 1;
+    }
+
+    // 청크에서 시작한 요청마다 응답 하나씩 (파이프라이닝 순서 유지)
+    int count = session->chunk_requests > 0 ? session->chunk_requests : 1;
+    for (int k = 1; k < count && k < HTTP_PIPELINE_MAX; k++) {
+        memcpy(out + k * len, out, len);
+    }
+    if (count > HTTP_PIPELINE_MAX) count = HTTP_PIPELINE_MAX;
+
+    http_drop_message(session, FLIGHT_DIR_C2S);
+    session->stats.injected += count;
+    return len * count;
+}
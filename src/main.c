@@ -13,6 +13,11 @@
 #include "filter.h"
 #include "proxy.h"
 #include "control.h"
+#include "dist.h"
+#include "rng.h"
+#include "tls.h"
+#include "capture.h"
+#include "udp.h"
 
 static volatile sig_atomic_t keep_running = 1;
 
@@ -21,9 +26,10 @@ void sigchld_handler(int signum) {
     (void)signum;  // 미사용 경고 방지
     int saved_errno = errno;
 
-    // 모든 종료된 자식 프로세스 정리
-    while (waitpid(-1, NULL, WNOHANG) > 0) {
-        // 자식 프로세스 정리
+    // 모든 종료된 자식 프로세스 정리 (flight_close 없이 끝난 연결의 플라이트 링도 닫음)
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        flight_reap(pid);
     }
 
     errno = saved_errno;
@@ -40,26 +46,71 @@ void signal_handler(int signum) {
         // 제어 소켓 정리
         control_server_stop();
 
+        // 캡처 링에 남은 레코드를 파일에 씀
+        capture_stop();
+
+        // 유닉스 리스닝 소켓 파일 정리
+        proxy_stop();
+
         exit(0);
     }
 }
 
+// "c2s:100" 형식의 방향 한정자 분리 (없으면 양방향), 잘못된 방향이면 NULL
+static const char *parse_direction_prefix(const char *arg, int *directions) {
+    const char *colon = strchr(arg, ':');
+    *directions = FILTER_DIR_BOTH;
+    if (colon == NULL) {
+        return arg;
+    }
+
+    char name[8];
+    size_t len = (size_t)(colon - arg);
+    if (len >= sizeof(name)) {
+        return NULL;
+    }
+    memcpy(name, arg, len);
+    name[len] = '\0';
+
+    *directions = filter_parse_direction(name);
+    return *directions ? colon + 1 : NULL;
+}
+
 void print_usage(const char *program_name) {
     printf("사용법: %s [옵션]\n", program_name);
     printf("\n옵션:\n");
-    printf("  -p <port>       리스닝 포트 (기본값: 9999)\n");
-    printf("  -t <host:port>  대상 서버 (기본값: 127.0.0.1:8080)\n");
-    printf("  -c <file>       설정 파일 경로\n");
+    printf("  -p <port>       리스닝 포트 (기본값: 9999, IPv6/IPv4 겸용) 또는 주소 (host:port, [v6]:port, unix:/경로)\n");
+    printf("  -t <host:port>  대상 서버 (기본값: 127.0.0.1:8080, [v6]:port, unix:/경로)\n");
+    printf("  -c <file>       설정 파일 경로 ([이름] 구역마다 리스너 하나)\n");
     printf("  -l <file>       로그 파일 경로 (기본값: logs/proxy.log)\n");
-    printf("  -d <ms>         지연 필터 추가 (밀리초)\n");
-    printf("  -r <rate>       드롭 필터 추가 (0.0~1.0)\n");
-    printf("  -b <bytes/s>    쓰로틀 필터 추가 (bytes per second)\n");
+    printf("  -d [dir:]<ms>   지연 필터 추가 (밀리초)\n");
+    printf("  -r [dir:]<rate> 드롭 필터 추가 (0.0~1.0)\n");
+    printf("  -b [dir:]<B/s>  쓰로틀 필터 추가 (bytes per second)\n");
+    printf("                  dir: c2s(클라이언트→서버), s2c(서버→클라이언트), both(기본값)\n");
+    printf("  -f <spec>       필터 명세로 추가 (예: \"delay=100 dir=s2c client=10.0.0.0/8\")\n");
+    printf("  -s <seed>       난수 마스터 시드 (같은 시드면 같은 드롭/지터 순서, 기본값: 자동)\n");
+    printf("  -S <file>       고장 시나리오 파일 실행 (시각별 필터 변경)\n");
+    printf("  -m <protocol>   프로토콜 인식 모드 (raw, mysql, http: 쿼리/요청 단위 지연/오류와 응답 시간 측정)\n");
+    printf("  -P <dir>        PROXY 프로토콜 (in: 클라이언트 헤더 v1/v2 해석, out: 대상에 v2 전송, both)\n");
+    printf("  -R <sni>=<host:port> TLS SNI별 대상 추가 (TLS 종료 없음, 예: \"*.example.com=10.0.0.5:443\")\n");
+    printf("  -w <file>       선택한 연결의 양방향 트래픽을 pcapng로 캡처\n");
+    printf("  -W <selector>   캡처할 연결 선택자 (예: \"client=10.0.0.0/8 percent=10\", 기본값: 모든 연결)\n");
+    printf("  -M <host:port>  서버로 보내는 바이트를 섀도 백엔드에도 복제 (응답은 버림)\n");
+    printf("  -X <selector>   미러링할 연결 선택자 (예: \"percent=10\", 기본값: 모든 연결)\n");
+    printf("  -u              UDP 모드 (클라이언트 주소별 세션, 데이터그램 단위 드롭/지연/쓰로틀/복제)\n");
     printf("  -v              디버그 모드\n");
     printf("  -h              도움말\n");
     printf("\n예시:\n");
     printf("  %s -p 9999 -t 127.0.0.1:8080\n", program_name);
     printf("  %s -p 10000 -t db.example.com:3306 -d 100 -r 0.1\n", program_name);
+    printf("  %s -d s2c:200 -b c2s:10240\n", program_name);
     printf("  %s -c config/proxy.conf\n", program_name);
+    printf("  %s -c config/multi_proxy.conf\n", program_name);
+    printf("  %s -f \"drop=0.5 ports=40000-40100\"\n", program_name);
+    printf("  %s -u -p 5353 -t 10.0.0.53:53 -r c2s:0.05 -d s2c:20\n", program_name);
+    printf("  %s -p 3307 -t unix:/run/mysqld/mysqld.sock -d 50\n", program_name);
+    printf("  %s -p 3307 -t db-v1:3306 -M db-v2:3306 -X percent=5\n", program_name);
+    printf("  %s -p 8443 -t 10.0.0.1:443 -R api.example.com=10.0.0.2:443 -R \"*.example.com=10.0.0.3:443\"\n", program_name);
 }
 
 int main(int argc, char *argv[]) {
@@ -72,43 +123,26 @@ int main(int argc, char *argv[]) {
     config_init(&config);
     filter_chain_init(&filter_chain);
     
-    // 난수 초기화 (드롭 필터용)
-    srand(time(NULL));
-    
     // 명령행 인자 파싱
     int opt;
-    while ((opt = getopt(argc, argv, "p:t:c:l:d:r:b:vh")) != -1) {
+    while ((opt = getopt(argc, argv, "p:t:c:l:d:r:b:f:s:S:m:R:P:w:W:M:X:uvh")) != -1) {
         switch (opt) {
-            case 'p': {
-                char *endptr;
-                long port = strtol(optarg, &endptr, 10);
-                if (*endptr != '\0' || port <= 0 || port > 65535) {
-                    fprintf(stderr, "잘못된 포트 번호: %s (1-65535 사이여야 함)\n", optarg);
+            case 'p':
+                // 포트, host:port, [v6]:port, unix:/경로
+                if (!config_parse_listen(optarg, config.listener.listen_host, sizeof(config.listener.listen_host),
+                                         &config.listener.listen_port)) {
+                    fprintf(stderr, "잘못된 리스닝 주소: %s (1-65535 포트, host:port, [v6]:port, unix:/경로)\n",
+                            optarg);
                     return 1;
                 }
-                config.listen_port = (int)port;
                 break;
-            }
-            case 't': {
-                char *colon = strchr(optarg, ':');
-                if (colon) {
-                    *colon = '\0';
-                    strncpy(config.target_host, optarg, MAX_HOST_LEN - 1);
-                    config.target_host[MAX_HOST_LEN - 1] = '\0';
-
-                    char *endptr;
-                    long port = strtol(colon + 1, &endptr, 10);
-                    if (*endptr != '\0' || port <= 0 || port > 65535) {
-                        fprintf(stderr, "잘못된 대상 포트 번호: %s\n", colon + 1);
-                        return 1;
-                    }
-                    config.target_port = (int)port;
-                } else {
-                    fprintf(stderr, "잘못된 대상 서버 형식: %s (host:port 형식이어야 함)\n", optarg);
+            case 't':
+                if (!config_parse_endpoint(optarg, config.listener.target_host, sizeof(config.listener.target_host),
+                                           &config.listener.target_port)) {
+                    fprintf(stderr, "잘못된 대상 서버 형식: %s (host:port, [v6]:port, unix:/경로)\n", optarg);
                     return 1;
                 }
                 break;
-            }
             case 'c':
                 strncpy(config_file, optarg, sizeof(config_file) - 1);
                 config_file[sizeof(config_file) - 1] = '\0';
@@ -119,37 +153,115 @@ int main(int argc, char *argv[]) {
                 break;
             case 'd': {
                 char *endptr;
-                long delay = strtol(optarg, &endptr, 10);
-                if (*endptr != '\0' || delay < 0 || delay > 10000) {
-                    fprintf(stderr, "잘못된 지연 시간: %s (0-10000ms)\n", optarg);
+                int directions;
+                const char *value = parse_direction_prefix(optarg, &directions);
+                long delay = value ? strtol(value, &endptr, 10) : -1;
+                if (value == NULL || *endptr != '\0' || delay < 0 || delay > 10000) {
+                    fprintf(stderr, "잘못된 지연 시간: %s ([c2s:|s2c:]0-10000ms)\n", optarg);
                     return 1;
                 }
-                filter_chain_add_delay(&filter_chain, (int)delay);
+                filter_chain_add_delay(&filter_chain, (int)delay, directions);
                 config.enable_filters = true;
                 break;
             }
             case 'r': {
                 char *endptr;
-                double rate = strtod(optarg, &endptr);
-                if (*endptr != '\0' || rate < 0.0 || rate > 1.0) {
-                    fprintf(stderr, "잘못된 드롭 확률: %s (0.0-1.0)\n", optarg);
+                int directions;
+                const char *value = parse_direction_prefix(optarg, &directions);
+                double rate = value ? strtod(value, &endptr) : -1.0;
+                if (value == NULL || *endptr != '\0' || rate < 0.0 || rate > 1.0) {
+                    fprintf(stderr, "잘못된 드롭 확률: %s ([c2s:|s2c:]0.0-1.0)\n", optarg);
                     return 1;
                 }
-                filter_chain_add_drop(&filter_chain, (float)rate);
+                filter_chain_add_drop(&filter_chain, (float)rate, directions);
                 config.enable_filters = true;
                 break;
             }
             case 'b': {
                 char *endptr;
-                long bps = strtol(optarg, &endptr, 10);
-                if (*endptr != '\0' || bps <= 0) {
-                    fprintf(stderr, "잘못된 대역폭: %s (양수여야 함)\n", optarg);
+                int directions;
+                const char *value = parse_direction_prefix(optarg, &directions);
+                long bps = value ? strtol(value, &endptr, 10) : 0;
+                if (value == NULL || *endptr != '\0' || bps <= 0) {
+                    fprintf(stderr, "잘못된 대역폭: %s ([c2s:|s2c:]양수)\n", optarg);
                     return 1;
                 }
-                filter_chain_add_throttle(&filter_chain, (int)bps);
+                filter_chain_add_throttle(&filter_chain, (int)bps, directions);
                 config.enable_filters = true;
                 break;
             }
+            case 'f': {
+                Filter filter;
+                char err[128];
+                if (!filter_parse_spec(optarg, &filter, err, sizeof(err))) {
+                    fprintf(stderr, "잘못된 필터 명세: %s (%s)\n", optarg, err);
+                    return 1;
+                }
+                if (!filter_chain_add(&filter_chain, &filter)) {
+                    return 1;
+                }
+                config.enable_filters = true;
+                break;
+            }
+            case 's':
+                if (!config_parse_seed(optarg, &config.seed)) {
+                    fprintf(stderr, "잘못된 시드: %s (0이 아닌 정수)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'S':
+                strncpy(config.scenario_file, optarg, sizeof(config.scenario_file) - 1);
+                break;
+            case 'm': {
+                int protocol = config_parse_protocol(optarg);
+                if (protocol < 0) {
+                    fprintf(stderr, "알 수 없는 프로토콜: %s (raw, mysql, http)\n", optarg);
+                    return 1;
+                }
+                config.listener.protocol = protocol;
+                break;
+            }
+            case 'P': {
+                int proxy_protocol = config_parse_proxy_protocol(optarg);
+                if (proxy_protocol < 0) {
+                    fprintf(stderr, "잘못된 PROXY 프로토콜 방향: %s (none, in, out, both)\n", optarg);
+                    return 1;
+                }
+                config.listener.proxy_protocol = proxy_protocol;
+                break;
+            }
+            case 'R': {
+                char err[128];
+                if (config.listener.sni_route_count >= MAX_SNI_ROUTES) {
+                    fprintf(stderr, "SNI 라우팅 규칙이 너무 많습니다 (최대 %d개)\n", MAX_SNI_ROUTES);
+                    return 1;
+                }
+                if (!tls_parse_route(optarg, &config.listener.sni_routes[config.listener.sni_route_count], err, sizeof(err))) {
+                    fprintf(stderr, "잘못된 SNI 라우팅 규칙: %s (%s)\n", optarg, err);
+                    return 1;
+                }
+                config.listener.sni_route_count++;
+                break;
+            }
+            case 'w':
+                strncpy(config.capture_file, optarg, sizeof(config.capture_file) - 1);
+                break;
+            case 'W':
+                strncpy(config.capture_select, optarg, sizeof(config.capture_select) - 1);
+                break;
+            case 'M':
+                if (!config_parse_host_port(optarg, config.mirror_host, sizeof(config.mirror_host),
+                                            &config.mirror_port)) {
+                    fprintf(stderr, "잘못된 섀도 백엔드: %s (host:port 형식이어야 함)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'X':
+                strncpy(config.mirror_select, optarg, sizeof(config.mirror_select) - 1);
+                break;
+            case 'u':
+                config.udp = true;
+                break;
             case 'v':
                 log_level = LOG_DEBUG;
                 break;
@@ -164,7 +276,7 @@ int main(int argc, char *argv[]) {
     
     // 설정 파일 로드 (옵션)
     if (config_file[0] != '\0') {
-        config_load(&config, config_file);
+        config_load(&config, config_file, &filter_chain);
     }
     
     // 로거 초기화
@@ -179,6 +291,14 @@ int main(int argc, char *argv[]) {
     
     LOG_INFO("TCP 프록시 서버 v1.0");
     
+    // 시드가 없으면 생성 (로그에 남겨 재현 가능하게)
+    if (config.seed == 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t x = ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)ts.tv_nsec ^ ((uint64_t)getpid() << 16);
+        config.seed = rng_splitmix64(&x) | 1;
+    }
+
     // 설정 출력
     config_print(&config);
     
@@ -203,9 +323,12 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    // 프록시 시작
-    int result = proxy_start(&config, 
-                             config.enable_filters ? &filter_chain : NULL);
+    // 지연 분포 표 생성 (자식 프로세스는 fork로 물려받음)
+    dist_init();
+
+    // 프록시 시작 (UDP 모드는 fork 없이 이벤트 루프 하나)
+    FilterChain *chain = config.enable_filters ? &filter_chain : NULL;
+    int result = config.udp ? udp_proxy_start(&config, chain) : proxy_start(&config, chain);
     
     // 정리
     logger_cleanup();
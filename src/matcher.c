@@ -0,0 +1,325 @@
+#include "../include/matcher.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MATCHER_SIMD_NEEDLES 8   // SIMD 사전 필터가 비교하는 시작 바이트 쌍 최대 종류
+
+typedef struct {
+    uint8_t len;
+    uint8_t action;              // MatchAction
+    int tag;
+    uint8_t bytes[MATCHER_MAX_PATTERN_LEN];
+    uint8_t replacement[MATCHER_MAX_PATTERN_LEN];
+} MatchPattern;
+
+struct Matcher {
+    MatchPattern patterns[MATCHER_MAX_PATTERNS];
+    int pattern_count;
+
+    // DFA (상태 0 = 루트, 전이는 모든 바이트에 대해 채워짐)
+    int state_count;
+    uint16_t *next;              // [state_count * 256]
+    uint8_t *depth;              // 루트로부터의 길이 (= 보류해야 할 바이트 수)
+    int16_t *term;               // 이 상태에서 끝나는 패턴 (-1 = 없음)
+    uint16_t *dict;              // 실패 경로상 다음 출력 상태 (0 = 없음)
+    uint8_t *has_output;         // term 또는 dict가 있음
+
+    // 루트 상태에서 다음 후보 위치를 찾는 사전 필터
+    // 패턴의 앞 두 바이트 쌍으로 비교 (1바이트 패턴은 둘째 바이트를 무시)
+    uint8_t first[MATCHER_SIMD_NEEDLES];
+    uint8_t second[MATCHER_SIMD_NEEDLES];
+    bool any_second[MATCHER_SIMD_NEEDLES];
+    int pair_count;              // 서로 다른 시작 쌍 수 (초과하면 첫 바이트 표만 사용)
+    bool start[256];
+
+    // 스트림 상태
+    uint16_t state;
+    int held;                    // 보류 바이트 수 (= depth[state])
+    uint8_t carry[MATCHER_MAX_PATTERN_LEN];
+};
+
+Matcher *matcher_create(void) {
+    return calloc(1, sizeof(Matcher));
+}
+
+void matcher_free(Matcher *matcher) {
+    if (matcher == NULL) return;
+    free(matcher->next);
+    free(matcher->depth);
+    free(matcher->term);
+    free(matcher->dict);
+    free(matcher->has_output);
+    free(matcher);
+}
+
+bool matcher_add(Matcher *matcher, const uint8_t *pattern, int len,
+                 MatchAction action, const uint8_t *replacement, int tag) {
+    if (matcher->pattern_count >= MATCHER_MAX_PATTERNS ||
+        len <= 0 || len > MATCHER_MAX_PATTERN_LEN) {
+        return false;
+    }
+
+    MatchPattern *p = &matcher->patterns[matcher->pattern_count++];
+    p->len = (uint8_t)len;
+    p->action = (uint8_t)action;
+    p->tag = tag;
+    memcpy(p->bytes, pattern, len);
+    if (action == MATCH_REPLACE) {
+        memcpy(p->replacement, replacement, len);
+    }
+    return true;
+}
+
+// 시작 쌍 등록 (같은 쌍은 한 번만, 1바이트 패턴은 같은 첫 바이트의 쌍을 포괄)
+static void add_start_pair(Matcher *matcher, const MatchPattern *p) {
+    bool any = p->len == 1;
+    uint8_t second = any ? 0 : p->bytes[1];
+
+    for (int i = 0; i < matcher->pair_count && i < MATCHER_SIMD_NEEDLES; i++) {
+        if (matcher->first[i] != p->bytes[0]) continue;
+        if (matcher->any_second[i] || (!any && matcher->second[i] == second)) {
+            return;
+        }
+        if (any) {
+            matcher->any_second[i] = true;
+            return;
+        }
+    }
+
+    if (matcher->pair_count < MATCHER_SIMD_NEEDLES) {
+        matcher->first[matcher->pair_count] = p->bytes[0];
+        matcher->second[matcher->pair_count] = second;
+        matcher->any_second[matcher->pair_count] = any;
+    }
+    matcher->pair_count++;
+}
+
+bool matcher_build(Matcher *matcher) {
+    int max_states = 1;
+    for (int i = 0; i < matcher->pattern_count; i++) {
+        max_states += matcher->patterns[i].len;
+    }
+
+    matcher->next = calloc((size_t)max_states * 256, sizeof(uint16_t));
+    matcher->depth = calloc(max_states, sizeof(uint8_t));
+    matcher->term = malloc(max_states * sizeof(int16_t));
+    matcher->dict = calloc(max_states, sizeof(uint16_t));
+    matcher->has_output = calloc(max_states, sizeof(uint8_t));
+    uint16_t *fail = calloc(max_states, sizeof(uint16_t));
+    uint16_t *queue = malloc(max_states * sizeof(uint16_t));
+
+    if (!matcher->next || !matcher->depth || !matcher->term || !matcher->dict ||
+        !matcher->has_output || !fail || !queue) {
+        free(fail);
+        free(queue);
+        return false;
+    }
+    memset(matcher->term, 0xFF, max_states * sizeof(int16_t));
+
+    // 1. 트라이 (전이 0 = 간선 없음, 루트는 누구의 자식도 아니므로 구분 가능)
+    matcher->state_count = 1;
+    matcher->pair_count = 0;
+    for (int i = 0; i < matcher->pattern_count; i++) {
+        const MatchPattern *p = &matcher->patterns[i];
+        uint16_t s = 0;
+        for (int j = 0; j < p->len; j++) {
+            uint16_t *t = &matcher->next[s * 256 + p->bytes[j]];
+            if (*t == 0) {
+                *t = (uint16_t)matcher->state_count++;
+                matcher->depth[*t] = (uint8_t)(j + 1);
+            }
+            s = *t;
+        }
+        // 같은 패턴이 여러 번 추가되면 먼저 추가된 것을 사용
+        if (matcher->term[s] < 0) {
+            matcher->term[s] = (int16_t)i;
+        }
+
+        matcher->start[p->bytes[0]] = true;
+        add_start_pair(matcher, p);
+    }
+
+    // 2. BFS로 실패 링크를 계산하며 없는 전이를 채워 DFA로 변환
+    //    (실패 상태는 항상 더 얕으므로 그 행은 이미 완성되어 있음)
+    int head = 0, tail = 0;
+    queue[tail++] = 0;
+    while (head < tail) {
+        uint16_t s = queue[head++];
+        for (int c = 0; c < 256; c++) {
+            uint16_t t = matcher->next[s * 256 + c];
+            if (t != 0 && matcher->depth[t] == matcher->depth[s] + 1) {
+                uint16_t f = (s == 0) ? 0 : matcher->next[fail[s] * 256 + c];
+                fail[t] = f;
+                matcher->dict[t] = matcher->term[f] >= 0 ? f : matcher->dict[f];
+                matcher->has_output[t] = matcher->term[t] >= 0 || matcher->dict[t] != 0;
+                queue[tail++] = t;
+            } else {
+                matcher->next[s * 256 + c] = (s == 0) ? 0 : matcher->next[fail[s] * 256 + c];
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+
+    matcher->state = 0;
+    matcher->held = 0;
+    return true;
+}
+
+// 루트 상태에서 어떤 패턴이 시작될 수 있는 위치까지 건너뜀
+static int skip_to_candidate(const Matcher *matcher, const uint8_t *buf, int i, int len) {
+    int n = matcher->pair_count;
+
+    // 시작 바이트가 하나뿐이면 libc memchr (벡터화되어 있음)
+    if (n == 1) {
+        const uint8_t *p = memchr(buf + i, matcher->first[0], len - i);
+        return p ? (int)(p - buf) : len;
+    }
+
+#if defined(__SSE2__)
+    if (n <= MATCHER_SIMD_NEEDLES) {
+        // 16바이트씩 (첫 바이트 일치 AND 다음 바이트 일치)를 모든 쌍에 대해 OR
+        // 1바이트 패턴의 쌍은 둘째 바이트 비교 결과를 any 마스크로 무시
+        __m128i first[MATCHER_SIMD_NEEDLES], second[MATCHER_SIMD_NEEDLES], any[MATCHER_SIMD_NEEDLES];
+        for (int k = 0; k < n; k++) {
+            first[k] = _mm_set1_epi8((char)matcher->first[k]);
+            second[k] = _mm_set1_epi8((char)matcher->second[k]);
+            any[k] = matcher->any_second[k] ? _mm_set1_epi8(-1) : _mm_setzero_si128();
+        }
+
+        while (i + 17 <= len) {
+            __m128i v0 = _mm_loadu_si128((const __m128i *)(buf + i));
+            __m128i v1 = _mm_loadu_si128((const __m128i *)(buf + i + 1));
+            __m128i eq = _mm_setzero_si128();
+            for (int k = 0; k < n; k++) {
+                __m128i hit2 = _mm_or_si128(_mm_cmpeq_epi8(v1, second[k]), any[k]);
+                eq = _mm_or_si128(eq, _mm_and_si128(_mm_cmpeq_epi8(v0, first[k]), hit2));
+            }
+            int mask = _mm_movemask_epi8(eq);
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+            i += 16;
+        }
+    }
+#endif
+
+    while (i < len && !matcher->start[buf[i]]) {
+        i++;
+    }
+    return i;
+}
+
+// end 직전에서 끝나는 모든 패턴 적용 (매칭은 원본 기준, 치환은 이미 지나온 바이트에만)
+static int apply_matches(const Matcher *matcher, uint16_t state, uint8_t *buf, int end,
+                         uint64_t *hits) {
+    int count = 0;
+    uint16_t s = matcher->term[state] >= 0 ? state : matcher->dict[state];
+
+    while (s != 0) {
+        const MatchPattern *p = &matcher->patterns[matcher->term[s]];
+        uint8_t *at = buf + end - p->len;
+
+        switch (p->action) {
+            case MATCH_REPLACE:
+                memcpy(at, p->replacement, p->len);
+                break;
+            case MATCH_FLIP:
+                for (int i = 0; i < p->len; i++) at[i] ^= 0xFF;
+                break;
+            case MATCH_ZERO:
+                memset(at, 0, p->len);
+                break;
+            case MATCH_DETECT:
+                break;
+        }
+
+        if (hits) hits[p->tag]++;
+        count++;
+        s = matcher->dict[s];
+    }
+    return count;
+}
+
+int matcher_process(Matcher *matcher, uint8_t **data, int *length, uint64_t *hits) {
+    // 보류 바이트를 청크 앞에 붙임 (이미 DFA 상태에 반영되어 있으므로 다시 검사하지 않음)
+    uint8_t *buf = *data - matcher->held;
+    memcpy(buf, matcher->carry, matcher->held);
+
+    int len = *length + matcher->held;
+    int i = matcher->held;
+    uint16_t state = matcher->state;
+    const uint16_t *next = matcher->next;
+    int replaced = 0;
+
+    while (i < len) {
+        if (state == 0) {
+            i = skip_to_candidate(matcher, buf, i, len);
+            if (i >= len) break;
+        }
+        state = next[state * 256 + buf[i++]];
+        if (matcher->has_output[state]) {
+            replaced += apply_matches(matcher, state, buf, i, hits);
+        }
+    }
+
+    // 진행 중인 접두사는 다음 청크까지 보류
+    int hold = matcher->depth[state];
+    memcpy(matcher->carry, buf + len - hold, hold);
+    matcher->state = state;
+    matcher->held = hold;
+
+    *data = buf;
+    *length = len - hold;
+    return replaced;
+}
+
+// 검출만 하는 스캔용: end에서 끝나는 패턴 수를 태그별로 집계
+static int count_matches(const Matcher *matcher, uint16_t state, uint64_t *hits) {
+    int count = 0;
+    uint16_t s = matcher->term[state] >= 0 ? state : matcher->dict[state];
+
+    while (s != 0) {
+        if (hits) hits[matcher->patterns[matcher->term[s]].tag]++;
+        count++;
+        s = matcher->dict[s];
+    }
+    return count;
+}
+
+int matcher_scan(Matcher *matcher, const uint8_t *data, int length, uint64_t *hits) {
+    uint16_t state = matcher->state;
+    const uint16_t *next = matcher->next;
+    int found = 0;
+    int i = 0;
+
+    while (i < length) {
+        if (state == 0) {
+            i = skip_to_candidate(matcher, data, i, length);
+            if (i >= length) break;
+        }
+        state = next[state * 256 + data[i++]];
+        if (matcher->has_output[state]) {
+            found += count_matches(matcher, state, hits);
+        }
+    }
+
+    matcher->state = state;
+    return found;
+}
+
+int matcher_pending(const Matcher *matcher) {
+    return matcher->held;
+}
+
+int matcher_flush(Matcher *matcher, uint8_t *out) {
+    int held = matcher->held;
+    memcpy(out, matcher->carry, held);
+    matcher->state = 0;
+    matcher->held = 0;
+    return held;
+}
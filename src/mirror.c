@@ -0,0 +1,304 @@
+#include "../include/mirror.h"
+#include "../include/filter.h"
+#include "../include/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+// 공유 카운터 (fork 전에 생성, 자식들이 원자적으로 더함)
+typedef struct {
+    uint64_t sessions;
+    uint64_t connect_failed;
+    uint64_t overflowed;
+    uint64_t bytes;
+    uint64_t dropped_bytes;
+    uint64_t discarded_bytes;
+} MirrorShared;
+
+typedef enum {
+    MIRROR_CONNECTING = 0,
+    MIRROR_CONNECTED,
+    MIRROR_BROKEN                 // 연결 실패/큐 넘침/섀도가 닫음: 이후 바이트는 버림
+} MirrorState;
+
+// 연결별 상태 (자식 프로세스 전용)
+typedef struct MirrorFlow {
+    int fd;
+    MirrorState state;
+    size_t start;                 // 큐에서 아직 보내지 않은 구간 [start, end)
+    size_t end;
+    char queue[MIRROR_QUEUE_SIZE];
+} MirrorFlow;
+
+static MirrorShared *g_mirror = NULL;
+static FilterSelector g_selector;        // 자식은 fork로 물려받음
+static struct sockaddr_storage g_addr;   // 섀도 주소 (시작 시 한 번 해석)
+static socklen_t g_addr_len = 0;
+static char g_host[MAX_HOST_LEN];
+static int g_port = 0;
+static char g_selector_text[MAX_FILTER_SPEC_LEN];
+
+static void count(uint64_t *counter, uint64_t n) {
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+}
+
+// 섀도 쪽을 포기 (남은 큐는 버린 바이트로)
+static void mirror_abandon(MirrorFlow *flow, uint64_t *reason, const char *what) {
+    if (flow->state == MIRROR_BROKEN) {
+        return;
+    }
+    if (reason) {
+        count(reason, 1);
+    }
+    count(&g_mirror->dropped_bytes, flow->end - flow->start);
+    flow->start = flow->end = 0;
+    flow->state = MIRROR_BROKEN;
+    if (flow->fd >= 0) {
+        close(flow->fd);
+        flow->fd = -1;
+    }
+    LOG_WARN("섀도 미러링 중단: %s", what);
+}
+
+// 큐에 쌓인 바이트를 보낼 수 있는 만큼 전송 (블로킹하지 않음)
+static void mirror_flush(MirrorFlow *flow) {
+    while (flow->state == MIRROR_CONNECTED && flow->start < flow->end) {
+        ssize_t n = send(flow->fd, flow->queue + flow->start, flow->end - flow->start,
+                         MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                mirror_abandon(flow, NULL, strerror(errno));
+            }
+            return;
+        }
+        count(&g_mirror->bytes, n);
+        flow->start += n;
+    }
+    if (flow->start == flow->end) {
+        flow->start = flow->end = 0;
+    }
+}
+
+MirrorFlow *mirror_open(const Connection *conn) {
+    if (g_mirror == NULL ||
+        !filter_selector_match(&g_selector, conn->conn_id, conn->pid,
+                               conn->client_addr, conn->client_port, conn->listener_name)) {
+        return NULL;
+    }
+
+    MirrorFlow *flow = malloc(sizeof(MirrorFlow));
+    if (flow == NULL) {
+        return NULL;
+    }
+    flow->state = MIRROR_CONNECTING;
+    flow->start = flow->end = 0;
+    count(&g_mirror->sessions, 1);
+
+    flow->fd = socket(g_addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (flow->fd < 0 ||
+        (connect(flow->fd, (struct sockaddr *)&g_addr, g_addr_len) < 0 && errno != EINPROGRESS)) {
+        mirror_abandon(flow, &g_mirror->connect_failed, strerror(errno));
+        return flow;
+    }
+
+    int one = 1;
+    setsockopt(flow->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    LOG_DEBUG("섀도 미러링 시작: %s:%d", g_host, g_port);
+    return flow;
+}
+
+void mirror_data(MirrorFlow *flow, const char *data, size_t length) {
+    if (flow == NULL || length == 0) {
+        return;
+    }
+    if (flow->state == MIRROR_BROKEN) {
+        count(&g_mirror->dropped_bytes, length);
+        return;
+    }
+
+    // 앞선 큐가 비면 바로 보내고, 못 보낸 나머지만 큐에
+    mirror_flush(flow);
+    if (flow->state == MIRROR_CONNECTED && flow->start == flow->end) {
+        ssize_t n = send(flow->fd, data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n > 0) {
+            count(&g_mirror->bytes, n);
+            data += n;
+            length -= n;
+        } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            mirror_abandon(flow, NULL, strerror(errno));
+            count(&g_mirror->dropped_bytes, length);
+            return;
+        }
+        if (length == 0) {
+            return;
+        }
+    }
+    if (flow->state == MIRROR_BROKEN) {
+        count(&g_mirror->dropped_bytes, length);
+        return;
+    }
+
+    if (flow->end + length > MIRROR_QUEUE_SIZE) {
+        if (flow->end - flow->start + length > MIRROR_QUEUE_SIZE) {
+            mirror_abandon(flow, &g_mirror->overflowed, "큐가 가득 참 (섀도가 따라오지 못함)");
+            count(&g_mirror->dropped_bytes, length);
+            return;
+        }
+        memmove(flow->queue, flow->queue + flow->start, flow->end - flow->start);
+        flow->end -= flow->start;
+        flow->start = 0;
+    }
+    memcpy(flow->queue + flow->end, data, length);
+    flow->end += length;
+}
+
+int mirror_fd(const MirrorFlow *flow) {
+    return flow ? flow->fd : -1;
+}
+
+bool mirror_wants_write(const MirrorFlow *flow) {
+    return flow && flow->fd >= 0 &&
+           (flow->state == MIRROR_CONNECTING || flow->start < flow->end);
+}
+
+void mirror_poll(MirrorFlow *flow, bool readable, bool writable) {
+    if (flow == NULL || flow->fd < 0) {
+        return;
+    }
+
+    if (flow->state == MIRROR_CONNECTING) {
+        if (!writable && !readable) {
+            return;
+        }
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(flow->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0) {
+            mirror_abandon(flow, &g_mirror->connect_failed, strerror(err));
+            return;
+        }
+        flow->state = MIRROR_CONNECTED;
+    }
+
+    // 섀도 응답은 읽어서 버림 (읽지 않으면 섀도가 막혀 요청도 받지 않음)
+    if (readable) {
+        char buf[BUFFER_SIZE];
+        while (1) {
+            ssize_t n = recv(flow->fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0) {
+                count(&g_mirror->discarded_bytes, n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                break;
+            }
+            mirror_abandon(flow, NULL, n == 0 ? "섀도가 연결을 닫음" : strerror(errno));
+            return;
+        }
+    }
+
+    mirror_flush(flow);
+}
+
+void mirror_close(MirrorFlow *flow) {
+    if (flow == NULL) {
+        return;
+    }
+
+    // 남은 큐를 잠깐 더 보냄 (주 연결은 이미 닫혀 클라이언트는 기다리지 않음)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    int64_t deadline_ms = (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 + MIRROR_DRAIN_MS;
+    while (mirror_wants_write(flow)) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        int64_t left = deadline_ms - ((int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+        struct pollfd pfd = { .fd = flow->fd, .events = POLLIN | POLLOUT };
+        if (left <= 0 || poll(&pfd, 1, (int)left) <= 0) {
+            break;
+        }
+        mirror_poll(flow, pfd.revents & (POLLIN | POLLERR | POLLHUP), pfd.revents & POLLOUT);
+    }
+
+    if (flow->state != MIRROR_BROKEN) {
+        count(&g_mirror->dropped_bytes, flow->end - flow->start);
+    }
+    if (flow->fd >= 0) {
+        close(flow->fd);
+    }
+    free(flow);
+}
+
+bool mirror_start(const char *host, int port, const char *selector) {
+    char err[160];
+    if (!filter_parse_selector(selector, &g_selector, err, sizeof(err))) {
+        LOG_ERROR("잘못된 미러링 선택자: %s", err);
+        return false;
+    }
+
+    // 섀도 주소는 한 번만 해석 (자식마다 DNS를 조회하지 않도록)
+    struct addrinfo hints, *result;
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int ret = getaddrinfo(host, port_str, &hints, &result);
+    if (ret != 0) {
+        LOG_ERROR("섀도 호스트를 찾을 수 없습니다: %s (%s)", host, gai_strerror(ret));
+        return false;
+    }
+    memcpy(&g_addr, result->ai_addr, result->ai_addrlen);
+    g_addr_len = result->ai_addrlen;
+    freeaddrinfo(result);
+
+    g_mirror = mmap(NULL, sizeof(MirrorShared), PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (g_mirror == MAP_FAILED) {
+        LOG_ERROR("미러링 카운터 공유 메모리 생성 실패: %s", strerror(errno));
+        g_mirror = NULL;
+        return false;
+    }
+
+    strncpy(g_host, host, sizeof(g_host) - 1);
+    g_port = port;
+    strncpy(g_selector_text, selector ? selector : "", sizeof(g_selector_text) - 1);
+
+    LOG_INFO("섀도 미러링: %s:%d (선택자: %s, 연결별 큐 %d KB)", host, port,
+             g_selector_text[0] ? g_selector_text : "모든 연결", MIRROR_QUEUE_SIZE / 1024);
+    return true;
+}
+
+void mirror_stop(void) {
+    if (g_mirror == NULL) return;
+
+    LOG_INFO("섀도 미러링 종료: 연결 %lu개, 보냄 %lu바이트, 버림 %lu바이트", g_mirror->sessions,
+             g_mirror->bytes, g_mirror->dropped_bytes);
+    munmap(g_mirror, sizeof(MirrorShared));
+    g_mirror = NULL;
+}
+
+void mirror_get_status(MirrorStatus *status) {
+    memset(status, 0, sizeof(MirrorStatus));
+    if (g_mirror == NULL) return;
+
+    status->enabled = true;
+    memcpy(status->host, g_host, sizeof(status->host));
+    status->port = g_port;
+    memcpy(status->selector, g_selector_text, sizeof(status->selector));
+    status->sessions = __atomic_load_n(&g_mirror->sessions, __ATOMIC_RELAXED);
+    status->connect_failed = __atomic_load_n(&g_mirror->connect_failed, __ATOMIC_RELAXED);
+    status->overflowed = __atomic_load_n(&g_mirror->overflowed, __ATOMIC_RELAXED);
+    status->bytes = __atomic_load_n(&g_mirror->bytes, __ATOMIC_RELAXED);
+    status->dropped_bytes = __atomic_load_n(&g_mirror->dropped_bytes, __ATOMIC_RELAXED);
+    status->discarded_bytes = __atomic_load_n(&g_mirror->discarded_bytes, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,211 @@
+#include "../include/mysql.h"
+#include "../include/latency.h"
+#include "../include/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 청크 스캔 결과 (이 청크에서 payload가 시작한 첫 패킷)
+typedef struct {
+    int start;                    // payload 첫 바이트 위치 (-1 = 없음)
+    uint8_t seq;
+    uint8_t type;                 // payload 첫 바이트 (명령/응답 종류)
+    uint32_t length;              // payload 길이
+    bool complete;                // 청크가 패킷 경계에서 끝남
+} MysqlScan;
+
+// 주입 가능한 오류의 SQLSTATE와 메시지 (서버가 보내는 것과 같게)
+typedef struct {
+    int code;
+    const char *sqlstate;
+    const char *message;
+} MysqlErrorInfo;
+
+static const MysqlErrorInfo mysql_errors[] = {
+    {1040, "08004", "Too many connections"},
+    {1205, "HY000", "Lock wait timeout exceeded; try restarting transaction"},
+    {1213, "40001", "Deadlock found when trying to get lock; try restarting transaction"},
+    {1317, "70100", "Query execution was interrupted"},
+    {3024, "HY000", "Query execution was interrupted, maximum statement execution time exceeded"},
+};
+
+MysqlSession *mysql_session_create(void) {
+    return calloc(1, sizeof(MysqlSession));
+}
+
+void mysql_session_free(MysqlSession *session) {
+    free(session);
+}
+
+// 헤더만 읽고 payload는 남은 길이만큼 건너뜀 (청크당 비용은 패킷 수에 비례)
+static void stream_scan(MysqlStream *st, const uint8_t *data, int length, MysqlScan *scan) {
+    int i = 0;
+    scan->start = -1;
+
+    while (i < length) {
+        if (st->remaining == 0 && st->header_len == 0 && length - i >= MYSQL_HEADER_LEN) {
+            // 헤더 전체가 청크 안에 있으면 모으지 않고 바로 읽음 (작은 행 패킷이 이어지는 경우)
+            st->length = data[i] | (data[i + 1] << 8) | ((uint32_t)data[i + 2] << 16);
+            st->seq = data[i + 3];
+            st->remaining = st->length;
+            st->at_payload = st->length > 0;
+            i += MYSQL_HEADER_LEN;
+            continue;
+        }
+
+        if (st->remaining == 0) {
+            // 헤더 (청크 경계에 걸치면 모아 둠)
+            int n = MYSQL_HEADER_LEN - st->header_len;
+            if (n > length - i) n = length - i;
+            memcpy(st->header + st->header_len, data + i, n);
+            st->header_len += n;
+            i += n;
+            if (st->header_len < MYSQL_HEADER_LEN) {
+                break;
+            }
+
+            st->length = st->header[0] | (st->header[1] << 8) | ((uint32_t)st->header[2] << 16);
+            st->seq = st->header[3];
+            st->header_len = 0;
+            st->remaining = st->length;
+            st->at_payload = st->length > 0;
+            continue;
+        }
+
+        if (st->at_payload) {
+            if (scan->start < 0) {
+                scan->start = i;
+                scan->seq = st->seq;
+                scan->type = data[i];
+                scan->length = st->length;
+            }
+            st->at_payload = false;
+        }
+
+        uint32_t n = st->remaining;
+        if (n > (uint32_t)(length - i)) n = (uint32_t)(length - i);
+        st->remaining -= n;
+        i += n;
+    }
+
+    scan->complete = st->remaining == 0 && st->header_len == 0;
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int mysql_client_data(MysqlSession *session, const char *data, int length,
+                      const char **query, int *query_len) {
+    *query = NULL;
+    *query_len = 0;
+    if (session->passthrough) {
+        return 0;
+    }
+
+    // 오류를 주입한 명령의 나머지는 서버로 보내지 않음 (스트림 상태는 그대로 이어감)
+    int skip = 0;
+    if (session->discard > 0) {
+        skip = session->discard < (uint32_t)length ? (int)session->discard : length;
+        session->discard -= skip;
+    }
+
+    MysqlScan scan;
+    stream_scan(&session->client, (const uint8_t *)data, length, &scan);
+
+    if (scan.start >= skip) {
+        const uint8_t *payload = (const uint8_t *)data + scan.start;
+        int available = length - scan.start;
+
+        if (!session->login_seen && scan.seq == 1) {
+            // 로그인 패킷 (또는 SSLRequest): 이후 프레이밍이 바뀌면 해석 중단
+            session->login_seen = true;
+            if (available >= 4 &&
+                (read_le32(payload) & (MYSQL_CLIENT_SSL | MYSQL_CLIENT_COMPRESS))) {
+                LOG_INFO("MySQL: TLS/압축 협상, 이후 해석 없이 중계");
+                session->passthrough = true;
+                return skip;
+            }
+        } else if (scan.seq == 0 &&
+                   (scan.type == MYSQL_COM_QUERY || scan.type == MYSQL_COM_STMT_EXECUTE)) {
+            session->query_open = true;
+            session->query_received = false;
+            *query = (const char *)payload + 1;
+            if (scan.type == MYSQL_COM_QUERY) {
+                uint32_t text_len = scan.length - 1;
+                *query_len = (uint32_t)(available - 1) < text_len ? available - 1 : (int)text_len;
+            }
+        }
+    }
+
+    if (session->query_open && scan.complete) {
+        session->query_open = false;
+        session->query_received = true;
+    }
+    return skip;
+}
+
+void mysql_client_sent(MysqlSession *session, uint64_t now_us) {
+    if (session->query_received) {
+        session->query_received = false;
+        session->awaiting_response = true;
+        session->sent_us = now_us;
+    }
+}
+
+int64_t mysql_server_data(MysqlSession *session, const char *data, int length, uint64_t now_us) {
+    if (session->passthrough) {
+        return -1;
+    }
+
+    MysqlScan scan;
+    stream_scan(&session->server, (const uint8_t *)data, length, &scan);
+
+    if (!session->awaiting_response || scan.start < 0) {
+        return -1;
+    }
+
+    session->awaiting_response = false;
+    uint64_t latency = now_us > session->sent_us ? now_us - session->sent_us : 0;
+    latency_record(&session->stats, latency, scan.type == MYSQL_ERR_PACKET);
+    return (int64_t)latency;
+}
+
+int mysql_inject_error(MysqlSession *session, int code, uint8_t *out) {
+    const char *sqlstate = "HY000";
+    const char *message = "Error injected by proxy";
+    for (size_t i = 0; i < sizeof(mysql_errors) / sizeof(mysql_errors[0]); i++) {
+        if (mysql_errors[i].code == code) {
+            sqlstate = mysql_errors[i].sqlstate;
+            message = mysql_errors[i].message;
+            break;
+        }
+    }
+
+    // ERR 패킷: 0xFF, 오류 번호(2), '#', SQLSTATE(5), 메시지 (sequence = 명령 + 1)
+    uint8_t *p = out + MYSQL_HEADER_LEN;
+    *p++ = MYSQL_ERR_PACKET;
+    *p++ = (uint8_t)(code & 0xFF);
+    *p++ = (uint8_t)((code >> 8) & 0xFF);
+    *p++ = '#';
+    memcpy(p, sqlstate, 5);
+    p += 5;
+    int message_len = snprintf((char *)p, MYSQL_ERROR_PACKET_MAX - (p - out), "%s", message);
+    if (message_len > MYSQL_ERROR_PACKET_MAX - (p - out) - 1) {
+        message_len = MYSQL_ERROR_PACKET_MAX - (int)(p - out) - 1;
+    }
+    p += message_len;
+
+    uint32_t payload_len = (uint32_t)(p - out - MYSQL_HEADER_LEN);
+    out[0] = (uint8_t)(payload_len & 0xFF);
+    out[1] = (uint8_t)((payload_len >> 8) & 0xFF);
+    out[2] = (uint8_t)((payload_len >> 16) & 0xFF);
+    out[3] = 1;
+
+    // 쿼리 패킷의 나머지는 버리고 응답 대기도 하지 않음
+    session->discard = session->client.remaining;
+    session->query_open = false;
+    session->query_received = false;
+    session->stats.injected++;
+    return (int)(p - out);
+}
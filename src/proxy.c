@@ -1,19 +1,38 @@
+#define _GNU_SOURCE
 #include "../include/proxy.h"
 #include "../include/logger.h"
 #include "../include/filter.h"
 #include "../include/control.h"
+#include "../include/tcpinfo.h"
+#include "../include/flight.h"
+#include "../include/probes.h"
+#include "../include/mysql.h"
+#include "../include/http.h"
+#include "../include/tls.h"
+#include "../include/proxyproto.h"
+#include "../include/capture.h"
+#include "../include/mirror.h"
+#include "../include/config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
+#include <poll.h>
 #include <errno.h>
+#include <signal.h>
+#include <math.h>
 
-// 모든 데이터를 전송할 때까지 반복
-static ssize_t send_all(int sockfd, const char *buf, size_t len) {
+// 모든 데이터를 전송할 때까지 반복 (재시도는 플라이트 레코더에 기록)
+static ssize_t send_all(int sockfd, const char *buf, size_t len, FlightRing *flight, uint8_t dir) {
     size_t total_sent = 0;
 
     while (total_sent < len) {
@@ -23,6 +42,7 @@ static ssize_t send_all(int sockfd, const char *buf, size_t len) {
                 return -1;
             }
             // EINTR or EAGAIN - 재시도
+            flight_record(flight, FLIGHT_EAGAIN, dir, errno);
             continue;
         }
         total_sent += sent;
@@ -31,10 +51,58 @@ static ssize_t send_all(int sockfd, const char *buf, size_t len) {
     return total_sent;
 }
 
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);  // 청크마다 호출하므로 저렴한 coarse 시계
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 static void stats_init(ConnectionStats *stats) {
     memset(stats, 0, sizeof(ConnectionStats));
     stats->start_time = time(NULL);
     stats->last_activity = stats->start_time;
+    stats->rate_last_ms = monotonic_ms();
+}
+
+// 주기가 지났으면 양쪽 소켓의 TCP_INFO 샘플링 (패킷마다 하지 않음)
+static bool stats_sample_tcp(Connection *conn, time_t now) {
+    if (now - conn->stats.last_tcp_sample < TCP_INFO_SAMPLE_SEC) {
+        return false;
+    }
+
+    conn->stats.last_tcp_sample = now;
+    tcpinfo_sample(conn->client_fd, &conn->stats.client_tcp);
+    tcpinfo_sample(conn->server_fd, &conn->stats.server_tcp);
+    return true;
+}
+
+// EWMA 창 길이 (초)
+static const float rate_window_sec[RATE_WINDOWS] = {1.0f, 10.0f, 60.0f};
+
+// 누적 바이트 증가분으로 처리량 EWMA 갱신 (RATE_UPDATE_MS마다 최대 한 번)
+static bool stats_update_rates(ConnectionStats *stats) {
+    uint64_t now_ms = monotonic_ms();
+    uint64_t elapsed_ms = now_ms - stats->rate_last_ms;
+
+    if (elapsed_ms < RATE_UPDATE_MS) {
+        return false;
+    }
+
+    float dt = elapsed_ms / 1000.0f;
+    float c2s_rate = (stats->client_to_server_bytes - stats->rate_base_c2s) / dt;
+    float s2c_rate = (stats->server_to_client_bytes - stats->rate_base_s2c) / dt;
+
+    for (int i = 0; i < RATE_WINDOWS; i++) {
+        // 불규칙한 간격에서도 창 길이가 유지되도록 경과 시간으로 가중치 계산
+        float alpha = 1.0f - expf(-dt / rate_window_sec[i]);
+        stats->rates.client_to_server[i] += alpha * (c2s_rate - stats->rates.client_to_server[i]);
+        stats->rates.server_to_client[i] += alpha * (s2c_rate - stats->rates.server_to_client[i]);
+    }
+
+    stats->rate_last_ms = now_ms;
+    stats->rate_base_c2s = stats->client_to_server_bytes;
+    stats->rate_base_s2c = stats->server_to_client_bytes;
+    return true;
 }
 
 static void stats_print(const ConnectionStats *stats) {
@@ -60,7 +128,34 @@ static void stats_print(const ConnectionStats *stats) {
     }
 }
 
+// 유닉스 도메인 소켓 대상 연결 (host = "unix:/경로")
+static int connect_unix(const char *host, const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
+        LOG_ERROR("소켓 생성 실패: %s", strerror(errno));
+        return -1;
+    }
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        LOG_ERROR("서버 연결 실패: %s - %s", host, strerror(errno));
+        close(sock);
+        return -1;
+    }
+
+    LOG_INFO("대상 서버 연결 성공: %s", host);
+    return sock;
+}
+
 int proxy_connect_target(const char *host, int port) {
+    const char *path = config_unix_path(host);
+    if (path != NULL) {
+        return connect_unix(host, path);
+    }
+
     struct addrinfo hints, *result, *rp;
     int sock = -1;
     char port_str[16];
@@ -96,162 +191,1042 @@ int proxy_connect_target(const char *host, int port) {
 
     freeaddrinfo(result);
 
+    char endpoint[MAX_HOST_LEN + 16];
+    config_format_endpoint(host, port, endpoint, sizeof(endpoint));
     if (sock < 0) {
-        LOG_ERROR("서버 연결 실패: %s:%d - %s", host, port, strerror(errno));
+        LOG_ERROR("서버 연결 실패: %s - %s", endpoint, strerror(errno));
         return -1;
     }
 
-    LOG_INFO("대상 서버 연결 성공: %s:%d", host, port);
+    LOG_INFO("대상 서버 연결 성공: %s", endpoint);
     return sock;
 }
 
-void proxy_handle_connection(Connection *conn) {
-    fd_set read_fds;
-    char buffer[BUFFER_SIZE];
-    int max_fd = (conn->client_fd > conn->server_fd) ?
-                  conn->client_fd : conn->server_fd;
+// 필터 효과 카운터를 공유 테이블로 반영 (청크마다가 아니라 EWMA 갱신 주기마다)
+static void flush_filter_counters(Connection *conn) {
+    control_filter_account(&conn->filters[0].chain, FILTER_DIR_C2S, conn->filters[0].counters);
+    control_filter_account(&conn->filters[1].chain, FILTER_DIR_S2C, conn->filters[1].counters);
+    if (conn->mysql) {
+        control_query_account(&conn->mysql->stats);
+    }
+    if (conn->http) {
+        control_query_account(&conn->http->stats);
+    }
+}
 
-    LOG_INFO("프록시 시작: 클라이언트[%s:%d] <-> 서버[%s:%d]",
-             conn->client_addr, conn->client_port,
-             conn->target_addr, conn->target_port);
+// 방향별 중계 상태 (필터가 보류시킨 청크와 순서 바꾸기로 미룬 청크)
+// 보류 중인 방향은 입력을 읽지 않으므로 청크는 수신 버퍼에 그대로 둔다.
+typedef struct {
+    // 앞 여유 공간은 수정 필터 보류 바이트용, 뒤 여유 공간은 보류 청크에 덧붙이는 용도
+    char buffer[FILTER_HEADROOM + BUFFER_SIZE + FILTER_HEADROOM];
+    char *pending;                // 보류 중인 청크 (NULL = 없음)
+    int pending_len;
+    uint64_t pending_until_us;    // 전송 시각 (FILTER_HOLD_FOREVER = 연결이 끝날 때까지)
+    FilterPlan pending_plan;
+    char swapped[FILTER_HEADROOM + BUFFER_SIZE + FILTER_HEADROOM];
+    int swapped_len;              // 순서 바꾸기로 미룬 청크 (0 = 없음)
+    uint64_t swapped_until_us;    // 다음 청크가 오지 않으면 그대로 보낼 시각
+    FilterPlan swapped_plan;
+    uint64_t last_recv_us;        // 마지막 수신 또는 보류 후 입력 재개 (수정 필터 보류 바이트 기준)
+    bool nodelay;                 // 출력 소켓에 TCP_NODELAY를 설정함
+    bool closed;                  // 출력을 반쪽 닫음 (이후 입력은 읽어서 버림)
+    int pipe_fds[2];              // 제로 카피 중계용 파이프 (-1 = 아직 만들지 않음)
+    bool splice_off;              // 커널이 이 소켓 쌍의 splice를 지원하지 않아 복사로 중계
+} RelayDir;
 
-    stats_init(&conn->stats);
+// 중계 루프가 끝나는 이유
+typedef enum {
+    RELAY_CONTINUE = 0,
+    RELAY_CLOSE,                  // 정상 종료 (EOF, 오류, 반쪽 닫기 유지 시간 만료)
+    RELAY_RESET                   // 리셋 필터: RST로 끊음
+} RelayResult;
 
-    // 연결 정보 등록
-    control_register_connection(conn);
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 
-    while (1) {
-        FD_ZERO(&read_fds);
-        FD_SET(conn->client_fd, &read_fds);
-        FD_SET(conn->server_fd, &read_fds);
+// 방향의 입력/출력 소켓
+static int relay_in_fd(const Connection *conn, uint8_t dir) {
+    return (dir == FLIGHT_DIR_C2S) ? conn->client_fd : conn->server_fd;
+}
 
-        struct timeval timeout = {SELECT_TIMEOUT_SEC, 0};
-        int activity = select(max_fd + 1, &read_fds, NULL, NULL, &timeout);
+static int relay_out_fd(const Connection *conn, uint8_t dir) {
+    return (dir == FLIGHT_DIR_C2S) ? conn->server_fd : conn->client_fd;
+}
 
-        if (activity < 0) {
-            if (errno == EINTR) {
-                continue;  // 시그널 인터럽트, 재시도
-            }
-            LOG_ERROR("select 에러: %s", strerror(errno));
-            break;
+// 보낸 바이트 기록 (쓰기마다: 캡처 중이면 링에 복사, 서버로 보낸 바이트는 섀도에도)
+static void account_bytes(Connection *conn, uint8_t dir, const char *data, ssize_t sent) {
+    flight_record(conn->flight, FLIGHT_SEND, dir, (uint32_t)sent);
+    capture_data(conn->capture, dir, data, (size_t)sent);
+    if (dir == FLIGHT_DIR_C2S) {
+        mirror_data(conn->mirror, data, (size_t)sent);
+    }
+    PROBE3(relay_send, conn->conn_id, dir, sent);
+    if (dir == FLIGHT_DIR_C2S) {
+        conn->stats.client_to_server_bytes += sent;
+        conn->stats.client_to_server_packets++;
+    } else {
+        conn->stats.server_to_client_bytes += sent;
+        conn->stats.server_to_client_packets++;
+    }
+}
+
+// 통계 갱신 (TCP_INFO 샘플, 처리량, 공유 메모리 반영은 제어 뮤텍스를 잡으므로 청크당 한 번)
+static void account_flush(Connection *conn) {
+    stats_sample_tcp(conn, conn->stats.last_activity);
+    if (stats_update_rates(&conn->stats)) {
+        flush_filter_counters(conn);
+    }
+
+    // 통계 업데이트
+    control_update_stats(conn);
+}
+
+// 전송 완료 기록 및 통계 갱신 (한 번에 보낸 청크)
+static void account_sent(Connection *conn, uint8_t dir, const char *data, ssize_t sent) {
+    account_bytes(conn, dir, data, sent);
+    account_flush(conn);
+}
+
+// 전송 방법(분할/복제)에 따라 청크 전송
+static bool send_chunk(Connection *conn, RelayDir *rd, uint8_t dir,
+                       const char *data, int length, const FilterPlan *plan) {
+    int fd = relay_out_fd(conn, dir);
+    int step = length;
+
+    if (plan->fragment > 0) {
+        // 작은 쓰기가 합쳐지지 않고 각각 세그먼트로 나가도록
+        if (!rd->nodelay) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            rd->nodelay = true;
         }
+        step = plan->fragment;
+    }
 
-        if (activity == 0) {
-            LOG_WARN("타임아웃 (%d초 동안 활동 없음)", SELECT_TIMEOUT_SEC);
-            break;
+    for (int copy = 0; copy < plan->copies; copy++) {
+        for (int offset = 0; offset < length; offset += step) {
+            int n = (length - offset < step) ? length - offset : step;
+            ssize_t sent = send_all(fd, data + offset, n, conn->flight, dir);
+            if (sent < 0) {
+                LOG_ERROR("%s 전송 실패: %s", dir == FLIGHT_DIR_C2S ? "서버" : "클라이언트",
+                          strerror(errno));
+                account_flush(conn);
+                return false;
+            }
+            account_bytes(conn, dir, data + offset, sent);
         }
+    }
+    account_flush(conn);
 
-        // 클라이언트 → 서버
-        if (FD_ISSET(conn->client_fd, &read_fds)) {
-            ssize_t bytes = recv(conn->client_fd, buffer, BUFFER_SIZE, 0);
+    // 쿼리 마지막 청크를 보냈으면 여기부터 서버 응답 시간
+    if (conn->mysql && dir == FLIGHT_DIR_C2S) {
+        mysql_client_sent(conn->mysql, monotonic_us());
+    }
+    if (conn->http && dir == FLIGHT_DIR_C2S) {
+        http_client_sent(conn->http, monotonic_us());
+    }
+    return true;
+}
 
-            if (bytes <= 0) {
-                if (bytes == 0) {
-                    LOG_INFO("클라이언트 연결 종료");
-                } else {
-                    LOG_ERROR("클라이언트 수신 실패: %s", strerror(errno));
-                }
-                break;
+// 보류가 끝난 청크 전달 (순서 바꾸기: 첫 청크는 미루고, 다음 청크를 보낸 뒤 이어 보냄)
+static bool deliver_chunk(Connection *conn, RelayDir *rd, uint8_t dir,
+                          const char *data, int length, const FilterPlan *plan) {
+    if (plan->reorder && rd->swapped_len == 0) {
+        memcpy(rd->swapped, data, length);
+        rd->swapped_len = length;
+        rd->swapped_plan = *plan;
+        rd->swapped_plan.reorder = false;
+        rd->swapped_until_us = monotonic_us() + REORDER_WAIT_MS * 1000;
+        return true;
+    }
+
+    if (!send_chunk(conn, rd, dir, data, length, plan)) {
+        return false;
+    }
+
+    if (rd->swapped_len > 0) {
+        int swapped_len = rd->swapped_len;
+        rd->swapped_len = 0;
+        return send_chunk(conn, rd, dir, rd->swapped, swapped_len, &rd->swapped_plan);
+    }
+    return true;
+}
+
+// 수정 필터가 보류한 바이트를 그대로 내보냄 (패턴이 완성되지 않은 채 입력이 멈췄을 때)
+// 보류 청크가 있으면 그 뒤에 덧붙여 스트림 순서를 지킨다.
+static bool flush_held_bytes(Connection *conn, RelayDir *relay, uint8_t dir) {
+    RelayDir *rd = &relay[dir - 1];
+    char held[FILTER_HEADROOM];
+    int length = filter_path_flush(&conn->filters[dir - 1], held);
+    if (length == 0 || rd->closed) {
+        return true;
+    }
+
+    if (rd->pending != NULL) {
+        memcpy(rd->pending + rd->pending_len, held, length);
+        rd->pending_len += length;
+        return true;
+    }
+
+    FilterPlan plan = {.copies = 1};
+    return deliver_chunk(conn, rd, dir, held, length, &plan);
+}
+
+// 런타임 필터 변경 반영 (세대가 같으면 atomic load 한 번, 바뀌었을 때만 다시 컴파일)
+static void sync_filters(Connection *conn, RelayDir *relay) {
+    FilterChain table;
+    if (control_filter_sync(&table, &conn->filter_generation)) {
+        flush_filter_counters(conn);
+        flush_held_bytes(conn, relay, FLIGHT_DIR_C2S);
+        flush_held_bytes(conn, relay, FLIGHT_DIR_S2C);
+        filter_path_compile(&table, conn, FILTER_DIR_C2S, &conn->filters[0]);
+        filter_path_compile(&table, conn, FILTER_DIR_S2C, &conn->filters[1]);
+        LOG_INFO("필터 테이블 갱신 적용 (세대 %u, 이 연결에 C→S %d개, S→C %d개)",
+                 conn->filter_generation, conn->filters[0].chain.count,
+                 conn->filters[1].chain.count);
+    }
+}
+
+// 필터 적용 (방향별 경로, 결정과 소요 시간을 플라이트 레코더에 기록)
+static FilterVerdict apply_filters(Connection *conn, char **data, int *length, uint8_t dir,
+                                   FilterPlan *plan) {
+    // 플라이트 레코더 방향(FLIGHT_DIR_C2S/S2C)은 필터 방향 플래그와 같은 값
+    FilterPath *path = &conn->filters[dir - 1];
+    if (path->chain.count == 0) {
+        memset(plan, 0, sizeof(FilterPlan));
+        plan->copies = 1;
+        return VERDICT_PASS;
+    }
+
+    uint64_t start = flight_now();
+    FilterVerdict verdict = filter_apply(path, data, length, &conn->stats, plan);
+    uint64_t elapsed = flight_now() - start;
+
+    flight_record(conn->flight, verdict == VERDICT_PASS ? FLIGHT_FILTER_PASS : FLIGHT_FILTER_DROP,
+                  dir, elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed);
+    return verdict;
+}
+
+// 양쪽 소켓을 SO_LINGER 0으로 만들어 close()가 FIN 대신 RST를 보내게 함
+static void reset_connection(Connection *conn, const char *reason) {
+    struct linger lg = {1, 0};
+    setsockopt(conn->client_fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    setsockopt(conn->server_fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    flight_record(conn->flight, FLIGHT_RESET, FLIGHT_DIR_NONE, 0);
+    LOG_WARN("%s: 양쪽 연결을 RST로 끊음", reason);
+}
+
+// 마감이 지난 보류 청크/미룬 청크/보류 바이트를 내보내고 예약된 리셋·종료 확인
+// *wait_us에는 다음 마감까지의 시간 (없으면 -1)
+static RelayResult relay_run_timers(Connection *conn, RelayDir *relay, uint64_t close_at_us,
+                                    int64_t *wait_us) {
+    uint64_t now = monotonic_us();
+    uint64_t next = UINT64_MAX;
+
+    for (uint8_t dir = FLIGHT_DIR_C2S; dir <= FLIGHT_DIR_S2C; dir++) {
+        RelayDir *rd = &relay[dir - 1];
+        FilterPath *path = &conn->filters[dir - 1];
+
+        if (path->reset_at_ms != 0) {
+            uint64_t now_ms = monotonic_ms();
+            if (now_ms >= path->reset_at_ms) {
+                return RELAY_RESET;
             }
+            uint64_t at = now + (path->reset_at_ms - now_ms) * 1000;
+            if (at < next) next = at;
+        }
 
-            conn->stats.last_activity = time(NULL);
-            LOG_DEBUG("클라이언트 → 서버: %zd bytes", bytes);
+        if (rd->pending != NULL) {
+            if (now >= rd->pending_until_us) {
+                char *data = rd->pending;
+                rd->pending = NULL;
+                rd->last_recv_us = now;  // 입력을 다시 읽기 시작하므로 보류 바이트 시한도 여기부터
+                if (!deliver_chunk(conn, rd, dir, data, rd->pending_len, &rd->pending_plan)) {
+                    return RELAY_CLOSE;
+                }
+            } else {
+                if (rd->pending_until_us < next) next = rd->pending_until_us;
+                continue;  // 보류 청크가 나가기 전에는 뒤의 데이터를 보내지 않음
+            }
+        }
 
-            // 필터 적용
-            if (!filter_apply(&conn->filter_chain, buffer, bytes, &conn->stats)) {
-                LOG_WARN("패킷 필터링됨 (드롭)");
-                conn->stats.client_to_server_dropped++;
-                continue;
+        if (rd->swapped_len > 0) {
+            if (now >= rd->swapped_until_us) {
+                int swapped_len = rd->swapped_len;
+                rd->swapped_len = 0;
+                if (!send_chunk(conn, rd, dir, rd->swapped, swapped_len, &rd->swapped_plan)) {
+                    return RELAY_CLOSE;
+                }
+            } else if (rd->swapped_until_us < next) {
+                next = rd->swapped_until_us;
             }
+        }
 
-            // 모든 데이터 전송
-            ssize_t sent = send_all(conn->server_fd, buffer, bytes);
-            if (sent < 0) {
-                LOG_ERROR("서버 전송 실패: %s", strerror(errno));
-                break;
+        // 입력이 MODIFY_FLUSH_MS 동안 멈춘 방향의 보류 바이트
+        if (filter_path_pending(path) > 0) {
+            uint64_t deadline = rd->last_recv_us + MODIFY_FLUSH_MS * 1000;
+            if (now >= deadline) {
+                if (!flush_held_bytes(conn, relay, dir)) {
+                    return RELAY_CLOSE;
+                }
+            } else if (deadline < next) {
+                next = deadline;
             }
+        }
+    }
+
+    if (close_at_us != 0) {
+        if (now >= close_at_us) {
+            LOG_INFO("반쪽 닫기 유지 시간 만료, 연결 종료");
+            return RELAY_CLOSE;
+        }
+        if (close_at_us < next) next = close_at_us;
+    }
 
-            conn->stats.client_to_server_bytes += sent;
-            conn->stats.client_to_server_packets++;
+    *wait_us = (next == UINT64_MAX) ? -1 : (int64_t)(next - now);
+    return RELAY_CONTINUE;
+}
 
-            // 통계 업데이트
-            control_update_stats(conn->pid, &conn->stats);
+// 사용자 공간을 거치지 않고 중계할 수 있는 방향인지
+// (이 연결에 적용할 필터와 보류 바이트가 없고, 바이트를 들여다볼 프로토콜 모드/캡처/미러링도 없을 때)
+static bool relay_can_splice(const Connection *conn, const RelayDir *rd, uint8_t dir) {
+    const FilterPath *path = &conn->filters[dir - 1];
+    return !rd->splice_off && !rd->closed && rd->swapped_len == 0 &&
+           path->chain.count == 0 && filter_path_pending(path) == 0 &&
+           conn->mysql == NULL && conn->http == NULL && conn->capture == NULL &&
+           (dir != FLIGHT_DIR_C2S || conn->mirror == NULL);
+}
+
+// 제로 카피 중계: 입력 소켓 → 파이프 → 출력 소켓을 splice로 옮김 (페이지를 넘길 뿐 복사하지 않음)
+// 커널이 이 소켓 종류의 splice를 지원하지 않으면 false를 돌려주고 이 방향은 이후 복사로 중계한다.
+static bool relay_splice(Connection *conn, RelayDir *rd, uint8_t dir, RelayResult *result) {
+    const char *from = (dir == FLIGHT_DIR_C2S) ? "클라이언트" : "서버";
+    const char *to = (dir == FLIGHT_DIR_C2S) ? "서버" : "클라이언트";
+
+    if (rd->pipe_fds[0] < 0) {
+        if (pipe2(rd->pipe_fds, O_CLOEXEC) < 0) {
+            LOG_DEBUG("splice 파이프 생성 실패, 복사로 중계: %s", strerror(errno));
+            rd->splice_off = true;
+            return false;
         }
+        fcntl(rd->pipe_fds[1], F_SETPIPE_SZ, SPLICE_PIPE_SIZE);  // 실패하면 기본 크기 (64 KB)
+    }
 
-        // 서버 → 클라이언트
-        if (FD_ISSET(conn->server_fd, &read_fds)) {
-            ssize_t bytes = recv(conn->server_fd, buffer, BUFFER_SIZE, 0);
-
-            if (bytes <= 0) {
-                if (bytes == 0) {
-                    LOG_INFO("서버 연결 종료");
-                } else {
-                    LOG_ERROR("서버 수신 실패: %s", strerror(errno));
+    ssize_t bytes = splice(relay_in_fd(conn, dir), NULL, rd->pipe_fds[1], NULL, SPLICE_PIPE_SIZE,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (bytes < 0) {
+        if (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP) {
+            LOG_DEBUG("%s 소켓 splice 미지원, 복사로 중계: %s", from, strerror(errno));
+            rd->splice_off = true;
+            return false;
+        }
+        if (errno == EAGAIN || errno == EINTR) {
+            *result = RELAY_CONTINUE;
+            return true;
+        }
+        LOG_ERROR("%s 수신 실패: %s", from, strerror(errno));
+        *result = RELAY_CLOSE;
+        return true;
+    }
+    if (bytes == 0) {
+        LOG_INFO("%s 연결 종료", from);
+        *result = RELAY_CLOSE;
+        return true;
+    }
+
+    conn->stats.last_activity = time(NULL);
+    LOG_DEBUG("%s: %zd bytes (splice)", dir == FLIGHT_DIR_C2S ? "클라이언트 → 서버" : "서버 → 클라이언트",
+              bytes);
+    flight_record(conn->flight, FLIGHT_RECV, dir, (uint32_t)bytes);
+    PROBE3(relay_recv, conn->conn_id, dir, bytes);
+    rd->last_recv_us = monotonic_us();
+
+    // 출력 소켓은 블로킹이므로 파이프가 빌 때까지 보냄
+    int out = relay_out_fd(conn, dir);
+    ssize_t left = bytes;
+    while (left > 0) {
+        ssize_t sent = splice(rd->pipe_fds[0], NULL, out, NULL, left, SPLICE_F_MOVE);
+        if (sent > 0) {
+            left -= sent;
+            continue;
+        }
+        if (sent < 0 && (errno == EINTR || errno == EAGAIN)) {
+            flight_record(conn->flight, FLIGHT_EAGAIN, dir, errno);
+            continue;
+        }
+        if (sent < 0 && (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+            // 출력 쪽이 splice를 받지 않음: 파이프에 든 바이트는 읽어서 보통 송신으로
+            LOG_DEBUG("%s 소켓 splice 미지원, 복사로 중계: %s", to, strerror(errno));
+            rd->splice_off = true;
+            while (left > 0) {
+                char *buf = rd->buffer + FILTER_HEADROOM;
+                ssize_t n = read(rd->pipe_fds[0], buf, left < BUFFER_SIZE ? left : BUFFER_SIZE);
+                if (n <= 0 || send_all(out, buf, n, conn->flight, dir) < 0) {
+                    break;
                 }
+                left -= n;
+            }
+            if (left == 0) {
                 break;
             }
+        }
+        LOG_ERROR("%s 전송 실패: %s", to, strerror(errno));
+        *result = RELAY_CLOSE;
+        return true;
+    }
 
-            conn->stats.last_activity = time(NULL);
-            LOG_DEBUG("서버 → 클라이언트: %zd bytes", bytes);
+    account_sent(conn, dir, NULL, bytes);
+    *result = RELAY_CONTINUE;
+    return true;
+}
+
+// 한 방향의 청크 수신 및 필터 판정
+static RelayResult relay_receive(Connection *conn, RelayDir *relay, uint8_t dir,
+                                 uint64_t *close_at_us) {
+    RelayDir *rd = &relay[dir - 1];
+
+    // 적용할 것이 없는 방향은 커널 안에서 옮김 (필터가 새로 생기면 다음 청크부터 복사 경로)
+    sync_filters(conn, relay);
+    RelayResult result;
+    if (relay_can_splice(conn, rd, dir) && relay_splice(conn, rd, dir, &result)) {
+        return result;
+    }
+
+    const char *from = (dir == FLIGHT_DIR_C2S) ? "클라이언트" : "서버";
+    int want = BUFFER_SIZE;
+    if (conn->http) {
+        // 본문 끝에서 끊어 다음 요청/응답이 새 청크에서 시작하도록 (메시지 단위 필터)
+        int limit = http_recv_limit(conn->http, dir);
+        if (limit > 0) want = limit;
+    }
+    ssize_t bytes = recv(relay_in_fd(conn, dir), rd->buffer + FILTER_HEADROOM, want, 0);
 
-            // 필터 적용
-            if (!filter_apply(&conn->filter_chain, buffer, bytes, &conn->stats)) {
-                LOG_WARN("패킷 필터링됨 (드롭)");
+    if (bytes <= 0) {
+        if (bytes == 0) {
+            LOG_INFO("%s 연결 종료", from);
+        } else {
+            LOG_ERROR("%s 수신 실패: %s", from, strerror(errno));
+        }
+        return RELAY_CLOSE;
+    }
+
+    conn->stats.last_activity = time(NULL);
+    LOG_DEBUG("%s: %zd bytes", dir == FLIGHT_DIR_C2S ? "클라이언트 → 서버" : "서버 → 클라이언트",
+              bytes);
+    flight_record(conn->flight, FLIGHT_RECV, dir, (uint32_t)bytes);
+    PROBE3(relay_recv, conn->conn_id, dir, bytes);
+    rd->last_recv_us = monotonic_us();
+
+    if (rd->closed) {
+        return RELAY_CONTINUE;  // 반쪽 닫은 방향: 상대는 살려 두고 입력만 버림
+    }
+
+    char *data = rd->buffer + FILTER_HEADROOM;
+    int length = (int)bytes;
+
+    // MySQL 모드: 패킷/명령 경계 해석 (쿼리가 시작하는 청크면 필터 트리거가 쿼리 단위로 동작)
+    if (conn->mysql) {
+        FilterPath *path = &conn->filters[dir - 1];
+        path->query = NULL;
+        path->reply_type = 0;
+        if (dir == FLIGHT_DIR_C2S) {
+            int skip = mysql_client_data(conn->mysql, data, length, &path->query, &path->query_len);
+            data += skip;  // 오류를 주입한 쿼리의 나머지
+            length -= skip;
+            if (length == 0) {
+                return RELAY_CONTINUE;
+            }
+            if (path->query != NULL) {
+                path->reply_type = FILTER_MYSQL_ERROR;
+            }
+        } else {
+            int64_t latency_us = mysql_server_data(conn->mysql, data, length, rd->last_recv_us);
+            if (latency_us >= 0) {
+                flight_record(conn->flight, FLIGHT_QUERY, dir,
+                              latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us);
+            }
+        }
+    }
+
+    // HTTP 모드: 요청/응답 경계 해석 (지연/드롭은 메시지가 시작하는 청크에서 메시지 단위로)
+    if (conn->http) {
+        FilterPath *path = &conn->filters[dir - 1];
+        HttpScan scan;
+        int skip;
+        if (dir == FLIGHT_DIR_C2S) {
+            skip = http_client_data(conn->http, data, length, &scan);
+        } else {
+            int64_t latency_us;
+            skip = http_server_data(conn->http, data, length, rd->last_recv_us, &scan, &latency_us);
+            if (latency_us >= 0) {
+                flight_record(conn->flight, FLIGHT_QUERY, dir,
+                              latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us);
+            }
+        }
+        data += skip;  // 드롭/오류 주입한 메시지의 나머지
+        length -= skip;
+        if (length == 0) {
+            return RELAY_CONTINUE;
+        }
+        path->per_message = !conn->http->passthrough;
+        path->message_start = scan.start >= skip;
+        path->query = scan.line;
+        path->query_len = scan.line_len;
+        // 받은 응답이 아직 보류 중이면(지연/쓰로틀/순서 바꾸기/수정 보류) 주입한 오류가 앞지르므로 안 됨
+        bool s2c_held = relay[1].pending != NULL || relay[1].swapped_len > 0 ||
+                        filter_path_pending(&conn->filters[1]) > 0;
+        path->reply_type = scan.can_reply && !s2c_held ? FILTER_HTTP_ERROR : 0;
+    }
+
+    // 필터 적용
+    FilterPlan plan;
+    FilterVerdict verdict = apply_filters(conn, &data, &length, dir, &plan);
+
+    switch (verdict) {
+        case VERDICT_DROP:
+            LOG_WARN("패킷 필터링됨 (드롭)");
+            if (conn->http) {
+                http_drop_message(conn->http, dir);  // 메시지의 나머지도 버림
+            }
+            if (dir == FLIGHT_DIR_C2S) {
+                conn->stats.client_to_server_dropped++;
+            } else {
                 conn->stats.server_to_client_dropped++;
-                continue;
             }
+            control_update_stats(conn);
+            return RELAY_CONTINUE;
 
-            // 모든 데이터 전송
-            ssize_t sent = send_all(conn->client_fd, buffer, bytes);
+        case VERDICT_RESET:
+            return RELAY_RESET;
+
+        case VERDICT_ERROR: {
+            // 쿼리(요청)를 서버로 보내지 않고 클라이언트에 오류로 응답
+            char reply[HTTP_ERROR_RESPONSE_MAX * HTTP_PIPELINE_MAX];
+            int reply_len = conn->http ?
+                            http_inject_error(conn->http, plan.error_code, reply) :
+                            mysql_inject_error(conn->mysql, plan.error_code, (uint8_t *)reply);
+            flight_record(conn->flight, FLIGHT_QUERY_ERROR, dir, (uint32_t)plan.error_code);
+            ssize_t sent = send_all(conn->client_fd, reply, reply_len,
+                                    conn->flight, FLIGHT_DIR_S2C);
             if (sent < 0) {
                 LOG_ERROR("클라이언트 전송 실패: %s", strerror(errno));
+                return RELAY_CLOSE;
+            }
+            account_sent(conn, FLIGHT_DIR_S2C, reply, sent);
+            return RELAY_CONTINUE;
+        }
+
+        case VERDICT_HALF_CLOSE: {
+            // 이 청크 앞의 보류 바이트와 미뤄 둔 청크까지는 보내고 FIN
+            if (!flush_held_bytes(conn, relay, dir)) {
+                return RELAY_CLOSE;
+            }
+            if (rd->swapped_len > 0) {
+                int swapped_len = rd->swapped_len;
+                rd->swapped_len = 0;
+                if (!send_chunk(conn, rd, dir, rd->swapped, swapped_len, &rd->swapped_plan)) {
+                    return RELAY_CLOSE;
+                }
+            }
+            shutdown(relay_out_fd(conn, dir), SHUT_WR);
+            rd->closed = true;
+            flight_record(conn->flight, FLIGHT_HALF_CLOSE, dir, (uint32_t)plan.hold_ms);
+            if (plan.hold_ms > 0) {
+                *close_at_us = monotonic_us() + (uint64_t)plan.hold_ms * 1000;
+            }
+            return RELAY_CONTINUE;
+        }
+
+        case VERDICT_PASS:
+            break;
+    }
+
+    if (length == 0) {
+        return RELAY_CONTINUE;  // 수정 필터가 패턴 접두사로 보류 중
+    }
+
+    // 지연/쓰로틀/정지: 잠들지 않고 마감 시각까지 보류 (그동안 이 방향 입력은 읽지 않음)
+    if (plan.hold_us > 0) {
+        rd->pending = data;
+        rd->pending_len = length;
+        rd->pending_plan = plan;
+        rd->pending_until_us = (plan.hold_us == FILTER_HOLD_FOREVER) ?
+                               FILTER_HOLD_FOREVER : rd->last_recv_us + plan.hold_us;
+        return RELAY_CONTINUE;
+    }
+
+    return deliver_chunk(conn, rd, dir, data, length, &plan) ? RELAY_CONTINUE : RELAY_CLOSE;
+}
+
+// 관리 명령의 종료 요청 (자식 프로세스 전용)
+// SIGTERM/SIGINT는 평소 막아 두고 pselect 대기 중에만 받으므로 검사와 대기 사이의 경쟁이 없다.
+static volatile sig_atomic_t g_terminate = 0;
+static sigset_t g_wait_mask;              // pselect 대기 중 마스크 (종료 시그널 허용)
+
+static void child_term_handler(int signum) {
+    (void)signum;
+    g_terminate = 1;
+}
+
+// fork 직후 자식의 시그널 설정 (부모의 핸들러는 프로세스 그룹 전체를 종료하므로 교체)
+static void child_signals_init(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = child_term_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+
+    sigset_t block;
+    sigemptyset(&block);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGINT);
+    sigprocmask(SIG_BLOCK, &block, &g_wait_mask);
+    sigdelset(&g_wait_mask, SIGTERM);
+    sigdelset(&g_wait_mask, SIGINT);
+}
+
+// 보류 청크를 받을 상대가 이미 닫혔는지 (RST를 받았거나 양방향이 모두 끊김)
+static bool relay_peer_gone(int fd) {
+    struct pollfd pfd = {.fd = fd, .events = POLLOUT};
+    return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR)) != 0;
+}
+
+// 종료 전 남은 보류 청크를 마감에 맞춰 전달
+// 잠들지 않고 pselect로 기다려 종료 시그널을 계속 받고, 최대 RELAY_DRAIN_MAX_MS까지만 기다린다.
+// 무제한 정지 청크, 그 안에 마감이 오지 않는 청크, 상대가 닫힌 방향의 청크는 버림.
+static void relay_drain(Connection *conn, RelayDir *relay) {
+    uint64_t limit_us = monotonic_us() + RELAY_DRAIN_MAX_MS * 1000ULL;
+    g_terminate = 0;  // 종료 요청으로 여기까지 왔어도 기다리는 중 다시 받으면 바로 끝냄
+
+    for (;;) {
+        uint64_t now = monotonic_us();
+        uint64_t next = UINT64_MAX;
+
+        for (uint8_t dir = FLIGHT_DIR_C2S; dir <= FLIGHT_DIR_S2C; dir++) {
+            RelayDir *rd = &relay[dir - 1];
+            if (rd->pending == NULL) {
+                continue;
+            }
+            if (rd->pending_until_us == FILTER_HOLD_FOREVER || rd->pending_until_us > limit_us ||
+                g_terminate || relay_peer_gone(relay_out_fd(conn, dir))) {
+                LOG_WARN("종료 시 보류 청크 버림: %d bytes (%s)", rd->pending_len,
+                         dir == FLIGHT_DIR_C2S ? "클라이언트 → 서버" : "서버 → 클라이언트");
+                rd->pending = NULL;
+                rd->swapped_len = 0;  // 보류 청크 뒤의 데이터만 보내면 스트림이 어긋남
+                filter_path_flush(&conn->filters[dir - 1], rd->buffer);
+                continue;
+            }
+            if (now >= rd->pending_until_us) {
+                char *data = rd->pending;
+                rd->pending = NULL;
+                if (!deliver_chunk(conn, rd, dir, data, rd->pending_len, &rd->pending_plan)) {
+                    rd->swapped_len = 0;
+                    rd->closed = true;  // 보류 바이트도 보내지 않음
+                }
+            } else if (rd->pending_until_us < next) {
+                next = rd->pending_until_us;
+            }
+        }
+
+        if (next == UINT64_MAX) {
+            break;
+        }
+        uint64_t wait_us = next - now;
+        struct timespec timeout = {(time_t)(wait_us / 1000000), (long)(wait_us % 1000000) * 1000};
+        pselect(0, NULL, NULL, NULL, &timeout, &g_wait_mask);
+    }
+
+    for (uint8_t dir = FLIGHT_DIR_C2S; dir <= FLIGHT_DIR_S2C; dir++) {
+        RelayDir *rd = &relay[dir - 1];
+        if (rd->swapped_len > 0) {
+            send_chunk(conn, rd, dir, rd->swapped, rd->swapped_len, &rd->swapped_plan);
+            rd->swapped_len = 0;
+        }
+        // 보류 바이트는 상대가 아직 읽을 수 있으면 전달
+        flush_held_bytes(conn, relay, dir);
+    }
+}
+
+// ClientHello의 SNI로 대상을 골라 연결 (자식 프로세스, SNI 라우팅 규칙이 있을 때)
+// 엿본 ClientHello는 클라이언트 소켓에 남아 중계 루프가 그대로 서버로 보낸다.
+static int connect_by_sni(const ListenerConfig *listener, Connection *conn) {
+    int found = tls_peek_sni(conn->client_fd, TLS_PEEK_TIMEOUT_MS, conn->sni, sizeof(conn->sni));
+    if (found < 0) {
+        LOG_INFO("ClientHello 전에 클라이언트가 연결을 닫음: %s:%d",
+                 conn->client_addr, conn->client_port);
+        return -1;
+    }
+
+    const SniRoute *route = tls_route_match(listener->sni_routes, listener->sni_route_count, conn->sni);
+    const char *host = route ? route->host : listener->target_host;
+    int port = route ? route->port : listener->target_port;
+
+    char endpoint[MAX_HOST_LEN + 16];
+    config_format_endpoint(host, port, endpoint, sizeof(endpoint));
+    if (route) {
+        LOG_INFO("SNI 라우팅: %s -> %s (규칙 %s)", conn->sni, endpoint, route->pattern);
+    } else {
+        LOG_INFO("SNI 라우팅: %s -> 기본 대상 %s",
+                 conn->sni[0] ? conn->sni : "(SNI 없음)", endpoint);
+    }
+
+    snprintf(conn->target_addr, sizeof(conn->target_addr), "%s", host);
+    conn->target_port = port;
+
+    int server_sock = proxy_connect_target(host, port);
+    PROBE4(connect_done, conn->conn_id, host, port, server_sock);
+    if (server_sock < 0) {
+        LOG_ERROR("대상 서버 연결 실패");
+        control_record_connect_error(conn->listener);
+    }
+    return server_sock;
+}
+
+void proxy_handle_connection(Connection *conn) {
+    fd_set read_fds, write_fds;
+    RelayDir relay[FILTER_DIR_COUNT];
+    uint64_t close_at_us = 0;
+    RelayResult result = RELAY_CONTINUE;
+    bool terminate_requested = false;
+
+    for (int i = 0; i < FILTER_DIR_COUNT; i++) {
+        relay[i].pending = NULL;
+        relay[i].swapped_len = 0;
+        relay[i].last_recv_us = 0;
+        relay[i].nodelay = false;
+        relay[i].closed = false;
+        relay[i].pipe_fds[0] = relay[i].pipe_fds[1] = -1;
+        relay[i].splice_off = false;
+    }
+
+    LOG_INFO("프록시 시작: 클라이언트[%s:%d] <-> 서버[%s:%d]",
+             conn->client_addr, conn->client_port,
+             conn->target_addr, conn->target_port);
+
+    stats_init(&conn->stats);
+    stats_sample_tcp(conn, conn->stats.start_time);
+
+    conn->flight = flight_open(conn->pid, conn->conn_id);
+    flight_record(conn->flight, FLIGHT_OPEN, FLIGHT_DIR_NONE, 0);
+    conn->capture = capture_open(conn);
+    conn->mirror = mirror_open(conn);
+
+    // 연결 정보 등록
+    control_register_connection(conn);
+
+    while (result == RELAY_CONTINUE) {
+        // 관리 명령 종료: 일괄 종료가 RST를 요청했으면 리셋, 아니면 남은 데이터를 보내고 FIN
+        if (g_terminate) {
+            terminate_requested = true;
+            result = control_abort_requested(conn->pid) ? RELAY_RESET : RELAY_CLOSE;
+            LOG_INFO("관리 명령으로 연결 종료 (%s)", result == RELAY_RESET ? "RST" : "FIN");
+            break;
+        }
+
+        // 마감이 지난 보류 청크 전송, 예약된 리셋/종료 처리
+        int64_t wait_us;
+        result = relay_run_timers(conn, relay, close_at_us, &wait_us);
+        if (result != RELAY_CONTINUE) {
+            break;
+        }
+
+        // 보류 청크가 있는 방향은 입력을 읽지 않음 (수신 버퍼를 쓰고 있고, 순서도 지켜야 함)
+        FD_ZERO(&read_fds);
+        FD_ZERO(&write_fds);
+        if (relay[0].pending == NULL) FD_SET(conn->client_fd, &read_fds);
+        if (relay[1].pending == NULL) FD_SET(conn->server_fd, &read_fds);
+        int max_fd = (conn->client_fd > conn->server_fd) ? conn->client_fd : conn->server_fd;
+
+        // 섀도 소켓: 응답은 늘 읽어 버리고, 큐가 남았거나 연결 중이면 쓰기도 기다림
+        int mirror_sock = mirror_fd(conn->mirror);
+        if (mirror_sock >= 0) {
+            FD_SET(mirror_sock, &read_fds);
+            if (mirror_wants_write(conn->mirror)) FD_SET(mirror_sock, &write_fds);
+            if (mirror_sock > max_fd) max_fd = mirror_sock;
+        }
+
+        // 샘플링 주기마다 깨어나 유휴 연결도 TCP_INFO를 갱신 (보류 마감이 있으면 더 일찍)
+        struct timespec timeout = {TCP_INFO_SAMPLE_SEC, 0};
+        if (wait_us >= 0 && wait_us < TCP_INFO_SAMPLE_SEC * 1000000LL) {
+            timeout.tv_sec = 0;
+            timeout.tv_nsec = wait_us * 1000;
+        }
+        int activity = pselect(max_fd + 1, &read_fds, &write_fds, NULL, &timeout, &g_wait_mask);
+
+        if (activity < 0) {
+            if (errno == EINTR) {
+                continue;  // 시그널 인터럽트, 재시도
+            }
+            LOG_ERROR("select 에러: %s", strerror(errno));
+            break;
+        }
+
+        if (activity == 0) {
+            time_t now = time(NULL);
+            if (now - conn->stats.last_activity >= SELECT_TIMEOUT_SEC) {
+                LOG_WARN("타임아웃 (%d초 동안 활동 없음)", SELECT_TIMEOUT_SEC);
+                flight_record(conn->flight, FLIGHT_TIMEOUT, FLIGHT_DIR_NONE, 0);
                 break;
             }
+            // 유휴 연결도 처리량이 감소하도록 갱신
+            bool sampled = stats_sample_tcp(conn, now);
+            bool rated = stats_update_rates(&conn->stats);
+            if (rated || sampled) {
+                control_update_stats(conn);
+            }
+            if (rated) {
+                flush_filter_counters(conn);
+            }
+            continue;
+        }
+
+        if (mirror_sock >= 0) {
+            mirror_poll(conn->mirror, FD_ISSET(mirror_sock, &read_fds),
+                        FD_ISSET(mirror_sock, &write_fds));
+        }
 
-            conn->stats.server_to_client_bytes += sent;
-            conn->stats.server_to_client_packets++;
+        // 클라이언트 → 서버
+        if (FD_ISSET(conn->client_fd, &read_fds)) {
+            result = relay_receive(conn, relay, FLIGHT_DIR_C2S, &close_at_us);
+        }
 
-            // 통계 업데이트
-            control_update_stats(conn->pid, &conn->stats);
+        // 서버 → 클라이언트
+        if (result == RELAY_CONTINUE && FD_ISSET(conn->server_fd, &read_fds)) {
+            result = relay_receive(conn, relay, FLIGHT_DIR_S2C, &close_at_us);
+        }
+    }
+
+    if (result == RELAY_RESET) {
+        reset_connection(conn, terminate_requested ? "관리 명령" : "리셋 필터");  // 보류 데이터는 버림
+    } else {
+        relay_drain(conn, relay);
+    }
+
+    for (int i = 0; i < FILTER_DIR_COUNT; i++) {
+        if (relay[i].pipe_fds[0] >= 0) {
+            close(relay[i].pipe_fds[0]);
+            close(relay[i].pipe_fds[1]);
         }
     }
 
     stats_print(&conn->stats);
+    flush_filter_counters(conn);
+    filter_path_free(&conn->filters[0]);
+    filter_path_free(&conn->filters[1]);
+    mysql_session_free(conn->mysql);
+    http_session_free(conn->http);
+
+    capture_close(conn->capture, result == RELAY_RESET);
+    flight_record(conn->flight, FLIGHT_CLOSE, FLIGHT_DIR_NONE, 0);
+    flight_close(conn->flight);
 
     // 연결 정보 해제
-    control_unregister_connection(conn->pid);
+    control_unregister_connection(conn);
 }
 
-int proxy_start(const ProxyConfig *config, FilterChain *filter_chain) {
-    int proxy_sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (proxy_sock < 0) {
+typedef char UnixListenPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+static UnixListenPath g_unix_listen_paths[MAX_LISTENERS];  // 종료 시 지울 소켓 파일 (리스너 순서)
+
+// 유닉스 도메인 소켓 리스닝 주소 (이전 실행이 남긴 소켓 파일은 지우고, 살아 있는 소켓이면 실패)
+static int listen_unix(const char *path, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    snprintf(addr->sun_path, sizeof(addr->sun_path), "%s", path);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) {
         LOG_ERROR("소켓 생성 실패: %s", strerror(errno));
         return -1;
     }
 
-    // 주소 재사용
-    int opt = 1;
-    if (setsockopt(proxy_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        LOG_WARN("SO_REUSEADDR 설정 실패: %s", strerror(errno));
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            LOG_ERROR("리스닝 경로에 소켓이 아닌 파일이 있습니다: %s", path);
+            close(sock);
+            return -1;
+        }
+        if (connect(sock, (struct sockaddr *)addr, sizeof(*addr)) == 0) {
+            LOG_ERROR("다른 프로세스가 이미 리스닝 중입니다: %s", path);
+            close(sock);
+            return -1;
+        }
+        close(sock);
+        unlink(path);
+        sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock < 0) {
+            LOG_ERROR("소켓 생성 실패: %s", strerror(errno));
+            return -1;
+        }
+    }
+    return sock;
+}
+
+// 리스닝 주소 해석 (호스트가 비어 있으면 [::], IPv6 전용을 풀어 IPv4도 받음)
+static bool listen_address(const char *host, int port, struct sockaddr_storage *addr,
+                           socklen_t *addr_len) {
+    memset(addr, 0, sizeof(*addr));
+    if (host[0] == '\0') {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)addr;
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_addr = in6addr_any;
+        sin6->sin6_port = htons(port);
+        *addr_len = sizeof(*sin6);
+        return true;
+    }
+
+    struct addrinfo hints, *result;
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    int ret = getaddrinfo(host, port_str, &hints, &result);
+    if (ret != 0) {
+        LOG_ERROR("리스닝 주소를 찾을 수 없습니다: %s (%s)", host, gai_strerror(ret));
+        return false;
     }
+    memcpy(addr, result->ai_addr, result->ai_addrlen);
+    *addr_len = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+// 리스닝 소켓 생성 (TCP는 IPv6/IPv4 겸용 또는 지정 주소, "unix:/경로"는 유닉스 소켓)
+static int proxy_listen(const ListenerConfig *listener, int index) {
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    int sock;
 
-    struct sockaddr_in proxy_addr;
-    memset(&proxy_addr, 0, sizeof(proxy_addr));
-    proxy_addr.sin_family = AF_INET;
-    proxy_addr.sin_addr.s_addr = INADDR_ANY;
-    proxy_addr.sin_port = htons(config->listen_port);
+    const char *path = config_unix_path(listener->listen_host);
+    if (path != NULL) {
+        sock = listen_unix(path, (struct sockaddr_un *)&addr);
+        addr_len = sizeof(struct sockaddr_un);
+    } else {
+        if (!listen_address(listener->listen_host, listener->listen_port, &addr, &addr_len)) {
+            return -1;
+        }
+        sock = socket(addr.ss_family, SOCK_STREAM, 0);
+        if (sock < 0 && listener->listen_host[0] == '\0' && errno == EAFNOSUPPORT) {
+            // IPv6가 꺼진 커널: 0.0.0.0
+            struct sockaddr_in *sin = (struct sockaddr_in *)&addr;
+            memset(&addr, 0, sizeof(addr));
+            sin->sin_family = AF_INET;
+            sin->sin_addr.s_addr = INADDR_ANY;
+            sin->sin_port = htons(listener->listen_port);
+            addr_len = sizeof(*sin);
+            sock = socket(AF_INET, SOCK_STREAM, 0);
+        }
+        if (sock < 0) {
+            LOG_ERROR("소켓 생성 실패: %s", strerror(errno));
+            return -1;
+        }
 
-    if (bind(proxy_sock, (struct sockaddr *)&proxy_addr, sizeof(proxy_addr)) < 0) {
-        LOG_ERROR("바인드 실패: %s", strerror(errno));
-        close(proxy_sock);
+        // 주소 재사용
+        int opt = 1;
+        if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+            LOG_WARN("SO_REUSEADDR 설정 실패: %s", strerror(errno));
+        }
+        if (addr.ss_family == AF_INET6) {
+            int off = 0;
+            setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+        }
+    }
+    if (sock < 0) {
+        return -1;
+    }
+
+    if (bind(sock, (struct sockaddr *)&addr, addr_len) < 0) {
+        LOG_ERROR("바인드 실패 [%s]: %s", listener->name, strerror(errno));
+        close(sock);
         return -1;
     }
+    if (path != NULL) {
+        snprintf(g_unix_listen_paths[index], sizeof(g_unix_listen_paths[index]), "%s", path);
+    }
 
-    if (listen(proxy_sock, MAX_LISTEN_BACKLOG) < 0) {
-        LOG_ERROR("리스닝 실패: %s", strerror(errno));
-        close(proxy_sock);
+    if (listen(sock, MAX_LISTEN_BACKLOG) < 0) {
+        LOG_ERROR("리스닝 실패 [%s]: %s", listener->name, strerror(errno));
+        close(sock);
         return -1;
     }
+    return sock;
+}
+
+// 수락한 클라이언트 주소를 문자열로
+// 겸용 소켓의 IPv4 클라이언트(::ffff:a.b.c.d)는 점 표기로, 유닉스 소켓 클라이언트는 "unix"와 상대 PID로
+static void format_peer(int sock, const struct sockaddr_storage *addr, char *ip, size_t ip_len,
+                        int *port) {
+    if (addr->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)addr;
+        if (IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr)) {
+            inet_ntop(AF_INET, &sin6->sin6_addr.s6_addr[12], ip, ip_len);
+        } else {
+            inet_ntop(AF_INET6, &sin6->sin6_addr, ip, ip_len);
+        }
+        *port = ntohs(sin6->sin6_port);
+    } else if (addr->ss_family == AF_INET) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)addr;
+        inet_ntop(AF_INET, &sin->sin_addr, ip, ip_len);
+        *port = ntohs(sin->sin_port);
+    } else {
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        snprintf(ip, ip_len, "unix");
+        *port = (getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0) ? (int)cred.pid : 0;
+    }
+}
+
+void proxy_stop(void) {
+    for (int i = 0; i < MAX_LISTENERS; i++) {
+        if (g_unix_listen_paths[i][0] != '\0') {
+            unlink(g_unix_listen_paths[i]);
+            g_unix_listen_paths[i][0] = '\0';
+        }
+    }
+}
+
+static void close_listeners(const int *socks, int count) {
+    for (int i = 0; i < count; i++) {
+        close(socks[i]);
+    }
+}
+
+int proxy_start(const ProxyConfig *config, FilterChain *filter_chain) {
+    // 리스너마다 소켓 하나 (하나라도 열지 못하면 시작하지 않음)
+    int listener_count;
+    const ListenerConfig *listeners = config_active_listeners(config, &listener_count);
+    int listen_socks[MAX_LISTENERS];
+    for (int i = 0; i < listener_count; i++) {
+        listen_socks[i] = proxy_listen(&listeners[i], i);
+        if (listen_socks[i] < 0) {
+            close_listeners(listen_socks, i);
+            proxy_stop();
+            return -1;
+        }
+    }
+
+    // 플라이트 레코더 (fork 전에 공유 메모리 생성)
+    if (!flight_init()) {
+        LOG_WARN("플라이트 레코더 비활성화");
+    }
+
+    // 트래픽 캡처 (공유 링은 fork 전에 만들어 자식들이 물려받음)
+    if (config->capture_file[0] != '\0' &&
+        !capture_start(config->capture_file, config->capture_select)) {
+        LOG_WARN("트래픽 캡처 비활성화");
+    }
+
+    // 섀도 미러링 (주소 해석과 공유 카운터는 fork 전에)
+    if (config->mirror_host[0] != '\0' &&
+        !mirror_start(config->mirror_host, config->mirror_port, config->mirror_select)) {
+        LOG_WARN("섀도 미러링 비활성화");
+    }
 
     // 제어 서버 시작
     if (control_server_start(config->control_socket) < 0) {
@@ -260,53 +1235,135 @@ int proxy_start(const ProxyConfig *config, FilterChain *filter_chain) {
 
     LOG_INFO("======================================");
     LOG_INFO("프록시 서버 시작");
-    LOG_INFO("리스닝: 0.0.0.0:%d", config->listen_port);
-    LOG_INFO("대상: %s:%d", config->target_host, config->target_port);
+    char endpoint[MAX_HOST_LEN + 16];
+    for (int i = 0; i < listener_count; i++) {
+        const ListenerConfig *listener = &listeners[i];
+        char prefix[MAX_LISTENER_NAME + 3] = "";
+        if (config->listener_count > 0) {
+            snprintf(prefix, sizeof(prefix), "[%s] ", listener->name);
+        }
+        config_format_endpoint(listener->listen_host, listener->listen_port, endpoint, sizeof(endpoint));
+        LOG_INFO("%s리스닝: %s%s", prefix, endpoint,
+                 listener->listen_host[0] == '\0' ? " (IPv6/IPv4)" : "");
+        config_format_endpoint(listener->target_host, listener->target_port, endpoint, sizeof(endpoint));
+        LOG_INFO("%s대상: %s", prefix, endpoint);
+        for (int j = 0; j < listener->sni_route_count; j++) {
+            config_format_endpoint(listener->sni_routes[j].host, listener->sni_routes[j].port,
+                                   endpoint, sizeof(endpoint));
+            LOG_INFO("%sSNI 라우팅: %s -> %s", prefix, listener->sni_routes[j].pattern, endpoint);
+        }
+    }
     LOG_INFO("제어 소켓: %s", config->control_socket);
     LOG_INFO("======================================");
 
     if (filter_chain && filter_chain->count > 0) {
         filter_chain_print(filter_chain);
     }
+
+    // 시작 필터 체인을 공유 테이블에 게시 (이후 proxyctl filter로 변경 가능)
+    control_filter_publish(filter_chain);
+    control_listeners_publish(listeners, listener_count);
+
+    // 고장 시나리오 (제어 스레드가 시각에 맞춰 필터 테이블을 바꿈)
+    if (config->scenario_file[0] != '\0' && !control_scenario_start(config->scenario_file)) {
+        control_server_stop();
+        capture_stop();
+        mirror_stop();
+        flight_cleanup();
+        close_listeners(listen_socks, listener_count);
+        proxy_stop();
+        return -1;
+    }
     
+    uint64_t next_conn_id = 1;
+
+    // 리스너가 여럿이면 poll로 기다렸다가 준비된 소켓에서 수락 (하나면 바로 accept에서 블록)
+    // poll 뒤 그 사이 연결이 사라져도 accept에서 멈추지 않도록 리스닝 소켓은 논블로킹
+    struct pollfd pfds[MAX_LISTENERS];
+    for (int i = 0; i < listener_count; i++) {
+        pfds[i].fd = listen_socks[i];
+        pfds[i].events = POLLIN;
+        pfds[i].revents = listener_count == 1 ? POLLIN : 0;
+        if (listener_count > 1) {
+            fcntl(listen_socks[i], F_SETFL, fcntl(listen_socks[i], F_GETFL) | O_NONBLOCK);
+        }
+    }
+    int next_ready = listener_count;   // 다음에 확인할 pfds 위치 (돌아가며 수락해 한 리스너가 독차지하지 않게)
+
     while (1) {
-        struct sockaddr_in client_addr;
+        if (next_ready >= listener_count) {
+            // poll은 SA_RESTART와 상관없이 SIGCHLD에도 EINTR로 돌아오므로 다시 기다림
+            // (종료 시그널은 핸들러가 정리하고 끝냄)
+            if (listener_count > 1 && poll(pfds, listener_count, -1) < 0) {
+                if (errno != EINTR) {
+                    LOG_ERROR("리스닝 소켓 대기 실패: %s", strerror(errno));
+                }
+                continue;
+            }
+            next_ready = 0;
+        }
+        int index = next_ready++;
+        if (!(pfds[index].revents & POLLIN)) {
+            continue;
+        }
+        const ListenerConfig *listener = &listeners[index];
+
+        struct sockaddr_storage client_addr;
         socklen_t client_len = sizeof(client_addr);
 
-        int client_sock = accept(proxy_sock, (struct sockaddr *)&client_addr, &client_len);
+        int client_sock = accept(listen_socks[index], (struct sockaddr *)&client_addr, &client_len);
         if (client_sock < 0) {
             if (errno == EINTR) {
                 // 시그널에 의한 중단 (Ctrl+C)
                 LOG_INFO("시그널 수신, 종료합니다");
                 break;
             }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                continue;
+            }
             LOG_ERROR("연결 수락 실패: %s", strerror(errno));
             continue;
         }
 
-        char client_ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, sizeof(client_ip));
-        int client_port = ntohs(client_addr.sin_port);
+        char client_ip[MAX_ADDR_LEN];
+        int client_port;
+        format_peer(client_sock, &client_addr, client_ip, sizeof(client_ip), &client_port);
 
-        LOG_INFO("새 클라이언트 연결: %s:%d", client_ip, client_port);
+        uint64_t conn_id = next_conn_id++;
+        if (config->listener_count > 0) {
+            LOG_INFO("새 클라이언트 연결 [%s]: %s:%d", listener->name, client_ip, client_port);
+        } else {
+            LOG_INFO("새 클라이언트 연결: %s:%d", client_ip, client_port);
+        }
+        PROBE3(conn_accept, conn_id, (const char *)client_ip, client_port);
 
-        // 대상 서버 연결
-        int server_sock = proxy_connect_target(config->target_host, config->target_port);
-        if (server_sock < 0) {
-            LOG_ERROR("대상 서버 연결 실패");
-            close(client_sock);
-            continue;
+        // 대상 서버 연결 (SNI 라우팅이면 ClientHello를 기다려야 하므로 자식이 연결)
+        int server_sock = -1;
+        if (listener->sni_route_count == 0) {
+            server_sock = proxy_connect_target(listener->target_host, listener->target_port);
+            PROBE4(connect_done, conn_id, (const char *)listener->target_host,
+                   listener->target_port, server_sock);
+            if (server_sock < 0) {
+                LOG_ERROR("대상 서버 연결 실패");
+                control_record_connect_error(index);
+                close(client_sock);
+                continue;
+            }
         }
 
         // 포크로 멀티 클라이언트 처리
         pid_t pid = fork();
         if (pid == 0) {
             // 자식 프로세스
-            close(proxy_sock);
+            close_listeners(listen_socks, listener_count);
+            child_signals_init();
 
             Connection conn;
             memset(&conn, 0, sizeof(conn));
             conn.pid = getpid();
+            conn.conn_id = conn_id;
+            conn.listener = index;
+            strcpy(conn.listener_name, listener->name);
             conn.client_fd = client_sock;
             conn.server_fd = server_sock;
 
@@ -315,37 +1372,91 @@ int proxy_start(const ProxyConfig *config, FilterChain *filter_chain) {
             conn.client_addr[MAX_ADDR_LEN - 1] = '\0';
             conn.client_port = client_port;
 
-            strncpy(conn.target_addr, config->target_host, MAX_ADDR_LEN - 1);
-            conn.target_addr[MAX_ADDR_LEN - 1] = '\0';
-            conn.target_port = config->target_port;
+            // 로드밸런서가 붙인 PROXY 헤더: 실제 클라이언트 주소로 바꿈 (선택자/목록/로그가 이 주소를 씀)
+            ProxyHeader proxy_header;
+            memset(&proxy_header, 0, sizeof(proxy_header));
+            if (listener->proxy_protocol & PROXY_PROTOCOL_IN) {
+                if (!proxyproto_read(client_sock, PROXY_HEADER_TIMEOUT_MS, &proxy_header)) {
+                    LOG_ERROR("PROXY 헤더 없음, 연결 종료: %s:%d", client_ip, client_port);
+                    close(client_sock);
+                    if (server_sock >= 0) close(server_sock);
+                    exit(1);
+                }
+                if (proxy_header.family != AF_UNSPEC) {
+                    LOG_INFO("PROXY v%d: 실제 클라이언트 %s:%d (경유 %s:%d)", proxy_header.version,
+                             proxy_header.src_addr, proxy_header.src_port, client_ip, client_port);
+                    strcpy(conn.client_addr, proxy_header.src_addr);
+                    conn.client_port = proxy_header.src_port;
+                }
+            }
 
-            // 필터 체인 복사
-            if (filter_chain) {
-                memcpy(&conn.filter_chain, filter_chain, sizeof(FilterChain));
+            if (server_sock < 0) {
+                server_sock = connect_by_sni(listener, &conn);
+                if (server_sock < 0) {
+                    close(client_sock);
+                    exit(1);
+                }
+                conn.server_fd = server_sock;
             } else {
-                filter_chain_init(&conn.filter_chain);
+                snprintf(conn.target_addr, sizeof(conn.target_addr), "%s", listener->target_host);
+                conn.target_port = listener->target_port;
+            }
+
+            // 대상 서버가 실제 클라이언트 주소를 알 수 있도록 첫 바이트로 v2 헤더 전송
+            if ((listener->proxy_protocol & PROXY_PROTOCOL_OUT) &&
+                !proxyproto_send_v2(server_sock, client_sock, &proxy_header,
+                                    conn.client_addr, conn.client_port)) {
+                close(client_sock);
+                close(server_sock);
+                exit(1);
+            }
+
+            // 이 연결에 해당하는 필터만 골라 방향별 체인 생성
+            // 방향별 난수 시드 (마스터 시드 + 연결 ID로 결정, 같은 시드면 같은 수열)
+            filter_path_init(&conn.filters[0], rng_derive_seed(config->seed, conn_id * 2));
+            filter_path_init(&conn.filters[1], rng_derive_seed(config->seed, conn_id * 2 + 1));
+            // 게시된 테이블로 컴파일해야 필터 ID가 맞아, 이후 테이블이 바뀌어도 고장 상태를 이어감
+            // (제어 서버가 없으면 시작 체인)
+            FilterChain table;
+            const FilterChain *start_chain = filter_chain;
+            if (control_filter_sync(&table, &conn.filter_generation)) {
+                start_chain = &table;
+            }
+            if (start_chain) {
+                filter_path_compile(start_chain, &conn, FILTER_DIR_C2S, &conn.filters[0]);
+                filter_path_compile(start_chain, &conn, FILTER_DIR_S2C, &conn.filters[1]);
+            }
+            if (listener->protocol == PROTOCOL_MYSQL) {
+                conn.mysql = mysql_session_create();
+            } else if (listener->protocol == PROTOCOL_HTTP) {
+                conn.http = http_session_create();
             }
 
             proxy_handle_connection(&conn);
 
             close(client_sock);
             close(server_sock);
+            mirror_close(conn.mirror);  // 주 연결을 닫은 뒤 섀도 큐를 마저 보냄
             LOG_INFO("연결 종료: %s:%d", client_ip, client_port);
             exit(0);
         } else if (pid > 0) {
             // 부모 프로세스
             close(client_sock);
-            close(server_sock);
+            if (server_sock >= 0) close(server_sock);
         } else {
             LOG_ERROR("fork 실패: %s", strerror(errno));
             close(client_sock);
-            close(server_sock);
+            if (server_sock >= 0) close(server_sock);
         }
     }
 
     // 정리
     control_server_stop();
-    close(proxy_sock);
+    capture_stop();
+    mirror_stop();
+    flight_cleanup();
+    close_listeners(listen_socks, listener_count);
+    proxy_stop();
     LOG_INFO("프록시 서버 종료 완료");
     return 0;
 }
@@ -1,13 +1,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <signal.h>
 #include <time.h>
 #include <errno.h>
+#include <arpa/inet.h>
+#include <limits.h>
 #include "../include/control.h"
+#include "../include/matcher.h"
+#include "../include/latency.h"
 
 #define DEFAULT_SOCKET_PATH "/tmp/tcp_proxy_control.sock"
 
@@ -55,8 +60,49 @@ static void format_duration(time_t seconds, char *buf, size_t size) {
     }
 }
 
+// 대상 주소 표시 (유닉스 소켓 대상은 포트 없이 "unix:/경로")
+static void format_target(const ConnectionInfo *conn, char *buf, size_t size) {
+    if (conn->target_port == 0) {
+        snprintf(buf, size, "%s", conn->target_addr);
+    } else {
+        snprintf(buf, size, "%s:%d", conn->target_addr, conn->target_port);
+    }
+}
+
+// TCP_INFO 샘플을 한 줄로 변환
+static void format_tcp_info(const TcpInfoSample *tcp, char *buf, size_t size) {
+    if (!tcp->valid) {
+        snprintf(buf, size, "-");
+        return;
+    }
+
+    char rate_str[16];
+    format_bytes(tcp->delivery_rate, rate_str, sizeof(rate_str));
+    snprintf(buf, size, "rtt %.2fms±%.2f cwnd %u unacked %u retrans %u rate %s/s",
+             tcp->rtt_us / 1000.0, tcp->rttvar_us / 1000.0,
+             tcp->snd_cwnd, tcp->unacked, tcp->retransmits, rate_str);
+}
+
+// 처리량(bytes/s)을 읽기 쉬운 형식으로 변환
+static void format_rate(float rate, char *buf, size_t size) {
+    char bytes_str[16];
+    format_bytes(rate > 0 ? (uint64_t)rate : 0, bytes_str, sizeof(bytes_str));
+    snprintf(buf, size, "%s/s", bytes_str);
+}
+
+// 1초/10초/60초 EWMA 처리량을 한 줄로 변환
+static void format_rates(const float rates[RATE_WINDOWS], char *buf, size_t size) {
+    char r1[24], r10[24], r60[24];
+    format_rate(rates[0], r1, sizeof(r1));
+    format_rate(rates[1], r10, sizeof(r10));
+    format_rate(rates[2], r60, sizeof(r60));
+    snprintf(buf, size, "%s / %s / %s", r1, r10, r60);
+}
+
 // 제어 요청 전송 및 응답 수신
-static int send_control_request(const char *socket_path, ControlRequest *req, ControlResponse *resp) {
+// rows가 NULL이 아니면 응답 뒤에 이어 오는 연결 목록을 받아 둠 (호출자가 free, 없으면 NULL)
+static int send_control_request_rows(const char *socket_path, ControlRequest *req,
+                                     ControlResponse *resp, ConnectionInfo **rows) {
     int sock = socket(AF_UNIX, SOCK_STREAM, 0);
     if (sock < 0) {
         fprintf(stderr, "소켓 생성 실패: %s\n", strerror(errno));
@@ -82,53 +128,106 @@ static int send_control_request(const char *socket_path, ControlRequest *req, Co
         return -1;
     }
 
-    // 응답 수신
-    if (recv(sock, resp, sizeof(ControlResponse), 0) != sizeof(ControlResponse)) {
+    // 응답 수신 (응답이 커서 여러 번에 나뉘어 도착할 수 있음)
+    if (recv(sock, resp, sizeof(ControlResponse), MSG_WAITALL) != sizeof(ControlResponse)) {
         fprintf(stderr, "응답 수신 실패: %s\n", strerror(errno));
         close(sock);
         return -1;
     }
 
+    if (rows != NULL) {
+        *rows = NULL;
+        if (resp->connection_count > 0) {
+            size_t length = (size_t)resp->connection_count * sizeof(ConnectionInfo);
+            *rows = malloc(length);
+            if (*rows == NULL || recv(sock, *rows, length, MSG_WAITALL) != (ssize_t)length) {
+                fprintf(stderr, "연결 목록 수신 실패 (%d개)\n", resp->connection_count);
+                free(*rows);
+                *rows = NULL;
+                close(sock);
+                return -1;
+            }
+        }
+    }
+
     close(sock);
     return 0;
 }
 
+static int send_control_request(const char *socket_path, ControlRequest *req, ControlResponse *resp) {
+    return send_control_request_rows(socket_path, req, resp, NULL);
+}
+
+// 연결 표가 가득 차 목록에 없는 연결 안내 (list, stats, top, 일괄 명령)
+static void print_unregistered(const ControlResponse *resp) {
+    if (resp->unregistered > 0) {
+        printf("주의: 연결 표가 가득 차 목록에 없는 활성 연결 %d개 (누적 %llu개, 최대 %d개 등록)\n",
+               resp->unregistered, (unsigned long long)resp->unregistered_total, MAX_CONNECTIONS);
+    }
+}
+
+// 연결 ID 순 (공유 연결 표는 해제 때 마지막 항목을 옮기므로 순서가 없음)
+static int compare_conn_id(const void *a, const void *b) {
+    uint64_t x = ((const ConnectionInfo *)a)->conn_id;
+    uint64_t y = ((const ConnectionInfo *)b)->conn_id;
+    return x < y ? -1 : x > y;
+}
+
 // list 명령
-static int cmd_list(const char *socket_path) {
+// listener가 NULL이 아니면 그 리스너의 연결만
+static int cmd_list(const char *socket_path, const char *listener) {
     ControlRequest req = {0};
     ControlResponse resp = {0};
+    ConnectionInfo *rows;
 
     req.cmd = CMD_LIST_CONNECTIONS;
 
-    if (send_control_request(socket_path, &req, &resp) < 0) {
+    if (send_control_request_rows(socket_path, &req, &resp, &rows) < 0) {
         return 1;
     }
 
     if (!resp.success) {
         fprintf(stderr, "실패: %s\n", resp.message);
+        free(rows);
         return 1;
     }
 
+    if (listener != NULL) {
+        int kept = 0;
+        for (int i = 0; i < resp.connection_count; i++) {
+            if (strcmp(rows[i].listener, listener) == 0) {
+                rows[kept++] = rows[i];
+            }
+        }
+        resp.connection_count = kept;
+    }
+
     if (resp.connection_count == 0) {
         printf("활성 연결이 없습니다.\n");
+        print_unregistered(&resp);
+        free(rows);
         return 0;
     }
+    qsort(rows, resp.connection_count, sizeof(ConnectionInfo), compare_conn_id);
 
-    printf("\n총 %d개의 활성 연결:\n\n", resp.connection_count);
-    printf("%-8s %-22s %-22s %-12s %-12s %-12s %s\n",
-           "PID", "클라이언트", "대상 서버", "업로드", "다운로드", "연결 시간", "마지막 활동");
+    printf("\n총 %d개의 활성 연결%s%s:\n", resp.connection_count,
+           listener ? ", 리스너 " : "", listener ? listener : "");
+    print_unregistered(&resp);
+    printf("\n");
+    printf("%-6s %-8s %-22s %-22s %-12s %-12s %-12s %s\n",
+           "ID", "PID", "클라이언트", "대상 서버", "업로드", "다운로드", "연결 시간", "마지막 활동");
     printf("========================================================================================================================\n");
 
     time_t now = time(NULL);
 
     for (int i = 0; i < resp.connection_count; i++) {
-        ConnectionInfo *conn = &resp.connections[i];
+        ConnectionInfo *conn = &rows[i];
 
         char client_str[64];
         snprintf(client_str, sizeof(client_str), "%s:%d", conn->client_addr, conn->client_port);
 
-        char target_str[64];
-        snprintf(target_str, sizeof(target_str), "%s:%d", conn->target_addr, conn->target_port);
+        char target_str[MAX_HOST_LEN + 8];
+        format_target(conn, target_str, sizeof(target_str));
 
         char upload_str[16], download_str[16];
         format_bytes(conn->client_to_server_bytes, upload_str, sizeof(upload_str));
@@ -144,11 +243,29 @@ static int cmd_list(const char *socket_path) {
             format_duration(last_activity, activity_str, sizeof(activity_str));
         }
 
-        printf("%-8d %-22s %-22s %-12s %-12s %-12s %s\n",
-               conn->pid, client_str, target_str, upload_str, download_str,
+        printf("%-6lu %-8d %-22s %-22s %-12s %-12s %-12s %s\n",
+               conn->conn_id, conn->pid, client_str, target_str, upload_str, download_str,
                duration_str, activity_str);
+
+        char client_tcp_str[128], server_tcp_str[128];
+        format_tcp_info(&conn->client_tcp, client_tcp_str, sizeof(client_tcp_str));
+        format_tcp_info(&conn->server_tcp, server_tcp_str, sizeof(server_tcp_str));
+        if (listener == NULL && strcmp(conn->listener, "default") != 0) {
+            printf("                └ 리스너: %s\n", conn->listener);
+        }
+        if (conn->sni[0] != '\0') {
+            printf("                └ SNI: %s\n", conn->sni);
+        }
+        printf("                └ TCP 클라이언트: %s\n", client_tcp_str);
+        printf("                └ TCP 서버:       %s\n", server_tcp_str);
+
+        char up_rates[96], down_rates[96];
+        format_rates(conn->rates.client_to_server, up_rates, sizeof(up_rates));
+        format_rates(conn->rates.server_to_client, down_rates, sizeof(down_rates));
+        printf("                └ 처리량 1s/10s/60s  ↑ %s  ↓ %s\n", up_rates, down_rates);
     }
 
+    free(rows);
     return 0;
 }
 
@@ -202,24 +319,81 @@ static int cmd_signal(const char *socket_path, pid_t pid, const char *sig_str) {
     }
 }
 
+// kill-all / signal-all 명령 (선택자에 맞는 연결을 한 번의 요청으로 처리)
+static int cmd_bulk(const char *socket_path, ControlCommand cmd, int sig_num,
+                    const char *selector, bool abortive, bool dry_run) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+    ConnectionInfo *rows;
+
+    req.cmd = cmd;
+    req.signal_num = sig_num;
+    req.abortive = abortive;
+    req.dry_run = dry_run;
+    strncpy(req.selector, selector, sizeof(req.selector) - 1);
+
+    if (send_control_request_rows(socket_path, &req, &resp, &rows) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        free(rows);
+        return 1;
+    }
+
+    printf("성공: %s\n", resp.message);
+    print_unregistered(&resp);
+    if (resp.connection_count == 0) {
+        free(rows);
+        return 0;
+    }
+    qsort(rows, resp.connection_count, sizeof(ConnectionInfo), compare_conn_id);
+
+    printf("\n%-6s %-8s %-22s %-22s %-12s %s\n",
+           "ID", "PID", "클라이언트", "대상 서버", "전송량", "유휴");
+
+    time_t now = time(NULL);
+    for (int i = 0; i < resp.connection_count; i++) {
+        ConnectionInfo *conn = &rows[i];
+
+        char client_str[64], target_str[MAX_HOST_LEN + 8], bytes_str[16], idle_str[32];
+        snprintf(client_str, sizeof(client_str), "%s:%d", conn->client_addr, conn->client_port);
+        format_target(conn, target_str, sizeof(target_str));
+        format_bytes(conn->client_to_server_bytes + conn->server_to_client_bytes,
+                     bytes_str, sizeof(bytes_str));
+        format_duration(now - conn->last_activity, idle_str, sizeof(idle_str));
+
+        printf("%-6lu %-8d %-22s %-22s %-12s %s\n",
+               conn->conn_id, conn->pid, client_str, target_str, bytes_str, idle_str);
+    }
+
+    free(rows);
+    return resp.bulk.failed > 0 ? 1 : 0;
+}
+
 // stats 명령
 static int cmd_stats(const char *socket_path) {
     ControlRequest req = {0};
     ControlResponse resp = {0};
+    ConnectionInfo *rows;
 
     req.cmd = CMD_GET_STATS;
 
-    if (send_control_request(socket_path, &req, &resp) < 0) {
+    if (send_control_request_rows(socket_path, &req, &resp, &rows) < 0) {
         return 1;
     }
 
     if (!resp.success) {
         fprintf(stderr, "실패: %s\n", resp.message);
+        free(rows);
         return 1;
     }
 
     if (resp.connection_count == 0) {
         printf("활성 연결이 없습니다.\n");
+        print_unregistered(&resp);
+        free(rows);
         return 0;
     }
 
@@ -227,9 +401,10 @@ static int cmd_stats(const char *socket_path) {
     uint64_t total_s2c = 0;
 
     for (int i = 0; i < resp.connection_count; i++) {
-        total_c2s += resp.connections[i].client_to_server_bytes;
-        total_s2c += resp.connections[i].server_to_client_bytes;
+        total_c2s += rows[i].client_to_server_bytes;
+        total_s2c += rows[i].server_to_client_bytes;
     }
+    free(rows);
 
     char upload_str[32], download_str[32], total_str[32];
     format_bytes(total_c2s, upload_str, sizeof(upload_str));
@@ -241,6 +416,590 @@ static int cmd_stats(const char *socket_path) {
     printf("총 업로드 (클라이언트→서버): %s\n", upload_str);
     printf("총 다운로드 (서버→클라이언트): %s\n", download_str);
     printf("총 데이터 전송량: %s\n", total_str);
+    print_unregistered(&resp);
+
+    return 0;
+}
+
+// top 명령
+static int cmd_top(const char *socket_path, int count, int window_sec) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+    ConnectionInfo *rows;
+
+    req.cmd = CMD_TOP_CONNECTIONS;
+    req.count = count;
+    req.interval_sec = window_sec;
+
+    if (send_control_request_rows(socket_path, &req, &resp, &rows) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        free(rows);
+        return 1;
+    }
+
+    if (resp.connection_count == 0) {
+        printf("활성 연결이 없습니다.\n");
+        print_unregistered(&resp);
+        free(rows);
+        return 0;
+    }
+
+    int window = window_sec >= 60 ? 2 : (window_sec >= 10 ? 1 : 0);
+
+    printf("\n현재 처리량 상위 %d개 연결 (%d초 EWMA, %s):\n",
+           resp.connection_count, window == 2 ? 60 : (window == 1 ? 10 : 1), resp.message);
+    print_unregistered(&resp);
+    printf("\n");
+    printf("%-6s %-8s %-22s %-14s %-14s %s\n",
+           "ID", "PID", "클라이언트", "합계", "업로드", "다운로드");
+    printf("================================================================================\n");
+
+    for (int i = 0; i < resp.connection_count; i++) {
+        ConnectionInfo *conn = &rows[i];
+
+        char client_str[64];
+        snprintf(client_str, sizeof(client_str), "%s:%d", conn->client_addr, conn->client_port);
+
+        float up = conn->rates.client_to_server[window];
+        float down = conn->rates.server_to_client[window];
+
+        char total_str[24], up_str[24], down_str[24];
+        format_rate(up + down, total_str, sizeof(total_str));
+        format_rate(up, up_str, sizeof(up_str));
+        format_rate(down, down_str, sizeof(down_str));
+
+        printf("%-6lu %-8d %-22s %-14s %-14s %s\n",
+               conn->conn_id, conn->pid, client_str, total_str, up_str, down_str);
+    }
+
+    free(rows);
+    return 0;
+}
+
+// history 명령
+static int cmd_history(const char *socket_path, int interval_sec, int count) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = CMD_GET_HISTORY;
+    req.interval_sec = interval_sec;
+    req.count = count;
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    const HistoryDump *history = &resp.history;
+    if (history->count == 0) {
+        printf("기록된 이력이 없습니다.\n");
+        return 0;
+    }
+
+    printf("\n=== 처리량 이력 (%s 단위, %d개) ===\n\n",
+           history->interval_sec == 60 ? "분" : "초", history->count);
+    printf("%-10s %-14s %-14s %-8s %-8s %-8s %s\n",
+           "시각", "업로드/s", "다운로드/s", "새 연결", "종료", "드롭", "연결 실패");
+    printf("==========================================================================\n");
+
+    for (int i = 0; i < history->count; i++) {
+        const HistoryBucket *bucket = &history->buckets[i];
+        int duration = bucket->duration_sec > 0 ? bucket->duration_sec : 1;
+
+        char time_str[16];
+        struct tm *tm_info = localtime(&bucket->end_time);
+        strftime(time_str, sizeof(time_str), "%H:%M:%S", tm_info);
+
+        char upload_str[16], download_str[16];
+        format_bytes(bucket->client_to_server_bytes / duration, upload_str, sizeof(upload_str));
+        format_bytes(bucket->server_to_client_bytes / duration, download_str, sizeof(download_str));
+
+        printf("%-10s %-14s %-14s %-8u %-8u %-8u %u%s\n",
+               time_str, upload_str, download_str,
+               bucket->connections_opened, bucket->connections_closed,
+               bucket->packets_dropped, bucket->connect_errors,
+               history->interval_sec == 60 && duration < 60 ? "  (집계 중)" : "");
+    }
+
+    return 0;
+}
+
+// 필터 한 개를 읽기 쉬운 형식으로 변환
+// 수정 패턴 표시 (출력 가능한 문자만 있으면 리터럴, 아니면 0x 16진수)
+static void format_modify_bytes(const uint8_t *bytes, int len, char *buf, size_t size) {
+    bool literal = !(len >= 2 && bytes[0] == '0' && bytes[1] == 'x');
+    for (int i = 0; i < len && literal; i++) {
+        literal = isgraph(bytes[i]) && !strchr("/,!", bytes[i]);
+    }
+
+    if (literal) {
+        snprintf(buf, size, "%.*s", len, (const char *)bytes);
+        return;
+    }
+
+    size_t pos = snprintf(buf, size, "0x");
+    for (int i = 0; i < len && pos + 2 < size; i++) {
+        pos += snprintf(buf + pos, size - pos, "%02x", bytes[i]);
+    }
+}
+
+static const char *delay_distribution_name(int dist) {
+    switch (dist) {
+        case DIST_UNIFORM:   return "uniform";
+        case DIST_NORMAL:    return "normal";
+        case DIST_PARETO:    return "pareto";
+        case DIST_LOGNORMAL: return "lognormal";
+        default:             return "constant";
+    }
+}
+
+static void format_filter(const Filter *filter, char *buf, size_t size) {
+    switch (filter->type) {
+        case FILTER_DELAY:
+            if (filter->params.delay.jitter_ms > 0) {
+                snprintf(buf, size, "지연 %d ms ±%d ms %s 상관 %.0f%%",
+                         filter->params.delay.delay_ms, filter->params.delay.jitter_ms,
+                         delay_distribution_name(filter->params.delay.distribution),
+                         filter->params.delay.correlation * 100);
+            } else {
+                snprintf(buf, size, "지연 %d ms", filter->params.delay.delay_ms);
+            }
+            break;
+        case FILTER_DROP:
+            snprintf(buf, size, "드롭 %.2f%%", filter->params.drop.drop_rate * 100);
+            break;
+        case FILTER_THROTTLE:
+            snprintf(buf, size, "쓰로틀 %d bytes/sec", filter->params.throttle.bytes_per_sec);
+            break;
+        case FILTER_MODIFY: {
+            size_t len = snprintf(buf, size, "수정");
+            for (int i = 0; i < filter->params.modify.rule_count && len < size; i++) {
+                const ModifyRule *rule = &filter->params.modify.rules[i];
+                char pattern[MODIFY_MAX_PATTERN_LEN * 2 + 3];
+                char replacement[MODIFY_MAX_PATTERN_LEN * 2 + 3];
+
+                format_modify_bytes(rule->pattern, rule->len, pattern, sizeof(pattern));
+                if (rule->action == MATCH_FLIP) {
+                    snprintf(replacement, sizeof(replacement), "!flip");
+                } else if (rule->action == MATCH_ZERO) {
+                    snprintf(replacement, sizeof(replacement), "!zero");
+                } else {
+                    format_modify_bytes(rule->replacement, rule->len, replacement, sizeof(replacement));
+                }
+                len += snprintf(buf + len, size - len, "%s%s/%s", i ? "," : " ", pattern, replacement);
+            }
+            break;
+        }
+        case FILTER_RESET:
+            snprintf(buf, size, "리셋 %d ms 후", filter->params.reset.after_ms);
+            break;
+        case FILTER_STALL:
+            if (filter->params.stall.duration_ms > 0) {
+                snprintf(buf, size, "정지 %d ms", filter->params.stall.duration_ms);
+            } else {
+                snprintf(buf, size, "정지 (연결 종료까지)");
+            }
+            break;
+        case FILTER_FRAGMENT:
+            snprintf(buf, size, "분할 %d bytes씩", filter->params.fragment.size);
+            break;
+        case FILTER_HALF_CLOSE:
+            snprintf(buf, size, "반쪽 닫기 %d ms 유지", filter->params.half_close.hold_ms);
+            break;
+        case FILTER_DUPLICATE:
+            snprintf(buf, size, "복제 %.2f%%", filter->params.chance.rate * 100);
+            break;
+        case FILTER_REORDER:
+            snprintf(buf, size, "순서 바꾸기 %.2f%%", filter->params.chance.rate * 100);
+            break;
+        case FILTER_MYSQL_ERROR:
+            snprintf(buf, size, "MySQL 오류 %d", filter->params.mysql_error.code);
+            break;
+        case FILTER_HTTP_ERROR:
+            snprintf(buf, size, "HTTP 오류 %d", filter->params.http_error.status);
+            break;
+        default:
+            snprintf(buf, size, "알 수 없음 (%d)", filter->type);
+            break;
+    }
+
+    // 방향 및 선택자 조건
+    const FilterSelector *sel = &filter->selector;
+    size_t len = strlen(buf);
+    if (filter->directions == FILTER_DIR_C2S && len < size) {
+        len += snprintf(buf + len, size - len, " dir=c2s");
+    } else if (filter->directions == FILTER_DIR_S2C && len < size) {
+        len += snprintf(buf + len, size - len, " dir=s2c");
+    }
+    if ((sel->flags & SELECT_CLIENT_CIDR) && len < size) {
+        char addr[INET6_ADDRSTRLEN];
+        inet_ntop(sel->family, sel->addr, addr, sizeof(addr));
+        len += snprintf(buf + len, size - len, " client=%s/%d", addr, sel->prefix_len);
+    }
+    if ((sel->flags & SELECT_CLIENT_PORT) && len < size) {
+        len += snprintf(buf + len, size - len, " ports=%d-%d", sel->port_min, sel->port_max);
+    }
+    if ((sel->flags & SELECT_CONN_ID) && len < size) {
+        len += snprintf(buf + len, size - len, " conn=%lu", sel->conn_id);
+    }
+    if ((sel->flags & SELECT_PID) && len < size) {
+        len += snprintf(buf + len, size - len, " pid=%d", sel->pid);
+    }
+    if ((sel->flags & SELECT_PERCENT) && len < size) {
+        len += snprintf(buf + len, size - len, " percent=%.1f", sel->percent);
+    }
+    if ((sel->flags & SELECT_LISTENER) && len < size) {
+        len += snprintf(buf + len, size - len, " listener=%s", sel->listener);
+    }
+
+    // 트리거 조건
+    const FilterTrigger *trigger = &filter->trigger;
+    if ((trigger->flags & TRIGGER_MATCH) && len < size) {
+        char pattern[MODIFY_MAX_PATTERN_LEN * 2 + 3];
+        format_modify_bytes(trigger->pattern, trigger->pattern_len, pattern, sizeof(pattern));
+        len += snprintf(buf + len, size - len, " match=%s", pattern);
+    }
+    if ((trigger->flags & TRIGGER_AFTER) && len < size) {
+        char bytes_str[16];
+        format_bytes(trigger->after_bytes, bytes_str, sizeof(bytes_str));
+        len += snprintf(buf + len, size - len, " after=%s", bytes_str);
+    }
+    if ((trigger->flags & TRIGGER_OFFSET) && len < size) {
+        len += snprintf(buf + len, size - len, trigger->offset_max ? " offset=%lu-%lu" : " offset=%lu",
+                        trigger->offset_min, trigger->offset_max);
+    }
+    if ((trigger->flags & TRIGGER_ELAPSED) && len < size) {
+        len += snprintf(buf + len, size - len, trigger->elapsed_max_ms ? " elapsed=%lu-%lums" : " elapsed=%lums",
+                        trigger->elapsed_min_ms, trigger->elapsed_max_ms);
+    }
+    if ((trigger->flags & TRIGGER_QUERY) && len < size) {
+        len += snprintf(buf + len, size - len, " query=%s", trigger->query_prefix_len ? "" : "*");
+        for (int i = 0; i < trigger->query_prefix_len && len < size; i++) {
+            char c = trigger->query_prefix[i];
+            len += snprintf(buf + len, size - len, c == ' ' ? "%%20" : "%c", c);
+        }
+    }
+}
+
+// 한 방향의 필터 효과 (예: "120 청크 (1.50 MB), 드롭 3, 지연 +1.20s")
+static void format_filter_counters(const Filter *filter, const FilterCounters *c,
+                                   char *buf, size_t size) {
+    if (c->chunks == 0) {
+        snprintf(buf, size, "-");
+        return;
+    }
+
+    char bytes_str[16];
+    format_bytes(c->bytes, bytes_str, sizeof(bytes_str));
+    if (filter->type == FILTER_MODIFY) {
+        snprintf(buf, size, "%lu 청크 (%s), 수정 %lu", c->chunks, bytes_str, c->modified);
+    } else if (filter->type == FILTER_DUPLICATE || filter->type == FILTER_REORDER ||
+               filter->type == FILTER_FRAGMENT) {
+        snprintf(buf, size, "%lu 청크 (%s), %s %lu", c->chunks, bytes_str,
+                 filter->type == FILTER_DUPLICATE ? "복제" :
+                 filter->type == FILTER_REORDER ? "순서 바꿈" : "분할", c->modified);
+    } else if (filter->type == FILTER_RESET || filter->type == FILTER_HALF_CLOSE) {
+        snprintf(buf, size, "%lu회 발동", c->chunks);
+    } else if (filter->type == FILTER_MYSQL_ERROR || filter->type == FILTER_HTTP_ERROR) {
+        snprintf(buf, size, "%lu 쿼리, 오류 주입 %lu", c->chunks, c->dropped);
+    } else {
+        snprintf(buf, size, "%lu 청크 (%s), 드롭 %lu, 지연 +%.2fs",
+                 c->chunks, bytes_str, c->dropped, c->delay_us / 1000000.0);
+    }
+}
+
+// filter 명령 (list/add/remove/enable/disable/clear)
+static int cmd_filter(const char *socket_path, ControlCommand cmd, int index, const char *spec) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = cmd;
+    req.filter_index = index;
+    if (spec != NULL) {
+        strncpy(req.filter_spec, spec, sizeof(req.filter_spec) - 1);
+    }
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    if (cmd != CMD_FILTER_LIST) {
+        printf("성공: %s\n", resp.message);
+    }
+
+    printf("\n=== 필터 테이블 (세대 %u, %d개) ===\n", resp.filter_generation, resp.filters.count);
+    if (resp.filters.count == 0) {
+        printf("활성 필터 없음\n");
+        return 0;
+    }
+
+    for (int i = 0; i < resp.filters.count; i++) {
+        const Filter *filter = &resp.filters.filters[i];
+        char filter_str[384];
+        format_filter(filter, filter_str, sizeof(filter_str));
+        printf("  [%d] %-50s %s\n", i, filter_str, filter->enabled ? "" : "(비활성)");
+
+        char c2s_str[96], s2c_str[96];
+        format_filter_counters(filter, &resp.filter_counters[i][0], c2s_str, sizeof(c2s_str));
+        format_filter_counters(filter, &resp.filter_counters[i][1], s2c_str, sizeof(s2c_str));
+        if (filter->directions & FILTER_DIR_C2S) {
+            printf("      C→S: %s\n", c2s_str);
+        }
+        if (filter->directions & FILTER_DIR_S2C) {
+            printf("      S→C: %s\n", s2c_str);
+        }
+    }
+
+    return 0;
+}
+
+// scenario 명령 (start/stop/status)
+static int cmd_scenario(const char *socket_path, ControlCommand cmd, const char *path) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = cmd;
+    if (path != NULL) {
+        // 부모 프로세스의 작업 디렉토리와 다를 수 있으므로 절대 경로로 보냄
+        char resolved[PATH_MAX];
+        if (realpath(path, resolved) == NULL) {
+            fprintf(stderr, "오류: 시나리오 파일을 찾을 수 없습니다: %s (%s)\n", path, strerror(errno));
+            return 1;
+        }
+        if (snprintf(req.path, sizeof(req.path), "%s", resolved) >= (int)sizeof(req.path)) {
+            fprintf(stderr, "오류: 시나리오 파일 경로가 너무 깁니다 (최대 %zu자): %s\n",
+                    sizeof(req.path) - 1, resolved);
+            return 1;
+        }
+    }
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    if (cmd != CMD_SCENARIO_STATUS) {
+        printf("성공: %s\n", resp.message);
+    }
+
+    const ScenarioStatus *st = &resp.scenario;
+    if (!st->loaded) {
+        printf("\n실행한 시나리오 없음\n");
+        return 0;
+    }
+
+    printf("\n=== 시나리오: %s (%s) ===\n", st->path,
+           st->running ? "진행 중" : st->steps_done < st->step_count ? "중단됨" : "끝남");
+    printf("  진행: %d/%d 단계, 경과 %.1fs\n", st->steps_done, st->step_count, st->elapsed_ms / 1000.0);
+    if (st->last_step[0] != '\0') {
+        printf("  마지막: %s\n", st->last_step);
+    }
+    if (st->running) {
+        uint64_t remaining = st->next_at_ms > st->elapsed_ms ? st->next_at_ms - st->elapsed_ms : 0;
+        printf("  다음:   %s (%.1fs 후)\n", st->next_step, remaining / 1000.0);
+    }
+
+    printf("\n현재 필터 테이블 (세대 %u, %d개)\n", resp.filter_generation, resp.filters.count);
+    for (int i = 0; i < resp.filters.count; i++) {
+        char filter_str[256];
+        format_filter(&resp.filters.filters[i], filter_str, sizeof(filter_str));
+        printf("  [%d] %s%s\n", i, filter_str, resp.filters.filters[i].enabled ? "" : " (비활성)");
+    }
+    return 0;
+}
+
+// 플라이트 레코더 이벤트 이름
+static const char *flight_event_name(uint8_t type) {
+    switch (type) {
+        case FLIGHT_OPEN:        return "OPEN";
+        case FLIGHT_RECV:        return "RECV";
+        case FLIGHT_SEND:        return "SEND";
+        case FLIGHT_FILTER_PASS: return "FILTER_PASS";
+        case FLIGHT_FILTER_DROP: return "FILTER_DROP";
+        case FLIGHT_EAGAIN:      return "EAGAIN";
+        case FLIGHT_TIMEOUT:     return "TIMEOUT";
+        case FLIGHT_CLOSE:       return "CLOSE";
+        case FLIGHT_RESET:       return "RESET";
+        case FLIGHT_HALF_CLOSE:  return "HALF_CLOSE";
+        case FLIGHT_QUERY:       return "QUERY";
+        case FLIGHT_QUERY_ERROR: return "QUERY_ERROR";
+        default:                 return "?";
+    }
+}
+
+static const char *flight_dir_name(uint8_t dir) {
+    switch (dir) {
+        case FLIGHT_DIR_C2S: return "C→S";
+        case FLIGHT_DIR_S2C: return "S→C";
+        default:             return "";
+    }
+}
+
+// flight 명령
+static int cmd_flight(const char *socket_path, pid_t pid, uint64_t conn_id) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = CMD_DUMP_FLIGHT;
+    req.target_pid = pid;
+    req.conn_id = conn_id;
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    const FlightDump *dump = &resp.flight;
+    printf("\n연결 #%lu (PID %d) - %s, 전체 이벤트 %u개 중 최근 %d개\n\n",
+           dump->conn_id, dump->pid,
+           dump->closed_at ? "종료됨" : "활성",
+           dump->total_events, dump->event_count);
+
+    if (dump->event_count == 0) {
+        return 0;
+    }
+
+    printf("%-14s %-12s %-12s %-4s %s\n", "시간(ms)", "간격(us)", "이벤트", "방향", "값");
+    printf("==============================================================\n");
+
+    uint64_t first = dump->events[0].ticks;
+    for (int i = 0; i < dump->event_count; i++) {
+        const FlightEvent *ev = &dump->events[i];
+        double at_ms = (ev->ticks - first) / dump->ticks_per_us / 1000.0;
+        double gap_us = i > 0 ? (ev->ticks - dump->events[i - 1].ticks) / dump->ticks_per_us : 0;
+
+        char value_str[32];
+        switch (ev->type) {
+            case FLIGHT_RECV:
+            case FLIGHT_SEND:
+                snprintf(value_str, sizeof(value_str), "%u bytes", ev->value);
+                break;
+            case FLIGHT_FILTER_PASS:
+            case FLIGHT_FILTER_DROP:
+                snprintf(value_str, sizeof(value_str), "%.1f us", ev->value / dump->ticks_per_us);
+                break;
+            case FLIGHT_EAGAIN:
+                snprintf(value_str, sizeof(value_str), "%s", strerror((int)ev->value));
+                break;
+            case FLIGHT_HALF_CLOSE:
+                snprintf(value_str, sizeof(value_str), "유지 %u ms", ev->value);
+                break;
+            case FLIGHT_QUERY:
+                snprintf(value_str, sizeof(value_str), "응답 %u us", ev->value);
+                break;
+            case FLIGHT_QUERY_ERROR:
+                snprintf(value_str, sizeof(value_str), "오류 %u", ev->value);
+                break;
+            default:
+                value_str[0] = '\0';
+                break;
+        }
+
+        printf("%-14.3f %-12.1f %-12s %-4s %s\n",
+               at_ms, gap_us, flight_event_name(ev->type), flight_dir_name(ev->dir), value_str);
+    }
+
+    return 0;
+}
+
+// 지연 값 표시 (us → "850 us", "12.3 ms", "1.20 s")
+static void format_latency(uint64_t us, char *buf, size_t size) {
+    if (us < 1000) {
+        snprintf(buf, size, "%lu us", us);
+    } else if (us < 1000000) {
+        snprintf(buf, size, "%.1f ms", us / 1000.0);
+    } else {
+        snprintf(buf, size, "%.2f s", us / 1000000.0);
+    }
+}
+
+// queries 명령 (프로토콜 모드 쿼리 지연 히스토그램)
+static int cmd_queries(const char *socket_path, bool reset) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = reset ? CMD_QUERY_RESET : CMD_QUERY_STATS;
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    const QueryStats *stats = &resp.queries;
+    if (reset) {
+        printf("%s\n", resp.message);
+        return 0;
+    }
+    if (stats->count == 0) {
+        printf("기록된 쿼리가 없습니다 (프로토콜 모드: -m mysql, -m http).\n");
+        return 0;
+    }
+
+    char mean[16], p50[16], p90[16], p99[16], max[16];
+    format_latency(stats->sum_us / stats->count, mean, sizeof(mean));
+    format_latency(latency_percentile(stats, 50), p50, sizeof(p50));
+    format_latency(latency_percentile(stats, 90), p90, sizeof(p90));
+    format_latency(latency_percentile(stats, 99), p99, sizeof(p99));
+    format_latency(stats->max_us, max, sizeof(max));
+
+    printf("\n=== 쿼리 응답 지연 ===\n\n");
+    printf("쿼리: %lu (서버 오류 %lu, 주입 오류 %lu)\n", stats->count, stats->errors, stats->injected);
+    printf("평균 %s  p50 %s  p90 %s  p99 %s  최대 %s\n", mean, p50, p90, p99, max);
+
+    // HTTP 응답 코드 종류 (MySQL 모드에서는 모두 0)
+    uint64_t status_total = 0;
+    for (int i = 0; i < 6; i++) {
+        status_total += stats->status[i];
+    }
+    if (status_total > 0) {
+        printf("응답 코드:");
+        for (int i = 1; i < 6; i++) {
+            printf("  %dxx %lu", i, stats->status[i]);
+        }
+        if (stats->status[0] > 0) {
+            printf("  기타 %lu", stats->status[0]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+
+    uint64_t peak = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (stats->buckets[i] > peak) peak = stats->buckets[i];
+    }
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (stats->buckets[i] == 0) continue;
+        char upper[16];
+        format_latency((2ULL << i) - 1, upper, sizeof(upper));
+        int bar = (int)(stats->buckets[i] * 40 / peak);
+        printf("  < %-10s %10lu  %.*s\n", upper, stats->buckets[i], bar > 0 ? bar : 1,
+               "########################################");
+    }
 
     return 0;
 }
@@ -279,24 +1038,224 @@ static int cmd_shutdown(const char *socket_path) {
     }
 }
 
+// capture 명령
+static int cmd_capture(const char *socket_path) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = CMD_CAPTURE_STATUS;
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    const CaptureStatus *cap = &resp.capture;
+    char bytes_str[16], dropped_str[16], file_str[16], used_str[16], size_str[16];
+    format_bytes(cap->bytes, bytes_str, sizeof(bytes_str));
+    format_bytes(cap->dropped_bytes, dropped_str, sizeof(dropped_str));
+    format_bytes(cap->file_bytes, file_str, sizeof(file_str));
+    format_bytes(cap->ring_used, used_str, sizeof(used_str));
+    format_bytes(cap->ring_size, size_str, sizeof(size_str));
+
+    printf("\n=== 트래픽 캡처 ===\n\n");
+    printf("파일: %s (%s, 패킷 %lu개)\n", cap->path, file_str, cap->written_packets);
+    printf("선택자: %s\n", cap->selector[0] ? cap->selector : "모든 연결");
+    printf("캡처한 연결: %lu\n", cap->sessions);
+    printf("기록: %lu 레코드, %s\n", cap->packets, bytes_str);
+    printf("버림 (링 가득 참): %lu 레코드, %s\n", cap->dropped, dropped_str);
+    printf("링 사용: %s / %s\n", used_str, size_str);
+    if (cap->abandoned > 0) {
+        printf("게시되지 않아 건너뜀: %lu 레코드 (기록 중 종료/정지된 자식)\n", cap->abandoned);
+    }
+    if (cap->write_errors > 0) {
+        printf("파일 쓰기 실패: %lu회\n", cap->write_errors);
+    }
+
+    return 0;
+}
+
+// mirror 명령
+static int cmd_mirror(const char *socket_path) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = CMD_MIRROR_STATUS;
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    const MirrorStatus *mir = &resp.mirror;
+    char bytes_str[16], dropped_str[16], discarded_str[16];
+    format_bytes(mir->bytes, bytes_str, sizeof(bytes_str));
+    format_bytes(mir->dropped_bytes, dropped_str, sizeof(dropped_str));
+    format_bytes(mir->discarded_bytes, discarded_str, sizeof(discarded_str));
+
+    printf("\n=== 섀도 미러링 ===\n\n");
+    printf("섀도 백엔드: %s:%d\n", mir->host, mir->port);
+    printf("선택자: %s\n", mir->selector[0] ? mir->selector : "모든 연결");
+    printf("미러링한 연결: %lu (연결 실패 %lu, 큐가 넘쳐 중단 %lu)\n",
+           mir->sessions, mir->connect_failed, mir->overflowed);
+    printf("보냄: %s\n", bytes_str);
+    printf("버림: %s\n", dropped_str);
+    printf("섀도 응답 (읽고 버림): %s\n", discarded_str);
+
+    return 0;
+}
+
+// udp 명령
+static int cmd_udp(const char *socket_path) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = CMD_UDP_STATUS;
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    const UdpStatus *udp = &resp.udp;
+    static const char *names[FILTER_DIR_COUNT] = { "클라이언트 → 서버", "서버 → 클라이언트" };
+
+    printf("\n=== UDP 모드 ===\n\n");
+    printf("세션: %lu / %d (생성 %lu, 만료 %lu, 거부 %lu), 유휴 %d초 후 만료\n",
+           udp->sessions_active, udp->max_sessions, udp->sessions_created,
+           udp->sessions_expired, udp->sessions_rejected, udp->idle_sec);
+    printf("GSO/GRO: %s\n", udp->gso ? "사용" : "사용 안 함");
+    for (int d = 0; d < FILTER_DIR_COUNT; d++) {
+        char bytes_str[16];
+        format_bytes(udp->bytes[d], bytes_str, sizeof(bytes_str));
+        printf("%s: 받음 %lu (%s), 보냄 %lu, 드롭 %lu, 송신 실패 %lu\n", names[d],
+               udp->datagrams[d], bytes_str, udp->sent[d], udp->dropped[d], udp->send_errors[d]);
+    }
+    printf("보류 중 (지연/쓰로틀): %lu\n", udp->delayed);
+    uint64_t received = udp->datagrams[0] + udp->datagrams[1];
+    uint64_t sent = udp->sent[0] + udp->sent[1];
+    printf("시스템 호출: recvmmsg %lu회 (%.1f개/회), sendmmsg %lu회 (%.1f개/회)\n",
+           udp->recv_calls, udp->recv_calls ? (double)received / udp->recv_calls : 0.0,
+           udp->send_calls, udp->send_calls ? (double)sent / udp->send_calls : 0.0);
+
+    return 0;
+}
+
+static const char *protocol_name(int protocol) {
+    switch (protocol) {
+        case PROTOCOL_MYSQL: return "mysql";
+        case PROTOCOL_HTTP: return "http";
+        default: return "raw";
+    }
+}
+
+// listeners 명령
+static int cmd_listeners(const char *socket_path) {
+    ControlRequest req = {0};
+    ControlResponse resp = {0};
+
+    req.cmd = CMD_LISTENERS;
+
+    if (send_control_request(socket_path, &req, &resp) < 0) {
+        return 1;
+    }
+
+    if (!resp.success) {
+        fprintf(stderr, "실패: %s\n", resp.message);
+        return 1;
+    }
+
+    printf("\n리스너 %d개:\n\n", resp.listener_count);
+    printf("%-12s %-24s %-28s %-6s %-8s %-10s %-10s %-10s %-8s %s\n",
+           "이름", "리스닝", "대상 서버", "모드", "활성", "누적 연결", "업로드", "다운로드", "드롭", "연결 실패");
+    printf("========================================================================================================================\n");
+
+    for (int i = 0; i < resp.listener_count; i++) {
+        const ListenerStats *l = &resp.listeners[i];
+        char target_str[160];
+        if (l->sni_route_count > 0) {
+            snprintf(target_str, sizeof(target_str), "%s (+SNI %d)", l->target, l->sni_route_count);
+        } else {
+            snprintf(target_str, sizeof(target_str), "%s", l->target);
+        }
+
+        char upload_str[16], download_str[16];
+        format_bytes(l->client_to_server_bytes, upload_str, sizeof(upload_str));
+        format_bytes(l->server_to_client_bytes, download_str, sizeof(download_str));
+
+        printf("%-12s %-24s %-28s %-6s %-8lu %-10lu %-10s %-10s %-8lu %lu\n",
+               l->name, l->listen, target_str, protocol_name(l->protocol),
+               l->connections_opened - l->connections_closed, l->connections_opened,
+               upload_str, download_str, l->packets_dropped, l->connect_errors);
+    }
+
+    return 0;
+}
+
 // 사용법 출력
 static void print_usage(const char *program_name) {
     printf("사용법: %s [옵션] <명령> [인자...]\n\n", program_name);
     printf("옵션:\n");
     printf("  -s <socket>    제어 소켓 경로 (기본값: %s)\n\n", DEFAULT_SOCKET_PATH);
     printf("명령어:\n");
-    printf("  list, ls                      활성 연결 목록 조회\n");
+    printf("  list, ls [리스너]             활성 연결 목록 조회 (리스너 이름을 주면 그 리스너만)\n");
+    printf("  listeners                     리스너별 주소와 누적 연결/트래픽\n");
     printf("  kill <PID>                    특정 연결 종료\n");
     printf("  signal <PID> <SIGNAL>         특정 연결에 시그널 전송\n");
+    printf("  kill-all <선택자> [rst] [dry-run] 선택자에 맞는 모든 연결 종료 (기본 FIN, rst = RST)\n");
+    printf("  signal-all <SIGNAL> <선택자> [dry-run] 선택자에 맞는 모든 연결에 시그널 전송\n");
+    printf("                                선택자: idle=<초|5m> bytes>N bytes<N client=<CIDR> target=<host:port>\n");
+    printf("                                        ports=<a-b> conn=<ID> pid=<PID> percent=<0~100> listener=<이름> all\n");
     printf("  stats                         통계 정보 조회\n");
+    printf("  top [N] [1|10|60]             현재 처리량 상위 N개 연결 (기본: 10개, 10초)\n");
+    printf("  history [sec|min] [N]         최근 처리량 이력 조회 (기본: 초 단위 30개)\n");
+    printf("  flight <PID>                  연결의 최근 이벤트 기록 조회\n");
+    printf("  filter list                   런타임 필터 테이블 조회\n");
+    printf("  filter add <명세>             필터 추가 (delay=<ms>, drop=<0~1>, throttle=<bytes/s>)\n");
+    printf("                                선택자: client=<CIDR> ports=<a-b> conn=<ID> pid=<PID> percent=<0~100>\n");
+    printf("                                        listener=<이름>\n");
+    printf("  filter remove <인덱스>        필터 제거\n");
+    printf("  filter enable|disable <인덱스> 필터 활성화/비활성화\n");
+    printf("  filter clear                  모든 필터 제거\n");
+    printf("  flight id <ID>                연결 ID로 이벤트 기록 조회\n");
+    printf("  scenario start <파일>         고장 시나리오 실행 (진행 중인 것은 교체)\n");
+    printf("  scenario stop                 시나리오 중단 (필터 테이블은 그대로)\n");
+    printf("  scenario [status]             시나리오 진행 상황\n");
+    printf("  queries [reset]               쿼리/요청 응답 지연 히스토그램 (-m mysql, -m http)\n");
+    printf("  capture                       트래픽 캡처 상태 (-w <file>)\n");
+    printf("  mirror                        섀도 미러링 상태 (-M <host:port>)\n");
+    printf("  udp                           UDP 모드 세션/데이터그램 상태 (-u)\n");
     printf("  shutdown                      프록시 서버 종료\n\n");
     printf("시그널:\n");
     printf("  TERM, KILL, STOP, CONT, HUP, USR1, USR2\n\n");
     printf("예시:\n");
     printf("  %s list\n", program_name);
+    printf("  %s listeners\n", program_name);
     printf("  %s kill 12345\n", program_name);
     printf("  %s signal 12345 STOP\n", program_name);
+    printf("  %s kill-all idle=300 bytes<1K\n", program_name);
+    printf("  %s kill-all target=:3306 client=10.0.0.0/8 rst\n", program_name);
     printf("  %s stats\n", program_name);
+    printf("  %s top 20 1\n", program_name);
+    printf("  %s history min 10\n", program_name);
+    printf("  %s flight id 42\n", program_name);
+    printf("  %s filter add delay=100\n", program_name);
+    printf("  %s filter add drop=0.1 client=10.0.0.0/8 percent=20\n", program_name);
+    printf("  %s filter add delay=200 listener=db\n", program_name);
+    printf("  %s filter add myerror=1213 query=UPDATE percent=5\n", program_name);
+    printf("  %s filter add httperror=503 query=POST%%20/orders percent=10\n", program_name);
 }
 
 int main(int argc, char *argv[]) {
@@ -328,7 +1287,9 @@ int main(int argc, char *argv[]) {
     const char *command = argv[optind];
 
     if (strcmp(command, "list") == 0 || strcmp(command, "ls") == 0) {
-        return cmd_list(socket_path);
+        return cmd_list(socket_path, optind + 1 < argc ? argv[optind + 1] : NULL);
+    } else if (strcmp(command, "listeners") == 0) {
+        return cmd_listeners(socket_path);
     } else if (strcmp(command, "kill") == 0) {
         if (optind + 1 >= argc) {
             fprintf(stderr, "오류: PID가 필요합니다.\n");
@@ -355,8 +1316,184 @@ int main(int argc, char *argv[]) {
             return 1;
         }
         return cmd_signal(socket_path, (pid_t)pid, argv[optind + 2]);
+    } else if (strcmp(command, "kill-all") == 0 || strcmp(command, "signal-all") == 0) {
+        bool is_kill = strcmp(command, "kill-all") == 0;
+        int arg_index = optind + 1;
+        int sig_num = SIGTERM;
+
+        if (!is_kill) {
+            if (arg_index >= argc || (sig_num = parse_signal(argv[arg_index])) < 0) {
+                fprintf(stderr, "오류: 시그널이 필요합니다 (TERM, KILL, STOP, CONT, HUP, USR1, USR2).\n");
+                fprintf(stderr, "사용법: %s signal-all <SIGNAL> <선택자...> [dry-run]\n", argv[0]);
+                return 1;
+            }
+            arg_index++;
+        }
+
+        // 나머지 인자는 선택자 (rst, fin, dry-run은 동작 옵션)
+        char selector[MAX_FILTER_SPEC_LEN] = {0};
+        bool abortive = false;
+        bool dry_run = false;
+        for (int i = arg_index; i < argc; i++) {
+            if (is_kill && (strcmp(argv[i], "rst") == 0 || strcmp(argv[i], "fin") == 0)) {
+                abortive = strcmp(argv[i], "rst") == 0;
+                continue;
+            }
+            if (strcmp(argv[i], "dry-run") == 0) {
+                dry_run = true;
+                continue;
+            }
+            if (strlen(selector) + strlen(argv[i]) + 2 > sizeof(selector)) {
+                fprintf(stderr, "오류: 선택자가 너무 깁니다.\n");
+                return 1;
+            }
+            if (selector[0] != '\0') strcat(selector, " ");
+            strcat(selector, argv[i]);
+        }
+        if (selector[0] == '\0') {
+            fprintf(stderr, "오류: 선택자가 필요합니다 (모든 연결은 all).\n");
+            fprintf(stderr, "사용법: %s %s <선택자...>\n", argv[0], command);
+            return 1;
+        }
+        return cmd_bulk(socket_path, is_kill ? CMD_KILL_MATCHING : CMD_SIGNAL_MATCHING,
+                        sig_num, selector, abortive, dry_run);
     } else if (strcmp(command, "stats") == 0) {
         return cmd_stats(socket_path);
+    } else if (strcmp(command, "top") == 0) {
+        int count = 10;
+        int window_sec = 10;
+        for (int i = 0; i < 2 && optind + 1 + i < argc; i++) {
+            const char *arg = argv[optind + 1 + i];
+            char *endptr;
+            long value = strtol(arg, &endptr, 10);
+            if (*endptr != '\0' || value <= 0) {
+                fprintf(stderr, "오류: 잘못된 값: %s\n", arg);
+                return 1;
+            }
+            if (i == 0) {
+                count = (int)value;
+            } else if (value == 1 || value == 10 || value == 60) {
+                window_sec = (int)value;
+            } else {
+                fprintf(stderr, "오류: 창은 1, 10, 60초 중 하나여야 합니다: %s\n", arg);
+                return 1;
+            }
+        }
+        return cmd_top(socket_path, count, window_sec);
+    } else if (strcmp(command, "history") == 0) {
+        int interval_sec = 1;
+        int count = 30;
+        int arg_index = optind + 1;
+        if (arg_index < argc && (strcmp(argv[arg_index], "min") == 0 ||
+                                 strcmp(argv[arg_index], "sec") == 0)) {
+            interval_sec = strcmp(argv[arg_index], "min") == 0 ? 60 : 1;
+            arg_index++;
+        }
+        if (arg_index < argc) {
+            char *endptr;
+            long value = strtol(argv[arg_index], &endptr, 10);
+            if (*endptr != '\0' || value <= 0) {
+                fprintf(stderr, "오류: 잘못된 개수: %s\n", argv[arg_index]);
+                return 1;
+            }
+            count = (int)value;
+        }
+        return cmd_history(socket_path, interval_sec, count);
+    } else if (strcmp(command, "flight") == 0) {
+        bool by_id = optind + 2 < argc && strcmp(argv[optind + 1], "id") == 0;
+        int arg_index = by_id ? optind + 2 : optind + 1;
+        if (arg_index >= argc) {
+            fprintf(stderr, "오류: PID 또는 연결 ID가 필요합니다.\n");
+            fprintf(stderr, "사용법: %s flight <PID> | flight id <ID>\n", argv[0]);
+            return 1;
+        }
+        char *endptr;
+        long long value = strtoll(argv[arg_index], &endptr, 10);
+        if (*endptr != '\0' || value <= 0) {
+            fprintf(stderr, "오류: 잘못된 값: %s\n", argv[arg_index]);
+            return 1;
+        }
+        if (by_id) {
+            return cmd_flight(socket_path, 0, (uint64_t)value);
+        }
+        return cmd_flight(socket_path, (pid_t)value, 0);
+    } else if (strcmp(command, "filter") == 0) {
+        const char *sub = optind + 1 < argc ? argv[optind + 1] : "list";
+
+        if (strcmp(sub, "list") == 0 || strcmp(sub, "ls") == 0) {
+            return cmd_filter(socket_path, CMD_FILTER_LIST, 0, NULL);
+        } else if (strcmp(sub, "clear") == 0) {
+            return cmd_filter(socket_path, CMD_FILTER_CLEAR, 0, NULL);
+        } else if (strcmp(sub, "add") == 0) {
+            if (optind + 2 >= argc) {
+                fprintf(stderr, "사용법: %s filter add <명세>\n", argv[0]);
+                return 1;
+            }
+            // 나머지 인자를 공백으로 이어 하나의 명세로 전달
+            char spec[MAX_FILTER_SPEC_LEN] = {0};
+            for (int i = optind + 2; i < argc; i++) {
+                if (strlen(spec) + strlen(argv[i]) + 2 > sizeof(spec)) {
+                    fprintf(stderr, "오류: 필터 명세가 너무 깁니다.\n");
+                    return 1;
+                }
+                if (spec[0] != '\0') strcat(spec, " ");
+                strcat(spec, argv[i]);
+            }
+            return cmd_filter(socket_path, CMD_FILTER_ADD, 0, spec);
+        }
+
+        ControlCommand cmd;
+        if (strcmp(sub, "remove") == 0 || strcmp(sub, "rm") == 0) {
+            cmd = CMD_FILTER_REMOVE;
+        } else if (strcmp(sub, "enable") == 0) {
+            cmd = CMD_FILTER_ENABLE;
+        } else if (strcmp(sub, "disable") == 0) {
+            cmd = CMD_FILTER_DISABLE;
+        } else {
+            fprintf(stderr, "오류: 알 수 없는 filter 명령: %s\n", sub);
+            return 1;
+        }
+
+        if (optind + 2 >= argc) {
+            fprintf(stderr, "사용법: %s filter %s <인덱스>\n", argv[0], sub);
+            return 1;
+        }
+        char *endptr;
+        long index = strtol(argv[optind + 2], &endptr, 10);
+        if (*endptr != '\0' || index < 0) {
+            fprintf(stderr, "오류: 잘못된 인덱스: %s\n", argv[optind + 2]);
+            return 1;
+        }
+        return cmd_filter(socket_path, cmd, (int)index, NULL);
+    } else if (strcmp(command, "scenario") == 0) {
+        const char *sub = optind + 1 < argc ? argv[optind + 1] : "status";
+
+        if (strcmp(sub, "status") == 0) {
+            return cmd_scenario(socket_path, CMD_SCENARIO_STATUS, NULL);
+        } else if (strcmp(sub, "stop") == 0) {
+            return cmd_scenario(socket_path, CMD_SCENARIO_STOP, NULL);
+        } else if (strcmp(sub, "start") == 0) {
+            if (optind + 2 >= argc) {
+                fprintf(stderr, "사용법: %s scenario start <파일>\n", argv[0]);
+                return 1;
+            }
+            return cmd_scenario(socket_path, CMD_SCENARIO_START, argv[optind + 2]);
+        }
+        fprintf(stderr, "오류: 알 수 없는 scenario 명령: %s\n", sub);
+        return 1;
+    } else if (strcmp(command, "queries") == 0) {
+        bool reset = optind + 1 < argc && strcmp(argv[optind + 1], "reset") == 0;
+        if (optind + 1 < argc && !reset) {
+            fprintf(stderr, "사용법: %s queries [reset]\n", argv[0]);
+            return 1;
+        }
+        return cmd_queries(socket_path, reset);
+    } else if (strcmp(command, "capture") == 0) {
+        return cmd_capture(socket_path);
+    } else if (strcmp(command, "mirror") == 0) {
+        return cmd_mirror(socket_path);
+    } else if (strcmp(command, "udp") == 0) {
+        return cmd_udp(socket_path);
     } else if (strcmp(command, "shutdown") == 0) {
         return cmd_shutdown(socket_path);
     } else {
@@ -0,0 +1,367 @@
+#include "../include/proxyproto.h"
+#include "../include/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+static const uint8_t v2_signature[12] = {
+    0x0D, 0x0A, 0x0D, 0x0A, 0x00, 0x0D, 0x0A, 0x51, 0x55, 0x49, 0x54, 0x0A
+};
+
+#define V2_VERSION 0x20
+#define V2_CMD_LOCAL 0x00
+#define V2_CMD_PROXY 0x01
+#define V2_FAM_TCP4 0x11
+#define V2_FAM_UDP4 0x12
+#define V2_FAM_TCP6 0x21
+#define V2_FAM_UDP6 0x22
+
+// 10진수 포트 (0~65535) - 실패 시 -1
+static int parse_port(const char *text, size_t len) {
+    if (len == 0 || len > 5) return -1;
+    int port = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] < '0' || text[i] > '9') return -1;
+        port = port * 10 + (text[i] - '0');
+    }
+    return port <= 65535 ? port : -1;
+}
+
+// 주소 토큰을 검증하고 복사 (inet_pton으로 형식 확인)
+static bool copy_addr(int family, const char *text, size_t len, char *out) {
+    if (len == 0 || len >= MAX_ADDR_LEN) return false;
+    memcpy(out, text, len);
+    out[len] = '\0';
+
+    uint8_t raw[sizeof(struct in6_addr)];
+    return inet_pton(family, out, raw) == 1;
+}
+
+// "PROXY TCP4 <src> <dst> <sport> <dport>\r\n" 또는 "PROXY UNKNOWN ...\r\n"
+static int parse_v1(const uint8_t *data, int length, ProxyHeader *header) {
+    const char *text = (const char *)data;
+    int limit = length < PROXY_V1_MAX ? length : PROXY_V1_MAX;
+
+    int end = -1;
+    for (int i = 0; i + 1 < limit; i++) {
+        if (text[i] == '\r' && text[i + 1] == '\n') {
+            end = i;
+            break;
+        }
+    }
+    if (end < 0) {
+        return length >= PROXY_V1_MAX ? -1 : 0;
+    }
+
+    header->version = 1;
+    header->family = AF_UNSPEC;
+
+    // 공백으로 나눈 토큰 (최대 6개)
+    const char *tokens[6];
+    size_t lens[6];
+    int count = 0;
+    int pos = 0;
+    while (pos < end && count < 6) {
+        int start = pos;
+        while (pos < end && text[pos] != ' ') pos++;
+        tokens[count] = text + start;
+        lens[count] = pos - start;
+        count++;
+        if (pos < end) pos++;
+    }
+
+    if (count >= 2 && lens[1] == 7 && memcmp(tokens[1], "UNKNOWN", 7) == 0) {
+        return end + 2;  // 나머지는 무시
+    }
+    if (count != 6 || pos != end || lens[1] != 4) {
+        return -1;
+    }
+
+    int family;
+    if (memcmp(tokens[1], "TCP4", 4) == 0) {
+        family = AF_INET;
+    } else if (memcmp(tokens[1], "TCP6", 4) == 0) {
+        family = AF_INET6;
+    } else {
+        return -1;
+    }
+
+    header->src_port = parse_port(tokens[4], lens[4]);
+    header->dst_port = parse_port(tokens[5], lens[5]);
+    if (!copy_addr(family, tokens[2], lens[2], header->src_addr) ||
+        !copy_addr(family, tokens[3], lens[3], header->dst_addr) ||
+        header->src_port < 0 || header->dst_port < 0) {
+        return -1;
+    }
+
+    header->family = family;
+    return end + 2;
+}
+
+static int parse_v2(const uint8_t *data, int length, ProxyHeader *header) {
+    if (length < PROXY_V2_HEADER_LEN) {
+        return 0;
+    }
+
+    uint8_t ver_cmd = data[12];
+    uint8_t fam = data[13];
+    int addr_len = (data[14] << 8) | data[15];
+    int total = PROXY_V2_HEADER_LEN + addr_len;
+
+    if ((ver_cmd & 0xF0) != V2_VERSION) {
+        return -1;
+    }
+
+    header->version = 2;
+    header->family = AF_UNSPEC;
+
+    // LOCAL (로드밸런서 자체의 상태 확인 등) 또는 TCP/UDP가 아닌 주소: 소켓 주소 사용
+    if ((ver_cmd & 0x0F) == V2_CMD_LOCAL) {
+        return total;
+    }
+    if ((ver_cmd & 0x0F) != V2_CMD_PROXY) {
+        return -1;
+    }
+
+    int need;
+    int family;
+    if (fam == V2_FAM_TCP4 || fam == V2_FAM_UDP4) {
+        family = AF_INET;
+        need = 12;
+    } else if (fam == V2_FAM_TCP6 || fam == V2_FAM_UDP6) {
+        family = AF_INET6;
+        need = 36;
+    } else {
+        return total;
+    }
+
+    if (addr_len < need) {
+        return -1;
+    }
+    if (length < PROXY_V2_HEADER_LEN + need) {
+        return 0;
+    }
+
+    // 주소 뒤의 TLV는 해석하지 않음 (헤더 길이만큼 함께 버림)
+    const uint8_t *addr = data + PROXY_V2_HEADER_LEN;
+    int alen = family == AF_INET ? 4 : 16;
+    if (inet_ntop(family, addr, header->src_addr, MAX_ADDR_LEN) == NULL ||
+        inet_ntop(family, addr + alen, header->dst_addr, MAX_ADDR_LEN) == NULL) {
+        return -1;
+    }
+    header->src_port = (addr[2 * alen] << 8) | addr[2 * alen + 1];
+    header->dst_port = (addr[2 * alen + 2] << 8) | addr[2 * alen + 3];
+    header->family = family;
+    return total;
+}
+
+int proxyproto_parse(const uint8_t *data, int length, ProxyHeader *header) {
+    memset(header, 0, sizeof(ProxyHeader));
+
+    // 서명이 다 오기 전에도 맞지 않는 바이트가 있으면 바로 판단
+    int n = length < (int)sizeof(v2_signature) ? length : (int)sizeof(v2_signature);
+    if (n > 0 && memcmp(data, v2_signature, n) == 0) {
+        return n < (int)sizeof(v2_signature) ? 0 : parse_v2(data, length, header);
+    }
+
+    n = length < 6 ? length : 6;
+    if (n > 0 && memcmp(data, "PROXY ", n) == 0) {
+        return n < 6 ? 0 : parse_v1(data, length, header);
+    }
+
+    return -1;
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// 데이터가 올 때까지 대기 (마감이 지나면 false)
+static bool wait_readable(int fd, uint64_t deadline) {
+    while (1) {
+        int64_t remaining = (int64_t)(deadline - monotonic_ms());
+        if (remaining <= 0) {
+            return false;
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+        int ready = poll(&pfd, 1, (int)remaining);
+        if (ready > 0) {
+            return true;
+        }
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+bool proxyproto_read(int fd, int timeout_ms, ProxyHeader *header) {
+    uint8_t buf[PROXY_V2_HEADER_LEN + PROXY_V2_ADDR_MAX];
+    uint64_t deadline = monotonic_ms() + timeout_ms;
+    ssize_t peeked = 0;
+    int lowat = 1;
+    int total = 0;
+
+    // 헤더 길이를 알 수 있을 만큼 엿봄 (모자라면 SO_RCVLOWAT로 더 쌓일 때까지 대기)
+    while (total == 0) {
+        if (!wait_readable(fd, deadline)) {
+            LOG_ERROR("PROXY 헤더 대기 시간 초과 (%zd바이트 수신)", peeked);
+            break;
+        }
+
+        ssize_t n = recv(fd, buf, sizeof(buf), MSG_PEEK);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("PROXY 헤더 엿보기 실패: %s", strerror(errno));
+            break;
+        }
+        if (n == 0 || n == peeked) {
+            LOG_ERROR("PROXY 헤더 전에 클라이언트가 연결을 닫음");
+            break;
+        }
+
+        total = proxyproto_parse(buf, (int)n, header);
+        if (total < 0) {
+            LOG_ERROR("PROXY 헤더가 아닙니다 (PROXY 프로토콜 수신이 켜져 있음)");
+            break;
+        }
+        if (total == 0 && (size_t)n >= sizeof(buf)) {
+            LOG_ERROR("PROXY 헤더가 너무 깁니다");
+            total = -1;
+            break;
+        }
+        peeked = n;
+
+        if (total == 0) {
+            lowat = (int)n + 1;
+            setsockopt(fd, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat));
+        }
+    }
+
+    if (lowat != 1) {
+        lowat = 1;
+        setsockopt(fd, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat));
+    }
+    if (total <= 0) {
+        return false;
+    }
+
+    // 헤더 바이트만 소비 (v2 TLV가 버퍼보다 길면 나눠서 버림)
+    int left = total;
+    while (left > 0) {
+        int want = left < (int)sizeof(buf) ? left : (int)sizeof(buf);
+        ssize_t n = recv(fd, buf, want, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            n = 0;
+        } else if (n <= 0) {
+            LOG_ERROR("PROXY 헤더 읽기 실패: %s", n < 0 ? strerror(errno) : "연결 닫힘");
+            return false;
+        }
+        left -= (int)n;
+        if (left > 0 && !wait_readable(fd, deadline)) {
+            LOG_ERROR("PROXY 헤더 대기 시간 초과");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int proxyproto_build_v2(const char *src_addr, int src_port, const char *dst_addr, int dst_port,
+                        uint8_t *out) {
+    memcpy(out, v2_signature, sizeof(v2_signature));
+
+    struct in6_addr src6, dst6;
+    struct in_addr src4, dst4;
+    int addr_len;
+
+    if (inet_pton(AF_INET, src_addr, &src4) == 1 && inet_pton(AF_INET, dst_addr, &dst4) == 1) {
+        out[12] = V2_VERSION | V2_CMD_PROXY;
+        out[13] = V2_FAM_TCP4;
+        memcpy(out + 16, &src4, 4);
+        memcpy(out + 20, &dst4, 4);
+        addr_len = 12;
+    } else if (inet_pton(AF_INET6, src_addr, &src6) == 1 &&
+               inet_pton(AF_INET6, dst_addr, &dst6) == 1) {
+        out[12] = V2_VERSION | V2_CMD_PROXY;
+        out[13] = V2_FAM_TCP6;
+        memcpy(out + 16, &src6, 16);
+        memcpy(out + 32, &dst6, 16);
+        addr_len = 36;
+    } else {
+        // 주소 종류가 다르거나 IP가 아님: 받는 쪽이 소켓 주소를 쓰도록 LOCAL
+        out[12] = V2_VERSION | V2_CMD_LOCAL;
+        out[13] = 0x00;
+        out[14] = 0;
+        out[15] = 0;
+        return PROXY_V2_HEADER_LEN;
+    }
+
+    uint8_t *ports = out + PROXY_V2_HEADER_LEN + addr_len - 4;
+    ports[0] = (uint8_t)(src_port >> 8);
+    ports[1] = (uint8_t)src_port;
+    ports[2] = (uint8_t)(dst_port >> 8);
+    ports[3] = (uint8_t)dst_port;
+    out[14] = 0;
+    out[15] = (uint8_t)addr_len;
+    return PROXY_V2_HEADER_LEN + addr_len;
+}
+
+bool proxyproto_send_v2(int server_fd, int client_fd, const ProxyHeader *header,
+                        const char *client_addr, int client_port) {
+    char dst_addr[MAX_ADDR_LEN] = "";
+    int dst_port = 0;
+
+    if (header != NULL && header->family != AF_UNSPEC) {
+        strcpy(dst_addr, header->dst_addr);
+        dst_port = header->dst_port;
+    } else {
+        struct sockaddr_storage local;
+        socklen_t len = sizeof(local);
+        if (getsockname(client_fd, (struct sockaddr *)&local, &len) == 0) {
+            if (local.ss_family == AF_INET) {
+                struct sockaddr_in *sin = (struct sockaddr_in *)&local;
+                inet_ntop(AF_INET, &sin->sin_addr, dst_addr, sizeof(dst_addr));
+                dst_port = ntohs(sin->sin_port);
+            } else if (local.ss_family == AF_INET6) {
+                // 겸용 소켓의 IPv4 연결은 ::ffff:a.b.c.d로 보이므로 클라이언트 주소처럼 점 표기로
+                // (종류가 달라지면 LOCAL 헤더가 되어 대상이 실제 클라이언트를 모름)
+                struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&local;
+                if (IN6_IS_ADDR_V4MAPPED(&sin6->sin6_addr)) {
+                    inet_ntop(AF_INET, &sin6->sin6_addr.s6_addr[12], dst_addr, sizeof(dst_addr));
+                } else {
+                    inet_ntop(AF_INET6, &sin6->sin6_addr, dst_addr, sizeof(dst_addr));
+                }
+                dst_port = ntohs(sin6->sin6_port);
+            }
+        }
+    }
+
+    uint8_t out[PROXY_V2_MAX];
+    int length = proxyproto_build_v2(client_addr, client_port, dst_addr, dst_port, out);
+
+    int sent = 0;
+    while (sent < length) {
+        ssize_t n = send(server_fd, out + sent, length - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("PROXY 헤더 전송 실패: %s", strerror(errno));
+            return false;
+        }
+        sent += (int)n;
+    }
+
+    LOG_DEBUG("PROXY v2 헤더 전송: %s:%d -> %s:%d (%d바이트)",
+              client_addr, client_port, dst_addr, dst_port, length);
+    return true;
+}
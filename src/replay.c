@@ -0,0 +1,1128 @@
+// proxyreplay: 캡처한 TCP 세션의 클라이언트 → 서버 스트림을 대상에 다시 보내는 부하 생성기
+//
+// 입력은 tcp_proxy -w가 만든 pcapng (또는 tcpdump의 pcap/pcapng). 흐름마다 클라이언트가 보낸
+// 바이트를 "요청"(서버 응답 사이의 연속된 클라이언트 세그먼트) 단위로 묶고, 각 요청 앞뒤에 서버가
+// 보낸 바이트 수를 기억한다. 재생할 때 요청의 응답 시간은 요청을 다 보낸 시각부터 그 요청에 대한
+// 서버 바이트가 처음 도착한 시각(첫 바이트)과, 녹화 때와 같은 양을 다 받은 시각(완료)이다.
+//
+// 속도: 1 = 녹화 시각 그대로, 2 = 두 배 빠르게, 0 = 최대 속도 (앞 요청의 응답을 다 받으면 바로 다음
+// 요청). 모든 세션은 epoll 이벤트 루프 하나에서 논블로킹 소켓으로 동시에 돈다.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#define DEFAULT_CONCURRENCY 256
+#define DEFAULT_TIMEOUT_MS 5000
+#define FLOW_HASH_SIZE 4096
+#define MAX_INTERFACES 16
+#define RECV_BUFFER_SIZE 65536
+#define EPOLL_BATCH 256
+
+#define TCP_FLAG_FIN 0x01
+#define TCP_FLAG_SYN 0x02
+#define TCP_FLAG_RST 0x04
+#define TCP_FLAG_ACK 0x10
+
+// 요청 (응답 사이의 연속된 클라이언트 세그먼트)
+typedef struct {
+    uint64_t at_us;               // 흐름 시작 기준 녹화 시각
+    size_t offset;                // 흐름 데이터 안의 위치
+    size_t length;
+    uint64_t expect_before;       // 이 요청 전까지 서버가 보낸 누적 바이트
+    uint64_t expect_after;        // 이 요청의 응답까지 포함한 누적 바이트
+} ReplayStep;
+
+// 녹화된 흐름
+typedef struct {
+    uint8_t addr[2][16];          // [0] 클라이언트, [1] 서버 (IPv4는 ::ffff: 매핑)
+    uint16_t port[2];
+    bool client_known;            // SYN 또는 첫 payload로 클라이언트를 정함
+    uint32_t next_seq[2];         // 방향별 다음 순서 번호 (재전송 제거)
+    bool seq_valid[2];
+    uint64_t first_us;            // 흐름 첫 패킷 시각 (절대)
+    uint8_t *data;                // 클라이언트가 보낸 바이트
+    size_t data_len;
+    size_t data_cap;
+    ReplayStep *steps;
+    int step_count;
+    int step_cap;
+    uint64_t s2c_total;           // 서버가 보낸 전체 바이트
+    bool last_was_c2s;            // 직전 payload 방향 (요청 묶기)
+    int next;                     // 해시 체인
+} Flow;
+
+// 재생 중인 세션
+typedef enum {
+    SESSION_WAITING = 0,          // 시작 시각 대기
+    SESSION_CONNECTING,
+    SESSION_RUNNING,
+    SESSION_DONE
+} SessionState;
+
+typedef struct {
+    const Flow *flow;
+    SessionState state;
+    int fd;
+    uint64_t start_us;            // 예정 시작 시각 (재생 시계)
+    uint64_t connect_us;          // connect() 호출 시각
+    int step;                     // 다음에 보낼 요청
+    size_t step_sent;             // 그 요청에서 이미 보낸 바이트
+    uint64_t *sent_us;            // 요청별 전송 완료 시각
+    int first_pending;            // 첫 바이트를 기다리는 가장 오래된 요청
+    int done_pending;             // 완료를 기다리는 가장 오래된 요청
+    uint64_t received;
+    uint64_t last_progress_us;
+    uint32_t events;              // epoll에 등록한 이벤트
+} Session;
+
+// 지연 표본 (끝나면 정렬해 정확한 백분위 계산)
+typedef struct {
+    uint64_t *values;
+    size_t count;
+    size_t cap;
+} Samples;
+
+typedef struct {
+    uint64_t sessions_done;
+    uint64_t connect_failed;
+    uint64_t closed_early;        // 요청을 다 보내기 전에 서버가 닫음
+    uint64_t timed_out;           // 응답을 기다리다 시간 초과
+    uint64_t requests;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    Samples connect;
+    Samples first_byte;
+    Samples complete;
+} ReplayReport;
+
+typedef struct {
+    const char *capture;
+    struct sockaddr_storage target;
+    socklen_t target_len;
+    char target_name[300];
+    double speed;                 // 0 = 최대 속도
+    int concurrency;
+    int loops;
+    int timeout_ms;
+    bool verbose;
+} ReplayOptions;
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void stop_handler(int signum) {
+    (void)signum;
+    g_stop = 1;
+}
+
+static uint64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// 바이트를 읽기 쉬운 형식으로 변환
+static void format_bytes(uint64_t bytes, char *buf, size_t size) {
+    if (bytes < 1024) {
+        snprintf(buf, size, "%lu B", bytes);
+    } else if (bytes < 1024 * 1024) {
+        snprintf(buf, size, "%.2f KB", bytes / 1024.0);
+    } else if (bytes < 1024 * 1024 * 1024) {
+        snprintf(buf, size, "%.2f MB", bytes / (1024.0 * 1024.0));
+    } else {
+        snprintf(buf, size, "%.2f GB", bytes / (1024.0 * 1024.0 * 1024.0));
+    }
+}
+
+// 마이크로초를 읽기 쉬운 형식으로
+static void format_latency(uint64_t us, char *buf, size_t size) {
+    if (us < 1000) {
+        snprintf(buf, size, "%lu us", us);
+    } else if (us < 1000000) {
+        snprintf(buf, size, "%.1f ms", us / 1000.0);
+    } else {
+        snprintf(buf, size, "%.2f s", us / 1000000.0);
+    }
+}
+
+static bool samples_add(Samples *samples, uint64_t value) {
+    if (samples->count == samples->cap) {
+        size_t cap = samples->cap ? samples->cap * 2 : 1024;
+        uint64_t *values = realloc(samples->values, cap * sizeof(uint64_t));
+        if (values == NULL) {
+            return false;
+        }
+        samples->values = values;
+        samples->cap = cap;
+    }
+    samples->values[samples->count++] = value;
+    return true;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : (x > y);
+}
+
+// ---- 캡처 파일 읽기 ----
+
+typedef struct {
+    Flow *flows;
+    int count;
+    int cap;
+    int buckets[FLOW_HASH_SIZE];
+    uint64_t packets;
+    uint64_t skipped;             // TCP가 아니거나 해석할 수 없는 패킷
+} FlowTable;
+
+static uint32_t flow_hash(const uint8_t *a, uint16_t pa, const uint8_t *b, uint16_t pb) {
+    // 방향과 무관하게 같은 값 (양쪽 해시를 더함)
+    uint32_t ha = 2166136261u, hb = 2166136261u;
+    for (int i = 0; i < 16; i++) {
+        ha = (ha ^ a[i]) * 16777619u;
+        hb = (hb ^ b[i]) * 16777619u;
+    }
+    ha = (ha ^ pa) * 16777619u;
+    hb = (hb ^ pb) * 16777619u;
+    return (ha + hb) % FLOW_HASH_SIZE;
+}
+
+// 흐름 찾기/만들기. *from_side에 보낸 쪽 (0 = addr[0] 쪽)
+static Flow *flow_lookup(FlowTable *table, const uint8_t *src, uint16_t sport,
+                         const uint8_t *dst, uint16_t dport, int *from_side) {
+    uint32_t h = flow_hash(src, sport, dst, dport);
+
+    for (int i = table->buckets[h]; i >= 0; i = table->flows[i].next) {
+        Flow *flow = &table->flows[i];
+        for (int side = 0; side < 2; side++) {
+            if (flow->port[side] == sport && flow->port[1 - side] == dport &&
+                memcmp(flow->addr[side], src, 16) == 0 && memcmp(flow->addr[1 - side], dst, 16) == 0) {
+                *from_side = side;
+                return flow;
+            }
+        }
+    }
+
+    if (table->count == table->cap) {
+        int cap = table->cap ? table->cap * 2 : 256;
+        Flow *flows = realloc(table->flows, cap * sizeof(Flow));
+        if (flows == NULL) {
+            return NULL;
+        }
+        table->flows = flows;
+        table->cap = cap;
+    }
+
+    Flow *flow = &table->flows[table->count];
+    memset(flow, 0, sizeof(Flow));
+    memcpy(flow->addr[0], src, 16);
+    memcpy(flow->addr[1], dst, 16);
+    flow->port[0] = sport;
+    flow->port[1] = dport;
+    flow->next = table->buckets[h];
+    table->buckets[h] = table->count++;
+    *from_side = 0;
+    return flow;
+}
+
+static bool flow_append(Flow *flow, const uint8_t *data, size_t length, uint64_t at_us) {
+    if (flow->data_len + length > flow->data_cap) {
+        size_t cap = flow->data_cap ? flow->data_cap : 4096;
+        while (cap < flow->data_len + length) cap *= 2;
+        uint8_t *buf = realloc(flow->data, cap);
+        if (buf == NULL) return false;
+        flow->data = buf;
+        flow->data_cap = cap;
+    }
+
+    // 응답이 끼어 있지 않으면 앞 요청에 이어 붙임
+    if (!flow->last_was_c2s || flow->step_count == 0) {
+        if (flow->step_count == flow->step_cap) {
+            int cap = flow->step_cap ? flow->step_cap * 2 : 16;
+            ReplayStep *steps = realloc(flow->steps, cap * sizeof(ReplayStep));
+            if (steps == NULL) return false;
+            flow->steps = steps;
+            flow->step_cap = cap;
+        }
+        ReplayStep *step = &flow->steps[flow->step_count++];
+        step->at_us = at_us;
+        step->offset = flow->data_len;
+        step->length = 0;
+        step->expect_before = flow->s2c_total;
+        step->expect_after = flow->s2c_total;
+    }
+
+    flow->steps[flow->step_count - 1].length += length;
+    memcpy(flow->data + flow->data_len, data, length);
+    flow->data_len += length;
+    flow->last_was_c2s = true;
+    return true;
+}
+
+// 재전송으로 이미 본 앞부분을 잘라냄 (순서 번호 비교는 2^32 순환 고려)
+static size_t trim_seen(Flow *flow, int dir, uint32_t seq, size_t length, size_t *skip) {
+    *skip = 0;
+    if (!flow->seq_valid[dir]) {
+        flow->seq_valid[dir] = true;
+        flow->next_seq[dir] = seq + (uint32_t)length;
+        return length;
+    }
+
+    int32_t behind = (int32_t)(flow->next_seq[dir] - seq);
+    if (behind > 0) {
+        if ((size_t)behind >= length) {
+            return 0;
+        }
+        *skip = (size_t)behind;
+        length -= *skip;
+    }
+    flow->next_seq[dir] = seq + (uint32_t)(*skip + length);
+    return length;
+}
+
+// IP 패킷 하나 처리
+static void handle_ip(FlowTable *table, const uint8_t *p, size_t length, uint64_t ts_us) {
+    uint8_t src[16] = {0}, dst[16] = {0};
+    const uint8_t *tcp;
+    size_t tcp_len;
+
+    if (length < 20) {
+        table->skipped++;
+        return;
+    }
+
+    if ((p[0] >> 4) == 4) {
+        size_t ihl = (p[0] & 0x0F) * 4;
+        size_t total = (p[2] << 8) | p[3];
+        if (p[9] != IPPROTO_TCP || ihl < 20 || total < ihl || total > length ||
+            ((p[6] & 0x3F) | p[7]) != 0) {  // 조각난 패킷은 건너뜀
+            table->skipped++;
+            return;
+        }
+        src[10] = src[11] = dst[10] = dst[11] = 0xff;
+        memcpy(src + 12, p + 12, 4);
+        memcpy(dst + 12, p + 16, 4);
+        tcp = p + ihl;
+        tcp_len = total - ihl;
+    } else if ((p[0] >> 4) == 6 && length >= 40) {
+        size_t payload = (p[4] << 8) | p[5];
+        if (p[6] != IPPROTO_TCP || 40 + payload > length) {
+            table->skipped++;  // 확장 헤더는 지원하지 않음
+            return;
+        }
+        memcpy(src, p + 8, 16);
+        memcpy(dst, p + 24, 16);
+        tcp = p + 40;
+        tcp_len = payload;
+    } else {
+        table->skipped++;
+        return;
+    }
+
+    if (tcp_len < 20) {
+        table->skipped++;
+        return;
+    }
+
+    uint16_t sport = (tcp[0] << 8) | tcp[1];
+    uint16_t dport = (tcp[2] << 8) | tcp[3];
+    uint32_t seq = ((uint32_t)tcp[4] << 24) | ((uint32_t)tcp[5] << 16) | ((uint32_t)tcp[6] << 8) | tcp[7];
+    size_t data_off = (tcp[12] >> 4) * 4;
+    uint8_t flags = tcp[13];
+    if (data_off < 20 || data_off > tcp_len) {
+        table->skipped++;
+        return;
+    }
+
+    int side;
+    Flow *flow = flow_lookup(table, src, sport, dst, dport, &side);
+    if (flow == NULL) {
+        return;
+    }
+    table->packets++;
+    if (flow->first_us == 0) {
+        flow->first_us = ts_us;
+    }
+
+    // 클라이언트 정하기: 순수 SYN을 보낸 쪽, 없으면 처음 payload를 보낸 쪽
+    size_t payload_len = tcp_len - data_off;
+    if (!flow->client_known && ((flags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == TCP_FLAG_SYN ||
+                                payload_len > 0)) {
+        if (side == 1) {
+            uint8_t addr[16];
+            memcpy(addr, flow->addr[0], 16);
+            memcpy(flow->addr[0], flow->addr[1], 16);
+            memcpy(flow->addr[1], addr, 16);
+            uint16_t port = flow->port[0];
+            flow->port[0] = flow->port[1];
+            flow->port[1] = port;
+            side = 0;
+        }
+        flow->client_known = true;
+    }
+
+    if (flags & TCP_FLAG_SYN) {
+        flow->seq_valid[side] = true;
+        flow->next_seq[side] = seq + 1;
+        return;
+    }
+    if (payload_len == 0 || !flow->client_known) {
+        return;
+    }
+
+    size_t skip;
+    size_t fresh = trim_seen(flow, side, seq, payload_len, &skip);
+    if (fresh == 0) {
+        return;
+    }
+
+    if (side == 0) {
+        flow_append(flow, tcp + data_off + skip, fresh, ts_us - flow->first_us);
+    } else {
+        flow->s2c_total += fresh;
+        flow->last_was_c2s = false;
+        if (flow->step_count > 0) {
+            flow->steps[flow->step_count - 1].expect_after = flow->s2c_total;
+        }
+    }
+}
+
+// 링크 계층 헤더를 벗기고 IP 패킷 처리
+static void handle_frame(FlowTable *table, int linktype, const uint8_t *p, size_t length, uint64_t ts_us) {
+    switch (linktype) {
+        case 1: {  // Ethernet (VLAN 태그 하나까지)
+            if (length < 14) break;
+            size_t off = 12;
+            uint16_t type = (p[off] << 8) | p[off + 1];
+            if (type == 0x8100 && length >= 18) {
+                off += 4;
+                type = (p[off] << 8) | p[off + 1];
+            }
+            if (type == 0x0800 || type == 0x86DD) {
+                handle_ip(table, p + off + 2, length - off - 2, ts_us);
+                return;
+            }
+            break;
+        }
+        case 113:  // Linux cooked (SLL)
+            if (length >= 16) {
+                handle_ip(table, p + 16, length - 16, ts_us);
+                return;
+            }
+            break;
+        case 101:  // RAW (tcp_proxy -w)
+        case 228:  // IPv4
+        case 229:  // IPv6
+            handle_ip(table, p, length, ts_us);
+            return;
+        default:
+            break;
+    }
+    table->skipped++;
+}
+
+static uint32_t rd32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+// pcapng (호스트 바이트 순서 섹션만)
+static bool load_pcapng(FlowTable *table, const uint8_t *data, size_t size) {
+    int linktypes[MAX_INTERFACES];
+    uint64_t units[MAX_INTERFACES];    // 초당 타임스탬프 단위
+    int iface_count = 0;
+    size_t pos = 0;
+
+    while (pos + 12 <= size) {
+        uint32_t type = rd32(data + pos);
+        uint32_t len = rd32(data + pos + 4);
+        if (len < 12 || len % 4 != 0 || pos + len > size) {
+            fprintf(stderr, "잘린 pcapng 블록 (위치 %zu)\n", pos);
+            return table->count > 0;
+        }
+        const uint8_t *body = data + pos + 8;
+        size_t body_len = len - 12;
+
+        if (type == 0x0A0D0D0A) {
+            if (body_len < 4 || rd32(body) != 0x1A2B3C4D) {
+                fprintf(stderr, "다른 바이트 순서의 pcapng는 지원하지 않습니다\n");
+                return false;
+            }
+            iface_count = 0;  // 섹션마다 인터페이스 번호를 새로 매김
+        } else if (type == 1 && body_len >= 8) {
+            if (iface_count < MAX_INTERFACES) {
+                linktypes[iface_count] = body[0] | (body[1] << 8);
+                units[iface_count] = 1000000;
+                // if_tsresol 옵션 (코드 9)
+                size_t opt = 8;
+                while (opt + 4 <= body_len) {
+                    uint16_t code = body[opt] | (body[opt + 1] << 8);
+                    uint16_t olen = body[opt + 2] | (body[opt + 3] << 8);
+                    if (code == 0 || opt + 4 + olen > body_len) break;
+                    if (code == 9 && olen >= 1) {
+                        uint8_t res = body[opt + 4];
+                        uint64_t unit = 1;
+                        for (int i = 0; i < (res & 0x7F) && unit < 1000000000000ULL; i++) {
+                            unit *= (res & 0x80) ? 2 : 10;
+                        }
+                        units[iface_count] = unit;
+                    }
+                    opt += 4 + ((olen + 3) & ~3u);
+                }
+            }
+            iface_count++;
+        } else if (type == 6 && body_len >= 20) {
+            uint32_t iface = rd32(body);
+            uint64_t ts = ((uint64_t)rd32(body + 4) << 32) | rd32(body + 8);
+            uint32_t caplen = rd32(body + 12);
+            if (iface < (uint32_t)iface_count && iface < MAX_INTERFACES &&
+                caplen <= body_len - 20) {
+                uint64_t ts_us = units[iface] == 1000000 ? ts :
+                                 (uint64_t)((double)ts * 1000000.0 / units[iface]);
+                handle_frame(table, linktypes[iface], body + 20, caplen, ts_us);
+            }
+        }
+        pos += len;
+    }
+    return true;
+}
+
+// 고전 pcap (마이크로초/나노초, 호스트 바이트 순서)
+static bool load_pcap(FlowTable *table, const uint8_t *data, size_t size) {
+    if (size < 24) return false;
+    uint32_t magic = rd32(data);
+    bool nano = magic == 0xA1B23C4D;
+    int linktype = (int)rd32(data + 20);
+    size_t pos = 24;
+
+    while (pos + 16 <= size) {
+        uint32_t sec = rd32(data + pos);
+        uint32_t frac = rd32(data + pos + 4);
+        uint32_t caplen = rd32(data + pos + 8);
+        if (pos + 16 + caplen > size) {
+            fprintf(stderr, "잘린 pcap 레코드 (위치 %zu)\n", pos);
+            break;
+        }
+        uint64_t ts_us = (uint64_t)sec * 1000000 + (nano ? frac / 1000 : frac);
+        handle_frame(table, linktype, data + pos + 16, caplen, ts_us);
+        pos += 16 + caplen;
+    }
+    return true;
+}
+
+static bool load_capture(const char *path, FlowTable *table) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "캡처 파일을 열 수 없습니다: %s (%s)\n", path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < 24) {
+        fprintf(stderr, "캡처 파일이 비었거나 읽을 수 없습니다: %s\n", path);
+        close(fd);
+        return false;
+    }
+
+    const uint8_t *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "mmap 실패: %s\n", strerror(errno));
+        return false;
+    }
+
+    memset(table->buckets, -1, sizeof(table->buckets));
+
+    bool ok;
+    uint32_t magic = rd32(data);
+    if (magic == 0x0A0D0D0A) {
+        ok = load_pcapng(table, data, st.st_size);
+    } else if (magic == 0xA1B2C3D4 || magic == 0xA1B23C4D) {
+        ok = load_pcap(table, data, st.st_size);
+    } else {
+        fprintf(stderr, "pcap/pcapng 파일이 아닙니다 (또는 다른 바이트 순서): %s\n", path);
+        ok = false;
+    }
+
+    munmap((void *)data, st.st_size);
+    return ok;
+}
+
+// ---- 재생 ----
+
+static bool parse_target(const char *text, ReplayOptions *opts) {
+    char host[256];
+    const char *colon = strrchr(text, ':');
+    if (colon == NULL || colon == text || (size_t)(colon - text) >= sizeof(host)) {
+        return false;
+    }
+    memcpy(host, text, colon - text);
+    host[colon - text] = '\0';
+
+    // [::1]:80 형식
+    char *h = host;
+    if (h[0] == '[' && h[strlen(h) - 1] == ']') {
+        h[strlen(h) - 1] = '\0';
+        h++;
+    }
+
+    struct addrinfo hints, *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    int ret = getaddrinfo(h, colon + 1, &hints, &result);
+    if (ret != 0) {
+        fprintf(stderr, "호스트를 찾을 수 없습니다: %s (%s)\n", text, gai_strerror(ret));
+        return false;
+    }
+    memcpy(&opts->target, result->ai_addr, result->ai_addrlen);
+    opts->target_len = result->ai_addrlen;
+    snprintf(opts->target_name, sizeof(opts->target_name), "%s", text);
+    freeaddrinfo(result);
+    return true;
+}
+
+static void session_set_events(int epfd, Session *s, uint32_t events) {
+    if (s->events == events) return;
+    struct epoll_event ev = { .events = events, .data.ptr = s };
+    epoll_ctl(epfd, EPOLL_CTL_MOD, s->fd, &ev);
+    s->events = events;
+}
+
+static void session_finish(int epfd, Session *s, ReplayReport *report, const char *reason,
+                           bool verbose) {
+    if (s->fd >= 0) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, s->fd, NULL);
+        close(s->fd);
+        s->fd = -1;
+    }
+    s->state = SESSION_DONE;
+    free(s->sent_us);
+    s->sent_us = NULL;
+
+    if (reason == NULL) {
+        report->sessions_done++;
+    }
+    if (verbose) {
+        char client[INET6_ADDRSTRLEN];
+        const uint8_t *addr = s->flow->addr[0];
+        bool mapped = addr[10] == 0xff && addr[11] == 0xff;
+        inet_ntop(mapped ? AF_INET : AF_INET6, mapped ? addr + 12 : addr, client, sizeof(client));
+        printf("세션 %s:%u: 요청 %d/%d, 받음 %lu/%lu바이트%s%s\n", client, s->flow->port[0],
+               s->step, s->flow->step_count, s->received, s->flow->s2c_total,
+               reason ? " - " : "", reason ? reason : "");
+    }
+}
+
+static bool session_start(int epfd, Session *s, const ReplayOptions *opts, ReplayReport *report,
+                          uint64_t now) {
+    s->fd = socket(opts->target.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (s->fd < 0) {
+        report->connect_failed++;
+        session_finish(epfd, s, report, "소켓 생성 실패", opts->verbose);
+        return false;
+    }
+    int one = 1;
+    setsockopt(s->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    s->sent_us = calloc(s->flow->step_count > 0 ? s->flow->step_count : 1, sizeof(uint64_t));
+    s->start_us = now;  // 동시 세션 제한으로 늦게 시작했으면 요청 시각도 함께 밀림
+    s->connect_us = now;
+    s->last_progress_us = now;
+    s->state = SESSION_CONNECTING;
+
+    if (connect(s->fd, (struct sockaddr *)&opts->target, opts->target_len) < 0 &&
+        errno != EINPROGRESS) {
+        report->connect_failed++;
+        session_finish(epfd, s, report, strerror(errno), opts->verbose);
+        return false;
+    }
+
+    struct epoll_event ev = { .events = EPOLLOUT, .data.ptr = s };
+    epoll_ctl(epfd, EPOLL_CTL_ADD, s->fd, &ev);
+    s->events = EPOLLOUT;
+    return true;
+}
+
+// 다음 요청을 보낼 수 있는 시각 (0 = 지금, UINT64_MAX = 응답을 기다림/보낼 것 없음)
+static uint64_t session_next_send(const Session *s, const ReplayOptions *opts) {
+    if (s->state != SESSION_RUNNING || s->step >= s->flow->step_count) {
+        return UINT64_MAX;
+    }
+    const ReplayStep *step = &s->flow->steps[s->step];
+    if (s->step_sent > 0) {
+        return 0;  // 보내던 요청의 나머지
+    }
+    if (opts->speed <= 0) {
+        return s->received >= step->expect_before ? 0 : UINT64_MAX;
+    }
+    return s->start_us + (uint64_t)(step->at_us / opts->speed);
+}
+
+// 받은 바이트로 응답 첫 바이트/완료 시각 기록
+static void session_account_recv(Session *s, ReplayReport *report, uint64_t now) {
+    const Flow *flow = s->flow;
+
+    while (s->first_pending < s->step) {
+        const ReplayStep *step = &flow->steps[s->first_pending];
+        if (step->expect_after == step->expect_before) {
+            s->first_pending++;  // 응답이 없던 요청
+            continue;
+        }
+        if (s->received <= step->expect_before) break;
+        samples_add(&report->first_byte, now - s->sent_us[s->first_pending]);
+        s->first_pending++;
+    }
+    while (s->done_pending < s->step) {
+        const ReplayStep *step = &flow->steps[s->done_pending];
+        if (step->expect_after == step->expect_before) {
+            s->done_pending++;
+            continue;
+        }
+        if (s->received < step->expect_after) break;
+        samples_add(&report->complete, now - s->sent_us[s->done_pending]);
+        s->done_pending++;
+    }
+}
+
+// 보낼 수 있는 만큼 보냄 (소켓 버퍼가 차면 EPOLLOUT 대기)
+static void session_send(int epfd, Session *s, const ReplayOptions *opts, ReplayReport *report,
+                         uint64_t now) {
+    const Flow *flow = s->flow;
+
+    while (session_next_send(s, opts) <= now) {
+        const ReplayStep *step = &flow->steps[s->step];
+        ssize_t n = send(s->fd, flow->data + step->offset + s->step_sent,
+                         step->length - s->step_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                session_set_events(epfd, s, EPOLLIN | EPOLLOUT);
+                return;
+            }
+            report->closed_early++;
+            session_finish(epfd, s, report, strerror(errno), opts->verbose);
+            return;
+        }
+        s->step_sent += n;
+        report->bytes_sent += n;
+        s->last_progress_us = now;
+
+        if (s->step_sent == step->length) {
+            s->sent_us[s->step] = monotonic_us();
+            s->step++;
+            s->step_sent = 0;
+            report->requests++;
+        }
+    }
+    session_set_events(epfd, s, EPOLLIN);
+}
+
+// 요청을 다 보냈고 녹화 때 받은 만큼 받았으면 끝
+static bool session_complete(const Session *s) {
+    return s->step >= s->flow->step_count && s->received >= s->flow->s2c_total;
+}
+
+static void session_event(int epfd, Session *s, uint32_t events, const ReplayOptions *opts,
+                          ReplayReport *report, uint8_t *buf) {
+    uint64_t now = monotonic_us();
+
+    if (s->state == SESSION_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(s->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0) {
+            report->connect_failed++;
+            session_finish(epfd, s, report, strerror(err), opts->verbose);
+            return;
+        }
+        samples_add(&report->connect, now - s->connect_us);
+        s->state = SESSION_RUNNING;
+        session_set_events(epfd, s, EPOLLIN);
+        session_send(epfd, s, opts, report, now);
+        return;
+    }
+
+    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        while (s->state == SESSION_RUNNING) {
+            ssize_t n = recv(s->fd, buf, RECV_BUFFER_SIZE, 0);
+            if (n > 0) {
+                s->received += n;
+                report->bytes_received += n;
+                s->last_progress_us = now;
+                session_account_recv(s, report, now);
+                if (n < RECV_BUFFER_SIZE) break;
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            // 서버가 닫음: 보낼 요청이 남았으면 비정상 종료
+            if (s->step < s->flow->step_count) {
+                report->closed_early++;
+                session_finish(epfd, s, report, n < 0 ? strerror(errno) : "서버가 먼저 닫음",
+                               opts->verbose);
+            } else {
+                session_finish(epfd, s, report, NULL, opts->verbose);
+            }
+            return;
+        }
+    }
+
+    if (s->state == SESSION_RUNNING) {
+        session_send(epfd, s, opts, report, now);
+    }
+    if (s->state == SESSION_RUNNING && session_complete(s)) {
+        session_finish(epfd, s, report, NULL, opts->verbose);
+    }
+}
+
+static int replay_run(const FlowTable *table, const ReplayOptions *opts, ReplayReport *report,
+                      uint64_t *elapsed_us) {
+    // 재생할 흐름 (클라이언트가 보낸 바이트가 있는 것만), 녹화 시작 순서
+    int flow_count = 0;
+    uint64_t base_us = UINT64_MAX, last_us = 0;
+    for (int i = 0; i < table->count; i++) {
+        const Flow *flow = &table->flows[i];
+        if (flow->step_count == 0) continue;
+        flow_count++;
+        if (flow->first_us < base_us) base_us = flow->first_us;
+        if (flow->first_us > last_us) last_us = flow->first_us;
+    }
+    if (flow_count == 0) {
+        fprintf(stderr, "재생할 클라이언트 데이터가 없습니다\n");
+        return 1;
+    }
+
+    int total = flow_count * opts->loops;
+    Session *sessions = calloc(total, sizeof(Session));
+    uint8_t *buf = malloc(RECV_BUFFER_SIZE);
+    int epfd = epoll_create1(0);
+    if (sessions == NULL || buf == NULL || epfd < 0) {
+        fprintf(stderr, "재생 준비 실패: %s\n", strerror(errno));
+        free(sessions);
+        free(buf);
+        return 1;
+    }
+
+    // 반복마다 녹화 전체 길이만큼 뒤로 (최대 속도는 모두 0)
+    uint64_t span_us = last_us - base_us + 1000;
+    uint64_t start = monotonic_us();
+    int n = 0;
+    for (int loop = 0; loop < opts->loops; loop++) {
+        for (int i = 0; i < table->count; i++) {
+            const Flow *flow = &table->flows[i];
+            if (flow->step_count == 0) continue;
+            Session *s = &sessions[n++];
+            s->flow = flow;
+            s->fd = -1;
+            if (opts->speed > 0) {
+                s->start_us = start + (uint64_t)((flow->first_us - base_us + loop * span_us) / opts->speed);
+            } else {
+                s->start_us = start;
+            }
+        }
+    }
+
+    // 시작 시각 순서로 정렬해 두면 다음 시작을 앞에서부터 찾을 수 있음
+    for (int i = 1; i < total; i++) {
+        Session tmp = sessions[i];
+        int j = i - 1;
+        while (j >= 0 && sessions[j].start_us > tmp.start_us) {
+            sessions[j + 1] = sessions[j];
+            j--;
+        }
+        sessions[j + 1] = tmp;
+    }
+
+    int next_start = 0;
+    int active = 0;
+    int finished = 0;
+    struct epoll_event events[EPOLL_BATCH];
+
+    while (finished < total && !g_stop) {
+        uint64_t now = monotonic_us();
+
+        // 시작 시각이 된 세션 (동시 세션 제한 안에서)
+        while (next_start < total && active < opts->concurrency && sessions[next_start].start_us <= now) {
+            Session *s = &sessions[next_start++];
+            if (session_start(epfd, s, opts, report, now)) {
+                active++;
+            } else {
+                finished++;
+            }
+        }
+
+        // 예정된 전송, 시간 초과, 다음 깨어날 시각
+        uint64_t wake = next_start < total && active < opts->concurrency ?
+                        sessions[next_start].start_us : now + 100000;
+        for (int i = 0; i < next_start; i++) {
+            Session *s = &sessions[i];
+            if (s->state != SESSION_RUNNING && s->state != SESSION_CONNECTING) continue;
+
+            uint64_t at = session_next_send(s, opts);
+            if (at <= now) {
+                session_send(epfd, s, opts, report, now);
+                at = session_next_send(s, opts);
+            }
+            if (s->state == SESSION_RUNNING && session_complete(s)) {
+                session_finish(epfd, s, report, NULL, opts->verbose);
+            } else if (s->state != SESSION_DONE &&
+                       now - s->last_progress_us >= (uint64_t)opts->timeout_ms * 1000 &&
+                       (at == UINT64_MAX || s->state == SESSION_CONNECTING)) {
+                if (s->state == SESSION_CONNECTING) {
+                    report->connect_failed++;
+                } else {
+                    report->timed_out++;
+                }
+                session_finish(epfd, s, report, "시간 초과", opts->verbose);
+            }
+
+            if (s->state == SESSION_DONE) {
+                active--;
+                finished++;
+                continue;
+            }
+            uint64_t deadline = s->last_progress_us + (uint64_t)opts->timeout_ms * 1000;
+            if (at < wake) wake = at;
+            if (deadline < wake) wake = deadline;
+        }
+
+        int timeout_ms = wake > now ? (int)((wake - now + 999) / 1000) : 0;
+        int ready = epoll_wait(epfd, events, EPOLL_BATCH, timeout_ms);
+        if (ready < 0 && errno != EINTR) {
+            fprintf(stderr, "epoll_wait 실패: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            Session *s = events[i].data.ptr;
+            if (s->state == SESSION_DONE) continue;
+            session_event(epfd, s, events[i].events, opts, report, buf);
+            if (s->state == SESSION_DONE) {
+                active--;
+                finished++;
+            }
+        }
+    }
+
+    *elapsed_us = monotonic_us() - start;
+
+    if (g_stop) {
+        for (int i = 0; i < next_start; i++) {
+            if (sessions[i].state != SESSION_DONE) {
+                session_finish(epfd, &sessions[i], report, "중단", opts->verbose);
+            }
+        }
+        fprintf(stderr, "중단됨: 세션 %d개 중 %d개 시작\n", total, next_start);
+    }
+
+    close(epfd);
+    free(sessions);
+    free(buf);
+    return 0;
+}
+
+// 화면 폭 기준으로 이름을 맞춰 출력 (한글은 2칸)
+static void print_label(const char *name, int width) {
+    int used = 0;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        if ((*p & 0xC0) == 0x80) continue;
+        used += *p >= 0xE0 ? 2 : 1;
+    }
+    printf("%s%*s", name, width > used ? width - used : 0, "");
+}
+
+static void print_percentiles(const char *name, Samples *samples) {
+    print_label(name, 16);
+    if (samples->count == 0) {
+        printf("없음\n");
+        return;
+    }
+
+    qsort(samples->values, samples->count, sizeof(uint64_t), compare_u64);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < samples->count; i++) {
+        sum += samples->values[i];
+    }
+
+    const double percents[] = {50, 90, 99, 99.9};
+    char text[4][16], mean[16], max[16];
+    for (int i = 0; i < 4; i++) {
+        size_t rank = (size_t)(samples->count * percents[i] / 100.0 + 0.5);
+        if (rank == 0) rank = 1;
+        if (rank > samples->count) rank = samples->count;
+        format_latency(samples->values[rank - 1], text[i], sizeof(text[i]));
+    }
+    format_latency(sum / samples->count, mean, sizeof(mean));
+    format_latency(samples->values[samples->count - 1], max, sizeof(max));
+
+    printf("평균 %-9s p50 %-9s p90 %-9s p99 %-9s p99.9 %-9s 최대 %s (%zu개)\n",
+           mean, text[0], text[1], text[2], text[3], max, samples->count);
+}
+
+static void print_report(const ReplayReport *report, const ReplayOptions *opts, int flows,
+                         uint64_t elapsed_us) {
+    double sec = elapsed_us / 1000000.0;
+    char sent[16], received[16], sent_rate[16], received_rate[16];
+    format_bytes(report->bytes_sent, sent, sizeof(sent));
+    format_bytes(report->bytes_received, received, sizeof(received));
+    format_bytes(sec > 0 ? (uint64_t)(report->bytes_sent / sec) : 0, sent_rate, sizeof(sent_rate));
+    format_bytes(sec > 0 ? (uint64_t)(report->bytes_received / sec) : 0,
+                 received_rate, sizeof(received_rate));
+
+    printf("\n=== 재생 결과 ===\n\n");
+    printf("대상: %s, 속도: ", opts->target_name);
+    if (opts->speed > 0) {
+        printf("x%g", opts->speed);
+    } else {
+        printf("최대 (응답을 받으면 바로 다음 요청)");
+    }
+    printf(", 흐름 %d개 x %d회, 동시 세션 최대 %d\n", flows, opts->loops, opts->concurrency);
+    printf("경과: %.2f s\n", sec);
+    printf("세션: 완료 %lu, 연결 실패 %lu, 서버가 먼저 닫음 %lu, 시간 초과 %lu\n",
+           report->sessions_done, report->connect_failed, report->closed_early, report->timed_out);
+    printf("요청: %lu (%.1f/s)\n", report->requests, sec > 0 ? report->requests / sec : 0.0);
+    printf("보냄: %s (%s/s), 받음: %s (%s/s)\n\n", sent, sent_rate, received, received_rate);
+
+    print_percentiles("연결", (Samples *)&report->connect);
+    print_percentiles("응답 첫 바이트", (Samples *)&report->first_byte);
+    print_percentiles("응답 완료", (Samples *)&report->complete);
+}
+
+static void print_usage(const char *program_name) {
+    printf("사용법: %s -t <host:port> [옵션] <캡처 파일>\n", program_name);
+    printf("\n캡처(pcapng/pcap)의 클라이언트 → 서버 스트림을 대상에 재생하고 처리량과 응답 시간을 보고합니다.\n");
+    printf("\n옵션:\n");
+    printf("  -t <host:port>  재생 대상 (필수)\n");
+    printf("  -s <speed>      재생 속도 배율 (1 = 녹화 시각 그대로, 2 = 두 배 빠르게,\n");
+    printf("                  0 = 최대 속도: 응답을 다 받으면 바로 다음 요청, 기본값: 1)\n");
+    printf("  -c <N>          최대 동시 세션 (기본값: %d)\n", DEFAULT_CONCURRENCY);
+    printf("  -n <N>          캡처 반복 횟수 (기본값: 1)\n");
+    printf("  -T <ms>         응답이 없을 때 세션을 끊는 시간 (기본값: %d)\n", DEFAULT_TIMEOUT_MS);
+    printf("  -v              세션마다 결과 출력\n");
+    printf("  -h              도움말\n");
+    printf("\n예시:\n");
+    printf("  %s -t 127.0.0.1:8080 logs/experiment.pcapng\n", program_name);
+    printf("  %s -t 127.0.0.1:9999 -s 0 -c 500 -n 20 logs/experiment.pcapng\n", program_name);
+}
+
+int main(int argc, char *argv[]) {
+    ReplayOptions opts;
+    memset(&opts, 0, sizeof(opts));
+    opts.speed = 1.0;
+    opts.concurrency = DEFAULT_CONCURRENCY;
+    opts.loops = 1;
+    opts.timeout_ms = DEFAULT_TIMEOUT_MS;
+    bool has_target = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:c:n:T:vh")) != -1) {
+        char *endptr;
+        switch (opt) {
+            case 't':
+                if (!parse_target(optarg, &opts)) {
+                    fprintf(stderr, "잘못된 대상: %s (host:port)\n", optarg);
+                    return 1;
+                }
+                has_target = true;
+                break;
+            case 's':
+                opts.speed = strtod(optarg, &endptr);
+                if (*endptr != '\0' || opts.speed < 0) {
+                    fprintf(stderr, "잘못된 속도: %s (0 이상)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'c':
+            case 'n':
+            case 'T': {
+                long value = strtol(optarg, &endptr, 10);
+                if (*endptr != '\0' || value <= 0 || value > 1000000) {
+                    fprintf(stderr, "잘못된 값: -%c %s\n", opt, optarg);
+                    return 1;
+                }
+                if (opt == 'c') opts.concurrency = (int)value;
+                else if (opt == 'n') opts.loops = (int)value;
+                else opts.timeout_ms = (int)value;
+                break;
+            }
+            case 'v':
+                opts.verbose = true;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (!has_target || optind + 1 != argc) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    opts.capture = argv[optind];
+
+    FlowTable table;
+    memset(&table, 0, sizeof(table));
+    if (!load_capture(opts.capture, &table)) {
+        return 1;
+    }
+
+    int flows = 0;
+    uint64_t requests = 0, c2s = 0, s2c = 0;
+    for (int i = 0; i < table.count; i++) {
+        if (table.flows[i].step_count == 0) continue;
+        flows++;
+        requests += table.flows[i].step_count;
+        c2s += table.flows[i].data_len;
+        s2c += table.flows[i].s2c_total;
+    }
+    char c2s_str[16], s2c_str[16];
+    format_bytes(c2s, c2s_str, sizeof(c2s_str));
+    format_bytes(s2c, s2c_str, sizeof(s2c_str));
+    printf("캡처: %s - TCP 패킷 %lu개 (건너뜀 %lu), 흐름 %d개, 요청 %lu개, 클라이언트 %s, 서버 %s\n",
+           opts.capture, table.packets, table.skipped, flows, requests, c2s_str, s2c_str);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    ReplayReport report;
+    memset(&report, 0, sizeof(report));
+    uint64_t elapsed_us = 0;
+    int result = replay_run(&table, &opts, &report, &elapsed_us);
+    if (result == 0) {
+        print_report(&report, &opts, flows, elapsed_us);
+    }
+
+    for (int i = 0; i < table.count; i++) {
+        free(table.flows[i].data);
+        free(table.flows[i].steps);
+    }
+    free(table.flows);
+    free(report.connect.values);
+    free(report.first_byte.values);
+    free(report.complete.values);
+    return result;
+}
@@ -0,0 +1,186 @@
+#include "../include/scenario.h"
+#include "../include/filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+// 시각 파싱 ("500ms", "30s", "30", "2m", "t=30s") - 실패 시 false
+static bool parse_time_ms(const char *text, uint64_t *out) {
+    char *endptr;
+
+    if (strncmp(text, "t=", 2) == 0) {
+        text += 2;
+    }
+
+    double value = strtod(text, &endptr);
+    if (endptr == text || !isfinite(value) || value < 0) {
+        return false;  // strtod가 받아들이는 nan/inf도 거부
+    }
+
+    double scale;
+    if (strcmp(endptr, "ms") == 0) {
+        scale = 1.0;
+    } else if (*endptr == '\0' || strcmp(endptr, "s") == 0) {
+        scale = 1000.0;
+    } else if (strcmp(endptr, "m") == 0) {
+        scale = 60000.0;
+    } else {
+        return false;
+    }
+
+    if (value * scale >= (double)UINT64_MAX) {
+        return false;
+    }
+    *out = (uint64_t)(value * scale + 0.5);
+    return true;
+}
+
+// 단계 동작 파싱 ("add <명세>", "remove 1", "clear", "nothing")
+static bool parse_step_action(char *text, ScenarioStep *step, char *err, size_t err_len) {
+    char *args = text + strcspn(text, " \t");
+    if (*args != '\0') {
+        *args++ = '\0';
+        args += strspn(args, " \t");
+    }
+
+    if (strcmp(text, "nothing") == 0) {
+        step->cmd = CMD_FILTER_LIST;  // 테이블을 바꾸지 않음 (진행 표시용 표식)
+    } else if (strcmp(text, "clear") == 0) {
+        step->cmd = CMD_FILTER_CLEAR;
+    } else if (strcmp(text, "add") == 0) {
+        Filter filter;
+        char spec_err[128];
+        if (*args == '\0' || strlen(args) >= sizeof(step->spec)) {
+            snprintf(err, err_len, "add 명세가 비었거나 너무 깁니다");
+            return false;
+        }
+        if (!filter_parse_spec(args, &filter, spec_err, sizeof(spec_err))) {
+            snprintf(err, err_len, "필터 명세 오류: %s", spec_err);
+            return false;
+        }
+        step->cmd = CMD_FILTER_ADD;
+        strcpy(step->spec, args);
+    } else if (strcmp(text, "remove") == 0 || strcmp(text, "enable") == 0 ||
+               strcmp(text, "disable") == 0) {
+        char *endptr;
+        long index = strtol(args, &endptr, 10);
+        if (*args == '\0' || *endptr != '\0' || index < 0 || index >= MAX_FILTERS) {
+            snprintf(err, err_len, "잘못된 인덱스: %s", args);
+            return false;
+        }
+        step->cmd = text[0] == 'r' ? CMD_FILTER_REMOVE :
+                    text[0] == 'e' ? CMD_FILTER_ENABLE : CMD_FILTER_DISABLE;
+        step->index = (int)index;
+    } else {
+        snprintf(err, err_len, "알 수 없는 동작: %s (add, remove, enable, disable, clear, nothing)",
+                 text);
+        return false;
+    }
+
+    return true;
+}
+
+bool scenario_load(const char *path, Scenario *scenario, char *err, size_t err_len) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        snprintf(err, err_len, "시나리오 파일을 열 수 없습니다: %s (%s)", path, strerror(errno));
+        return false;
+    }
+
+    memset(scenario, 0, sizeof(Scenario));
+    strncpy(scenario->path, path, sizeof(scenario->path) - 1);
+
+    char line[256];
+    char step_err[192];
+    int line_no = 0;
+    uint64_t last_ms = 0;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), fp)) {
+        line_no++;
+        // 버퍼보다 긴 줄은 나눠 읽으면 뒷부분이 다른 단계로 해석되므로 오류
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n' && !feof(fp)) {
+            snprintf(err, err_len, "%d행: 줄이 너무 깁니다 (최대 %zu바이트)", line_no, sizeof(line) - 2);
+            ok = false;
+            break;
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char *text = line + strspn(line, " \t");
+        if (*text == '\0' || *text == '#') {
+            continue;
+        }
+
+        if (scenario->count >= MAX_SCENARIO_STEPS) {
+            snprintf(err, err_len, "%d행: 단계가 너무 많습니다 (최대 %d개)", line_no, MAX_SCENARIO_STEPS);
+            ok = false;
+            break;
+        }
+
+        // 첫 토큰은 시각, 나머지는 동작
+        char *action = text + strcspn(text, " \t");
+        if (*action != '\0') {
+            *action++ = '\0';
+            action += strspn(action, " \t");
+        }
+
+        ScenarioStep *step = &scenario->steps[scenario->count];
+        memset(step, 0, sizeof(ScenarioStep));
+        step->line = line_no;
+
+        if (!parse_time_ms(text, &step->at_ms)) {
+            snprintf(err, err_len, "%d행: 잘못된 시각: %s (예: 500ms, 30s, 2m)", line_no, text);
+            ok = false;
+        } else if (step->at_ms < last_ms) {
+            snprintf(err, err_len, "%d행: 시각이 앞 단계보다 이릅니다: %s", line_no, text);
+            ok = false;
+        } else if (!parse_step_action(action, step, step_err, sizeof(step_err))) {
+            snprintf(err, err_len, "%d행: %s", line_no, step_err);
+            ok = false;
+        } else {
+            last_ms = step->at_ms;
+            scenario->count++;
+        }
+    }
+
+    fclose(fp);
+
+    if (ok && scenario->count == 0) {
+        snprintf(err, err_len, "시나리오에 단계가 없습니다: %s", path);
+        ok = false;
+    }
+    return ok;
+}
+
+void scenario_step_describe(const ScenarioStep *step, char *buf, size_t size) {
+    char at[32];
+    if (step->at_ms % 1000 == 0) {
+        snprintf(at, sizeof(at), "%lus", step->at_ms / 1000);
+    } else {
+        snprintf(at, sizeof(at), "%lums", step->at_ms);
+    }
+
+    switch (step->cmd) {
+        case CMD_FILTER_ADD:
+            snprintf(buf, size, "%s add %s", at, step->spec);
+            break;
+        case CMD_FILTER_REMOVE:
+            snprintf(buf, size, "%s remove %d", at, step->index);
+            break;
+        case CMD_FILTER_ENABLE:
+            snprintf(buf, size, "%s enable %d", at, step->index);
+            break;
+        case CMD_FILTER_DISABLE:
+            snprintf(buf, size, "%s disable %d", at, step->index);
+            break;
+        case CMD_FILTER_CLEAR:
+            snprintf(buf, size, "%s clear", at);
+            break;
+        default:
+            snprintf(buf, size, "%s nothing", at);
+            break;
+    }
+}
@@ -0,0 +1,33 @@
+#include "../include/tcpinfo.h"
+#include <string.h>
+#include <stddef.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>  // glibc의 tcp_info에는 tcpi_delivery_rate가 없음
+
+bool tcpinfo_sample(int sockfd, TcpInfoSample *sample) {
+    struct tcp_info info;
+    socklen_t len = sizeof(info);
+
+    memset(&info, 0, sizeof(info));
+    if (getsockopt(sockfd, IPPROTO_TCP, TCP_INFO, &info, &len) < 0) {
+        sample->valid = false;
+        return false;
+    }
+
+    sample->rtt_us = info.tcpi_rtt;
+    sample->rttvar_us = info.tcpi_rttvar;
+    sample->retransmits = info.tcpi_total_retrans;
+    sample->snd_cwnd = info.tcpi_snd_cwnd;
+    sample->unacked = info.tcpi_unacked;
+
+    // 오래된 커널은 구조체를 짧게 채움 (delivery_rate는 4.9+)
+    if (len >= offsetof(struct tcp_info, tcpi_delivery_rate) + sizeof(info.tcpi_delivery_rate)) {
+        sample->delivery_rate = info.tcpi_delivery_rate;
+    } else {
+        sample->delivery_rate = 0;
+    }
+
+    sample->valid = true;
+    return true;
+}
@@ -0,0 +1,277 @@
+#include "../include/tls.h"
+#include "../include/logger.h"
+#include "../include/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#define TLS_RECORD_HEADER_LEN 5
+#define TLS_CONTENT_HANDSHAKE 22
+#define TLS_HANDSHAKE_CLIENT_HELLO 1
+#define TLS_EXT_SERVER_NAME 0
+#define TLS_SNI_HOST_NAME 0
+
+static uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t read_u24(const uint8_t *p) {
+    return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+// ClientHello 본문에서 server_name 확장 찾기 (본문은 완전함)
+static int parse_hello_body(const uint8_t *body, uint32_t length, char *sni, size_t size) {
+    uint32_t pos = 2 + 32;  // client_version, random
+    if (pos + 1 > length) return 0;
+
+    pos += 1 + body[pos];   // session_id
+    if (pos + 2 > length) return 0;
+
+    pos += 2 + read_u16(body + pos);  // cipher_suites
+    if (pos + 1 > length) return 0;
+
+    pos += 1 + body[pos];   // compression_methods
+    if (pos + 2 > length) return 0;  // 확장 없음
+
+    uint32_t ext_end = pos + 2 + read_u16(body + pos);
+    pos += 2;
+    if (ext_end > length) return 0;
+
+    while (pos + 4 <= ext_end) {
+        uint16_t type = read_u16(body + pos);
+        uint16_t ext_len = read_u16(body + pos + 2);
+        pos += 4;
+        if (pos + ext_len > ext_end) return 0;
+
+        if (type == TLS_EXT_SERVER_NAME) {
+            // server_name_list: 2바이트 길이 + (종류 1바이트, 길이 2바이트, 이름)...
+            const uint8_t *list = body + pos;
+            if (ext_len < 2) return 0;
+            uint32_t list_end = 2 + (uint32_t)read_u16(list);
+            if (list_end > ext_len) return 0;
+
+            uint32_t i = 2;
+            while (i + 3 <= list_end) {
+                uint8_t name_type = list[i];
+                uint16_t name_len = read_u16(list + i + 1);
+                i += 3;
+                if (i + name_len > list_end) return 0;
+
+                if (name_type == TLS_SNI_HOST_NAME) {
+                    if (name_len == 0 || name_len >= size) return 0;
+                    for (uint16_t k = 0; k < name_len; k++) {
+                        char c = (char)list[i + k];
+                        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                              (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '_')) {
+                            return 0;  // 호스트 이름이 아님 (로그/표시에 넣지 않음)
+                        }
+                        sni[k] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+                    }
+                    sni[name_len] = '\0';
+                    return 1;
+                }
+                i += name_len;
+            }
+            return 0;
+        }
+        pos += ext_len;
+    }
+
+    return 0;
+}
+
+int tls_parse_client_hello(const uint8_t *data, int length, char *sni, size_t size) {
+    // 핸드셰이크 메시지는 여러 레코드에 나뉠 수 있으므로 레코드 payload를 이어 붙임
+    uint8_t handshake[TLS_PEEK_MAX];
+    uint32_t hs_len = 0;
+    int pos = 0;
+
+    if (length > 0 && data[0] != TLS_CONTENT_HANDSHAKE) {
+        return 0;
+    }
+
+    while (pos + TLS_RECORD_HEADER_LEN <= length) {
+        const uint8_t *record = data + pos;
+        uint16_t record_len = read_u16(record + 3);
+
+        if (record[0] != TLS_CONTENT_HANDSHAKE || record[1] != 3 || record_len == 0) {
+            return 0;
+        }
+
+        int available = length - pos - TLS_RECORD_HEADER_LEN;
+        int take = available < record_len ? available : record_len;
+        if (hs_len + (uint32_t)take > sizeof(handshake)) {
+            return 0;
+        }
+        memcpy(handshake + hs_len, record + TLS_RECORD_HEADER_LEN, take);
+        hs_len += take;
+
+        if (hs_len >= 4) {
+            if (handshake[0] != TLS_HANDSHAKE_CLIENT_HELLO) {
+                return 0;
+            }
+            uint32_t body_len = read_u24(handshake + 1);
+            if (4 + body_len > sizeof(handshake)) {
+                return 0;  // 엿볼 수 있는 크기보다 큼
+            }
+            if (hs_len >= 4 + body_len) {
+                return parse_hello_body(handshake + 4, body_len, sni, size);
+            }
+        }
+
+        if (take < record_len) {
+            break;  // 레코드가 아직 다 오지 않음
+        }
+        pos += TLS_RECORD_HEADER_LEN + record_len;
+    }
+
+    // 첫 레코드 헤더의 일부만 왔을 때도 TLS가 아니면 바로 판단
+    if (length - pos > 0 && data[pos] != TLS_CONTENT_HANDSHAKE) {
+        return 0;
+    }
+    if (length - pos > 1 && data[pos + 1] != 3) {
+        return 0;
+    }
+    return -1;
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int tls_peek_sni(int fd, int timeout_ms, char *sni, size_t size) {
+    static uint8_t buf[TLS_PEEK_MAX];  // 자식 프로세스마다 한 번만 씀
+    uint64_t deadline = monotonic_ms() + timeout_ms;
+    ssize_t peeked = 0;
+    int lowat = 1;
+    int result = -1;
+
+    sni[0] = '\0';
+
+    while (1) {
+        // 지금까지 엿본 것보다 많이 쌓이거나 (SO_RCVLOWAT) 클라이언트가 닫을 때까지 대기
+        int64_t remaining = (int64_t)(deadline - monotonic_ms());
+        if (remaining <= 0) {
+            LOG_WARN("ClientHello 대기 시간 초과 (%zd바이트 수신, 기본 대상 사용)", peeked);
+            result = 0;
+            break;
+        }
+
+        struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+        int ready = poll(&pfd, 1, (int)remaining);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("ClientHello 대기 실패: %s", strerror(errno));
+            break;
+        }
+        if (ready == 0) {
+            continue;  // 위에서 시간 초과 처리
+        }
+
+        ssize_t n = recv(fd, buf, sizeof(buf), MSG_PEEK);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("ClientHello 엿보기 실패: %s", strerror(errno));
+            break;
+        }
+        if (n == 0) {
+            break;  // 아무것도 보내지 않고 닫음
+        }
+
+        result = tls_parse_client_hello(buf, (int)n, sni, size);
+        if (result >= 0) {
+            break;
+        }
+
+        // 더 올 데이터가 없음 (FIN 뒤 같은 길이) 또는 엿볼 수 있는 한도에 닿음
+        if (n == peeked || (size_t)n >= sizeof(buf)) {
+            result = 0;
+            break;
+        }
+        peeked = n;
+
+        lowat = (int)n + 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat)) < 0) {
+            LOG_WARN("SO_RCVLOWAT 설정 실패: %s", strerror(errno));
+        }
+    }
+
+    // 중계 루프는 1바이트부터 읽어야 함
+    if (lowat != 1) {
+        lowat = 1;
+        setsockopt(fd, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat));
+    }
+    if (result <= 0) {
+        sni[0] = '\0';
+    }
+    return result;
+}
+
+bool tls_parse_route(const char *spec, SniRoute *route, char *err, size_t err_len) {
+    memset(route, 0, sizeof(SniRoute));
+
+    // 패턴과 대상은 마지막 '='로 나눔
+    const char *eq = strrchr(spec, '=');
+    if (eq == NULL || eq == spec) {
+        snprintf(err, err_len, "<SNI 패턴>=<host:port> 형식이어야 합니다");
+        return false;
+    }
+
+    size_t pattern_len = eq - spec;
+    if (pattern_len >= sizeof(route->pattern)) {
+        snprintf(err, err_len, "SNI 패턴이 너무 깁니다 (최대 %d자)", MAX_SNI_LEN - 1);
+        return false;
+    }
+    for (size_t i = 0; i < pattern_len; i++) {
+        char c = spec[i];
+        route->pattern[i] = (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+    route->pattern[pattern_len] = '\0';
+
+    if (strchr(route->pattern + 1, '*') != NULL ||
+        (route->pattern[0] == '*' && route->pattern[1] != '\0' && route->pattern[1] != '.')) {
+        snprintf(err, err_len, "잘못된 SNI 패턴: %s (이름, *.도메인, * 중 하나)", route->pattern);
+        return false;
+    }
+
+    // 대상은 host:port, [v6]:port, unix:/경로
+    const char *target = eq + 1;
+    if (!config_parse_endpoint(target, route->host, sizeof(route->host), &route->port)) {
+        snprintf(err, err_len, "잘못된 대상: %s (host:port, [v6]:port, unix:/경로)", target);
+        return false;
+    }
+    return true;
+}
+
+const SniRoute *tls_route_match(const SniRoute *routes, int count, const char *sni) {
+    if (sni == NULL || sni[0] == '\0') {
+        return NULL;
+    }
+
+    size_t sni_len = strlen(sni);
+    for (int i = 0; i < count; i++) {
+        const char *pattern = routes[i].pattern;
+
+        if (strcmp(pattern, "*") == 0) {
+            return &routes[i];
+        }
+        if (pattern[0] == '*') {
+            // "*.example.com": 하위 이름만 (example.com 자체는 아님)
+            size_t suffix_len = strlen(pattern + 1);
+            if (sni_len > suffix_len &&
+                strcasecmp(sni + sni_len - suffix_len, pattern + 1) == 0) {
+                return &routes[i];
+            }
+        } else if (strcasecmp(sni, pattern) == 0) {
+            return &routes[i];
+        }
+    }
+    return NULL;
+}
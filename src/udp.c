@@ -0,0 +1,1008 @@
+#define _GNU_SOURCE
+#include "../include/udp.h"
+#include "../include/control.h"
+#include "../include/filter.h"
+#include "../include/logger.h"
+#include "../include/config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+
+#define UDP_HASH_BITS 17              // 세션 해시 버킷 2^17개 (UDP_MAX_SESSIONS의 두 배)
+#define UDP_RECV_ROUNDS 8             // 이벤트 하나에서 연속으로 비울 recvmmsg 묶음 수 (다른 소켓 차례 보장)
+#define UDP_GSO_SEGMENTS 64           // GSO 메시지 하나에 합칠 최대 데이터그램 수 (커널 제한)
+#define UDP_GSO_BYTES 61440           // GSO 메시지 하나의 최대 페이로드
+#define UDP_EVENTS 256
+#define UDP_LISTEN_BUFFER (8 * 1024 * 1024)  // 리스닝 소켓 송수신 버퍼 (모든 클라이언트가 공유)
+#define UDP_SESSION_BUFFER (1024 * 1024)     // 세션 소켓 수신 버퍼 (작은 데이터그램도 버퍼를 ~1KB씩 차지)
+
+// 세션 키 (클라이언트 주소)
+typedef struct {
+    uint8_t family;
+    uint16_t port;
+    uint8_t addr[16];
+} UdpKey;
+
+typedef struct UdpSession {
+    UdpKey key;
+    struct sockaddr_storage client;
+    socklen_t client_len;
+    int fd;                           // 대상 서버에 connect한 전용 소켓
+    uint64_t id;                      // 세션 ID (선택자 conn=, 로그)
+    char client_addr[MAX_ADDR_LEN];
+    int client_port;
+    uint32_t select_epoch;            // mask를 계산한 체인 컴파일 차수
+    uint32_t mask[FILTER_DIR_COUNT];  // 방향별로 이 세션에 적용할 체인 필터
+    uint64_t offset[FILTER_DIR_COUNT];
+    uint64_t throttle_until[FILTER_DIR_COUNT]; // 쓰로틀로 이어 붙인 마지막 전송 시각 (µs)
+    Rng rng[FILTER_DIR_COUNT];        // 방향별 난수 (마스터 시드 + 세션 ID, 클라이언트가 여럿이어도 재현)
+    uint64_t start_ms;                // 세션 시작 (CLOCK_MONOTONIC_COARSE, 트리거 elapsed 기준)
+    uint64_t last_us;                 // 마지막 데이터그램 시각
+    int pending;                      // 보류 힙에 남은 데이터그램 (0이 될 때까지 만료하지 않음)
+    struct UdpSession *hash_next;
+    struct UdpSession *lru_prev;      // 최근 사용 순 목록 (앞이 최근)
+    struct UdpSession *lru_next;
+} UdpSession;
+
+// 지연/쓰로틀로 보류한 데이터그램 (마감 시각, 같으면 들어온 순서)
+typedef struct {
+    uint64_t due_us;
+    uint64_t seq;
+    UdpSession *session;
+    int direction;
+    int copies;
+    int length;
+    char *data;
+} UdpHeld;
+
+// 송신 묶음 (한 소켓으로 보낼 메시지, GSO면 같은 크기의 연속 데이터그램을 메시지 하나로)
+typedef struct {
+    int direction;
+    int fd;
+    int count;                        // 메시지 수
+    int iov_count;                    // 데이터그램 수
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iov[UDP_BATCH];
+    UdpSession *dest[UDP_BATCH];
+    int segment[UDP_BATCH];
+    char control[UDP_BATCH][CMSG_SPACE(sizeof(uint16_t))];
+} UdpOut;
+
+static int g_listen_fd = -1;
+static int g_timer_fd = -1;
+static int g_epoll_fd = -1;
+static struct sockaddr_storage g_target;
+static socklen_t g_target_len = 0;
+static bool g_gso = false;
+static int g_max_sessions = 0;
+static uint64_t g_idle_us = 0;
+static pid_t g_pid = 0;
+static char g_listener[MAX_LISTENER_NAME];   // 리스너 이름 (listener= 선택자, UDP 모드는 리스너 하나)
+
+static UdpSession **g_buckets = NULL;
+static UdpSession *g_lru_head = NULL;
+static UdpSession *g_lru_tail = NULL;
+static UdpSession *g_last = NULL;    // 직전 데이터그램의 세션 (같은 클라이언트가 연달아 보내는 경우)
+static int g_session_count = 0;
+static uint64_t g_next_session_id = 1;
+static uint64_t g_seed = 0;          // 마스터 시드 (세션별 난수 시드를 여기서 파생)
+
+// 필터: 공유 테이블 사본과 방향별 경로 (선택자는 세션별 mask로 따로 평가)
+static FilterChain g_table;
+static uint32_t g_generation = 0;
+static uint32_t g_select_epoch = 0;
+static FilterPath g_paths[FILTER_DIR_COUNT];
+static FilterSelector g_selectors[FILTER_DIR_COUNT][MAX_FILTERS];
+
+static UdpHeld *g_heap = NULL;
+static int g_heap_count = 0;
+static uint64_t g_heap_seq = 0;
+static uint64_t g_timer_armed = 0;
+
+static struct mmsghdr g_rx[UDP_BATCH];
+static struct iovec g_rx_iov[UDP_BATCH];
+static struct sockaddr_storage g_rx_addr[UDP_BATCH];
+static char g_rx_control[UDP_BATCH][CMSG_SPACE(sizeof(int))];
+static char *g_rx_buf = NULL;
+static UdpOut g_out[FILTER_DIR_COUNT];
+
+// 루프 전용 카운터와 제어 스레드가 읽는 사본 (1초마다 복사)
+static UdpStatus g_counters;
+static UdpStatus g_status;
+static pthread_mutex_t g_status_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t coarse_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void key_from_addr(const struct sockaddr_storage *ss, UdpKey *key) {
+    memset(key, 0, sizeof(UdpKey));
+    key->family = (uint8_t)ss->ss_family;
+    if (ss->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)ss;
+        memcpy(key->addr, &sin6->sin6_addr, 16);
+        key->port = sin6->sin6_port;
+    } else {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)ss;
+        memcpy(key->addr, &sin->sin_addr, 4);
+        key->port = sin->sin_port;
+    }
+}
+
+static uint32_t key_hash(const UdpKey *key) {
+    uint64_t a, b;
+    memcpy(&a, key->addr, 8);
+    memcpy(&b, key->addr + 8, 8);
+    uint64_t h = (a ^ (b * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)key->port << 48)) * 0xBF58476D1CE4E5B9ULL;
+    return (uint32_t)(h >> (64 - UDP_HASH_BITS));
+}
+
+static bool key_equal(const UdpKey *a, const UdpKey *b) {
+    return a->port == b->port && a->family == b->family && memcmp(a->addr, b->addr, 16) == 0;
+}
+
+// 최근 사용 순 목록
+static void lru_unlink(UdpSession *s) {
+    if (s->lru_prev) s->lru_prev->lru_next = s->lru_next;
+    else g_lru_head = s->lru_next;
+    if (s->lru_next) s->lru_next->lru_prev = s->lru_prev;
+    else g_lru_tail = s->lru_prev;
+    s->lru_prev = s->lru_next = NULL;
+}
+
+static void lru_push_front(UdpSession *s) {
+    s->lru_prev = NULL;
+    s->lru_next = g_lru_head;
+    if (g_lru_head) g_lru_head->lru_prev = s;
+    g_lru_head = s;
+    if (g_lru_tail == NULL) g_lru_tail = s;
+}
+
+static void session_touch(UdpSession *s, uint64_t now) {
+    s->last_us = now;
+    if (g_lru_head != s) {
+        lru_unlink(s);
+        lru_push_front(s);
+    }
+}
+
+// 세션에 적용할 필터 계산 (체인을 다시 컴파일했을 때만)
+static void session_select(UdpSession *s) {
+    for (int d = 0; d < FILTER_DIR_COUNT; d++) {
+        uint32_t mask = 0;
+        for (int i = 0; i < g_paths[d].chain.count; i++) {
+            if (filter_selector_match(&g_selectors[d][i], s->id, g_pid, s->client_addr, s->client_port,
+                                      g_listener)) {
+                mask |= 1u << i;
+            }
+        }
+        s->mask[d] = mask;
+    }
+    s->select_epoch = g_select_epoch;
+}
+
+static UdpSession *session_find(const UdpKey *key) {
+    if (g_last && key_equal(&g_last->key, key)) {
+        return g_last;
+    }
+    for (UdpSession *s = g_buckets[key_hash(key)]; s; s = s->hash_next) {
+        if (key_equal(&s->key, key)) {
+            g_last = s;
+            return s;
+        }
+    }
+    return NULL;
+}
+
+static UdpSession *session_create(const struct sockaddr_storage *addr, socklen_t addr_len,
+                                  const UdpKey *key, uint64_t now) {
+    if (g_session_count >= g_max_sessions) {
+        g_counters.sessions_rejected++;
+        return NULL;
+    }
+
+    int fd = socket(g_target.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&g_target, g_target_len) < 0) {
+        LOG_DEBUG("UDP 세션 소켓 생성 실패: %s", strerror(errno));
+        if (fd >= 0) close(fd);
+        g_counters.sessions_rejected++;
+        return NULL;
+    }
+    // 기본 수신 버퍼로는 작은 응답 수백 개면 넘쳐 루프가 잠깐만 늦어도 버려짐
+    int rcvbuf = UDP_SESSION_BUFFER;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (g_gso) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_UDP, UDP_GRO, &one, sizeof(one));
+    }
+
+    UdpSession *s = calloc(1, sizeof(UdpSession));
+    if (s == NULL) {
+        close(fd);
+        g_counters.sessions_rejected++;
+        return NULL;
+    }
+    s->key = *key;
+    memcpy(&s->client, addr, addr_len);
+    s->client_len = addr_len;
+    s->fd = fd;
+    s->id = g_next_session_id++;
+    // TCP 연결과 같은 방식: 세션 ID로 방향별 시드를 정함 (다른 세션의 데이터그램 수와 무관)
+    for (int d = 0; d < FILTER_DIR_COUNT; d++) {
+        rng_seed(&s->rng[d], rng_derive_seed(g_seed, s->id * 2 + d));
+    }
+    s->start_ms = coarse_ms();
+    s->last_us = now;
+    if (addr->ss_family == AF_INET6) {
+        // 겸용 소켓으로 들어온 IPv4 클라이언트는 점 표기로 (목록/선택자가 TCP 모드와 같도록)
+        const struct in6_addr *a6 = &((const struct sockaddr_in6 *)addr)->sin6_addr;
+        if (IN6_IS_ADDR_V4MAPPED(a6)) {
+            inet_ntop(AF_INET, &a6->s6_addr[12], s->client_addr, sizeof(s->client_addr));
+        } else {
+            inet_ntop(AF_INET6, a6, s->client_addr, sizeof(s->client_addr));
+        }
+    } else {
+        inet_ntop(AF_INET, &((const struct sockaddr_in *)addr)->sin_addr, s->client_addr,
+                  sizeof(s->client_addr));
+    }
+    s->client_port = ntohs(key->port);
+
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = s };
+    if (epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR("UDP 세션 소켓 등록 실패: %s", strerror(errno));
+        close(fd);
+        free(s);
+        g_counters.sessions_rejected++;
+        return NULL;
+    }
+
+    uint32_t h = key_hash(key);
+    s->hash_next = g_buckets[h];
+    g_buckets[h] = s;
+    lru_push_front(s);
+    session_select(s);
+    g_session_count++;
+    g_counters.sessions_created++;
+    g_last = s;
+
+    LOG_DEBUG("새 UDP 세션 #%lu: %s:%d", s->id, s->client_addr, s->client_port);
+    return s;
+}
+
+static void session_destroy(UdpSession *s) {
+    UdpSession **link = &g_buckets[key_hash(&s->key)];
+    while (*link != s) {
+        link = &(*link)->hash_next;
+    }
+    *link = s->hash_next;
+    lru_unlink(s);
+    if (g_last == s) {
+        g_last = NULL;
+    }
+
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    LOG_DEBUG("UDP 세션 #%lu 만료: %s:%d (c2s %lu, s2c %lu bytes)", s->id, s->client_addr,
+              s->client_port, s->offset[0], s->offset[1]);
+    free(s);
+    g_session_count--;
+}
+
+// 유휴 세션 만료 (오래된 쪽부터, 보류 중인 데이터그램이 있으면 남김)
+static void sessions_expire(uint64_t now) {
+    int budget = g_session_count;
+    while (g_lru_tail && budget-- > 0 && now - g_lru_tail->last_us >= g_idle_us) {
+        UdpSession *s = g_lru_tail;
+        if (s->pending > 0) {
+            session_touch(s, now);
+            continue;
+        }
+        session_destroy(s);
+        g_counters.sessions_expired++;
+    }
+}
+
+// 공유 필터 테이블에서 방향별 경로를 다시 컴파일
+// 경로는 모든 세션이 함께 쓰므로 선택자를 빼고 컴파일하고, 선택자는 같은 위치에 따로 두어 세션마다 평가한다.
+static void paths_compile(void) {
+    FilterChain table = g_table;
+    for (int i = 0; i < table.count; i++) {
+        table.filters[i].selector.flags = 0;
+    }
+
+    Connection any;
+    memset(&any, 0, sizeof(any));
+    for (int d = 0; d < FILTER_DIR_COUNT; d++) {
+        int direction = d + 1;
+        control_filter_account(&g_paths[d].chain, direction, g_paths[d].counters);
+        filter_path_compile(&table, &any, direction, &g_paths[d]);
+
+        for (int i = 0; i < g_paths[d].chain.count; i++) {
+            for (int j = 0; j < g_table.count; j++) {
+                if (g_table.filters[j].id == g_paths[d].chain.filters[i].id) {
+                    g_selectors[d][i] = g_table.filters[j].selector;
+                    break;
+                }
+            }
+        }
+    }
+    g_select_epoch++;
+}
+
+// 송신 묶음 전송 (소켓 버퍼가 가득 차면 나머지는 UDP답게 버림)
+static void out_send_segments(int fd, struct msghdr *hdr, int d) {
+    for (size_t k = 0; k < hdr->msg_iovlen; k++) {
+        struct msghdr one = { .msg_name = hdr->msg_name, .msg_namelen = hdr->msg_namelen,
+                              .msg_iov = &hdr->msg_iov[k], .msg_iovlen = 1 };
+        if (sendmsg(fd, &one, MSG_DONTWAIT) < 0) {
+            g_counters.send_errors[d]++;
+        } else {
+            g_counters.sent[d]++;
+        }
+    }
+}
+
+static void out_flush(UdpOut *out) {
+    if (out->count == 0) {
+        return;
+    }
+    int d = out->direction - 1;
+
+    for (int i = 0; i < out->count; i++) {
+        struct msghdr *hdr = &out->msgs[i].msg_hdr;
+        if (hdr->msg_iovlen > 1) {
+            hdr->msg_control = out->control[i];
+            hdr->msg_controllen = sizeof(out->control[i]);
+            struct cmsghdr *cm = CMSG_FIRSTHDR(hdr);
+            cm->cmsg_level = SOL_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t segment = (uint16_t)out->segment[i];
+            memcpy(CMSG_DATA(cm), &segment, sizeof(segment));
+        }
+    }
+
+    int sent = 0;
+    while (sent < out->count) {
+        int n = sendmmsg(out->fd, out->msgs + sent, out->count - sent, MSG_DONTWAIT);
+        g_counters.send_calls++;
+        if (n > 0) {
+            for (int k = sent; k < sent + n; k++) {
+                g_counters.sent[d] += out->msgs[k].msg_hdr.msg_iovlen;
+            }
+            sent += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        struct msghdr *hdr = &out->msgs[sent].msg_hdr;
+        if (hdr->msg_iovlen > 1 && (errno == EIO || errno == EINVAL || errno == EOPNOTSUPP)) {
+            // 장치가 UDP GSO를 지원하지 않음: 이후로는 데이터그램마다 메시지 하나
+            LOG_WARN("UDP GSO 전송 실패 (%s), GSO를 끕니다", strerror(errno));
+            g_gso = false;
+            out_send_segments(out->fd, hdr, d);
+            sent++;
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+            for (int k = sent; k < out->count; k++) {
+                g_counters.send_errors[d] += out->msgs[k].msg_hdr.msg_iovlen;
+            }
+            break;
+        }
+        // 이 메시지만 실패 (앞서 받은 ICMP 거부 등)
+        g_counters.send_errors[d] += hdr->msg_iovlen;
+        sent++;
+    }
+
+    out->count = 0;
+    out->iov_count = 0;
+}
+
+static void out_push(UdpOut *out, int fd, UdpSession *s, const char *data, int length) {
+    if (out->count > 0 && out->fd != fd) {
+        out_flush(out);
+    }
+    if (out->iov_count == UDP_BATCH) {
+        out_flush(out);
+    }
+    out->fd = fd;
+
+    struct iovec *iov = &out->iov[out->iov_count++];
+    iov->iov_base = (void *)data;
+    iov->iov_len = length;
+
+    // 같은 목적지로 가는 같은 크기 데이터그램은 GSO 메시지 하나로 합침
+    if (g_gso && out->count > 0) {
+        int last = out->count - 1;
+        struct msghdr *hdr = &out->msgs[last].msg_hdr;
+        if (out->dest[last] == s && out->segment[last] == length &&
+            hdr->msg_iovlen < UDP_GSO_SEGMENTS && (hdr->msg_iovlen + 1) * length <= UDP_GSO_BYTES) {
+            hdr->msg_iovlen++;
+            return;
+        }
+    }
+
+    struct msghdr *hdr = &out->msgs[out->count].msg_hdr;
+    memset(hdr, 0, sizeof(struct msghdr));
+    if (out->direction == FILTER_DIR_S2C) {
+        hdr->msg_name = &s->client;
+        hdr->msg_namelen = s->client_len;
+    }
+    hdr->msg_iov = iov;
+    hdr->msg_iovlen = 1;
+    out->dest[out->count] = s;
+    out->segment[out->count] = length;
+    out->count++;
+}
+
+static void deliver(UdpSession *s, int direction, const char *data, int length, int copies) {
+    UdpOut *out = &g_out[direction - 1];
+    int fd = direction == FILTER_DIR_C2S ? s->fd : g_listen_fd;
+    for (int c = 0; c < copies; c++) {
+        out_push(out, fd, s, data, length);
+    }
+}
+
+// 보류 힙 (마감 시각이 같으면 들어온 순서를 지킴)
+static bool held_before(const UdpHeld *a, const UdpHeld *b) {
+    return a->due_us < b->due_us || (a->due_us == b->due_us && a->seq < b->seq);
+}
+
+static bool held_push(UdpSession *s, int direction, uint64_t due, const char *data, int length,
+                      int copies) {
+    if (g_heap_count >= UDP_DELAY_QUEUE) {
+        return false;
+    }
+    char *copy = malloc(length > 0 ? length : 1);
+    if (copy == NULL) {
+        return false;
+    }
+    memcpy(copy, data, length);
+
+    int i = g_heap_count++;
+    UdpHeld item = { .due_us = due, .seq = g_heap_seq++, .session = s, .direction = direction,
+                     .copies = copies, .length = length, .data = copy };
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!held_before(&item, &g_heap[parent])) break;
+        g_heap[i] = g_heap[parent];
+        i = parent;
+    }
+    g_heap[i] = item;
+    s->pending++;
+    return true;
+}
+
+static UdpHeld held_pop(void) {
+    UdpHeld top = g_heap[0];
+    UdpHeld last = g_heap[--g_heap_count];
+    int i = 0;
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= g_heap_count) break;
+        if (child + 1 < g_heap_count && held_before(&g_heap[child + 1], &g_heap[child])) child++;
+        if (!held_before(&g_heap[child], &last)) break;
+        g_heap[i] = g_heap[child];
+        i = child;
+    }
+    if (g_heap_count > 0) {
+        g_heap[i] = last;
+    }
+    return top;
+}
+
+// 마감 시각이 지난 데이터그램 전송
+static void held_release(uint64_t now) {
+    UdpHeld batch[UDP_BATCH];
+    while (g_heap_count > 0 && g_heap[0].due_us <= now) {
+        int n = 0;
+        while (n < UDP_BATCH && g_heap_count > 0 && g_heap[0].due_us <= now) {
+            batch[n] = held_pop();
+            deliver(batch[n].session, batch[n].direction, batch[n].data, batch[n].length,
+                    batch[n].copies);
+            n++;
+        }
+        out_flush(&g_out[0]);
+        out_flush(&g_out[1]);
+        for (int i = 0; i < n; i++) {
+            batch[i].session->pending--;
+            free(batch[i].data);
+        }
+    }
+}
+
+// 다음 마감 시각에 타이머를 맞춤 (epoll 대기는 밀리초 단위라 지연 정밀도를 위해 timerfd 사용)
+static void held_arm_timer(void) {
+    uint64_t due = g_heap_count > 0 ? g_heap[0].due_us : 0;
+    if (due == g_timer_armed) {
+        return;
+    }
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    if (due != 0) {
+        its.it_value.tv_sec = due / 1000000;
+        its.it_value.tv_nsec = (due % 1000000) * 1000;
+    }
+    timerfd_settime(g_timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+    g_timer_armed = due;
+}
+
+// 데이터그램 하나 처리: 필터 적용 후 바로 보내거나 보류
+static void handle_datagram(UdpSession *s, int direction, const char *data, int length, uint64_t now) {
+    int d = direction - 1;
+    g_counters.datagrams[d]++;
+    g_counters.bytes[d] += length;
+    session_touch(s, now);
+
+    FilterPath *path = &g_paths[d];
+    int copies = 1;
+    if (path->chain.count > 0) {
+        if (s->select_epoch != g_select_epoch) {
+            session_select(s);
+        }
+        if (s->mask[d] != 0) {
+            DatagramContext ctx = { .mask = s->mask[d], .offset = s->offset[d],
+                                    .session_bytes = s->offset[0] + s->offset[1],
+                                    .start_ms = s->start_ms, .rng = &s->rng[d] };
+            FilterPlan plan;
+            FilterVerdict verdict = filter_apply_datagram(path, &ctx, data, length, &plan);
+            s->offset[d] += length;
+            if (verdict == VERDICT_DROP) {
+                g_counters.dropped[d]++;
+                return;
+            }
+
+            if (plan.hold_us > 0 || plan.throttle_us > 0) {
+                uint64_t due = now + plan.hold_us;
+                if (plan.throttle_us > 0) {
+                    // 쓰로틀은 세션 방향별 병목: 앞선 데이터그램이 다 나간 뒤에 이어서 전송
+                    if (s->throttle_until[d] > due) due = s->throttle_until[d];
+                    due += plan.throttle_us;
+                    s->throttle_until[d] = due;
+                }
+                if (!held_push(s, direction, due, data, length, plan.copies)) {
+                    g_counters.dropped[d]++;  // 보류 큐가 넘침 (병목 큐의 꼬리 드롭과 같음)
+                }
+                return;
+            }
+            copies = plan.copies;
+            deliver(s, direction, data, length, copies);
+            return;
+        }
+    }
+
+    s->offset[d] += length;
+    deliver(s, direction, data, length, copies);
+}
+
+// GRO로 합쳐진 버퍼의 세그먼트 크기 (합쳐지지 않았으면 0)
+static int rx_segment_size(struct msghdr *hdr) {
+    if (!g_gso || hdr->msg_controllen == 0) {
+        return 0;
+    }
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(hdr); cm; cm = CMSG_NXTHDR(hdr, cm)) {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+            int size;
+            memcpy(&size, CMSG_DATA(cm), sizeof(size));
+            return size;
+        }
+    }
+    return 0;
+}
+
+static int rx_receive(int fd, bool with_addr) {
+    for (int i = 0; i < UDP_BATCH; i++) {
+        struct msghdr *hdr = &g_rx[i].msg_hdr;
+        hdr->msg_name = with_addr ? &g_rx_addr[i] : NULL;
+        hdr->msg_namelen = with_addr ? sizeof(g_rx_addr[i]) : 0;
+        hdr->msg_iov = &g_rx_iov[i];
+        hdr->msg_iovlen = 1;
+        hdr->msg_control = g_gso ? g_rx_control[i] : NULL;
+        hdr->msg_controllen = g_gso ? sizeof(g_rx_control[i]) : 0;
+        hdr->msg_flags = 0;
+    }
+    g_counters.recv_calls++;
+    return recvmmsg(fd, g_rx, UDP_BATCH, MSG_DONTWAIT, NULL);
+}
+
+// 받은 묶음의 데이터그램마다 handle_datagram (GRO 버퍼는 세그먼트로 나눔)
+static void rx_dispatch(int i, UdpSession *s, int direction, uint64_t now) {
+    const char *data = g_rx_iov[i].iov_base;
+    int length = (int)g_rx[i].msg_len;
+    int segment = rx_segment_size(&g_rx[i].msg_hdr);
+    if (segment <= 0 || segment >= length) {
+        handle_datagram(s, direction, data, length, now);
+        return;
+    }
+    for (int off = 0; off < length; off += segment) {
+        handle_datagram(s, direction, data + off, length - off < segment ? length - off : segment, now);
+    }
+}
+
+// 클라이언트 → 서버: 리스닝 소켓을 묶음으로 비움
+static void receive_clients(void) {
+    for (int round = 0; round < UDP_RECV_ROUNDS; round++) {
+        int n = rx_receive(g_listen_fd, true);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_ERROR("UDP 수신 실패: %s", strerror(errno));
+            }
+            return;
+        }
+
+        uint64_t now = now_us();
+        for (int i = 0; i < n; i++) {
+            UdpKey key;
+            key_from_addr(&g_rx_addr[i], &key);
+            UdpSession *s = session_find(&key);
+            if (s == NULL) {
+                s = session_create(&g_rx_addr[i], g_rx[i].msg_hdr.msg_namelen, &key, now);
+                if (s == NULL) {
+                    g_counters.datagrams[0]++;
+                    g_counters.bytes[0] += g_rx[i].msg_len;
+                    g_counters.dropped[0]++;
+                    continue;
+                }
+            }
+            rx_dispatch(i, s, FILTER_DIR_C2S, now);
+        }
+        out_flush(&g_out[0]);
+        out_flush(&g_out[1]);
+
+        if (n < UDP_BATCH) {
+            return;
+        }
+    }
+}
+
+// 서버 → 클라이언트: 세션 소켓을 묶음으로 비움
+static void receive_server(UdpSession *s) {
+    for (int round = 0; round < UDP_RECV_ROUNDS; round++) {
+        int n = rx_receive(s->fd, false);
+        if (n <= 0) {
+            if (n < 0 && errno == ECONNREFUSED) {
+                continue;  // 대상 서버의 ICMP 거부 (앞서 보낸 데이터그램은 이미 나감), 오류만 비움
+            }
+            return;
+        }
+
+        uint64_t now = now_us();
+        for (int i = 0; i < n; i++) {
+            rx_dispatch(i, s, FILTER_DIR_S2C, now);
+        }
+        out_flush(&g_out[0]);
+        out_flush(&g_out[1]);
+
+        if (n < UDP_BATCH) {
+            return;
+        }
+    }
+}
+
+// 1초마다: 필터 효과/이력 반영, 유휴 세션 만료, 상태 게시
+static void tick(uint64_t now) {
+    static UdpStatus last;
+
+    for (int d = 0; d < FILTER_DIR_COUNT; d++) {
+        control_filter_account(&g_paths[d].chain, d + 1, g_paths[d].counters);
+    }
+    sessions_expire(now);
+
+    g_counters.sessions_active = g_session_count;
+    g_counters.delayed = g_heap_count;
+    g_counters.gso = g_gso;
+    control_account_traffic(g_counters.bytes[0] - last.bytes[0], g_counters.bytes[1] - last.bytes[1],
+                            g_counters.sessions_created - last.sessions_created,
+                            g_counters.sessions_expired - last.sessions_expired,
+                            (g_counters.dropped[0] + g_counters.dropped[1]) -
+                            (last.dropped[0] + last.dropped[1]));
+    if (g_counters.sessions_rejected > last.sessions_rejected) {
+        LOG_WARN("UDP 세션 %lu개 거부 (세션 %d개 한도 또는 소켓 생성 실패)",
+                 g_counters.sessions_rejected - last.sessions_rejected, g_max_sessions);
+    }
+    last = g_counters;
+
+    pthread_mutex_lock(&g_status_lock);
+    g_status = g_counters;
+    pthread_mutex_unlock(&g_status_lock);
+}
+
+// 세션마다 소켓이 하나이므로 파일 수 제한을 올리고 그에 맞춰 세션 수를 정함
+static int max_sessions_for_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) < 0) {
+        return 1024 - 64;
+    }
+    rlim_t want = UDP_MAX_SESSIONS + 64;
+    if (rl.rlim_cur < want && rl.rlim_cur != RLIM_INFINITY) {
+        rl.rlim_cur = (rl.rlim_max == RLIM_INFINITY || rl.rlim_max > want) ? want : rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+    }
+    rlim_t usable = rl.rlim_cur == RLIM_INFINITY ? want : rl.rlim_cur;
+    return usable - 64 < UDP_MAX_SESSIONS ? (int)(usable - 64) : UDP_MAX_SESSIONS;
+}
+
+static bool resolve_target(const char *host, int port) {
+    struct addrinfo hints, *result;
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    int ret = getaddrinfo(host, port_str, &hints, &result);
+    if (ret != 0) {
+        LOG_ERROR("호스트를 찾을 수 없습니다: %s (%s)", host, gai_strerror(ret));
+        return false;
+    }
+    memcpy(&g_target, result->ai_addr, result->ai_addrlen);
+    g_target_len = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+// 리스닝 주소 해석 (호스트가 비어 있으면 [::], IPv6 전용을 풀어 IPv4도 받음)
+static bool listen_address(const char *host, int port, struct sockaddr_storage *addr,
+                           socklen_t *addr_len) {
+    memset(addr, 0, sizeof(*addr));
+    if (host[0] == '\0') {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)addr;
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_addr = in6addr_any;
+        sin6->sin6_port = htons(port);
+        *addr_len = sizeof(*sin6);
+        return true;
+    }
+
+    struct addrinfo hints, *result;
+    char port_str[16];
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICSERV;
+    int ret = getaddrinfo(host, port_str, &hints, &result);
+    if (ret != 0) {
+        LOG_ERROR("리스닝 주소를 찾을 수 없습니다: %s (%s)", host, gai_strerror(ret));
+        return false;
+    }
+    memcpy(addr, result->ai_addr, result->ai_addrlen);
+    *addr_len = result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+static int udp_listen(const char *host, int port) {
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    if (!listen_address(host, port, &addr, &addr_len)) {
+        return -1;
+    }
+
+    int fd = socket(addr.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 && host[0] == '\0' && errno == EAFNOSUPPORT) {
+        // IPv6가 꺼진 커널: 0.0.0.0
+        struct sockaddr_in *sin = (struct sockaddr_in *)&addr;
+        memset(&addr, 0, sizeof(addr));
+        sin->sin_family = AF_INET;
+        sin->sin_addr.s_addr = INADDR_ANY;
+        sin->sin_port = htons(port);
+        addr_len = sizeof(*sin);
+        fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    if (fd < 0) {
+        LOG_ERROR("소켓 생성 실패: %s", strerror(errno));
+        return -1;
+    }
+
+    int opt = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        LOG_WARN("SO_REUSEADDR 설정 실패: %s", strerror(errno));
+    }
+    if (addr.ss_family == AF_INET6) {
+        int off = 0;
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    }
+    // 모든 클라이언트가 이 소켓 하나로 들어오므로 수신 버퍼를 키움 (net.core.rmem_max까지)
+    int size = UDP_LISTEN_BUFFER;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    if (bind(fd, (struct sockaddr *)&addr, addr_len) < 0) {
+        LOG_ERROR("바인드 실패: %s", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool udp_init(const ProxyConfig *config) {
+    if (config_unix_path(config->listener.listen_host) != NULL || config_unix_path(config->listener.target_host) != NULL) {
+        LOG_ERROR("UDP 모드는 유닉스 소켓 주소를 지원하지 않습니다 (unix:는 TCP 모드 전용)");
+        return false;
+    }
+    if (!resolve_target(config->listener.target_host, config->listener.target_port)) {
+        return false;
+    }
+    if ((g_listen_fd = udp_listen(config->listener.listen_host, config->listener.listen_port)) < 0) {
+        return false;
+    }
+
+    g_gso = config->udp_gso;
+    if (g_gso) {
+        int one = 1;
+        if (setsockopt(g_listen_fd, IPPROTO_UDP, UDP_GRO, &one, sizeof(one)) < 0) {
+            LOG_WARN("UDP GRO를 쓸 수 없습니다 (%s), GSO/GRO 없이 실행", strerror(errno));
+            g_gso = false;
+        }
+    }
+
+    g_buckets = calloc((size_t)1 << UDP_HASH_BITS, sizeof(UdpSession *));
+    g_heap = malloc(sizeof(UdpHeld) * UDP_DELAY_QUEUE);
+    g_rx_buf = malloc((size_t)UDP_BATCH * UDP_MAX_DATAGRAM);
+    if (g_buckets == NULL || g_heap == NULL || g_rx_buf == NULL) {
+        LOG_ERROR("UDP 버퍼 할당 실패");
+        return false;
+    }
+    for (int i = 0; i < UDP_BATCH; i++) {
+        g_rx_iov[i].iov_base = g_rx_buf + (size_t)i * UDP_MAX_DATAGRAM;
+        g_rx_iov[i].iov_len = UDP_MAX_DATAGRAM;
+    }
+    g_out[0].direction = FILTER_DIR_C2S;
+    g_out[1].direction = FILTER_DIR_S2C;
+
+    g_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    g_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (g_epoll_fd < 0 || g_timer_fd < 0) {
+        LOG_ERROR("epoll/timerfd 생성 실패: %s", strerror(errno));
+        return false;
+    }
+    // 리스닝 소켓과 타이머는 세션이 아닌 표지 포인터로 구분
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &g_listen_fd };
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, g_listen_fd, &ev);
+    ev.data.ptr = &g_timer_fd;
+    epoll_ctl(g_epoll_fd, EPOLL_CTL_ADD, g_timer_fd, &ev);
+
+    g_max_sessions = max_sessions_for_fd_limit();
+    g_idle_us = (uint64_t)(config->udp_idle_sec > 0 ? config->udp_idle_sec : UDP_DEFAULT_IDLE_SEC) * 1000000;
+    g_pid = getpid();
+    snprintf(g_listener, sizeof(g_listener), "%s", config->listener.name);
+
+    g_seed = config->seed;
+    for (int d = 0; d < FILTER_DIR_COUNT; d++) {
+        filter_path_init(&g_paths[d], rng_derive_seed(config->seed, d));
+    }
+
+    g_counters.enabled = true;
+    g_counters.gso = g_gso;
+    g_counters.idle_sec = (int)(g_idle_us / 1000000);
+    g_counters.max_sessions = g_max_sessions;
+    pthread_mutex_lock(&g_status_lock);
+    g_status = g_counters;
+    pthread_mutex_unlock(&g_status_lock);
+    return true;
+}
+
+// UDP 모드에서 쓰지 않는 TCP 전용 설정 알림
+static void warn_ignored(const ProxyConfig *config) {
+    if (config->listener.sni_route_count > 0) LOG_WARN("UDP 모드: SNI 라우팅 규칙은 무시됩니다");
+    if (config->listener.proxy_protocol != 0) LOG_WARN("UDP 모드: PROXY 프로토콜 설정은 무시됩니다");
+    if (config->listener.protocol != PROTOCOL_RAW) LOG_WARN("UDP 모드: 프로토콜 인식 모드는 무시됩니다");
+    if (config->capture_file[0] != '\0') LOG_WARN("UDP 모드: 트래픽 캡처는 무시됩니다");
+    if (config->mirror_host[0] != '\0') LOG_WARN("UDP 모드: 섀도 미러링은 무시됩니다");
+}
+
+int udp_proxy_start(const ProxyConfig *config, FilterChain *filter_chain) {
+    if (config->listener_count > 0) {
+        LOG_ERROR("UDP 모드는 리스너 구역([이름])을 지원하지 않습니다 (listen=/target=을 구역 밖에)");
+        return -1;
+    }
+    warn_ignored(config);
+    if (!udp_init(config)) {
+        return -1;
+    }
+
+    if (control_server_start(config->control_socket) < 0) {
+        LOG_WARN("제어 서버 시작 실패 (관리 기능 비활성화)");
+    }
+
+    LOG_INFO("======================================");
+    LOG_INFO("UDP 프록시 서버 시작");
+    char endpoint[MAX_HOST_LEN + 16];
+    config_format_endpoint(config->listener.listen_host, config->listener.listen_port, endpoint, sizeof(endpoint));
+    LOG_INFO("리스닝: %s/udp", endpoint);
+    config_format_endpoint(config->listener.target_host, config->listener.target_port, endpoint, sizeof(endpoint));
+    LOG_INFO("대상: %s/udp", endpoint);
+    LOG_INFO("세션: 최대 %d개, 유휴 %d초 후 만료, GSO/GRO %s", g_max_sessions,
+             (int)(g_idle_us / 1000000), g_gso ? "사용" : "사용 안 함");
+    LOG_INFO("제어 소켓: %s", config->control_socket);
+    LOG_INFO("======================================");
+
+    if (filter_chain && filter_chain->count > 0) {
+        filter_chain_print(filter_chain);
+    }
+    control_filter_publish(filter_chain);
+    control_listeners_publish(&config->listener, 1);
+    if (config->scenario_file[0] != '\0' && !control_scenario_start(config->scenario_file)) {
+        control_server_stop();
+        close(g_listen_fd);
+        return -1;
+    }
+    control_filter_sync(&g_table, &g_generation);
+    paths_compile();
+
+    struct epoll_event events[UDP_EVENTS];
+    uint64_t next_tick = now_us() + 1000000;
+
+    while (1) {
+        uint64_t now = now_us();
+        int timeout_ms = next_tick > now ? (int)((next_tick - now + 999) / 1000) : 0;
+        int n = epoll_wait(g_epoll_fd, events, UDP_EVENTS, timeout_ms);
+        if (n < 0 && errno != EINTR) {
+            LOG_ERROR("epoll 대기 실패: %s", strerror(errno));
+            break;
+        }
+
+        // 런타임 필터 변경 (세대 비교 한 번)
+        if (control_filter_sync(&g_table, &g_generation)) {
+            paths_compile();
+        }
+
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &g_listen_fd) {
+                receive_clients();
+            } else if (ptr == &g_timer_fd) {
+                uint64_t expirations;
+                if (read(g_timer_fd, &expirations, sizeof(expirations)) < 0) {
+                    // 이미 비워짐
+                }
+                g_timer_armed = 0;
+            } else {
+                receive_server((UdpSession *)ptr);
+            }
+        }
+
+        now = now_us();
+        held_release(now);
+        held_arm_timer();
+
+        if (now >= next_tick) {
+            tick(now);
+            next_tick = now + 1000000;
+        }
+    }
+
+    control_server_stop();
+    close(g_listen_fd);
+    return -1;
+}
+
+void udp_get_status(UdpStatus *status) {
+    pthread_mutex_lock(&g_status_lock);
+    *status = g_status;
+    pthread_mutex_unlock(&g_status_lock);
+}